@@ -40,6 +40,7 @@
 #include "core/integral.hpp"
 #include "core/integral_compressed.hpp"
 #include "core/integral_dyall.hpp"
+#include "core/integral_cholesky.hpp"
 #include "core/iterative_matrix_functions.hpp"
 #include "core/matching.hpp"
 #include "core/matrix.hpp"
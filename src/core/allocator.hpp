@@ -41,6 +41,7 @@
 #include <future>
 #include <iostream>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -318,6 +319,8 @@ struct DataFrame {
     mutable double tread = 0, //!< IO Time cost for reading scratch files.
         twrite = 0,           //!< IO Time cost for writing scratch files.
         tasync = 0;           //!< IO Time cost for async writing scratch files.
+    mutable double tprefetch =
+        0; //!< IO Time cost for reading scratch files in background.
     mutable double fpread = 0, //!< IO Time cost for reading scratch files with
                                //!< floating-point decompression.
         fpwrite = 0;           //!< IO Time cost for writing scratch files with
@@ -344,6 +347,13 @@ struct DataFrame {
     //!< Buffers for async saving.
     mutable vector<shared_future<void>> save_futures;
     //!< Async saving files.
+    mutable vector<shared_ptr<pair<double, double>>> save_times;
+    //!< Start and end time of async saving files, set by the saving thread.
+    mutable vector<pair<string, shared_future<shared_ptr<stringstream>>>>
+        prefetch_futures;
+    //!< Async reading files, started by prefetch_data.
+    mutable vector<shared_ptr<pair<double, double>>> prefetch_times;
+    //!< Start and end time of async reading files, set by the reading thread.
     bool load_buffering = false, //!< Whether load buffering should be used. If
                                  //!< true, memory usage will increase.
         save_buffering =
@@ -360,6 +370,16 @@ struct DataFrame {
     shared_ptr<FPCodec<double>> fp_codec =
         nullptr; //!< Floating-point compression codec. If nullptr,
                  //!< floating-point compression will not be used.
+    bool checkpoint_async =
+        false; //!< Whether restart dirs (checkpoints) should be written to
+               //!< disk in a background thread. If true, memory usage will
+               //!< increase by the size of one checkpoint.
+    mutable shared_ptr<vector<pair<string, string>>> checkpoint_buffer =
+        nullptr; //!< Snapshot of files in the checkpoint being prepared.
+    mutable shared_future<double>
+        checkpoint_future; //!< Async writing of the last checkpoint
+                           //!< (returning its IO time cost).
+    mutable double tcheckpoint = 0; //!< IO Time cost for writing checkpoints.
     // isize and dsize are in Bytes
     /** Constructor.
      * @param isize Max size (in bytes) of all integer stacks.
@@ -380,6 +400,9 @@ struct DataFrame {
         load_buffers.resize(n_frames);
         save_buffers.resize(n_frames);
         save_futures.resize(n_frames);
+        save_times.resize(n_frames);
+        prefetch_futures.resize(n_frames);
+        prefetch_times.resize(n_frames);
         this->isize = isize >> 2;
         this->dsize = dsize >> 3;
         size_t imain = (size_t)(imain_ratio * this->isize);
@@ -405,7 +428,11 @@ struct DataFrame {
             Parsing::mkdir(mps_dir);
     }
     /** Destructor. */
-    ~DataFrame() { deallocate(); }
+    ~DataFrame() {
+        if (checkpoint_future.valid())
+            checkpoint_future.wait();
+        deallocate();
+    }
     /** Activate one data frame.
      * @param i The index of the data frame to be activated.
      */
@@ -431,6 +458,69 @@ struct DataFrame {
         if (save_buffering && save_futures[i].valid())
             save_futures[i].wait();
         save_buffers[i] = make_pair("", nullptr);
+        reset_prefetch(i);
+    }
+    /** Discard the file being read in background for one data frame.
+     * @param i The index of the data frame.
+     */
+    void reset_prefetch(int i) const {
+        if (prefetch_futures[i].second.valid()) {
+            prefetch_futures[i].second.wait();
+            tprefetch += prefetch_times[i]->second - prefetch_times[i]->first;
+        }
+        prefetch_futures[i] =
+            make_pair("", shared_future<shared_ptr<stringstream>>());
+        prefetch_times[i] = nullptr;
+    }
+    /** Read one scratch file into memory.
+     * @param filename The filename for the data frame.
+     * @param times Output for the start and end time of the reading.
+     * @return The file contents, or nullptr if the file cannot be read.
+     */
+    static shared_ptr<stringstream>
+    buffer_load_data(const string &filename,
+                     const shared_ptr<pair<double, double>> &times) {
+        Timer tx;
+        tx.get_time();
+        times->first = times->second = tx.current;
+        ifstream ifs(filename.c_str(), ios::binary);
+        shared_ptr<stringstream> ss = make_shared<stringstream>();
+        if (!ifs.good())
+            ss = nullptr;
+        else {
+            *ss << ifs.rdbuf();
+            if (ifs.bad())
+                ss = nullptr;
+            ifs.close();
+        }
+        tx.get_time();
+        times->second = tx.current;
+        return ss;
+    }
+    /** Start reading one data frame from disk in a background thread.
+     * The next load_data of the same file in the same data frame
+     * will use the contents read in background.
+     * Nothing is done if the file does not need to be read from disk.
+     * @param i The index of the data frame.
+     * @param filename The filename for the data frame.
+     * @return The future of the reading, or an invalid future if
+     *   nothing is done.
+     */
+    shared_future<shared_ptr<stringstream>>
+    prefetch_data(int i, const string &filename) const {
+        if (present_filenames[i] == filename ||
+            load_buffers[i].first == filename ||
+            save_buffers[i].first == filename)
+            return shared_future<shared_ptr<stringstream>>();
+        if (prefetch_futures[i].first == filename)
+            return prefetch_futures[i].second;
+        reset_prefetch(i);
+        prefetch_times[i] = make_shared<pair<double, double>>(0.0, 0.0);
+        prefetch_futures[i] = make_pair(
+            filename, async(launch::async, &DataFrame::buffer_load_data,
+                            filename, prefetch_times[i])
+                          .share());
+        return prefetch_futures[i].second;
     }
     /** Rename one scratch file.
      * @param old_filename original filename.
@@ -443,6 +533,8 @@ struct DataFrame {
                                 new_filename + "' failed.");
         for (auto &fn : present_filenames)
             fn = "";
+        for (int i = 0; i < n_frames; i++)
+            reset_prefetch(i);
     }
     /** Load one data frame from input stream.
      * @param i The index of the data frame.
@@ -484,6 +576,17 @@ struct DataFrame {
             save_data_to(i, *ss);
             load_buffers[i] = make_pair(present_filenames[i], ss);
         }
+        if (prefetch_futures[i].first == filename) {
+            shared_ptr<stringstream> ss = prefetch_futures[i].second.get();
+            reset_prefetch(i);
+            if (ss != nullptr) {
+                load_data_from(i, *ss);
+                present_filenames[i] = filename;
+                tread += _t.get_time();
+                update_peak_used_memory();
+                return;
+            }
+        }
         if (save_buffers[i].first == filename) {
             if (save_futures[i].valid())
                 save_futures[i].wait();
@@ -528,12 +631,15 @@ struct DataFrame {
      * @param filename The filename for saving data.
      * @param ss The buffer stream.
      * @param tasync Pointer to the time recorder for async saving.
+     * @param times Output for the start and end time of the saving.
      */
-    static void buffer_save_data(const string &filename,
-                                 const shared_ptr<stringstream> &ss,
-                                 double *tasync) {
+    static void
+    buffer_save_data(const string &filename, const shared_ptr<stringstream> &ss,
+                     double *tasync,
+                     const shared_ptr<pair<double, double>> &times) {
         Timer tx;
         tx.get_time();
+        times->first = times->second = tx.current;
         if (Parsing::link_exists(filename))
             Parsing::remove_file(filename);
         ofstream ofs(filename.c_str(), ios::binary);
@@ -548,12 +654,16 @@ struct DataFrame {
                                 "' failed.");
         ofs.close();
         *tasync += tx.get_time();
+        times->second = tx.current;
     }
     /** Save one data frame to disk.
      * @param i The index of the data frame.
      * @param filename The filename for the data frame.
      */
     void save_data(int i, const string &filename) const {
+        for (int j = 0; j < n_frames; j++)
+            if (prefetch_futures[j].first == filename)
+                reset_prefetch(j);
         if (!partition_can_write) {
             update_peak_used_memory();
             present_filenames[i] = filename;
@@ -566,8 +676,9 @@ struct DataFrame {
             shared_ptr<stringstream> ss = make_shared<stringstream>();
             save_data_to(i, *ss);
             save_buffers[i] = make_pair(filename, ss);
+            save_times[i] = make_shared<pair<double, double>>(0.0, 0.0);
             save_futures[i] = async(launch::async, &DataFrame::buffer_save_data,
-                                    filename, ss, &tasync);
+                                    filename, ss, &tasync, save_times[i]);
             twrite += _t.get_time();
             update_peak_used_memory();
             present_filenames[i] = filename;
@@ -588,6 +699,110 @@ struct DataFrame {
         update_peak_used_memory();
         present_filenames[i] = filename;
     }
+    /** Start preparing a checkpoint (restart dir).
+     * Files should be placed in the returned staging dir, using
+     * copy_checkpoint_file for copying scratch files. The previous
+     * checkpoint will be finished first. Files in the checkpoint dir that
+     * are not part of this checkpoint are kept.
+     * @param dir The final checkpoint dir.
+     * @return The staging dir.
+     */
+    string begin_checkpoint(const string &dir) const {
+        wait_checkpoint();
+        string staging = dir + ".TMP";
+        if (Parsing::path_exists(staging))
+            Parsing::remove_dir(staging);
+        Parsing::mkdir(staging);
+        checkpoint_buffer = make_shared<vector<pair<string, string>>>();
+        return staging;
+    }
+    /** Copy one file into the checkpoint being prepared.
+     * The contents are read into memory immediately, so that the source file
+     * can be changed after this call. Outside begin/end_checkpoint,
+     * this is the same as Parsing::copy_file.
+     * @param src The source filename.
+     * @param dest The filename in the staging dir.
+     */
+    void copy_checkpoint_file(const string &src, const string &dest) const {
+        if (checkpoint_buffer == nullptr)
+            Parsing::copy_file(src, dest);
+        else
+            checkpoint_buffer->push_back(
+                make_pair(dest, Parsing::read_file(src)));
+    }
+    /** Write files in the checkpoint buffer into the staging dir, then
+     * move each file of the staging dir into the checkpoint dir.
+     * All files are flushed to disk before the first one is moved, and each
+     * move replaces one file atomically, so that a crash at any time leaves
+     * every file either old or new. The commit files are moved last, in the
+     * given order, so that they are only updated when all other files are.
+     * @param dir The final checkpoint dir.
+     * @param files Snapshot of files to be written in the staging dir.
+     * @param commit_files Names (in the staging dir) of files moved last.
+     * @return The IO time cost.
+     */
+    static double
+    write_checkpoint(const string &dir,
+                     const shared_ptr<vector<pair<string, string>>> &files,
+                     const vector<string> &commit_files) {
+        Timer tx;
+        tx.get_time();
+        string staging = dir + ".TMP";
+        for (auto &f : *files)
+            Parsing::write_file(f.first, f.second);
+        vector<string> names = Parsing::list_dir(staging);
+        for (auto &x : names)
+            if (!Parsing::sync_file(staging + "/" + x))
+                throw runtime_error("DataFrame::write_checkpoint on '" +
+                                    staging + "/" + x + "' failed.");
+        if (!Parsing::path_exists(dir))
+            Parsing::mkdir(dir);
+        vector<string> xnames;
+        for (auto &x : names)
+            if (find(commit_files.begin(), commit_files.end(), x) ==
+                commit_files.end())
+                xnames.push_back(x);
+        for (auto &x : commit_files)
+            if (find(names.begin(), names.end(), x) != names.end())
+                xnames.push_back(x);
+        for (auto &x : xnames)
+            if (!Parsing::rename_file(staging + "/" + x, dir + "/" + x))
+                throw runtime_error("DataFrame::write_checkpoint on '" + dir +
+                                    "/" + x + "' failed.");
+        Parsing::sync_file(dir);
+        Parsing::remove_dir(staging);
+        return tx.get_time();
+    }
+    /** Finish preparing a checkpoint and write it to disk
+     * (in background if checkpoint_async is true).
+     * @param dir The final checkpoint dir.
+     * @param commit_files Names of files written after all other files
+     * (such as the MPS info file).
+     */
+    void end_checkpoint(const string &dir,
+                        const vector<string> &commit_files =
+                            vector<string>()) const {
+        assert(checkpoint_buffer != nullptr);
+        shared_ptr<vector<pair<string, string>>> files = checkpoint_buffer;
+        checkpoint_buffer = nullptr;
+        if (checkpoint_async)
+            checkpoint_future =
+                async(launch::async, &DataFrame::write_checkpoint, dir, files,
+                      commit_files);
+        else
+            tcheckpoint += write_checkpoint(dir, files, commit_files);
+    }
+    /** Wait for the async writing of the last checkpoint.
+     * Its IO time cost is added to tcheckpoint here, so that tcheckpoint
+     * is only accessed in the calling thread.
+     */
+    void wait_checkpoint() const {
+        if (checkpoint_future.valid()) {
+            shared_future<double> ft = checkpoint_future;
+            checkpoint_future = shared_future<double>();
+            tcheckpoint += ft.get();
+        }
+    }
     /** Deallocate the memory allocated for all stacks.
      * Note that this method is automatically invoked at deconstruction.
      */
@@ -600,6 +815,9 @@ struct DataFrame {
             for (const auto &ft : save_futures)
                 if (ft.valid())
                     ft.wait();
+        for (const auto &pf : prefetch_futures)
+            if (pf.second.valid())
+                pf.second.wait();
     }
     /** Return the current used memory in all stacks.
      * @return The current used memory in Bytes.
@@ -1187,6 +1187,57 @@ template <> struct GMatrixFunctions<complex<double>> {
         }
         d_alloc->complex_deallocate(aa.data, aa.size());
     }
+    // Randomized truncated SVD using range finder with power iterations
+    // Halko, Martinsson & Tropp, SIAM Rev. 53, 217 (2011)
+    // k = l.n = r.m is the sampled rank (kept rank plus oversampling)
+    // original matrix is not changed
+    // returns false if the weight of a outside the sampled range is larger
+    // than both eps * |a|^2 and the weight of s beyond the kept rank
+    static bool randomized_svd(const ComplexMatrixRef &a,
+                               const ComplexMatrixRef &l, const MatrixRef &s,
+                               const ComplexMatrixRef &r, MKL_INT rank,
+                               double eps = 1E-12, int n_power_iter = 2) {
+        shared_ptr<VectorAllocator<double>> d_alloc =
+            make_shared<VectorAllocator<double>>();
+        MKL_INT k = l.n;
+        assert(a.m == l.m && a.n == r.n && r.m == k && s.n == k);
+        assert(k <= min(a.m, a.n) && rank <= k);
+        ComplexMatrixRef om(nullptr, a.n, k), y(nullptr, a.m, k),
+            q(nullptr, a.m, k);
+        ComplexMatrixRef z(nullptr, a.n, k), t(nullptr, k, k),
+            b(nullptr, k, a.n);
+        om.data = d_alloc->complex_allocate(om.size());
+        y.data = d_alloc->complex_allocate(y.size());
+        q.data = d_alloc->complex_allocate(q.size());
+        z.data = d_alloc->complex_allocate(z.size());
+        t.data = d_alloc->complex_allocate(t.size());
+        b.data = d_alloc->complex_allocate(b.size());
+        // fixed seed so that results do not depend on thread scheduling
+        RandomMT rand_mt((unsigned)(a.m * 7 + a.n * 13 + k));
+        rand_mt.fill<double>((double *)om.data, om.size() * 2, -1.0, 1.0);
+        multiply(a, false, om, false, y, 1.0, 0.0);
+        qr(y, q, t);
+        for (int it = 0; it < n_power_iter; it++) {
+            multiply(a, 3, q, false, z, 1.0, 0.0);
+            qr(z, om, t);
+            multiply(a, false, om, false, y, 1.0, 0.0);
+            qr(y, q, t);
+        }
+        multiply(q, 3, a, false, b, 1.0, 0.0);
+        double anorm = norm(a), bnorm = norm(b);
+        svd(b, t, s, r);
+        multiply(q, false, t, false, l, 1.0, 0.0);
+        double resid = max(anorm * anorm - bnorm * bnorm, 0.0), tail = 0;
+        for (MKL_INT i = rank; i < k; i++)
+            tail += s.data[i] * s.data[i];
+        d_alloc->complex_deallocate(b.data, b.size());
+        d_alloc->complex_deallocate(t.data, t.size());
+        d_alloc->complex_deallocate(z.data, z.size());
+        d_alloc->complex_deallocate(q.data, q.size());
+        d_alloc->complex_deallocate(y.data, y.size());
+        d_alloc->complex_deallocate(om.data, om.size());
+        return resid <= max(eps * anorm * anorm, tail);
+    }
     // LQ factorization
     static void lq(const ComplexMatrixRef &a, const ComplexMatrixRef &l,
                    const ComplexMatrixRef &q) {
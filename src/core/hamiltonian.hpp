@@ -23,7 +23,9 @@
 
 #include "delayed_sparse_matrix.hpp"
 #include "expr.hpp"
+#include "integral.hpp"
 #include "operator_functions.hpp"
+#include "parallel_rule.hpp"
 #include "sparse_matrix.hpp"
 #include "symbolic.hpp"
 #include <algorithm>
@@ -119,6 +121,8 @@ template <typename S, typename FL> struct Hamiltonian {
     // For storing pre-computed CG factors for sparse matrix functions
     shared_ptr<OperatorFunctions<S, FL>> opf = nullptr;
     DelayedOpNames delayed = DelayedOpNames::None;
+    // Node-shared storage of site operators (nullptr if not shared)
+    shared_ptr<ParallelSharedMemory> site_ops_shm = nullptr;
     static vector<typename S::pg_t>
     combine_orb_sym(const vector<uint8_t> &orb_sym, const vector<int> &k_sym,
                     int k_mod) {
@@ -258,6 +262,123 @@ template <typename S, typename FL> struct Hamiltonian {
         else
             return p->second;
     }
+    // Upper bound of the norm of the Hamiltonian terms dropped by
+    // screening integrals below cutoff, which bounds the error in the energy
+    // n_spin = 2: spin-orbital integrals t(s, i, j) and v(sl, sr, i, j, k, l)
+    // n_spin = 1: t(i, j) and v(i, j, k, l), each counted tf and vf times
+    static typename GMatrix<FL>::FP
+    screening_error_bound(const shared_ptr<FCIDUMP<FL>> &fcidump, FL mu,
+                          typename GMatrix<FL>::FP cutoff, int n_spin,
+                          typename GMatrix<FL>::FP tf,
+                          typename GMatrix<FL>::FP vf) {
+        typedef typename GMatrix<FL>::FP FP;
+        if (cutoff == (FP)0.0)
+            return 0;
+        const int n = (int)fcidump->n_sites();
+        FP r = 0;
+        int ntg = threading->activate_global();
+#pragma omp parallel for schedule(dynamic) reduction(+ : r) num_threads(ntg)
+        for (int i = 0; i < n; i++) {
+            for (int s = 0; s < n_spin; s++)
+                for (int j = 0; j < n; j++) {
+                    FL t = n_spin == 1 ? fcidump->t(i, j)
+                                       : fcidump->t((uint8_t)s, i, j);
+                    FP x = abs(i == j ? t - mu : t);
+                    if (x < cutoff)
+                        r += tf * x;
+                }
+            for (int sl = 0; sl < n_spin; sl++)
+                for (int sr = 0; sr < n_spin; sr++)
+                    for (int j = 0; j < n; j++)
+                        for (int k = 0; k < n; k++)
+                            for (int l = 0; l < n; l++) {
+                                FP x = abs(n_spin == 1
+                                               ? fcidump->v(i, j, k, l)
+                                               : fcidump->v((uint8_t)sl,
+                                                            (uint8_t)sr, i,
+                                                            j, k, l));
+                                if (x < cutoff)
+                                    r += vf * x;
+                            }
+        }
+        threading->activate_normal();
+        return r;
+    }
+    // Keep only one copy of the integrals in each node
+    // All procs must hold integrals with the same layout
+    // Should be called after symmetrize / reorder / rotate
+    static void
+    node_share_integrals(const shared_ptr<ParallelCommunicator<S>> &comm,
+                         const shared_ptr<FCIDUMP<FL>> &fcidump) {
+        if (comm->node_size() == 1 || fcidump == nullptr ||
+            fcidump->total_memory == 0)
+            return;
+        Timer t;
+        t.get_time();
+        shared_ptr<ParallelSharedMemory> shm =
+            comm->shared_allocate(sizeof(FL) * fcidump->total_memory);
+        if (shm->writable)
+            memcpy(shm->data, fcidump->data, shm->size);
+        shm->sync();
+        fcidump->rebind_data((FL *)shm->data, shm, false);
+        comm->tcomm += t.get_time();
+    }
+    // Keep only one copy of the site operators in each node
+    // mats: matrices owning the data; views: matrices pointing into
+    // the data of mats, which are rebound to the shared copy
+    void node_share_site_ops(
+        const shared_ptr<ParallelCommunicator<S>> &comm,
+        const vector<shared_ptr<SparseMatrix<S, FL>>> &mats,
+        const vector<shared_ptr<SparseMatrix<S, FL>>> &views) {
+        vector<pair<size_t, size_t>> ranges(mats.size());
+        for (size_t i = 0; i < mats.size(); i++)
+            ranges[i] = make_pair((size_t)mats[i]->data,
+                                  (size_t)(mats[i]->data +
+                                           mats[i]->total_memory));
+        vector<size_t> view_idx(views.size(), mats.size());
+        vector<size_t> view_off(views.size(), 0);
+        for (size_t j = 0; j < views.size(); j++)
+            for (size_t i = 0; i < mats.size(); i++)
+                if ((size_t)views[j]->data >= ranges[i].first &&
+                    (size_t)views[j]->data < ranges[i].second) {
+                    view_idx[j] = i;
+                    view_off[j] = views[j]->data - (FL *)ranges[i].first;
+                    break;
+                }
+        shared_ptr<ParallelSharedMemory> shm = comm->node_share(mats);
+        if (shm == nullptr)
+            return;
+        for (size_t j = 0; j < views.size(); j++)
+            if (view_idx[j] != mats.size())
+                views[j]->data = mats[view_idx[j]]->data + view_off[j];
+        site_ops_shm = shm;
+    }
+    // Keep only one copy of the primitive site operators and integrals in
+    // each node; site_norm_ops point into the data of op_prims
+    template <typename PG>
+    void node_share_op_prims(
+        const shared_ptr<ParallelCommunicator<S>> &comm,
+        const unordered_map<
+            PG, vector<unordered_map<OpNames, shared_ptr<SparseMatrix<S, FL>>>>>
+            &op_prims,
+        const vector<unordered_map<shared_ptr<OpExpr<S>>,
+                                   shared_ptr<SparseMatrix<S, FL>>>>
+            &site_norm_ops,
+        const shared_ptr<FCIDUMP<FL>> &fcidump) {
+        vector<shared_ptr<SparseMatrix<S, FL>>> mats, views;
+        for (auto &op_prim : op_prims)
+            for (auto &ops_map : op_prim.second)
+                for (auto &p : ops_map)
+                    mats.push_back(p.second);
+        for (auto &ops : site_norm_ops)
+            for (auto &p : ops)
+                views.push_back(p.second);
+        node_share_site_ops(comm, mats, views);
+        node_share_integrals(comm, fcidump);
+    }
+    // Keep only one copy of integrals and site operators in each node
+    // Collective over all procs in comm
+    virtual void node_share(const shared_ptr<ParallelCommunicator<S>> &comm) {}
     virtual void deallocate() {}
 };
 
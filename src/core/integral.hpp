@@ -32,11 +32,28 @@
 #include <map>
 #include <memory>
 #include <vector>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
 
 using namespace std;
 
 namespace block2 {
 
+// Header of binary integral file (followed by params text, const_e,
+// total_memory, padding to fd_binary_align bytes, and integral arrays)
+struct FCIDUMPBinaryHeader {
+    char magic[8];
+    uint32_t version, fl_size;
+    uint64_t params_len;
+    FCIDUMPBinaryHeader() : version(1), fl_size(0), params_len(0) {
+        memcpy(magic, "B2FCIDMP", 8);
+    }
+    bool check_magic() const { return memcmp(magic, "B2FCIDMP", 8) == 0; }
+};
+
+const size_t fd_binary_align = 64;
+
 inline void fd_write_line(ostream &os, double x, uint16_t i = 0, uint16_t j = 0,
                           uint16_t k = 0, uint16_t l = 0) {
     os << fixed << setprecision(16);
@@ -76,6 +93,149 @@ inline void fd_read_line(array<uint16_t, 4> &idx, complex<double> &d,
         assert(false);
 }
 
+// Tokenize one line of FCIDUMP in place (text after "!" is ignored)
+// Returns the number of tokens (at most 8) and sets p to the next line
+inline int fd_tokenize_line(const char *&p, const char *tok[8]) {
+    int ntok = 0;
+    for (;;) {
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == ',')
+            p++;
+        if (*p == '!')
+            while (*p != '\n')
+                p++;
+        if (*p == '\n') {
+            p++;
+            return ntok;
+        }
+        if (ntok < 8)
+            tok[ntok++] = p;
+        while (*p != ' ' && *p != '\t' && *p != '\r' && *p != ',' &&
+               *p != '!' && *p != '\n')
+            p++;
+    }
+}
+
+// Integer index in FCIDUMP (non-negative, same result as atoi)
+inline uint16_t fd_parse_index(const char *p) {
+    uint32_t r = 0;
+    if (*p == '+')
+        p++;
+    for (; *p >= '0' && *p <= '9'; p++)
+        r = r * 10 + (*p - '0');
+    return (uint16_t)r;
+}
+
+// Parse one line of FCIDUMP in place (without creating strings)
+// Returns false for empty or comment lines; sets p to the next line
+inline bool fd_parse_line(const char *&p, array<uint16_t, 4> &idx, double &d) {
+    const char *tok[8];
+    int ntok = fd_tokenize_line(p, tok);
+    if (ntok == 0)
+        return false;
+    assert(ntok == 5);
+    idx = array<uint16_t, 4>{fd_parse_index(tok[1]), fd_parse_index(tok[2]),
+                             fd_parse_index(tok[3]), fd_parse_index(tok[4])};
+    d = strtod(tok[0], nullptr);
+    return true;
+}
+
+inline bool fd_parse_line(const char *&p, array<uint16_t, 4> &idx,
+                          complex<double> &d) {
+    const char *tok[8];
+    int ntok = fd_tokenize_line(p, tok);
+    if (ntok == 0)
+        return false;
+    assert(ntok == 5 || ntok == 6);
+    const int k = ntok - 4;
+    idx = array<uint16_t, 4>{fd_parse_index(tok[k]), fd_parse_index(tok[k + 1]),
+                             fd_parse_index(tok[k + 2]),
+                             fd_parse_index(tok[k + 3])};
+    d = ntok == 6
+            ? complex<double>(strtod(tok[0], nullptr), strtod(tok[1], nullptr))
+            : (complex<double>)strtod(tok[0], nullptr);
+    return true;
+}
+
+// Split [p, end) into n ranges at line boundaries
+// end[-1] must be a newline character
+inline vector<const char *> fd_split_lines(const char *p, const char *end,
+                                           int n) {
+    vector<const char *> r(n + 1, end);
+    r[0] = p;
+    for (int i = 1; i < n; i++) {
+        const char *q = max(p + (end - p) * i / n, r[i - 1]);
+        if (q != p && q != end && q[-1] != '\n')
+            q = (const char *)memchr(q, '\n', end - q) + 1;
+        r[i] = q;
+    }
+    return r;
+}
+
+// Parse FCIDUMP integral lines in [p, end) in place with ntg threads
+// end[-1] must be a newline character
+// ip: number of separator lines (all indices zero) before p
+//     (updated on return; only computed when count_sep is true)
+// f(ir, idx, val, ip) is called for every element, where ir is the range
+// index (each range is parsed by one thread in file order) and ip counts
+// separator lines up to and including this line
+template <typename FL, typename F>
+inline void fd_parse_lines(const char *p, const char *end, int &ip,
+                           bool count_sep, int ntg, F f) {
+    vector<const char *> r = fd_split_lines(p, end, ntg);
+    vector<int> ips(ntg + 1, 0);
+    if (count_sep) {
+#pragma omp parallel for schedule(static, 1) num_threads(ntg)
+        for (int ir = 0; ir < ntg; ir++) {
+            array<uint16_t, 4> idx;
+            FL val;
+            for (const char *q = r[ir]; q < r[ir + 1];)
+                if (fd_parse_line(q, idx, val) &&
+                    idx[0] + idx[1] + idx[2] + idx[3] == 0)
+                    ips[ir + 1]++;
+        }
+    }
+    ips[0] = ip;
+    for (int ir = 0; ir < ntg; ir++)
+        ips[ir + 1] += ips[ir];
+#pragma omp parallel for schedule(static, 1) num_threads(ntg)
+    for (int ir = 0; ir < ntg; ir++) {
+        array<uint16_t, 4> idx;
+        FL val;
+        int jp = ips[ir];
+        for (const char *q = r[ir]; q < r[ir + 1];)
+            if (fd_parse_line(q, idx, val)) {
+                if (count_sep && idx[0] + idx[1] + idx[2] + idx[3] == 0)
+                    jp++;
+                f(ir, idx, val, jp);
+            }
+    }
+    ip = ips[ntg];
+}
+
+// Read the next chunk of FCIDUMP integral lines from a stream into buf
+// buf[0, len) holds a partial line left from the previous chunk
+// Returns the end of complete lines in buf (0 at the end of stream)
+// len is updated to include the newly read bytes
+inline size_t fd_read_chunk(istream &is, vector<char> &buf, size_t &len,
+                            size_t chunk_size) {
+    for (;;) {
+        if (buf.size() < len + chunk_size + 1)
+            buf.resize(len + chunk_size + 1);
+        is.read(buf.data() + len, chunk_size);
+        size_t got = (size_t)is.gcount();
+        len += got;
+        bool eof = got < chunk_size;
+        if (eof && len != 0 && buf[len - 1] != '\n')
+            buf[len++] = '\n';
+        size_t cut = len;
+        while (cut != 0 && buf[cut - 1] != '\n')
+            cut--;
+        // otherwise the line is longer than chunk_size
+        if (cut != 0 || eof)
+            return cut;
+    }
+}
+
 // Symmetric/general 2D array for storage of one-electron integrals
 template <typename FL> struct TInt {
     // Number of orbitals
@@ -170,12 +330,17 @@ template <typename FL> struct V1Int {
     }
     void reorder(const V1Int &other, const vector<uint16_t> &ord) {
         assert(n == other.n);
-        for (uint32_t i = 0; i < n; i++)
-            for (uint32_t j = 0; j < n; j++)
-                for (uint32_t k = 0; k < n; k++)
-                    for (uint32_t l = 0; l < n; l++)
-                        (*this)(i, j, k, l) =
-                            other(ord[i], ord[j], ord[k], ord[l]);
+        int ntg = threading->activate_global();
+#pragma omp parallel for schedule(static) num_threads(ntg)
+        for (int64_t ij = 0; ij < (int64_t)n * n; ij++) {
+            const uint32_t i = (uint32_t)(ij / n), j = (uint32_t)(ij % n);
+            FL *dst = data + (size_t)ij * n * n;
+            for (uint32_t k = 0; k < n; k++)
+                for (uint32_t l = 0; l < n; l++)
+                    dst[(size_t)k * n + l] =
+                        other(ord[i], ord[j], ord[k], ord[l]);
+        }
+        threading->activate_normal();
     }
     void rotate(const V1Int &other, const vector<FL> &rot_mat) {
         assert(n == other.n);
@@ -271,6 +436,85 @@ template <typename FL> struct V1Int {
     }
 };
 
+// Four-index transformation of two-electron integrals in packed storage
+// (V4Int or V8Int), done in blocks of the first index i without any
+// n^4 intermediate arrays
+// r(ijkl) = sum_pqrs conj(U_pi) U_qj conj(U_rk) U_sl x(pqrs)
+// where U = rot_mat; only elements with i >= j, k >= l (and ij >= kl
+// if eight_fold) are computed
+template <typename FL, typename VI>
+inline void fd_rotate_packed(VI &v, const VI &x, const vector<FL> &rot_mat,
+                             bool eight_fold) {
+    assert(v.n == x.n);
+    const int n = (int)x.n;
+    const size_t m = x.m;
+    const FL *u = rot_mat.data();
+    // half-transformed integrals for i in block: h[ib, j; rs]
+    const int b = min(n, max(8, n / 16));
+    vector<FL> h((size_t)b * n * m);
+    int ntg = threading->activate_global();
+    for (int i0 = 0; i0 < n; i0 += b) {
+        const int bi = min(b, n - i0);
+#pragma omp parallel num_threads(ntg)
+        {
+            vector<FL> w((size_t)n * n), t((size_t)n * n);
+            // first half: (pq|rs) -> (ij|rs) for i in block and j <= i
+#pragma omp for schedule(dynamic)
+            for (int r = 0; r < n; r++)
+                for (int s = 0; s <= r; s++) {
+                    const size_t rs = ((size_t)r * (r + 1) >> 1) + s;
+                    for (int p = 0; p < n; p++)
+                        for (int q = 0; q < n; q++)
+                            w[(size_t)p * n + q] = x(p, q, r, s);
+                    fill(t.begin(), t.begin() + (size_t)bi * n, (FL)0.0);
+                    for (int p = 0; p < n; p++)
+                        for (int ib = 0; ib < bi; ib++) {
+                            const FL c = xconj(u[(size_t)p * n + i0 + ib]);
+                            for (int q = 0; q < n; q++)
+                                t[(size_t)ib * n + q] +=
+                                    c * w[(size_t)p * n + q];
+                        }
+                    for (int ib = 0; ib < bi; ib++)
+                        for (int j = 0; j <= i0 + ib; j++) {
+                            FL y = 0;
+                            for (int q = 0; q < n; q++)
+                                y += t[(size_t)ib * n + q] *
+                                     u[(size_t)q * n + j];
+                            h[((size_t)ib * n + j) * m + rs] = y;
+                        }
+                }
+            // second half: (ij|rs) -> (ij|kl)
+#pragma omp for schedule(dynamic)
+            for (int ibj = 0; ibj < bi * n; ibj++) {
+                const int ib = ibj / n, i = i0 + ib, j = ibj % n;
+                if (j > i)
+                    continue;
+                const FL *hr = h.data() + ((size_t)ib * n + j) * m;
+                for (int r = 0; r < n; r++)
+                    for (int s = 0; s <= r; s++)
+                        w[(size_t)r * n + s] = w[(size_t)s * n + r] =
+                            hr[((size_t)r * (r + 1) >> 1) + s];
+                const int kmax = eight_fold ? i : n - 1;
+                fill(t.begin(), t.begin() + (size_t)(kmax + 1) * n, (FL)0.0);
+                for (int r = 0; r < n; r++)
+                    for (int k = 0; k <= kmax; k++) {
+                        const FL c = xconj(u[(size_t)r * n + k]);
+                        for (int s = 0; s < n; s++)
+                            t[(size_t)k * n + s] += c * w[(size_t)r * n + s];
+                    }
+                for (int k = 0; k <= kmax; k++)
+                    for (int l = 0; l <= (eight_fold && k == i ? j : k); l++) {
+                        FL y = 0;
+                        for (int s = 0; s < n; s++)
+                            y += t[(size_t)k * n + s] * u[(size_t)s * n + l];
+                        v(i, j, k, l) = y;
+                    }
+            }
+        }
+    }
+    threading->activate_normal();
+}
+
 // 4D array with 4-fold symmetry for storage of two-electron integrals
 // [ijkl] = [jikl] = [jilk] = [ijlk]
 template <typename FL> struct V4Int {
@@ -296,96 +540,23 @@ template <typename FL> struct V4Int {
     }
     void reorder(const V4Int &other, const vector<uint16_t> &ord) {
         assert(n == other.n);
-        for (uint32_t i = 0; i < n; i++)
-            for (uint32_t j = 0; j <= i; j++)
-                for (uint32_t k = 0; k < n; k++)
-                    for (uint32_t l = 0; l <= k; l++)
-                        (*this)(i, j, k, l) =
-                            other(ord[i], ord[j], ord[k], ord[l]);
-    }
-    void rotate(const V4Int &other, const vector<FL> &rot_mat) {
-        assert(n == other.n);
-        vector<FL> tmp((size_t)n * n * n * n), tmp2((size_t)n * n * n * n);
-#ifdef _MSC_VER
-        assert((size_t)n * n * n * n <= (size_t)numeric_limits<int>::max());
-#endif
+        // pair index in other for each pair in this
+        vector<size_t> pmap(m);
+        for (uint32_t i = 0, ij = 0; i < n; i++)
+            for (uint32_t j = 0; j <= i; j++, ij++)
+                pmap[ij] = other.find_index(ord[i], ord[j]);
         int ntg = threading->activate_global();
-#pragma omp parallel num_threads(ntg)
-        {
-#ifdef _MSC_VER
-#pragma omp for schedule(dynamic)
-            for (int ijkl = 0; ijkl < n * n * n * n; ijkl++) {
-                int i = ijkl / (n * n * n), j = (ijkl / (n * n)) % n,
-                    k = (ijkl / n) % n, l = ijkl % n;
-#else
-#pragma omp for schedule(dynamic) collapse(4)
-            for (int i = 0; i < n; i++)
-                for (int j = 0; j < n; j++)
-                    for (int k = 0; k < n; k++)
-                        for (int l = 0; l < n; l++) {
-#endif
-                FL x = 0;
-                for (int q = 0; q < n; q++)
-                    x += other(i, j, k, q) * rot_mat[q * n + l];
-                tmp[(((size_t)i * n + j) * n + k) * n + l] = x;
-            }
-#ifdef _MSC_VER
-#pragma omp for schedule(dynamic)
-            for (int ijkl = 0; ijkl < n * n * n * n; ijkl++) {
-                int i = ijkl / (n * n * n), j = (ijkl / (n * n)) % n,
-                    k = (ijkl / n) % n, l = ijkl % n;
-#else
-#pragma omp for schedule(dynamic) collapse(4)
-            for (int i = 0; i < n; i++)
-                for (int j = 0; j < n; j++)
-                    for (int k = 0; k < n; k++)
-                        for (int l = 0; l < n; l++) {
-#endif
-                FL x = 0;
-                for (int q = 0; q < n; q++)
-                    x += tmp[(((size_t)i * n + j) * n + q) * n + l] *
-                         xconj(rot_mat[q * n + k]);
-                tmp2[(((size_t)i * n + j) * n + k) * n + l] = x;
-            }
-#ifdef _MSC_VER
-#pragma omp for schedule(dynamic)
-            for (int ijkl = 0; ijkl < n * n * n * n; ijkl++) {
-                int i = ijkl / (n * n * n), j = (ijkl / (n * n)) % n,
-                    k = (ijkl / n) % n, l = ijkl % n;
-#else
-#pragma omp for schedule(dynamic) collapse(4)
-            for (int i = 0; i < n; i++)
-                for (int j = 0; j < n; j++)
-                    for (int k = 0; k < n; k++)
-                        for (int l = 0; l < n; l++) {
-#endif
-                FL x = 0;
-                for (int q = 0; q < n; q++)
-                    x += tmp2[(((size_t)i * n + q) * n + k) * n + l] *
-                         rot_mat[q * n + j];
-                tmp[(((size_t)i * n + j) * n + k) * n + l] = x;
-            }
-#ifdef _MSC_VER
-#pragma omp for schedule(dynamic)
-            for (int ijkl = 0; ijkl < n * n * n * n; ijkl++) {
-                int i = ijkl / (n * n * n), j = (ijkl / (n * n)) % n,
-                    k = (ijkl / n) % n, l = ijkl % n;
-#else
-#pragma omp for schedule(dynamic) collapse(4)
-            for (int i = 0; i < n; i++)
-                for (int j = 0; j < n; j++)
-                    for (int k = 0; k < n; k++)
-                        for (int l = 0; l < n; l++) {
-                            if (j > i || l > k)
-                                continue;
-#endif
-                FL x = 0;
-                for (int q = 0; q < n; q++)
-                    x += tmp[(((size_t)q * n + j) * n + k) * n + l] *
-                         xconj(rot_mat[q * n + i]);
-                (*this)(i, j, k, l) = x;
-            }
+#pragma omp parallel for schedule(static) num_threads(ntg)
+        for (int64_t ij = 0; ij < (int64_t)m; ij++) {
+            const FL *src = other.data + pmap[ij] * m;
+            FL *dst = data + (size_t)ij * m;
+            for (uint32_t kl = 0; kl < m; kl++)
+                dst[kl] = src[pmap[kl]];
         }
+        threading->activate_normal();
+    }
+    void rotate(const V4Int &other, const vector<FL> &rot_mat) {
+        fd_rotate_packed(*this, other, rot_mat, false);
     }
     friend ostream &operator<<(ostream &os, V4Int x) {
         os << fixed << setprecision(16);
@@ -425,98 +596,27 @@ template <typename FL> struct V8Int {
     }
     void reorder(const V8Int &other, const vector<uint16_t> &ord) {
         assert(n == other.n);
+        // pair index in other for each pair in this
+        vector<size_t> pmap(m);
         for (uint32_t i = 0, ij = 0; i < n; i++)
             for (uint32_t j = 0; j <= i; j++, ij++)
-                for (uint32_t k = 0, kl = 0; k <= i; k++)
-                    for (uint32_t l = 0; l <= k; l++, kl++)
-                        if (ij >= kl)
-                            (*this)(i, j, k, l) =
-                                other(ord[i], ord[j], ord[k], ord[l]);
-    }
-    void rotate(const V8Int &other, const vector<FL> &rot_mat) {
-        assert(n == other.n);
-        vector<FL> tmp((size_t)n * n * n * n), tmp2((size_t)n * n * n * n);
-#ifdef _MSC_VER
-        assert((size_t)n * n * n * n <= (size_t)numeric_limits<int>::max());
-#endif
+                pmap[ij] = other.find_index(ord[i], ord[j]);
         int ntg = threading->activate_global();
-#pragma omp parallel num_threads(ntg)
-        {
-#ifdef _MSC_VER
-#pragma omp for schedule(dynamic)
-            for (int ijkl = 0; ijkl < n * n * n * n; ijkl++) {
-                int i = ijkl / (n * n * n), j = (ijkl / (n * n)) % n,
-                    k = (ijkl / n) % n, l = ijkl % n;
-#else
-#pragma omp for schedule(dynamic) collapse(4)
-            for (int i = 0; i < n; i++)
-                for (int j = 0; j < n; j++)
-                    for (int k = 0; k < n; k++)
-                        for (int l = 0; l < n; l++) {
-#endif
-                FL x = 0;
-                for (int q = 0; q < n; q++)
-                    x += other(i, j, k, q) * rot_mat[q * n + l];
-                tmp[(((size_t)i * n + j) * n + k) * n + l] = x;
-            }
-#ifdef _MSC_VER
-#pragma omp for schedule(dynamic)
-            for (int ijkl = 0; ijkl < n * n * n * n; ijkl++) {
-                int i = ijkl / (n * n * n), j = (ijkl / (n * n)) % n,
-                    k = (ijkl / n) % n, l = ijkl % n;
-#else
-#pragma omp for schedule(dynamic) collapse(4)
-            for (int i = 0; i < n; i++)
-                for (int j = 0; j < n; j++)
-                    for (int k = 0; k < n; k++)
-                        for (int l = 0; l < n; l++) {
-#endif
-                FL x = 0;
-                for (int q = 0; q < n; q++)
-                    x += tmp[(((size_t)i * n + j) * n + q) * n + l] *
-                         xconj(rot_mat[q * n + k]);
-                tmp2[(((size_t)i * n + j) * n + k) * n + l] = x;
-            }
-#ifdef _MSC_VER
-#pragma omp for schedule(dynamic)
-            for (int ijkl = 0; ijkl < n * n * n * n; ijkl++) {
-                int i = ijkl / (n * n * n), j = (ijkl / (n * n)) % n,
-                    k = (ijkl / n) % n, l = ijkl % n;
-#else
-#pragma omp for schedule(dynamic) collapse(4)
-            for (int i = 0; i < n; i++)
-                for (int j = 0; j < n; j++)
-                    for (int k = 0; k < n; k++)
-                        for (int l = 0; l < n; l++) {
-#endif
-                FL x = 0;
-                for (int q = 0; q < n; q++)
-                    x += tmp2[(((size_t)i * n + q) * n + k) * n + l] *
-                         rot_mat[q * n + j];
-                tmp[(((size_t)i * n + j) * n + k) * n + l] = x;
-            }
-#ifdef _MSC_VER
-#pragma omp for schedule(dynamic)
-            for (int ijkl = 0; ijkl < n * n * n * n; ijkl++) {
-                int i = ijkl / (n * n * n), j = (ijkl / (n * n)) % n,
-                    k = (ijkl / n) % n, l = ijkl % n;
-#else
-#pragma omp for schedule(dynamic) collapse(4)
-            for (int i = 0; i < n; i++)
-                for (int j = 0; j < n; j++)
-                    for (int k = 0; k < n; k++)
-                        for (int l = 0; l < n; l++) {
-                            if (j > i || l > k ||
-                                (k * (k + 1) >> 1) + l > (i * (i + 1) >> 1) + j)
-                                continue;
-#endif
-                FL x = 0;
-                for (int q = 0; q < n; q++)
-                    x += tmp[(((size_t)q * n + j) * n + k) * n + l] *
-                         xconj(rot_mat[q * n + i]);
-                (*this)(i, j, k, l) = x;
+#pragma omp parallel for schedule(dynamic, 64) num_threads(ntg)
+        for (int64_t ij = 0; ij < (int64_t)m; ij++) {
+            const size_t p = pmap[ij];
+            // elements (pq) with q <= p are contiguous in other
+            const FL *src = other.data + (p * (p + 1) >> 1);
+            FL *dst = data + ((size_t)ij * (ij + 1) >> 1);
+            for (size_t kl = 0; kl <= (size_t)ij; kl++) {
+                const size_t q = pmap[kl];
+                dst[kl] = q <= p ? src[q] : other.data[(q * (q + 1) >> 1) + p];
             }
         }
+        threading->activate_normal();
+    }
+    void rotate(const V8Int &other, const vector<FL> &rot_mat) {
+        fd_rotate_packed(*this, other, rot_mat, true);
     }
     friend ostream &operator<<(ostream &os, V8Int x) {
         os << fixed << setprecision(16);
@@ -535,6 +635,9 @@ template <typename FL> struct V8Int {
 template <typename FL> struct FCIDUMP {
     typedef decltype(abs((FL)0.0)) FP;
     shared_ptr<vector<FL>> vdata;
+    // Owner of external integral storage (e.g. node-shared memory)
+    // When set, data is not owned by vdata
+    shared_ptr<void> ext_data = nullptr;
     map<string, string> params;
     vector<TInt<FL>> ts;
     vector<V8Int<FL>> vs;
@@ -544,6 +647,8 @@ template <typename FL> struct FCIDUMP {
     FL *data;
     size_t total_memory;
     bool uhf, general;
+    // Size of the blocks of integral lines parsed in parallel by read
+    size_t read_chunk_size = (size_t)1 << 26;
     FCIDUMP() : const_e(0.0), uhf(false), total_memory(0), vdata(nullptr) {}
     // Initialize integrals: U(1) case
     // Two-electron integrals can be three general rank-4 arrays
@@ -734,32 +839,17 @@ template <typename FL> struct FCIDUMP {
             throw runtime_error("FCIDUMP::write on '" + filename + "' failed.");
         ofs.close();
     }
-    // Parsing a FCIDUMP file
-    virtual void read(const string &filename) {
-        params.clear();
-        ts.clear();
-        vs.clear();
-        vabs.clear();
-        const_e = 0.0;
-        ifstream ifs(filename.c_str());
-        if (!ifs.good())
-            throw runtime_error("FCIDUMP::read on '" + filename + "' failed.");
-        vector<string> lines = Parsing::readlines(&ifs);
-        if (ifs.bad())
-            throw runtime_error("FCIDUMP::read on '" + filename + "' failed.");
-        ifs.close();
+    // Parsing the namelist (header) lines of a FCIDUMP file
+    // lines: header lines before "&END" or "/"
+    void read_params(const vector<string> &lines) {
         vector<string> pars;
-        size_t il = 0;
-        for (; il < lines.size(); il++) {
-            string l(Parsing::lower(lines[il]));
+        for (size_t il = 0; il < lines.size(); il++) {
+            string l(lines[il]);
+            Parsing::lower(l);
             if (l.find("&fci") != string::npos)
                 l.replace(l.find("&fci"), 4, "");
-            if (l.find("/") != string::npos || l.find("&end") != string::npos)
-                break;
-            else
-                pars.push_back(l);
+            pars.push_back(l);
         }
-        il++;
         string par = Parsing::join(pars.begin(), pars.end(), ",");
         for (size_t ip = 0; ip < par.length(); ip++)
             if (par[ip] == ' ')
@@ -779,131 +869,269 @@ template <typename FL> struct FCIDUMP {
                                         : params[p_key] + "," + cc;
             }
         }
-        size_t int_sz = lines.size() > il ? lines.size() - il : 0;
-        vector<array<uint16_t, 4>> int_idx(int_sz);
-        vector<FL> int_val(int_sz);
-        int ntg = threading->activate_global();
-#pragma omp parallel for schedule(static) num_threads(ntg)
-        for (int64_t ill = 0; ill < (int64_t)int_sz; ill++) {
-            string ll = Parsing::trim(lines[il + ill]);
-            if (ll.length() == 0 || ll[0] == '!') {
-                int_idx[ill][0] = numeric_limits<uint16_t>::max();
-                continue;
-            }
-            vector<string> ls = Parsing::split(ll, " ", true);
-            fd_read_line(int_idx[ill], int_val[ill], ls);
+    }
+    // Parsing the namelist (header) lines of a FCIDUMP file from a stream
+    // The stream is left at the first integral line
+    void read_params(istream &is) {
+        vector<string> lines;
+        string line;
+        while (getline(is, line)) {
+            if (line.find("!") != string::npos)
+                line = line.substr(0, line.find("!"));
+            line.erase(remove(line.begin(), line.end(), '\r'), line.end());
+            if (is_params_end(line))
+                break;
+            lines.push_back(line);
         }
-        threading->activate_normal();
+        read_params(lines);
+    }
+    // Whether a line ends the namelist (header) of a FCIDUMP file
+    static bool is_params_end(const string &line) {
+        string l(line);
+        Parsing::lower(l);
+        if (l.find("&fci") != string::npos)
+            l.replace(l.find("&fci"), 4, "");
+        return l.find("/") != string::npos || l.find("&end") != string::npos;
+    }
+    // Create integral arrays according to params
+    // If allocate is false, only the layout (and total_memory) is set
+    void init_integrals(bool allocate = true) {
+        ts.clear(), vs.clear(), vabs.clear(), vgs.clear();
         uint16_t n = (uint16_t)Parsing::to_int(params["norb"]);
         uhf = params.count("iuhf") != 0 && Parsing::to_int(params["iuhf"]) == 1;
         general = params.count("igeneral") != 0 &&
                   Parsing::to_int(params["igeneral"]) == 1;
-        if (!uhf) {
-            ts.push_back(TInt<FL>(n));
-            ts[0].general = params.count("itgeneral") != 0 &&
-                            Parsing::to_int(params["itgeneral"]) == 1;
-            if (!general) {
+        bool tgeneral = params.count("itgeneral") != 0 &&
+                        Parsing::to_int(params["itgeneral"]) == 1;
+        for (int i = 0; i < (uhf ? 2 : 1); i++)
+            ts.push_back(TInt<FL>(n, tgeneral));
+        if (!general) {
+            for (int i = 0; i < (uhf ? 2 : 1); i++)
                 vs.push_back(V8Int<FL>(n));
-                total_memory = ts[0].size() + vs[0].size();
-                vdata = make_shared<vector<FL>>(total_memory);
-                data = vdata->data();
-                ts[0].data = data;
-                vs[0].data = data + ts[0].size();
-                ts[0].clear();
-                vs[0].clear();
-            } else {
+            if (uhf)
+                vabs.push_back(V4Int<FL>(n));
+        } else
+            for (int i = 0; i < (uhf ? 3 : 1); i++)
                 vgs.push_back(V1Int<FL>(n));
-                total_memory = ts[0].size() + vgs[0].size();
-                vdata = make_shared<vector<FL>>(total_memory);
-                data = vdata->data();
-                ts[0].data = data;
-                vgs[0].data = data + ts[0].size();
-                ts[0].clear();
-                vgs[0].clear();
-            }
-            for (size_t i = 0; i < int_val.size(); i++) {
-                if (int_idx[i][0] == numeric_limits<uint16_t>::max())
-                    continue;
-                if (int_idx[i][0] + int_idx[i][1] + int_idx[i][2] +
-                        int_idx[i][3] ==
-                    0)
-                    const_e = int_val[i];
-                else if (int_idx[i][2] + int_idx[i][3] == 0)
-                    ts[0](int_idx[i][0] - 1, int_idx[i][1] - 1) = int_val[i];
-                else if (!general)
-                    vs[0](int_idx[i][0] - 1, int_idx[i][1] - 1,
-                          int_idx[i][2] - 1, int_idx[i][3] - 1) = int_val[i];
-                else
-                    vgs[0](int_idx[i][0] - 1, int_idx[i][1] - 1,
-                           int_idx[i][2] - 1, int_idx[i][3] - 1) = int_val[i];
-            }
+        total_memory = 0;
+        for (auto &t : ts)
+            total_memory += t.size();
+        for (auto &v : vs)
+            total_memory += v.size();
+        for (auto &v : vabs)
+            total_memory += v.size();
+        for (auto &v : vgs)
+            total_memory += v.size();
+        vdata = nullptr, ext_data = nullptr, data = nullptr;
+        if (!allocate)
+            return;
+        vdata = make_shared<vector<FL>>(total_memory);
+        bind_integrals(vdata->data());
+    }
+    // Point integral arrays to consecutive segments of ptr
+    // (in the order of ts, vs, vabs, vgs)
+    void bind_integrals(FL *ptr) {
+        data = ptr;
+        for (auto &t : ts)
+            t.data = ptr, ptr += t.size();
+        for (auto &v : vs)
+            v.data = ptr, ptr += v.size();
+        for (auto &v : vabs)
+            v.data = ptr, ptr += v.size();
+        for (auto &v : vgs)
+            v.data = ptr, ptr += v.size();
+    }
+    // Store one integral element read from FCIDUMP (indices counting from 1)
+    // ip: number of separator lines (all indices zero) up to and including
+    //     this line (only used for UHF)
+    void set_integral(const array<uint16_t, 4> &idx, FL val, int ip) {
+        if (idx[0] + idx[1] + idx[2] + idx[3] == 0) {
+            if (!uhf || ip == 6)
+                const_e = val;
+        } else if (!uhf) {
+            if (idx[2] + idx[3] == 0)
+                ts[0](idx[0] - 1, idx[1] - 1) = val;
+            else if (!general)
+                vs[0](idx[0] - 1, idx[1] - 1, idx[2] - 1, idx[3] - 1) = val;
+            else
+                vgs[0](idx[0] - 1, idx[1] - 1, idx[2] - 1, idx[3] - 1) = val;
+        } else if (idx[2] + idx[3] == 0) {
+            ts[ip - 3](idx[0] - 1, idx[1] - 1) = val;
         } else {
-            ts.push_back(TInt<FL>(n));
-            ts.push_back(TInt<FL>(n));
-            ts[0].general = ts[1].general =
-                params.count("itgeneral") != 0 &&
-                Parsing::to_int(params["itgeneral"]) == 1;
-            if (!general) {
-                vs.push_back(V8Int<FL>(n));
-                vs.push_back(V8Int<FL>(n));
-                vabs.push_back(V4Int<FL>(n));
-                total_memory =
-                    ((ts[0].size() + vs[0].size()) << 1) + vabs[0].size();
-                vdata = make_shared<vector<FL>>(total_memory);
-                data = vdata->data();
-                ts[0].data = data;
-                ts[1].data = data + ts[0].size();
-                vs[0].data = data + (ts[0].size() << 1);
-                vs[1].data = data + (ts[0].size() << 1) + vs[0].size();
-                vabs[0].data = data + ((ts[0].size() + vs[0].size()) << 1);
-                ts[0].clear(), ts[1].clear();
-                vs[0].clear(), vs[1].clear(), vabs[0].clear();
-            } else {
-                for (int i = 0; i < 3; i++)
-                    vgs.push_back(V1Int<FL>(n));
-                total_memory = ts[0].size() * 2 + vgs[0].size() * 3;
-                vdata = make_shared<vector<FL>>(total_memory);
-                data = vdata->data();
-                ts[0].data = data;
-                ts[1].data = data + ts[0].size();
-                vgs[0].data = data + (ts[0].size() << 1);
-                vgs[1].data = data + (ts[0].size() << 1) + vgs[0].size();
-                vgs[2].data = data + (ts[0].size() << 1) + (vgs[0].size() << 1);
-                ts[0].clear(), ts[1].clear();
-                vgs[0].clear(), vgs[1].clear(), vgs[2].clear();
-            }
-            int ip = 0;
-            for (size_t i = 0; i < int_val.size(); i++) {
-                if (int_idx[i][0] == numeric_limits<uint16_t>::max())
-                    continue;
-                if (int_idx[i][0] + int_idx[i][1] + int_idx[i][2] +
-                        int_idx[i][3] ==
-                    0) {
-                    ip++;
-                    if (ip == 6)
-                        const_e = int_val[i];
-                } else if (int_idx[i][2] + int_idx[i][3] == 0) {
-                    ts[ip - 3](int_idx[i][0] - 1, int_idx[i][1] - 1) =
-                        int_val[i];
-                } else {
-                    assert(ip <= 2);
-                    if (!general) {
-                        if (ip < 2)
-                            vs[ip](int_idx[i][0] - 1, int_idx[i][1] - 1,
-                                   int_idx[i][2] - 1, int_idx[i][3] - 1) =
-                                int_val[i];
-                        else
-                            vabs[0](int_idx[i][0] - 1, int_idx[i][1] - 1,
-                                    int_idx[i][2] - 1, int_idx[i][3] - 1) =
-                                int_val[i];
-                    } else {
-                        vgs[ip](int_idx[i][0] - 1, int_idx[i][1] - 1,
-                                int_idx[i][2] - 1, int_idx[i][3] - 1) =
-                            int_val[i];
-                    }
-                }
+            assert(ip <= 2);
+            if (general)
+                vgs[ip](idx[0] - 1, idx[1] - 1, idx[2] - 1, idx[3] - 1) = val;
+            else if (ip < 2)
+                vs[ip](idx[0] - 1, idx[1] - 1, idx[2] - 1, idx[3] - 1) = val;
+            else
+                vabs[0](idx[0] - 1, idx[1] - 1, idx[2] - 1, idx[3] - 1) = val;
+        }
+    }
+    // Parsing a FCIDUMP file (or a binary integral file)
+    virtual void read(const string &filename) {
+        if (is_binary(filename))
+            return read_binary(filename);
+        params.clear();
+        const_e = 0.0;
+        ifstream ifs(filename.c_str(), ios::binary);
+        if (!ifs.good())
+            throw runtime_error("FCIDUMP::read on '" + filename + "' failed.");
+        read_params(ifs);
+        init_integrals();
+        for (auto &t : ts)
+            t.clear();
+        for (auto &v : vs)
+            v.clear();
+        for (auto &v : vabs)
+            v.clear();
+        for (auto &v : vgs)
+            v.clear();
+        // integral lines are read in chunks and parsed in place
+        // by multiple threads, then stored in file order, so that the
+        // last one of duplicate (or equivalent) elements is kept
+        vector<char> buf;
+        size_t len = 0, cut;
+        int ip = 0, ntg = threading->activate_global();
+        vector<vector<tuple<array<uint16_t, 4>, FL, int>>> elems(ntg);
+        while ((cut = fd_read_chunk(ifs, buf, len, read_chunk_size)) != 0) {
+            fd_parse_lines<FL>(
+                buf.data(), buf.data() + cut, ip, uhf, ntg,
+                [&elems](int ir, const array<uint16_t, 4> &idx, FL val,
+                         int jp) {
+                    elems[ir].push_back(make_tuple(idx, val, jp));
+                });
+            for (auto &el : elems) {
+                for (auto &x : el)
+                    set_integral(get<0>(x), get<1>(x), get<2>(x));
+                el.clear();
             }
+            memmove(buf.data(), buf.data() + cut, len - cut);
+            len -= cut;
         }
+        threading->activate_normal();
+        if (ifs.bad())
+            throw runtime_error("FCIDUMP::read on '" + filename + "' failed.");
+        ifs.close();
+    }
+    // Writing integrals to disk in binary format
+    // Integral arrays are stored as (packed) arrays in memory
+    virtual void write_binary(const string &filename) const {
+        map<string, string> pars = params;
+        pars["iuhf"] = uhf ? "1" : "0";
+        pars["igeneral"] = general ? "1" : "0";
+        pars["itgeneral"] = ts[0].general ? "1" : "0";
+        stringstream ss;
+        for (auto &p : pars)
+            ss << p.first << "=" << p.second << endl;
+        string ptext = ss.str();
+        FCIDUMPBinaryHeader hdr;
+        hdr.fl_size = (uint32_t)sizeof(FL);
+        hdr.params_len = (uint64_t)ptext.length();
+        uint64_t tm = 0;
+        for (auto &t : ts)
+            tm += t.size();
+        for (auto &v : vs)
+            tm += v.size();
+        for (auto &v : vabs)
+            tm += v.size();
+        for (auto &v : vgs)
+            tm += v.size();
+        ofstream ofs(filename.c_str(), ios::binary);
+        if (!ofs.good())
+            throw runtime_error("FCIDUMP::write_binary on '" + filename +
+                                "' failed.");
+        ofs.write((char *)&hdr, sizeof(hdr));
+        ofs.write(ptext.c_str(), ptext.length());
+        ofs.write((char *)&const_e, sizeof(const_e));
+        ofs.write((char *)&tm, sizeof(tm));
+        size_t hsz = sizeof(hdr) + ptext.length() + sizeof(FL) + sizeof(tm);
+        vector<char> pad((fd_binary_align - hsz % fd_binary_align) %
+                             fd_binary_align,
+                         0);
+        ofs.write(pad.data(), pad.size());
+        for (auto &t : ts)
+            ofs.write((char *)t.data, sizeof(FL) * t.size());
+        for (auto &v : vs)
+            ofs.write((char *)v.data, sizeof(FL) * v.size());
+        for (auto &v : vabs)
+            ofs.write((char *)v.data, sizeof(FL) * v.size());
+        for (auto &v : vgs)
+            ofs.write((char *)v.data, sizeof(FL) * v.size());
+        if (!ofs.good())
+            throw runtime_error("FCIDUMP::write_binary on '" + filename +
+                                "' failed.");
+        ofs.close();
+    }
+    // Whether a file is in the binary format written by write_binary
+    static bool is_binary(const string &filename) {
+        FCIDUMPBinaryHeader hdr;
+        ifstream ifs(filename.c_str(), ios::binary);
+        if (!ifs.good())
+            return false;
+        memset(hdr.magic, 0, sizeof(hdr.magic));
+        ifs.read(hdr.magic, sizeof(hdr.magic));
+        return ifs.good() && hdr.check_magic();
+    }
+    // Reading integrals in binary format
+    // use_mmap: if true, integral arrays are mapped (copy-on-write) from
+    //   the file without reading; otherwise they are read into memory
+    virtual void read_binary(const string &filename, bool use_mmap = true) {
+        params.clear();
+        const_e = 0.0;
+        ifstream ifs(filename.c_str(), ios::binary);
+        if (!ifs.good())
+            throw runtime_error("FCIDUMP::read_binary on '" + filename +
+                                "' failed.");
+        FCIDUMPBinaryHeader hdr;
+        ifs.read((char *)&hdr, sizeof(hdr));
+        if (!ifs.good() || !hdr.check_magic() || hdr.fl_size != sizeof(FL))
+            throw runtime_error("FCIDUMP::read_binary on '" + filename +
+                                "' failed.");
+        string ptext(hdr.params_len, ' ');
+        ifs.read(&ptext[0], hdr.params_len);
+        vector<string> pars = Parsing::split(ptext, "\n", true);
+        for (auto &p : pars) {
+            size_t ip = p.find('=');
+            params[p.substr(0, ip)] =
+                ip == string::npos ? "" : p.substr(ip + 1);
+        }
+        uint64_t tm = 0;
+        ifs.read((char *)&const_e, sizeof(const_e));
+        ifs.read((char *)&tm, sizeof(tm));
+        init_integrals(false);
+        size_t hsz = sizeof(hdr) + hdr.params_len + sizeof(FL) + sizeof(tm);
+        size_t offset = hsz + (fd_binary_align - hsz % fd_binary_align) %
+                                  fd_binary_align;
+        if (!ifs.good() || tm != total_memory)
+            throw runtime_error("FCIDUMP::read_binary on '" + filename +
+                                "' failed.");
+#ifndef _WIN32
+        if (use_mmap && total_memory != 0) {
+            ifs.close();
+            size_t len = offset + sizeof(FL) * total_memory;
+            int fd = open(filename.c_str(), O_RDONLY);
+            void *ptr = fd == -1 ? MAP_FAILED
+                                 : mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                                        MAP_PRIVATE, fd, 0);
+            if (fd != -1)
+                close(fd);
+            if (ptr == MAP_FAILED)
+                throw runtime_error("FCIDUMP::read_binary on '" + filename +
+                                    "' failed.");
+            ext_data =
+                shared_ptr<void>(ptr, [len](void *p) { munmap(p, len); });
+            bind_integrals((FL *)((char *)ptr + offset));
+            return;
+        }
+#endif
+        vdata = make_shared<vector<FL>>(total_memory);
+        bind_integrals(vdata->data());
+        ifs.seekg(offset);
+        ifs.read((char *)data, sizeof(FL) * total_memory);
+        if (!ifs.good())
+            throw runtime_error("FCIDUMP::read_binary on '" + filename +
+                                "' failed.");
+        ifs.close();
     }
     // Remove integral elements that violate point group symmetry
     // orbsym: in XOR convention
@@ -1253,6 +1481,7 @@ template <typename FL> struct FCIDUMP {
             rvs[i].reorder(vs[i], ord);
         }
         vdata = rdata;
+        ext_data = nullptr;
         data = rdata->data();
         ts = rts, vgs = rvgs, vabs = rvabs, vs = rvs;
         if (params.count("orbsym"))
@@ -1287,12 +1516,32 @@ template <typename FL> struct FCIDUMP {
             rvs[i].rotate(vs[i], rot_mat);
         }
         vdata = rdata;
+        ext_data = nullptr;
         data = rdata->data();
         ts = rts, vgs = rvgs, vabs = rvabs, vs = rvs;
     }
+    // Move integrals to external storage of at least total_memory elements
+    // If copy is false, the external storage is assumed to be filled
+    virtual void rebind_data(FL *ptr, const shared_ptr<void> &owner,
+                             bool copy = true) {
+        if (copy && total_memory != 0)
+            memcpy(ptr, data, sizeof(FL) * total_memory);
+        for (size_t i = 0; i < ts.size(); i++)
+            ts[i].data = ts[i].data - data + ptr;
+        for (size_t i = 0; i < vgs.size(); i++)
+            vgs[i].data = vgs[i].data - data + ptr;
+        for (size_t i = 0; i < vabs.size(); i++)
+            vabs[i].data = vabs[i].data - data + ptr;
+        for (size_t i = 0; i < vs.size(); i++)
+            vs[i].data = vs[i].data - data + ptr;
+        data = ptr;
+        vdata = nullptr;
+        ext_data = owner;
+    }
     virtual shared_ptr<FCIDUMP> deep_copy() const {
         shared_ptr<FCIDUMP> fcidump = make_shared<FCIDUMP>(*this);
-        fcidump->vdata = make_shared<vector<FL>>(*vdata);
+        fcidump->vdata = make_shared<vector<FL>>(data, data + total_memory);
+        fcidump->ext_data = nullptr;
         fcidump->data = fcidump->vdata->data();
         vector<TInt<FL>> rts(ts);
         vector<V1Int<FL>> rvgs(vgs);
@@ -1335,6 +1584,7 @@ template <typename FL> struct FCIDUMP {
     virtual void deallocate() {
         assert(total_memory != 0);
         vdata = nullptr;
+        ext_data = nullptr;
         data = nullptr;
         ts.clear();
         vs.clear();
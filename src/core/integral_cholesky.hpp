@@ -0,0 +1,444 @@
+
+/*
+ * block2: Efficient MPO implementation of quantum chemistry DMRG
+ * Copyright (C) 2020-2021 Huanchen Zhai <hczhai@caltech.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "integral.hpp"
+#include "threading.hpp"
+#include <functional>
+
+using namespace std;
+
+namespace block2 {
+
+// One- and two-electron integrals
+// with two-electron integrals in factorized form (Cholesky / density fitting)
+// (ij|kl) = sum_Q L[ij, Q] L[kl, Q]
+// Two-electron integral elements are evaluated on demand
+template <typename FL> struct CholeskyFCIDUMP : FCIDUMP<FL> {
+    using typename FCIDUMP<FL>::FP;
+    using FCIDUMP<FL>::params;
+    using FCIDUMP<FL>::ts;
+    using FCIDUMP<FL>::vdata;
+    using FCIDUMP<FL>::data;
+    using FCIDUMP<FL>::total_memory;
+    using FCIDUMP<FL>::const_e;
+    using FCIDUMP<FL>::uhf;
+    using FCIDUMP<FL>::general;
+    using FCIDUMP<FL>::n_sites;
+    // Number of Cholesky (auxiliary) vectors
+    int n_aux = 0;
+    // Factors for each spin: cds[s][(i * n + j) * n_aux + Q] = L[ij, Q]
+    vector<shared_ptr<vector<FL>>> cds;
+    // Number of cached two-electron integral elements per thread
+    // (rounded to power of 2; 0 to disable cache)
+    size_t cache_size;
+    mutable vector<vector<pair<uint64_t, FL>>> vcaches;
+    // Two-electron integral elements not allowed by this filter are zero
+    // (set by symmetrize)
+    function<bool(uint16_t, uint16_t, uint16_t, uint16_t)> v_allowed =
+        nullptr;
+    // Largest diagonal residual left by decompose (used by read)
+    FP cd_thresh = (FP)1E-12;
+    CholeskyFCIDUMP(size_t cache_size = (size_t)1 << 16)
+        : FCIDUMP<FL>(), cache_size(cache_size) {}
+    virtual ~CholeskyFCIDUMP() = default;
+    // Initialize integrals: U(1) case
+    // ta, tb: one-electron integrals (n * n or n * (n + 1) / 2)
+    // cda, cdb: factors of alpha and beta spin (n * n * n_aux)
+    void initialize_sz(uint16_t n_sites, uint16_t n_elec, uint16_t twos,
+                       uint16_t isym, FL e, const FL *ta, size_t lta,
+                       const FL *tb, size_t ltb, const FL *cda, size_t lcda,
+                       const FL *cdb, size_t lcdb) {
+        init_params(n_sites, n_elec, twos, isym, e, true, lta);
+        assert(lta == ts[0].size() && ltb == ts[1].size());
+        memcpy(ts[0].data, ta, sizeof(FL) * lta);
+        memcpy(ts[1].data, tb, sizeof(FL) * ltb);
+        n_aux = (int)(lcda / ((size_t)n_sites * n_sites));
+        assert(lcda == (size_t)n_sites * n_sites * n_aux && lcdb == lcda);
+        cds.push_back(make_shared<vector<FL>>(cda, cda + lcda));
+        cds.push_back(make_shared<vector<FL>>(cdb, cdb + lcdb));
+        init_cache();
+    }
+    // Initialize integrals: SU(2) case
+    // t: one-electron integrals (n * n or n * (n + 1) / 2)
+    // cd: factors (n * n * n_aux)
+    void initialize_su2(uint16_t n_sites, uint16_t n_elec, uint16_t twos,
+                        uint16_t isym, FL e, const FL *t, size_t lt,
+                        const FL *cd, size_t lcd) {
+        init_params(n_sites, n_elec, twos, isym, e, false, lt);
+        assert(lt == ts[0].size());
+        memcpy(ts[0].data, t, sizeof(FL) * lt);
+        n_aux = (int)(lcd / ((size_t)n_sites * n_sites));
+        assert(lcd == (size_t)n_sites * n_sites * n_aux);
+        cds.push_back(make_shared<vector<FL>>(cd, cd + lcd));
+        init_cache();
+    }
+    // Initialize integrals from a FCIDUMP with full two-electron integrals
+    // by pivoted Cholesky decomposition of (ij|kl), stopped when all
+    // diagonal residuals are below cd_thresh
+    // For UHF the decomposition is done jointly for both spins
+    void decompose(const FCIDUMP<FL> &fd) {
+        const uint16_t n = fd.n_sites();
+        const int ns = fd.uhf ? 2 : 1;
+        const size_t nn = (size_t)n * n, m = ns * nn;
+        init_params(n, fd.n_elec(), fd.twos(), fd.isym(), fd.e(), fd.uhf,
+                    fd.ts[0].size());
+        for (auto &p : fd.params)
+            if (!params.count(p.first))
+                params[p.first] = p.second;
+        for (size_t i = 0; i < ts.size(); i++)
+            memcpy(ts[i].data, fd.ts[i].data, sizeof(FL) * ts[i].size());
+        // (a|b) with a = s * nn + i * n + j
+        auto velem = [&fd, n, nn](size_t a, size_t b) -> FL {
+            const uint8_t sa = (uint8_t)(a / nn), sb = (uint8_t)(b / nn);
+            a %= nn, b %= nn;
+            return fd.uhf ? fd.v(sa, sb, a / n, a % n, b / n, b % n)
+                          : fd.v(a / n, a % n, b / n, b % n);
+        };
+        vector<FL> diag(m);
+        // one buffer per Cholesky vector, so that adding a vector
+        // does not copy the previous ones
+        vector<vector<FL>> ld;
+        for (size_t a = 0; a < m; a++)
+            diag[a] = velem(a, a);
+        int ntg = threading->activate_global();
+        for (n_aux = 0; n_aux < (int)m; n_aux++) {
+            size_t p = 0;
+            for (size_t a = 1; a < m; a++)
+                if (abs(diag[a]) > abs(diag[p]))
+                    p = a;
+            if (abs(diag[p]) < cd_thresh)
+                break;
+            ld.push_back(vector<FL>(m));
+            const FL dp = sqrt(diag[p]);
+            FL *lq = ld.back().data();
+#pragma omp parallel for schedule(static) num_threads(ntg)
+            for (int64_t a = 0; a < (int64_t)m; a++) {
+                FL x = velem(a, p);
+                for (int q = 0; q < n_aux; q++)
+                    x -= ld[q][a] * ld[q][p];
+                lq[a] = x / dp;
+                diag[a] -= lq[a] * lq[a];
+            }
+        }
+        threading->activate_normal();
+        for (int s = 0; s < ns; s++) {
+            cds.push_back(make_shared<vector<FL>>(nn * n_aux));
+            FL *cd = cds.back()->data();
+            for (size_t ij = 0; ij < nn; ij++)
+                for (int q = 0; q < n_aux; q++)
+                    cd[ij * n_aux + q] = ld[q][s * nn + ij];
+        }
+        init_cache();
+    }
+    void init_params(uint16_t n_sites, uint16_t n_elec, uint16_t twos,
+                     uint16_t isym, FL e, bool iuhf, size_t lt) {
+        params.clear();
+        cds.clear();
+        v_allowed = nullptr;
+        const_e = e;
+        params["norb"] = Parsing::to_string(n_sites);
+        params["nelec"] = Parsing::to_string(n_elec);
+        params["ms2"] = Parsing::to_string(twos);
+        params["isym"] = Parsing::to_string(isym);
+        params["iuhf"] = iuhf ? "1" : "0";
+        params["itgeneral"] = lt == (size_t)n_sites * n_sites ? "1" : "0";
+        // only one-electron integrals are stored in the FCIDUMP arrays
+        params["igeneral"] = "1";
+        FCIDUMP<FL>::init_integrals(false);
+        this->vgs.clear();
+        general = false;
+        total_memory = 0;
+        for (auto &t : ts)
+            total_memory += t.size();
+        vdata = make_shared<vector<FL>>(total_memory);
+        FCIDUMP<FL>::bind_integrals(vdata->data());
+        params.erase("igeneral");
+    }
+    void init_cache() {
+        vcaches.clear();
+        if (cache_size == 0)
+            return;
+        size_t sz = 1;
+        while (sz < cache_size)
+            sz <<= 1;
+#ifdef _OPENMP
+        int nth = max(omp_get_max_threads(), threading->n_threads_global);
+#else
+        int nth = 1;
+#endif
+        vcaches.resize(
+            nth, vector<pair<uint64_t, FL>>(
+                     sz, make_pair(numeric_limits<uint64_t>::max(), (FL)0.0)));
+    }
+    // Two-electron integral element from factors of spin sl and sr
+    FL evaluate(uint8_t sl, uint8_t sr, uint16_t i, uint16_t j, uint16_t k,
+                uint16_t l) const {
+        const size_t n = n_sites();
+        const FL *pa = cds[sl]->data() + (i * n + j) * n_aux;
+        const FL *pb = cds[sr]->data() + (k * n + l) * n_aux;
+        FL r = 0;
+        for (int q = 0; q < n_aux; q++)
+            r += pa[q] * pb[q];
+        return r;
+    }
+    // Two-electron integral element without cache
+    FL element(uint8_t sl, uint8_t sr, uint16_t i, uint16_t j, uint16_t k,
+               uint16_t l) const {
+        if (v_allowed != nullptr && !v_allowed(i, j, k, l))
+            return 0;
+        return evaluate(sl, sr, i, j, k, l);
+    }
+    // Two-electron integral element with per-thread cache
+    FL cached_v(uint8_t sl, uint8_t sr, uint16_t i, uint16_t j, uint16_t k,
+                uint16_t l) const {
+        if (v_allowed != nullptr && !v_allowed(i, j, k, l))
+            return 0;
+        int tid = threading->get_thread_id();
+#ifdef _OPENMP
+        // thread ids are not unique inside nested parallel regions
+        if (omp_get_level() > 1)
+            tid = -1;
+#endif
+        if (tid < 0 || tid >= (int)vcaches.size())
+            return evaluate(sl, sr, i, j, k, l);
+        const uint64_t key = ((uint64_t)((sl << 1) | sr) << 60) |
+                             ((uint64_t)i << 45) | ((uint64_t)j << 30) |
+                             ((uint64_t)k << 15) | (uint64_t)l;
+        vector<pair<uint64_t, FL>> &cache = vcaches[tid];
+        pair<uint64_t, FL> &entry =
+            cache[(key * 0x9E3779B97F4A7C15ULL >> 32) & (cache.size() - 1)];
+        if (entry.first != key)
+            entry = make_pair(key, evaluate(sl, sr, i, j, k, l));
+        return entry.second;
+    }
+    // Two-electron integral element (SU(2))
+    FL v(uint16_t i, uint16_t j, uint16_t k, uint16_t l) const override {
+        return cached_v(0, 0, i, j, k, l);
+    }
+    // Two-electron integral element (SZ)
+    FL v(uint8_t sl, uint8_t sr, uint16_t i, uint16_t j, uint16_t k,
+         uint16_t l) const override {
+        return uhf ? cached_v(sl, sr, i, j, k, l) : cached_v(0, 0, i, j, k, l);
+    }
+    // Sum of absolute two-electron integral elements allowed by the current
+    // v_allowed but not by f, over the unique elements stored in a full
+    // FCIDUMP (the same elements as counted by FCIDUMP::symmetrize)
+    FP masked_error(
+        const function<bool(uint16_t, uint16_t, uint16_t, uint16_t)> &f) const {
+        const int n = n_sites();
+        const bool gen = !is_same<FL, FP>::value;
+        FP error = 0;
+        int ntg = threading->activate_global();
+#pragma omp parallel for schedule(dynamic) num_threads(ntg) reduction(+ : error)
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < n; j++)
+                for (int k = 0; k < n; k++)
+                    for (int l = 0; l < n; l++) {
+                        if (f(i, j, k, l) ||
+                            (v_allowed != nullptr && !v_allowed(i, j, k, l)))
+                            continue;
+                        if (gen) {
+                            for (int s = 0; s < (uhf ? 3 : 1); s++)
+                                error +=
+                                    abs(evaluate(s == 1, s != 0, i, j, k, l));
+                            continue;
+                        }
+                        if (j > i || l > k)
+                            continue;
+                        if (uhf)
+                            error += abs(evaluate(0, 1, i, j, k, l));
+                        if ((k * (k + 1) >> 1) + l > (i * (i + 1) >> 1) + j)
+                            continue;
+                        for (int s = 0; s < (uhf ? 2 : 1); s++)
+                            error += abs(evaluate(s, s, i, j, k, l));
+                    }
+        threading->activate_normal();
+        return error;
+    }
+    // Remove integral elements that violate point group symmetry
+    // Two-electron integral elements are masked by v_allowed
+    FP symmetrize(const vector<uint8_t> &orbsym) override {
+        FP error = FCIDUMP<FL>::symmetrize(orbsym);
+        auto f = [orbsym](uint16_t i, uint16_t j, uint16_t k, uint16_t l) {
+            return !(orbsym[i] ^ orbsym[j] ^ orbsym[k] ^ orbsym[l]);
+        };
+        error += masked_error(f);
+        v_allowed = f;
+        init_cache();
+        return error;
+    }
+    FP symmetrize(const vector<int16_t> &orbsym) override {
+        FP error = FCIDUMP<FL>::symmetrize(orbsym);
+        auto f = [orbsym](uint16_t i, uint16_t j, uint16_t k, uint16_t l) {
+            return !(orbsym[i] - orbsym[j] + orbsym[k] - orbsym[l]);
+        };
+        error += masked_error(f);
+        v_allowed = f;
+        init_cache();
+        return error;
+    }
+    FP symmetrize(const vector<int> &ksym, int kmod) override {
+        FP error = FCIDUMP<FL>::symmetrize(ksym, kmod);
+        auto f = [ksym, kmod](uint16_t i, uint16_t j, uint16_t k, uint16_t l) {
+            const int dk = ksym[i] - ksym[j] + ksym[k] - ksym[l];
+            return kmod == 0 ? dk == 0 : (dk % kmod + kmod) % kmod == 0;
+        };
+        error += masked_error(f);
+        v_allowed = f;
+        init_cache();
+        return error;
+    }
+    void reorder(const vector<uint16_t> &ord) override {
+        FCIDUMP<FL>::reorder(ord);
+        const size_t n = n_sites();
+        for (auto &cd : cds) {
+            shared_ptr<vector<FL>> rcd = make_shared<vector<FL>>(cd->size());
+            int ntg = threading->activate_global();
+#pragma omp parallel for schedule(static) num_threads(ntg)
+            for (int64_t ij = 0; ij < (int64_t)(n * n); ij++)
+                memcpy(rcd->data() + ij * n_aux,
+                       cd->data() + (ord[ij / n] * n + ord[ij % n]) * n_aux,
+                       sizeof(FL) * n_aux);
+            threading->activate_normal();
+            cd = rcd;
+        }
+        if (v_allowed != nullptr) {
+            auto f = v_allowed;
+            v_allowed = [f, ord](uint16_t i, uint16_t j, uint16_t k,
+                                 uint16_t l) {
+                return f(ord[i], ord[j], ord[k], ord[l]);
+            };
+        }
+        init_cache();
+    }
+    // orbital rotation
+    // rot_mat: (old, new)
+    // L'[ij, Q] = sum_pq conj(U[p, i]) L[pq, Q] U[q, j]
+    void rotate(const vector<FL> &rot_mat) override {
+        FCIDUMP<FL>::rotate(rot_mat);
+        const int n = n_sites();
+        const FL *u = rot_mat.data();
+        for (auto &cd : cds) {
+            shared_ptr<vector<FL>> tmp = make_shared<vector<FL>>(cd->size());
+            shared_ptr<vector<FL>> rcd = make_shared<vector<FL>>(cd->size());
+            FL *pcd = cd->data(), *ptmp = tmp->data(), *prcd = rcd->data();
+            int ntg = threading->activate_global();
+#pragma omp parallel num_threads(ntg)
+            {
+#pragma omp for schedule(static)
+                for (int i = 0; i < n; i++)
+                    for (int p = 0; p < n; p++) {
+                        const FL c = xconj(u[(size_t)p * n + i]);
+                        for (size_t qk = 0; qk < (size_t)n * n_aux; qk++)
+                            ptmp[(size_t)i * n * n_aux + qk] +=
+                                c * pcd[(size_t)p * n * n_aux + qk];
+                    }
+#pragma omp for schedule(static)
+                for (int i = 0; i < n; i++)
+                    for (int j = 0; j < n; j++) {
+                        FL *r = prcd + ((size_t)i * n + j) * n_aux;
+                        for (int q = 0; q < n; q++) {
+                            const FL c = u[(size_t)q * n + j];
+                            const FL *x = ptmp + ((size_t)i * n + q) * n_aux;
+                            for (int k = 0; k < n_aux; k++)
+                                r[k] += x[k] * c;
+                        }
+                    }
+            }
+            threading->activate_normal();
+            cd = rcd;
+        }
+        v_allowed = nullptr;
+        init_cache();
+    }
+    // Full FCIDUMP with all two-electron integral elements evaluated
+    // (8-fold symmetry is assumed for real integrals)
+    shared_ptr<FCIDUMP<FL>> to_fcidump() const {
+        shared_ptr<FCIDUMP<FL>> r = make_shared<FCIDUMP<FL>>();
+        r->params = params;
+        r->params["igeneral"] =
+            is_same<FL, typename FCIDUMP<FL>::FP>::value ? "0" : "1";
+        r->init_integrals();
+        r->const_e = const_e;
+        for (size_t i = 0; i < ts.size(); i++)
+            memcpy(r->ts[i].data, ts[i].data, sizeof(FL) * ts[i].size());
+        const int n = n_sites();
+        int ntg = threading->activate_global();
+#pragma omp parallel for schedule(dynamic) num_threads(ntg)
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < n; j++)
+                for (int k = 0; k < n; k++)
+                    for (int l = 0; l < n; l++) {
+                        for (size_t s = 0; s < r->vgs.size(); s++)
+                            r->vgs[s](i, j, k, l) =
+                                element(s == 1, s != 0, i, j, k, l);
+                        if (j > i || l > k)
+                            continue;
+                        for (size_t s = 0; s < r->vabs.size(); s++)
+                            r->vabs[s](i, j, k, l) = element(0, 1, i, j, k, l);
+                        if ((k * (k + 1) >> 1) + l > (i * (i + 1) >> 1) + j)
+                            continue;
+                        for (size_t s = 0; s < r->vs.size(); s++)
+                            r->vs[s](i, j, k, l) = element(s, s, i, j, k, l);
+                    }
+        threading->activate_normal();
+        return r;
+    }
+    // Writing FCIDUMP file to disk (with all integral elements evaluated)
+    void write(const string &filename) const override {
+        to_fcidump()->write(filename);
+    }
+    void write_binary(const string &filename) const override {
+        to_fcidump()->write_binary(filename);
+    }
+    // Reading a FCIDUMP file (or a binary integral file)
+    // and decomposing the two-electron integrals
+    void read(const string &filename) override {
+        FCIDUMP<FL> fd;
+        fd.read(filename);
+        decompose(fd);
+        fd.deallocate();
+    }
+    void read_binary(const string &filename, bool use_mmap = true) override {
+        FCIDUMP<FL> fd;
+        fd.read_binary(filename, use_mmap);
+        decompose(fd);
+        fd.deallocate();
+    }
+    shared_ptr<FCIDUMP<FL>> deep_copy() const override {
+        shared_ptr<CholeskyFCIDUMP> r = make_shared<CholeskyFCIDUMP>(*this);
+        r->vdata = make_shared<vector<FL>>(data, data + total_memory);
+        r->ext_data = nullptr;
+        r->bind_integrals(r->vdata->data());
+        for (auto &cd : r->cds)
+            cd = make_shared<vector<FL>>(*cd);
+        r->init_cache();
+        return r;
+    }
+    void deallocate() override {
+        cds.clear();
+        vcaches.clear();
+        FCIDUMP<FL>::deallocate();
+    }
+};
+
+} // namespace block2
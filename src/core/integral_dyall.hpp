@@ -73,8 +73,17 @@ struct DyallFCIDUMP : FCIDUMP<double> {
     void read(const string &filename) override {
         shared_ptr<FCIDUMP<double>> fd = make_shared<FCIDUMP<double>>();
         fd->read(filename);
-        vdata_fock = fd->vdata;
+        // integrals of fd may not be owned by fd->vdata
         fock = fd->ts;
+        size_t lf = 0;
+        for (auto &f : fock)
+            lf += f.size();
+        vdata_fock = make_shared<vector<double>>(lf);
+        lf = 0;
+        for (auto &f : fock) {
+            memcpy(vdata_fock->data() + lf, f.data, sizeof(double) * f.size());
+            f.data = vdata_fock->data() + lf, lf += f.size();
+        }
         fd = nullptr;
         initialize_heff();
         initialize_const();
@@ -102,6 +102,7 @@ template <typename FL> struct IterativeMatrixFunctions : GMatrixFunctions<FL> {
     // aa: diag elements of a (for precondition)
     // bs: input/output vector
     // ors: orthogonal states to be projected out
+    // init_qq: if not null, returns squared residual norm of initial guess
     template <typename MatMul, typename PComm>
     static vector<FP>
     davidson(MatMul &op, const GDiagonalMatrix<FL> &aa, vector<GMatrix<FL>> &vs,
@@ -109,7 +110,8 @@ template <typename FL> struct IterativeMatrixFunctions : GMatrixFunctions<FL> {
              bool iprint = false, const PComm &pcomm = nullptr,
              FP conv_thrd = 5E-6, int max_iter = 5000, int soft_max_iter = -1,
              int deflation_min_size = 2, int deflation_max_size = 50,
-             const vector<GMatrix<FL>> &ors = vector<GMatrix<FL>>()) {
+             const vector<GMatrix<FL>> &ors = vector<GMatrix<FL>>(),
+             FP *init_qq = nullptr) {
         assert(!(davidson_type & DavidsonTypes::Harmonic));
         shared_ptr<VectorAllocator<FL>> d_alloc =
             make_shared<VectorAllocator<FL>>();
@@ -297,6 +299,8 @@ template <typename FL> struct IterativeMatrixFunctions : GMatrixFunctions<FL> {
                 pcomm->broadcast(&qq, 1, pcomm->root);
                 pcomm->broadcast(&ck, 1, pcomm->root);
             }
+            if (xiter == 1 && init_qq != nullptr)
+                *init_qq = abs(qq);
             if (abs(qq) < conv_thrd) {
                 ck++;
                 if (ck == k)
@@ -377,6 +381,7 @@ template <typename FL> struct IterativeMatrixFunctions : GMatrixFunctions<FL> {
     // shift: solve for eigenvalues near this value
     // davidson_type: whether eigenvalues should be above/below/near shift
     // ors: orthogonal states to be projected out
+    // init_qq: if not null, returns squared residual norm of initial guess
     template <typename MatMul, typename PComm>
     static vector<FP> harmonic_davidson(
         MatMul &op, const GDiagonalMatrix<FL> &aa, vector<GMatrix<FL>> &vs,
@@ -384,11 +389,13 @@ template <typename FL> struct IterativeMatrixFunctions : GMatrixFunctions<FL> {
         const PComm &pcomm = nullptr, FP conv_thrd = 5E-6, int max_iter = 5000,
         int soft_max_iter = -1, int deflation_min_size = 2,
         int deflation_max_size = 50,
-        const vector<GMatrix<FL>> &ors = vector<GMatrix<FL>>()) {
+        const vector<GMatrix<FL>> &ors = vector<GMatrix<FL>>(),
+        FP *init_qq = nullptr) {
         if (!(davidson_type & DavidsonTypes::Harmonic))
             return davidson(op, aa, vs, shift, davidson_type, ndav, iprint,
                             pcomm, conv_thrd, max_iter, soft_max_iter,
-                            deflation_min_size, deflation_max_size, ors);
+                            deflation_min_size, deflation_max_size, ors,
+                            init_qq);
         shared_ptr<VectorAllocator<FL>> d_alloc =
             make_shared<VectorAllocator<FL>>();
         int k = (int)vs.size(), nor = (int)ors.size();
@@ -566,6 +573,8 @@ template <typename FL> struct IterativeMatrixFunctions : GMatrixFunctions<FL> {
                 pcomm->broadcast(&qq, 1, pcomm->root);
                 pcomm->broadcast(&ck, 1, pcomm->root);
             }
+            if (xiter == 1 && init_qq != nullptr)
+                *init_qq = abs(qq);
             if (abs(qq) < conv_thrd) {
                 ck++;
                 if (ck == k)
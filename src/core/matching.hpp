@@ -130,4 +130,125 @@ struct KuhnMunkres {
     }
 };
 
+/** Hopcroft-Karp algorithm for maximum cardinality matching
+ * in a bipartite graph, and minimum vertex cover (Konig's theorem).
+ * Complexity: O(E sqrt(V)).
+ */
+struct HopcroftKarp {
+    int nl;                  //!< Number of left vertices.
+    int nr;                  //!< Number of right vertices.
+    vector<vector<int>> adj; //!< Adjacency list of left vertices.
+    vector<int> match_l; //!< Right vertex matched to each left vertex, or -1.
+    vector<int> match_r; //!< Left vertex matched to each right vertex, or -1.
+    vector<int> dist;    //!< BFS layer of left vertices (working array).
+    vector<int> iter;    //!< Next edge of left vertices (working array).
+    vector<int> stk;     //!< DFS stack of left vertices (working array).
+    /** Constructor.
+     * @param nl Number of left vertices.
+     * @param nr Number of right vertices.
+     */
+    HopcroftKarp(int nl, int nr) : nl(nl), nr(nr), adj(nl) {}
+    /** Add an edge.
+     * @param u Left vertex index.
+     * @param v Right vertex index.
+     */
+    void add_edge(int u, int v) { adj[u].push_back(v); }
+    /** Build BFS layers from all free left vertices.
+     * @return ``true`` if there is an augmenting path.
+     */
+    bool bfs() {
+        vector<int> que;
+        que.reserve(nl);
+        bool found = false;
+        for (int u = 0; u < nl; u++)
+            if (match_l[u] == -1)
+                dist[u] = 0, que.push_back(u);
+            else
+                dist[u] = -1;
+        for (size_t iq = 0; iq < que.size(); iq++) {
+            int u = que[iq];
+            for (int v : adj[u]) {
+                int w = match_r[v];
+                if (w == -1)
+                    found = true;
+                else if (dist[w] == -1)
+                    dist[w] = dist[u] + 1, que.push_back(w);
+            }
+        }
+        return found;
+    }
+    /** Find an augmenting path along the BFS layers.
+     * The depth-first search uses an explicit stack, so that long
+     * alternating paths do not overflow the call stack.
+     * @param root Starting left vertex.
+     * @return ``true`` if an augmenting path is found.
+     */
+    bool dfs(int root) {
+        stk.clear();
+        stk.push_back(root), iter[root] = 0;
+        while (!stk.empty()) {
+            int u = stk.back();
+            if (iter[u] == (int)adj[u].size()) {
+                dist[u] = -1;
+                stk.pop_back();
+                if (!stk.empty())
+                    iter[stk.back()]++;
+                continue;
+            }
+            int w = match_r[adj[u][iter[u]]];
+            if (w == -1) {
+                // augment along the path stored in the stack
+                for (int x : stk) {
+                    int v = adj[x][iter[x]];
+                    match_l[x] = v, match_r[v] = x;
+                }
+                return true;
+            } else if (dist[w] == dist[u] + 1)
+                stk.push_back(w), iter[w] = 0;
+            else
+                iter[u]++;
+        }
+        return false;
+    }
+    /** Find a maximum matching.
+     * @return the size of the matching. The matching is stored in
+     *   ``match_l`` and ``match_r``.
+     */
+    int solve() {
+        match_l.assign(nl, -1), match_r.assign(nr, -1), dist.resize(nl);
+        iter.resize(nl), stk.reserve(nl);
+        int r = 0;
+        while (bfs())
+            for (int u = 0; u < nl; u++)
+                if (match_l[u] == -1 && dfs(u))
+                    r++;
+        return r;
+    }
+    /** Find a minimum vertex cover from the maximum matching.
+     * Must be called after ``solve``.
+     * @return a pair of flag arrays for left and right vertices,
+     *   with 1 meaning that the vertex is in the cover.
+     */
+    pair<vector<char>, vector<char>> min_vertex_cover() const {
+        // vertices reachable from free left vertices by alternating paths
+        vector<char> zl(nl, 0), zr(nr, 0);
+        vector<int> que;
+        que.reserve(nl);
+        for (int u = 0; u < nl; u++)
+            if (match_l[u] == -1)
+                zl[u] = 1, que.push_back(u);
+        for (size_t iq = 0; iq < que.size(); iq++)
+            for (int v : adj[que[iq]])
+                if (!zr[v]) {
+                    zr[v] = 1;
+                    int w = match_r[v];
+                    if (w != -1 && !zl[w])
+                        zl[w] = 1, que.push_back(w);
+                }
+        for (int u = 0; u < nl; u++)
+            zl[u] = !zl[u];
+        return make_pair(zl, zr);
+    }
+};
+
 } // namespace block2
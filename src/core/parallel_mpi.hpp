@@ -73,6 +73,32 @@ struct MPI {
     static int size() { return mpi()._size; }
 };
 
+// MPI-3 shared memory window in one node
+struct MPISharedMemory : ParallelSharedMemory {
+    MPI_Win win;
+    MPI_Comm comm;
+    MPISharedMemory(MPI_Win win, MPI_Comm comm, char *data, size_t size,
+                    bool writable)
+        : ParallelSharedMemory(data, size, writable), win(win), comm(comm) {
+        int ierr = MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+        assert(ierr == 0);
+    }
+    ~MPISharedMemory() override {
+        int ierr = MPI_Win_unlock_all(win);
+        assert(ierr == 0);
+        ierr = MPI_Win_free(&win);
+        assert(ierr == 0);
+    }
+    void sync() override {
+        int ierr = MPI_Win_sync(win);
+        assert(ierr == 0);
+        ierr = MPI_Barrier(comm);
+        assert(ierr == 0);
+        ierr = MPI_Win_sync(win);
+        assert(ierr == 0);
+    }
+};
+
 template <typename S> struct MPICommunicator : ParallelCommunicator<S> {
     using ParallelCommunicator<S>::size;
     using ParallelCommunicator<S>::rank;
@@ -86,6 +112,25 @@ template <typename S> struct MPICommunicator : ParallelCommunicator<S> {
     const size_t chunk_size = 1 << 30;
     vector<MPI_Request> reqs;
     MPI_Comm comm;
+    // Communicator of procs in the same node (created on first use)
+    MPI_Comm node_comm = MPI_COMM_NULL;
+    int _node_rank = 0, _node_size = 1;
+    // If nonzero, procs are grouped into nodes of this many consecutive
+    // ranks (inside shared memory domains), for example for testing
+    int fixed_node_size = 0;
+    // Whether sum reductions are done in two levels: first inside each node
+    // through shared memory, then between node leaders (node rank 0)
+    bool hierarchical = false;
+    // Communicator of node leaders (created on first use)
+    MPI_Comm leader_comm = MPI_COMM_NULL;
+    // Rank in leader_comm of the node leader of each proc
+    vector<int> node_leaders;
+    // Largest number of procs in one node, same in all procs
+    int max_node_size = 0;
+    // Shared buffer for intra-node reductions
+    shared_ptr<ParallelSharedMemory> hier_buf = nullptr;
+    // Number of elements per proc in each intra-node reduction step
+    size_t hier_chunk_size = 1 << 22;
     MPICommunicator(int root = 0)
         : ParallelCommunicator<S>(MPI::size(), MPI::rank(), root) {
         para_type = ParallelTypes::Distributed;
@@ -96,11 +141,244 @@ template <typename S> struct MPICommunicator : ParallelCommunicator<S> {
         para_type = ParallelTypes::Distributed;
     }
     ~MPICommunicator() override {
+        hier_buf = nullptr;
+        if (leader_comm != MPI_COMM_NULL) {
+            int ierr = MPI_Comm_free(&leader_comm);
+            assert(ierr == 0);
+        }
+        if (node_comm != MPI_COMM_NULL) {
+            int ierr = MPI_Comm_free(&node_comm);
+            assert(ierr == 0);
+        }
         if (comm != MPI_COMM_WORLD && comm != MPI_COMM_NULL) {
             int ierr = MPI_Comm_free(&comm);
             assert(ierr == 0);
         }
     }
+    void init_node_comm() {
+        if (node_comm != MPI_COMM_NULL || comm == MPI_COMM_NULL)
+            return;
+        int ierr = MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank,
+                                       MPI_INFO_NULL, &node_comm);
+        assert(ierr == 0);
+        if (fixed_node_size != 0) {
+            MPI_Comm shm_comm = node_comm;
+            ierr = MPI_Comm_split(shm_comm, rank / fixed_node_size, rank,
+                                  &node_comm);
+            assert(ierr == 0);
+            ierr = MPI_Comm_free(&shm_comm);
+            assert(ierr == 0);
+        }
+        ierr = MPI_Comm_rank(node_comm, &_node_rank);
+        assert(ierr == 0);
+        ierr = MPI_Comm_size(node_comm, &_node_size);
+        assert(ierr == 0);
+    }
+    void send_file(const string &src, const string &dest, int from,
+                   int to) override {
+        if (from == to) {
+            if (rank == from && dest != src)
+                Parsing::copy_file(src, dest);
+            return;
+        }
+        _t.get_time();
+        int ierr;
+        uint64_t len = 0;
+        vector<char> buf;
+        if (rank == from) {
+            ifstream ifs(src.c_str(), ios::binary);
+            if (!ifs.good())
+                throw runtime_error("MPICommunicator::send_file on '" + src +
+                                    "' failed.");
+            buf.assign(istreambuf_iterator<char>(ifs),
+                       istreambuf_iterator<char>());
+            if (ifs.bad())
+                throw runtime_error("MPICommunicator::send_file on '" + src +
+                                    "' failed.");
+            ifs.close();
+            len = (uint64_t)buf.size();
+            ierr = MPI_Send(&len, 1, MPI_UINT64_T, to, 0, comm);
+            assert(ierr == 0);
+            for (size_t offset = 0; offset < len; offset += chunk_size) {
+                ierr = MPI_Send(buf.data() + offset,
+                                min(chunk_size, (size_t)len - offset),
+                                MPI_CHAR, to, 1, comm);
+                assert(ierr == 0);
+            }
+        } else if (rank == to) {
+            ierr = MPI_Recv(&len, 1, MPI_UINT64_T, from, 0, comm,
+                            MPI_STATUS_IGNORE);
+            assert(ierr == 0);
+            buf.resize(len);
+            for (size_t offset = 0; offset < len; offset += chunk_size) {
+                ierr = MPI_Recv(buf.data() + offset,
+                                min(chunk_size, (size_t)len - offset),
+                                MPI_CHAR, from, 1, comm, MPI_STATUS_IGNORE);
+                assert(ierr == 0);
+            }
+            // write to a temporary file first so that a partially
+            // received file is never visible under the final name
+            string tmp = dest + ".TMP";
+            ofstream ofs(tmp.c_str(), ios::binary);
+            if (!ofs.good())
+                throw runtime_error("MPICommunicator::send_file on '" + dest +
+                                    "' failed.");
+            ofs.write(buf.data(), buf.size());
+            if (!ofs.good())
+                throw runtime_error("MPICommunicator::send_file on '" + dest +
+                                    "' failed.");
+            ofs.close();
+            if (!Parsing::rename_file(tmp, dest))
+                throw runtime_error("MPICommunicator::send_file on '" + dest +
+                                    "' failed.");
+        }
+        tcomm += _t.get_time();
+    }
+    void alltoallv(const vector<vector<char>> &sdata,
+                   vector<vector<char>> &rdata) override {
+        assert((int)sdata.size() == size);
+        _t.get_time();
+        vector<uint64_t> slens(size), rlens(size);
+        for (int i = 0; i < size; i++)
+            slens[i] = (uint64_t)sdata[i].size();
+        int ierr = MPI_Alltoall(slens.data(), 1, MPI_UINT64_T, rlens.data(), 1,
+                                MPI_UINT64_T, comm);
+        assert(ierr == 0);
+        rdata.resize(size);
+        vector<MPI_Request> reqs;
+        for (int i = 0; i < size; i++) {
+            rdata[i].resize(rlens[i]);
+            if (i == rank) {
+                memcpy(rdata[i].data(), sdata[i].data(), rlens[i]);
+                continue;
+            }
+            for (size_t offset = 0; offset < rlens[i]; offset += chunk_size) {
+                reqs.push_back(MPI_Request());
+                ierr = MPI_Irecv(rdata[i].data() + offset,
+                                 min(chunk_size, (size_t)rlens[i] - offset),
+                                 MPI_CHAR, i, 2, comm, &reqs.back());
+                assert(ierr == 0);
+            }
+        }
+        for (int i = 0; i < size; i++) {
+            if (i == rank)
+                continue;
+            for (size_t offset = 0; offset < slens[i]; offset += chunk_size) {
+                reqs.push_back(MPI_Request());
+                ierr = MPI_Isend(sdata[i].data() + offset,
+                                 min(chunk_size, (size_t)slens[i] - offset),
+                                 MPI_CHAR, i, 2, comm, &reqs.back());
+                assert(ierr == 0);
+            }
+        }
+        ierr = MPI_Waitall((int)reqs.size(), reqs.data(), MPI_STATUSES_IGNORE);
+        assert(ierr == 0);
+        tcomm += _t.get_time();
+    }
+    // Build the two-level hierarchy of procs
+    // Returns whether hierarchical reductions can be used
+    // The result is the same in all procs (even if nodes have different
+    // numbers of procs), so that all procs call the same collectives
+    bool init_hierarchy() {
+        if (comm == MPI_COMM_NULL)
+            return false;
+        init_node_comm();
+        if (node_leaders.size() == 0) {
+            int ierr = MPI_Comm_split(
+                comm, _node_rank == 0 ? 0 : MPI_UNDEFINED, rank, &leader_comm);
+            assert(ierr == 0);
+            int ileader = -1;
+            if (_node_rank == 0) {
+                ierr = MPI_Comm_rank(leader_comm, &ileader);
+                assert(ierr == 0);
+            }
+            ierr = MPI_Bcast(&ileader, 1, MPI_INT, 0, node_comm);
+            assert(ierr == 0);
+            node_leaders.resize(size);
+            ierr = MPI_Allgather(&ileader, 1, MPI_INT, node_leaders.data(), 1,
+                                 MPI_INT, comm);
+            assert(ierr == 0);
+            ierr = MPI_Allreduce(&_node_size, &max_node_size, 1, MPI_INT,
+                                 MPI_MAX, comm);
+            assert(ierr == 0);
+        }
+        return max_node_size > 1;
+    }
+    // Two-level sum reduction (owner == -1 for allreduce)
+    // Step 1: each proc puts its data in the node-shared buffer and
+    //   all procs in the node sum one slice of the buffer
+    // Step 2: node leaders reduce the node sums between nodes
+    // Step 3: result is copied from the node-shared buffer
+    void hierarchical_reduce_sum(double *data, size_t len, int owner) {
+        size_t cs = min(len, hier_chunk_size);
+        if (hier_buf == nullptr ||
+            hier_buf->size < sizeof(double) * cs * _node_size) {
+            hier_buf = nullptr;
+            hier_buf = shared_allocate(sizeof(double) * cs * _node_size);
+        }
+        double *slots = (double *)hier_buf->data;
+        int owner_leader = owner == -1 ? -1 : node_leaders[owner];
+        for (size_t offset = 0; offset < len; offset += cs) {
+            size_t n = min(cs, len - offset);
+            if (offset != 0)
+                hier_buf->sync();
+            memcpy(slots + _node_rank * cs, data + offset, sizeof(double) * n);
+            hier_buf->sync();
+            size_t a = n * _node_rank / _node_size,
+                   b = n * (_node_rank + 1) / _node_size;
+            for (int k = 1; k < _node_size; k++)
+                for (size_t i = a; i < b; i++)
+                    slots[i] += slots[k * cs + i];
+            hier_buf->sync();
+            if (_node_rank == 0) {
+                int ierr;
+                if (owner == -1)
+                    ierr = MPI_Allreduce(MPI_IN_PLACE, slots, n, MPI_DOUBLE,
+                                         MPI_SUM, leader_comm);
+                else if (node_leaders[rank] == owner_leader)
+                    ierr = MPI_Reduce(MPI_IN_PLACE, slots, n, MPI_DOUBLE,
+                                      MPI_SUM, owner_leader, leader_comm);
+                else
+                    ierr = MPI_Reduce(slots, nullptr, n, MPI_DOUBLE, MPI_SUM,
+                                      owner_leader, leader_comm);
+                assert(ierr == 0);
+            }
+            hier_buf->sync();
+            if (owner == -1 || owner == rank)
+                memcpy(data + offset, slots, sizeof(double) * n);
+        }
+        hier_buf->sync();
+    }
+    int node_size() override {
+        init_node_comm();
+        return _node_size;
+    }
+    int node_rank() override {
+        init_node_comm();
+        return _node_rank;
+    }
+    shared_ptr<ParallelSharedMemory> shared_allocate(size_t len) override {
+        init_node_comm();
+        // _t may be in use by the caller
+        Timer t;
+        t.get_time();
+        MPI_Win win;
+        char *ptr = nullptr;
+        int ierr = MPI_Win_allocate_shared(
+            (MPI_Aint)(_node_rank == 0 ? len : 0), 1, MPI_INFO_NULL, node_comm,
+            &ptr, &win);
+        assert(ierr == 0);
+        if (_node_rank != 0) {
+            MPI_Aint qlen;
+            int disp_unit;
+            ierr = MPI_Win_shared_query(win, 0, &qlen, &disp_unit, &ptr);
+            assert(ierr == 0);
+            assert((size_t)qlen == len);
+        }
+        tcomm += t.get_time();
+        return make_shared<MPISharedMemory>(win, node_comm, ptr, len,
+                                            _node_rank == 0);
+    }
     shared_ptr<ParallelCommunicator<S>> split(int igroup, int irank) override {
         MPI_Comm icomm;
         int jrank, isize, ierr;
@@ -114,7 +392,11 @@ template <typename S> struct MPICommunicator : ParallelCommunicator<S> {
             assert(ierr == 0);
         } else
             isize = irank = -1;
-        return make_shared<MPICommunicator<S>>(icomm, isize, jrank);
+        shared_ptr<MPICommunicator<S>> r =
+            make_shared<MPICommunicator<S>>(icomm, isize, jrank);
+        r->hierarchical = hierarchical;
+        r->fixed_node_size = fixed_node_size;
+        return r;
     }
     void barrier() override {
         if (comm == MPI_COMM_NULL)
@@ -209,6 +491,11 @@ template <typename S> struct MPICommunicator : ParallelCommunicator<S> {
     }
     void allreduce_sum(double *data, size_t len) override {
         _t.get_time();
+        if (hierarchical && init_hierarchy()) {
+            hierarchical_reduce_sum(data, len, -1);
+            tcomm += _t.get_time();
+            return;
+        }
         for (size_t offset = 0; offset < len; offset += chunk_size) {
             int ierr = MPI_Allreduce(MPI_IN_PLACE, data + offset,
                                      min(chunk_size, len - offset), MPI_DOUBLE,
@@ -219,6 +506,11 @@ template <typename S> struct MPICommunicator : ParallelCommunicator<S> {
     }
     void allreduce_sum(complex<double> *data, size_t len) override {
         _t.get_time();
+        if (hierarchical && init_hierarchy()) {
+            hierarchical_reduce_sum((double *)data, len * 2, -1);
+            tcomm += _t.get_time();
+            return;
+        }
         for (size_t offset = 0; offset < len; offset += chunk_size) {
             int ierr = MPI_Allreduce(MPI_IN_PLACE, (double *)(data + offset),
                                      min(chunk_size, len - offset) * 2,
@@ -347,6 +639,11 @@ template <typename S> struct MPICommunicator : ParallelCommunicator<S> {
     }
     void reduce_sum(double *data, size_t len, int owner) override {
         _t.get_time();
+        if (hierarchical && init_hierarchy()) {
+            hierarchical_reduce_sum(data, len, owner);
+            tcomm += _t.get_time();
+            return;
+        }
         for (size_t offset = 0; offset < len; offset += chunk_size) {
             int ierr = MPI_Reduce(rank == owner ? MPI_IN_PLACE : data + offset,
                                   data + offset, min(chunk_size, len - offset),
@@ -357,6 +654,11 @@ template <typename S> struct MPICommunicator : ParallelCommunicator<S> {
     }
     void reduce_sum(complex<double> *data, size_t len, int owner) override {
         _t.get_time();
+        if (hierarchical && init_hierarchy()) {
+            hierarchical_reduce_sum((double *)data, len * 2, owner);
+            tcomm += _t.get_time();
+            return;
+        }
         for (size_t offset = 0; offset < len; offset += chunk_size) {
             int ierr = MPI_Reduce(
                 rank == owner ? MPI_IN_PLACE : (double *)(data + offset),
@@ -366,8 +668,15 @@ template <typename S> struct MPICommunicator : ParallelCommunicator<S> {
         }
         tcomm += _t.get_time();
     }
+    // In hierarchical mode, the intra-node step needs synchronization,
+    // so the reduction is done before returning
     void ireduce_sum(double *data, size_t len, int owner) override {
         _t.get_time();
+        if (hierarchical && init_hierarchy()) {
+            hierarchical_reduce_sum(data, len, owner);
+            tcomm += _t.get_time();
+            return;
+        }
         for (size_t offset = 0; offset < len; offset += chunk_size) {
             MPI_Request req;
             int ierr = MPI_Ireduce(rank == owner ? MPI_IN_PLACE : data + offset,
@@ -380,6 +689,11 @@ template <typename S> struct MPICommunicator : ParallelCommunicator<S> {
     }
     void ireduce_sum(complex<double> *data, size_t len, int owner) override {
         _t.get_time();
+        if (hierarchical && init_hierarchy()) {
+            hierarchical_reduce_sum((double *)data, len * 2, owner);
+            tcomm += _t.get_time();
+            return;
+        }
         for (size_t offset = 0; offset < len; offset += chunk_size) {
             MPI_Request req;
             int ierr = MPI_Ireduce(
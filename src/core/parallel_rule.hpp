@@ -35,6 +35,26 @@ enum ParallelOpTypes : uint8_t {
     Partial = 4
 };
 
+// Memory shared by all procs in the same node
+// Only the proc with writable == true can change the contents
+// Serial case: private heap memory
+struct ParallelSharedMemory {
+    char *data;
+    size_t size;
+    bool writable;
+    vector<char> vdata;
+    ParallelSharedMemory(size_t size)
+        : size(size), writable(true), vdata(size) {
+        data = vdata.data();
+    }
+    ParallelSharedMemory(char *data, size_t size, bool writable)
+        : data(data), size(size), writable(writable) {}
+    virtual ~ParallelSharedMemory() = default;
+    // Make contents written by the writable proc visible to all procs
+    // Collective over the procs sharing this memory
+    virtual void sync() {}
+};
+
 template <typename S> struct ParallelCommunicator {
     int size, rank, root, group, grank, gsize, ngroup;
     ParallelTypes para_type = ParallelTypes::Serial;
@@ -174,6 +194,67 @@ template <typename S> struct ParallelCommunicator {
     }
     virtual void allreduce_logical_or(bool &v) { assert(size == 1); }
     virtual void waitall() { assert(size == 1); }
+    // Personalized all-to-all exchange of byte buffers
+    // sdata[i] is sent to proc i; rdata[i] is received from proc i
+    virtual void alltoallv(const vector<vector<char>> &sdata,
+                           vector<vector<char>> &rdata) {
+        assert(size == 1 && sdata.size() == 1);
+        rdata = sdata;
+    }
+    // Point-to-point transfer of a scratch file from proc "from" to proc "to"
+    // src is only used in proc "from" and dest is only used in proc "to"
+    // Only procs "from" and "to" need to call this method
+    virtual void send_file(const string &src, const string &dest, int from,
+                           int to) {
+        assert(size == 1 && from == to);
+        if (dest != src)
+            Parsing::copy_file(src, dest);
+    }
+    // Number of procs and rank inside the node of this proc
+    virtual int node_size() { return 1; }
+    virtual int node_rank() { return 0; }
+    // Allocate len bytes shared by all procs in the same node
+    // Collective, writable only in node rank 0
+    virtual shared_ptr<ParallelSharedMemory> shared_allocate(size_t len) {
+        return make_shared<ParallelSharedMemory>(len);
+    }
+    // Keep only one copy of the data of (normal) sparse matrices in each node
+    // The matrices will no longer own their data
+    template <typename FL>
+    shared_ptr<ParallelSharedMemory>
+    node_share(const vector<shared_ptr<SparseMatrix<S, FL>>> &mats) {
+        size_t len = 0;
+        for (auto &mat : mats) {
+            assert(mat->get_type() == SparseMatrixTypes::Normal);
+            len += mat->total_memory;
+        }
+        if (node_size() == 1 || len == 0)
+            return nullptr;
+        Timer t;
+        t.get_time();
+        shared_ptr<ParallelSharedMemory> shm =
+            shared_allocate(sizeof(FL) * len);
+        FL *ptr = (FL *)shm->data;
+        if (shm->writable)
+            for (auto &mat : mats)
+                memcpy(ptr, mat->data, sizeof(FL) * mat->total_memory),
+                    ptr += mat->total_memory;
+        shm->sync();
+        vector<FL *> ptrs(mats.size());
+        vector<size_t> tms(mats.size());
+        ptr = (FL *)shm->data;
+        for (size_t i = 0; i < mats.size(); ptr += tms[i++])
+            ptrs[i] = ptr, tms[i] = mats[i]->total_memory;
+        // reverse order for stack allocators
+        for (size_t i = mats.size(); i > 0; i--)
+            mats[i - 1]->deallocate();
+        for (size_t i = 0; i < mats.size(); i++) {
+            mats[i]->alloc = nullptr;
+            mats[i]->data = ptrs[i], mats[i]->total_memory = tms[i];
+        }
+        tcomm += t.get_time();
+        return shm;
+    }
 };
 
 struct ParallelProperty {
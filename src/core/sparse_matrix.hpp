@@ -1197,10 +1197,12 @@ template <typename S, typename FL> struct SparseMatrix {
     }
     // l will have the same number of non-zero blocks as this matrix
     // s will be labelled by right q labels
-    void left_svd(vector<S> &rqs, vector<shared_ptr<GTensor<FL>>> &l,
-                  vector<shared_ptr<GTensor<FP>>> &s,
-                  vector<shared_ptr<GTensor<FL>>> &r, ubond_t bond_dim = 0,
-                  FP svd_eps = 0) const {
+    // returns the number of blocks decomposed by randomized svd
+    int left_svd(vector<S> &rqs, vector<shared_ptr<GTensor<FL>>> &l,
+                 vector<shared_ptr<GTensor<FP>>> &s,
+                 vector<shared_ptr<GTensor<FL>>> &r, ubond_t bond_dim = 0,
+                 FP svd_eps = 0, ubond_t rsvd_rank = 0,
+                 int rsvd_oversampling = 10, FP rsvd_eps = 1E-12) const {
         map<S, MKL_INT> qs_mp;
         for (int i = 0; i < info->n; i++) {
             S q = info->is_wavefunction ? -info->quanta[i].get_ket()
@@ -1230,33 +1232,50 @@ template <typename S, typename FL> struct SparseMatrix {
         for (int ir = 0; ir < nr; ir++)
             assert(it[ir] == tmp[ir + 1] - tmp[ir]);
         vector<shared_ptr<GTensor<FL>>> merged_l(nr);
+        vector<char> rsvd_used(nr, 0);
         r.resize(nr);
         s.resize(nr);
-        int ntg = threading->activate_global();
-#pragma omp parallel for schedule(dynamic) num_threads(ntg)
-        for (int ir = 0; ir < nr; ir++) {
+        vector<size_t> sizes(nr);
+        for (int ir = 0; ir < nr; ir++)
+            sizes[ir] = (size_t)(tmp[ir + 1] - tmp[ir]);
+        threading->parallel_for_blocks(sizes, [&](int ir) {
             MKL_INT nxr = sz[ir], nxl = (tmp[ir + 1] - tmp[ir]) / nxr;
             assert((tmp[ir + 1] - tmp[ir]) % nxr == 0);
             MKL_INT nxk = min(nxl, nxr);
-            shared_ptr<GTensor<FL>> tsl =
-                make_shared<GTensor<FL>>(vector<MKL_INT>{nxl, nxk});
-            shared_ptr<GTensor<FP>> tss =
-                make_shared<GTensor<FP>>(vector<MKL_INT>{nxk});
-            shared_ptr<GTensor<FL>> tsr =
-                make_shared<GTensor<FL>>(vector<MKL_INT>{nxk, nxr});
-            if (svd_eps != 0)
-                GMatrixFunctions<FL>::accurate_svd(
-                    GMatrix<FL>(dt + tmp[ir], nxl, nxr), tsl->ref(),
-                    tss->ref().flip_dims(), tsr->ref(), svd_eps);
-            else
-                GMatrixFunctions<FL>::svd(GMatrix<FL>(dt + tmp[ir], nxl, nxr),
-                                          tsl->ref(), tss->ref().flip_dims(),
-                                          tsr->ref());
+            MKL_INT nxs = min(nxk, (MKL_INT)rsvd_rank + rsvd_oversampling);
+            shared_ptr<GTensor<FL>> tsl, tsr;
+            shared_ptr<GTensor<FP>> tss;
+            // randomized svd only pays off when the block is much larger
+            // than the sampled rank; fall back to exact svd if inaccurate
+            if (rsvd_rank != 0 && 2 * nxs < nxk) {
+                tsl = make_shared<GTensor<FL>>(vector<MKL_INT>{nxl, nxs});
+                tss = make_shared<GTensor<FP>>(vector<MKL_INT>{nxs});
+                tsr = make_shared<GTensor<FL>>(vector<MKL_INT>{nxs, nxr});
+                if (GMatrixFunctions<FL>::randomized_svd(
+                        GMatrix<FL>(dt + tmp[ir], nxl, nxr), tsl->ref(),
+                        tss->ref().flip_dims(), tsr->ref(), rsvd_rank,
+                        rsvd_eps))
+                    rsvd_used[ir] = 1;
+                else
+                    tsl = nullptr;
+            }
+            if (tsl == nullptr) {
+                tsl = make_shared<GTensor<FL>>(vector<MKL_INT>{nxl, nxk});
+                tss = make_shared<GTensor<FP>>(vector<MKL_INT>{nxk});
+                tsr = make_shared<GTensor<FL>>(vector<MKL_INT>{nxk, nxr});
+                if (svd_eps != 0)
+                    GMatrixFunctions<FL>::accurate_svd(
+                        GMatrix<FL>(dt + tmp[ir], nxl, nxr), tsl->ref(),
+                        tss->ref().flip_dims(), tsr->ref(), svd_eps);
+                else
+                    GMatrixFunctions<FL>::svd(
+                        GMatrix<FL>(dt + tmp[ir], nxl, nxr), tsl->ref(),
+                        tss->ref().flip_dims(), tsr->ref());
+            }
             merged_l[ir] = tsl;
             s[ir] = tss;
             r[ir] = tsr;
-        }
-        threading->activate_normal();
+        });
         vector<FP> svals;
         for (int ir = 0; ir < nr; ir++)
             svals.insert(svals.end(), s[ir]->data.begin(), s[ir]->data.end());
@@ -1288,13 +1307,16 @@ template <typename S, typename FL> struct SparseMatrix {
         for (int ir = 0; ir < nr; ir++)
             assert(it[ir] == merged_l[ir]->size());
         dalloc->deallocate(dt, tmp[nr] * cpx_sz);
+        return (int)count(rsvd_used.begin(), rsvd_used.end(), 1);
     }
     // r will have the same number of non-zero blocks as this matrix
     // s will be labelled by left q labels
-    void right_svd(vector<S> &lqs, vector<shared_ptr<GTensor<FL>>> &l,
-                   vector<shared_ptr<GTensor<FP>>> &s,
-                   vector<shared_ptr<GTensor<FL>>> &r, ubond_t bond_dim = 0,
-                   FP svd_eps = 0) const {
+    // returns the number of blocks decomposed by randomized svd
+    int right_svd(vector<S> &lqs, vector<shared_ptr<GTensor<FL>>> &l,
+                  vector<shared_ptr<GTensor<FP>>> &s,
+                  vector<shared_ptr<GTensor<FL>>> &r, ubond_t bond_dim = 0,
+                  FP svd_eps = 0, ubond_t rsvd_rank = 0,
+                  int rsvd_oversampling = 10, FP rsvd_eps = 1E-12) const {
         map<S, MKL_INT> qs_mp;
         for (int i = 0; i < info->n; i++) {
             S q = info->quanta[i].get_bra(info->delta_quantum);
@@ -1326,33 +1348,50 @@ template <typename S, typename FL> struct SparseMatrix {
         for (int il = 0; il < nl; il++)
             assert(it[il] == (tmp[il + 1] - tmp[il]) / sz[il]);
         vector<shared_ptr<GTensor<FL>>> merged_r(nl);
+        vector<char> rsvd_used(nl, 0);
         l.resize(nl);
         s.resize(nl);
-        int ntg = threading->activate_global();
-#pragma omp parallel for schedule(dynamic) num_threads(ntg)
-        for (int il = 0; il < nl; il++) {
+        vector<size_t> sizes(nl);
+        for (int il = 0; il < nl; il++)
+            sizes[il] = (size_t)(tmp[il + 1] - tmp[il]);
+        threading->parallel_for_blocks(sizes, [&](int il) {
             MKL_INT nxl = sz[il], nxr = (tmp[il + 1] - tmp[il]) / nxl;
             assert((tmp[il + 1] - tmp[il]) % nxl == 0);
             MKL_INT nxk = min(nxl, nxr);
-            shared_ptr<GTensor<FL>> tsl =
-                make_shared<GTensor<FL>>(vector<MKL_INT>{nxl, nxk});
-            shared_ptr<GTensor<FP>> tss =
-                make_shared<GTensor<FP>>(vector<MKL_INT>{nxk});
-            shared_ptr<GTensor<FL>> tsr =
-                make_shared<GTensor<FL>>(vector<MKL_INT>{nxk, nxr});
-            if (svd_eps != 0)
-                GMatrixFunctions<FL>::accurate_svd(
-                    GMatrix<FL>(dt + tmp[il], nxl, nxr), tsl->ref(),
-                    tss->ref().flip_dims(), tsr->ref(), svd_eps);
-            else
-                GMatrixFunctions<FL>::svd(GMatrix<FL>(dt + tmp[il], nxl, nxr),
-                                          tsl->ref(), tss->ref().flip_dims(),
-                                          tsr->ref());
+            MKL_INT nxs = min(nxk, (MKL_INT)rsvd_rank + rsvd_oversampling);
+            shared_ptr<GTensor<FL>> tsl, tsr;
+            shared_ptr<GTensor<FP>> tss;
+            // randomized svd only pays off when the block is much larger
+            // than the sampled rank; fall back to exact svd if inaccurate
+            if (rsvd_rank != 0 && 2 * nxs < nxk) {
+                tsl = make_shared<GTensor<FL>>(vector<MKL_INT>{nxl, nxs});
+                tss = make_shared<GTensor<FP>>(vector<MKL_INT>{nxs});
+                tsr = make_shared<GTensor<FL>>(vector<MKL_INT>{nxs, nxr});
+                if (GMatrixFunctions<FL>::randomized_svd(
+                        GMatrix<FL>(dt + tmp[il], nxl, nxr), tsl->ref(),
+                        tss->ref().flip_dims(), tsr->ref(), rsvd_rank,
+                        rsvd_eps))
+                    rsvd_used[il] = 1;
+                else
+                    tsl = nullptr;
+            }
+            if (tsl == nullptr) {
+                tsl = make_shared<GTensor<FL>>(vector<MKL_INT>{nxl, nxk});
+                tss = make_shared<GTensor<FP>>(vector<MKL_INT>{nxk});
+                tsr = make_shared<GTensor<FL>>(vector<MKL_INT>{nxk, nxr});
+                if (svd_eps != 0)
+                    GMatrixFunctions<FL>::accurate_svd(
+                        GMatrix<FL>(dt + tmp[il], nxl, nxr), tsl->ref(),
+                        tss->ref().flip_dims(), tsr->ref(), svd_eps);
+                else
+                    GMatrixFunctions<FL>::svd(
+                        GMatrix<FL>(dt + tmp[il], nxl, nxr), tsl->ref(),
+                        tss->ref().flip_dims(), tsr->ref());
+            }
             l[il] = tsl;
             s[il] = tss;
             merged_r[il] = tsr;
-        }
-        threading->activate_normal();
+        });
         vector<FP> svals;
         for (int il = 0; il < nl; il++)
             svals.insert(svals.end(), s[il]->data.begin(), s[il]->data.end());
@@ -1387,6 +1426,7 @@ template <typename S, typename FL> struct SparseMatrix {
         for (int il = 0; il < nl; il++)
             assert(it[il] == merged_r[il]->shape[1]);
         dalloc->deallocate(dt, tmp[nl] * cpx_sz);
+        return (int)count(rsvd_used.begin(), rsvd_used.end(), 1);
     }
     void left_canonicalize(const shared_ptr<SparseMatrix> &rmat) {
         int nr = rmat->info->n, n = info->n;
@@ -2094,9 +2134,10 @@ template <typename S, typename FL> struct SparseMatrixGroup {
         vector<shared_ptr<GTensor<FL>>> merged_l(nr);
         r.resize(nr);
         s.resize(nr);
-        int ntg = threading->activate_global();
-#pragma omp parallel for schedule(dynamic) num_threads(ntg)
-        for (int ir = 0; ir < nr; ir++) {
+        vector<size_t> sizes(nr);
+        for (int ir = 0; ir < nr; ir++)
+            sizes[ir] = (size_t)(tmp[ir + 1] - tmp[ir]);
+        threading->parallel_for_blocks(sizes, [&](int ir) {
             MKL_INT nxr = (MKL_INT)sz[ir],
                     nxl = (MKL_INT)((tmp[ir + 1] - tmp[ir]) / nxr);
             assert((tmp[ir + 1] - tmp[ir]) % nxr == 0);
@@ -2113,8 +2154,7 @@ template <typename S, typename FL> struct SparseMatrixGroup {
             merged_l[ir] = tsl;
             s[ir] = tss;
             r[ir] = tsr;
-        }
-        threading->activate_normal();
+        });
         memset(it.data(), 0, sizeof(size_t) * nr);
         l.resize(xinfos.size());
         for (int ii = 0; ii < (int)xinfos.size(); ii++) {
@@ -2209,9 +2249,10 @@ template <typename S, typename FL> struct SparseMatrixGroup {
         vector<shared_ptr<GTensor<FL>>> merged_r(nl);
         l.resize(nl);
         s.resize(nl);
-        int ntg = threading->activate_global();
-#pragma omp parallel for schedule(dynamic) num_threads(ntg)
-        for (int il = 0; il < nl; il++) {
+        vector<size_t> sizes(nl);
+        for (int il = 0; il < nl; il++)
+            sizes[il] = (size_t)(tmp[il + 1] - tmp[il]);
+        threading->parallel_for_blocks(sizes, [&](int il) {
             MKL_INT nxl = (MKL_INT)sz[il],
                     nxr = (MKL_INT)((tmp[il + 1] - tmp[il]) / nxl);
             assert((tmp[il + 1] - tmp[il]) % nxl == 0);
@@ -2228,8 +2269,7 @@ template <typename S, typename FL> struct SparseMatrixGroup {
             l[il] = tsl;
             s[il] = tss;
             merged_r[il] = tsr;
-        }
-        threading->activate_normal();
+        });
         memset(it.data(), 0, sizeof(size_t) * nl);
         r.resize(xinfos.size());
         for (int ii = 0; ii < (int)xinfos.size(); ii++) {
@@ -32,6 +32,7 @@
 #endif
 #include "mkl.h"
 #endif
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstring>
@@ -149,6 +150,10 @@ struct Threading {
                               //!< dense matrix multiplications.
         n_threads_global = 0, //!< Number of threads for general tasks
         n_levels = 0;         //!< Number of nested threading layers
+    size_t mkl_block_size =
+        (size_t)1 << 20; //!< Dense blocks with more elements than this are
+                         //!< decomposed with threaded MKL, one at a time
+                         //!< (zero means no such blocks).
     /** Whether openmp compiler option is set. */
     bool openmp_available() const {
 #ifdef _OPENMP
@@ -309,6 +314,38 @@ struct Threading {
         return 1;
 #endif
     }
+    /** Run independent dense block decompositions (SVD or
+     * diagonalization of each symmetry sector) in parallel.
+     * Blocks are scheduled largest-first over global threads, with
+     * single-threaded MKL inside each block. Blocks larger than
+     * ``mkl_block_size`` are done first, one at a time, with threaded MKL.
+     * @param sizes Number of matrix elements of each block.
+     * @param f Function decomposing the block with the given index.
+     */
+    template <typename F>
+    void parallel_for_blocks(const vector<size_t> &sizes, F f) const {
+        vector<int> idx(sizes.size());
+        for (int i = 0; i < (int)idx.size(); i++)
+            idx[i] = i;
+        stable_sort(idx.begin(), idx.end(), [&sizes](int i, int j) {
+            return sizes[i] > sizes[j];
+        });
+        int nlarge = 0;
+        if (mkl_block_size != 0)
+            while (nlarge < (int)idx.size() &&
+                   sizes[idx[nlarge]] > mkl_block_size)
+                nlarge++;
+        if (nlarge != 0) {
+            activate_global_mkl();
+            for (int i = 0; i < nlarge; i++)
+                f(idx[i]);
+        }
+        int ntg = activate_global();
+#pragma omp parallel for schedule(dynamic) num_threads(ntg)
+        for (int i = nlarge; i < (int)idx.size(); i++)
+            f(idx[i]);
+        activate_normal();
+    }
     /** Default constructor.
      * Uses ``ThreadingTypes::Global | ThreadingTypes::BatchedGEMM``
      * with maximal available number of threads, and ``SeqTypes::None``
@@ -29,12 +29,15 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <random>
 #include <type_traits>
 #include <sstream>
 #include <string>
 #include <sys/stat.h>
 #ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
 #include <sys/time.h>
 #include <unistd.h>
 #define _mkdir(x) ::mkdir(x, 0755)
@@ -322,6 +325,79 @@ struct Parsing {
         return stat(name.c_str(), &buffer) == 0 && (buffer.st_mode & S_IFDIR);
     }
     static void mkdir(const string &name) { _mkdir(name.c_str()); }
+    // Names of entries (excluding "." and "..") in a directory
+    static vector<string> list_dir(const string &name) {
+        vector<string> r;
+#ifdef _WIN32
+        struct _finddata_t fd;
+        intptr_t h = _findfirst((name + "/*").c_str(), &fd);
+        if (h == -1)
+            return r;
+        do
+            if (string(fd.name) != "." && string(fd.name) != "..")
+                r.push_back(fd.name);
+        while (_findnext(h, &fd) == 0);
+        _findclose(h);
+#else
+        DIR *dir = opendir(name.c_str());
+        if (dir == nullptr)
+            return r;
+        for (struct dirent *ent = readdir(dir); ent != nullptr;
+             ent = readdir(dir))
+            if (string(ent->d_name) != "." && string(ent->d_name) != "..")
+                r.push_back(ent->d_name);
+        closedir(dir);
+#endif
+        return r;
+    }
+    // Remove a directory containing only files
+    static bool remove_dir(const string &name) {
+        for (auto &x : list_dir(name))
+            remove_file(name + "/" + x);
+#ifdef _WIN32
+        return _rmdir(name.c_str()) == 0;
+#else
+        return rmdir(name.c_str()) == 0;
+#endif
+    }
+    // Flush contents of a file or directory to disk
+    static bool sync_file(const string &name) {
+#ifdef _WIN32
+        return true;
+#else
+        int fd = open(name.c_str(), O_RDONLY);
+        if (fd == -1)
+            return false;
+        bool r = fsync(fd) == 0;
+        return close(fd) == 0 && r;
+#endif
+    }
+    static string read_file(const string &name) {
+        ifstream ifs(name.c_str(), ios::binary);
+        if (!ifs.good())
+            throw runtime_error("read_file '" + name + "' failed.");
+        string r((istreambuf_iterator<char>(ifs)), istreambuf_iterator<char>());
+        if (ifs.bad())
+            throw runtime_error("read_file '" + name + "' failed.");
+        ifs.close();
+        return r;
+    }
+    // 64-bit FNV-1a hash of a sequence of bytes
+    static uint64_t hash_string(const string &x,
+                                uint64_t h = 14695981039346656037ULL) {
+        for (size_t i = 0; i < x.size(); i++)
+            h = (h ^ (uint8_t)x[i]) * 1099511628211ULL;
+        return h;
+    }
+    static void write_file(const string &name, const string &contents) {
+        ofstream ofs(name.c_str(), ios::binary);
+        if (!ofs.good())
+            throw runtime_error("write_file '" + name + "' failed.");
+        ofs.write(contents.data(), contents.size());
+        if (!ofs.good())
+            throw runtime_error("write_file '" + name + "' failed.");
+        ofs.close();
+    }
 };
 
 } // namespace block2
@@ -358,14 +358,16 @@ struct EffectiveHamiltonian<S, FL, MPS<S, FL>> {
     }
     // Find eigenvalues and eigenvectors of [H_eff]
     // energy, ndav, nflop, tdav
+    // nmult: if not null, the number of [H_eff] x [b] is added to it
     tuple<FP, int, size_t, double>
     eigs(bool iprint = false, FP conv_thrd = 5E-6, int max_iter = 5000,
          int soft_max_iter = -1,
          DavidsonTypes davidson_type = DavidsonTypes::Normal, FP shift = 0,
          const shared_ptr<ParallelRule<S>> &para_rule = nullptr,
          const vector<shared_ptr<SparseMatrix<S, FL>>> &ortho_bra =
-             vector<shared_ptr<SparseMatrix<S, FL>>>()) {
-        int ndav = 0;
+             vector<shared_ptr<SparseMatrix<S, FL>>>(),
+         FP *init_qq = nullptr, int *nmult = nullptr) {
+        int ndav = 0, nm = 0;
         assert(compute_diag);
         GDiagonalMatrix<FL> aa(diag->data, (MKL_INT)diag->total_memory);
         vector<GMatrix<FL>> bs = vector<GMatrix<FL>>{
@@ -380,22 +382,26 @@ struct EffectiveHamiltonian<S, FL, MPS<S, FL>> {
         t.get_time();
         tf->opf->seq->cumulative_nflop = 0;
         precompute();
-        vector<FP> eners =
-            (tf->opf->seq->mode == SeqTypes::Auto ||
-             (tf->opf->seq->mode & SeqTypes::Tasked))
-                ? IterativeMatrixFunctions<FL>::harmonic_davidson(
-                      *tf, aa, bs, shift, davidson_type, ndav, iprint,
-                      para_rule == nullptr ? nullptr : para_rule->comm,
-                      conv_thrd, max_iter, soft_max_iter, 2, 50, ors)
-                : IterativeMatrixFunctions<FL>::harmonic_davidson(
-                      *this, aa, bs, shift, davidson_type, ndav, iprint,
-                      para_rule == nullptr ? nullptr : para_rule->comm,
-                      conv_thrd, max_iter, soft_max_iter, 2, 50, ors);
+        const function<void(const GMatrix<FL> &, const GMatrix<FL> &)> &f =
+            [this, &nm](const GMatrix<FL> &a, const GMatrix<FL> &b) {
+                nm++;
+                if (this->tf->opf->seq->mode == SeqTypes::Auto ||
+                    (this->tf->opf->seq->mode & SeqTypes::Tasked))
+                    return this->tf->operator()(a, b);
+                else
+                    return (*this)(a, b);
+            };
+        vector<FP> eners = IterativeMatrixFunctions<FL>::harmonic_davidson(
+            f, aa, bs, shift, davidson_type, ndav, iprint,
+            para_rule == nullptr ? nullptr : para_rule->comm, conv_thrd,
+            max_iter, soft_max_iter, 2, 50, ors, init_qq);
         post_precompute();
         uint64_t nflop = tf->opf->seq->cumulative_nflop;
         if (para_rule != nullptr)
             para_rule->comm->reduce_sum(&nflop, 1, para_rule->comm->root);
         tf->opf->seq->cumulative_nflop = 0;
+        if (nmult != nullptr)
+            *nmult += nm;
         return make_tuple(eners[0], ndav, (size_t)nflop, t.get_time());
     }
     // [bra] = [H_eff]^(-1) x [ket]
@@ -1322,12 +1328,14 @@ struct EffectiveHamiltonian<S, FL, MultiMPS<S, FL>> {
     }
     // Find eigenvalues and eigenvectors of [H_eff]
     // energies, ndav, nflop, tdav
+    // nmult: if not null, the number of [H_eff] x [b] is added to it
     tuple<vector<FP>, int, size_t, double>
     eigs(bool iprint = false, FP conv_thrd = 5E-6, int max_iter = 5000,
          int soft_max_iter = -1,
          DavidsonTypes davidson_type = DavidsonTypes::Normal, FP shift = 0,
-         const shared_ptr<ParallelRule<S>> &para_rule = nullptr) {
-        int ndav = 0;
+         const shared_ptr<ParallelRule<S>> &para_rule = nullptr,
+         int *nmult = nullptr) {
+        int ndav = 0, nm = 0;
         assert(compute_diag);
         GDiagonalMatrix<FL> aa(diag->data, (MKL_INT)diag->total_memory);
         vector<GMatrix<FL>> bs;
@@ -1339,22 +1347,26 @@ struct EffectiveHamiltonian<S, FL, MultiMPS<S, FL>> {
         t.get_time();
         tf->opf->seq->cumulative_nflop = 0;
         precompute();
-        vector<FP> eners =
-            (tf->opf->seq->mode == SeqTypes::Auto ||
-             (tf->opf->seq->mode & SeqTypes::Tasked))
-                ? IterativeMatrixFunctions<FL>::harmonic_davidson(
-                      *tf, aa, bs, shift, davidson_type, ndav, iprint,
-                      para_rule == nullptr ? nullptr : para_rule->comm,
-                      conv_thrd, max_iter, soft_max_iter)
-                : IterativeMatrixFunctions<FL>::harmonic_davidson(
-                      *this, aa, bs, shift, davidson_type, ndav, iprint,
-                      para_rule == nullptr ? nullptr : para_rule->comm,
-                      conv_thrd, max_iter, soft_max_iter);
+        const function<void(const GMatrix<FL> &, const GMatrix<FL> &)> &f =
+            [this, &nm](const GMatrix<FL> &a, const GMatrix<FL> &b) {
+                nm++;
+                if (this->tf->opf->seq->mode == SeqTypes::Auto ||
+                    (this->tf->opf->seq->mode & SeqTypes::Tasked))
+                    return this->tf->operator()(a, b);
+                else
+                    return (*this)(a, b);
+            };
+        vector<FP> eners = IterativeMatrixFunctions<FL>::harmonic_davidson(
+            f, aa, bs, shift, davidson_type, ndav, iprint,
+            para_rule == nullptr ? nullptr : para_rule->comm, conv_thrd,
+            max_iter, soft_max_iter);
         post_precompute();
         uint64_t nflop = tf->opf->seq->cumulative_nflop;
         if (para_rule != nullptr)
             para_rule->comm->reduce_sum(&nflop, 1, para_rule->comm->root);
         tf->opf->seq->cumulative_nflop = 0;
+        if (nmult != nullptr)
+            *nmult += nm;
         return make_tuple(eners, ndav, (size_t)nflop, t.get_time());
     }
     shared_ptr<OpExpr<S>>
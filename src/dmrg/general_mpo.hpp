@@ -0,0 +1,581 @@
+
+/*
+ * block2: Efficient MPO implementation of quantum chemistry DMRG
+ * Copyright (C) 2020-2021 Huanchen Zhai <hczhai@caltech.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+/** MPO construction from a general sum of operator strings. */
+
+#pragma once
+
+#include "../core/delayed_tensor_functions.hpp"
+#include "../core/hamiltonian.hpp"
+#include "../core/matching.hpp"
+#include "../core/operator_tensor.hpp"
+#include "../core/symbolic.hpp"
+#include "../core/tensor_functions.hpp"
+#include "mpo.hpp"
+#include <cstring>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+namespace block2 {
+
+/** Algorithm for compressing the virtual bond of a general MPO. */
+enum struct MPOAlgorithmTypes : uint8_t {
+    Bipartite, //!< Minimum vertex cover of the bipartite graph (exact).
+    SVD        //!< SVD of the coefficient matrix, with a cutoff.
+};
+
+/** Quantum numbers supported by GeneralMPO.
+ * The bond quantum numbers are sums of operator quantum numbers, which is
+ * not well defined for spin-adapted (SU2) operators.
+ */
+template <typename S, typename = void> struct GeneralMPOSymmetry {
+    static const bool supported = false;
+};
+
+template <typename S> struct GeneralMPOSymmetry<S, typename S::is_sz_t> {
+    static const bool supported = true;
+};
+
+template <typename S> struct GeneralMPOSymmetry<S, typename S::is_sg_t> {
+    static const bool supported = true;
+};
+
+/** MPO of a general sum of operator strings
+ * H = sum_t c_t O_{t,1} O_{t,2} ..., where each O is an elementary site
+ * operator acting on site ``site_index[0]``.
+ * The virtual bond is built from left to right. At each cut, the terms
+ * form a bipartite graph between the distinct left parts (a left bond
+ * operator times a site operator) and the distinct right parts (the
+ * remaining operator strings). The new bond operators are taken from a
+ * minimum vertex cover of this graph, or from the SVD of its coefficient
+ * matrix, so that no complementary operator scheme is needed. Products of
+ * operators on the same site are combined into one site operator named
+ * ``X``. Spin-adapted quantum numbers are not supported.
+ * @tparam S Quantum label type (SZ or SG types).
+ * @tparam FL float point type.
+ */
+template <typename S, typename FL> struct GeneralMPO : MPO<S, FL> {
+    static_assert(GeneralMPOSymmetry<S>::supported,
+                  "GeneralMPO: spin-adapted quantum numbers are not "
+                  "supported.");
+    typedef typename GMatrix<FL>::FP FP;
+    using MPO<S, FL>::n_sites;
+    MPOAlgorithmTypes algo_type; //!< Bond compression algorithm.
+    FP cutoff; //!< Relative cutoff for singular values (SVD only).
+    /** Constructor.
+     * @param hamil Hamiltonian providing the site operators.
+     * @param terms Operator strings.
+     * @param coeffs Coefficient of each operator string.
+     * @param algo_type Bond compression algorithm.
+     * @param cutoff Singular values and elements of the singular vectors
+     *   smaller than this times the largest one (in the same quantum number
+     *   block or singular vector) are discarded (SVD only).
+     * @param const_e Constant energy shift.
+     */
+    GeneralMPO(const shared_ptr<Hamiltonian<S, FL>> &hamil,
+               const vector<vector<shared_ptr<OpElement<S, FL>>>> &terms,
+               const vector<FL> &coeffs,
+               MPOAlgorithmTypes algo_type = MPOAlgorithmTypes::Bipartite,
+               FP cutoff = (FP)1E-12, FL const_e = (FL)0.0)
+        : MPO<S, FL>(hamil->n_sites), algo_type(algo_type), cutoff(cutoff) {
+        const S vacuum = hamil->vacuum;
+        shared_ptr<OpElement<S, FL>> i_op =
+            make_shared<OpElement<S, FL>>(OpNames::I, SiteIndex(), vacuum);
+        shared_ptr<VectorAllocator<FP>> d_alloc =
+            make_shared<VectorAllocator<FP>>();
+        if (n_sites < 2)
+            throw runtime_error("GeneralMPO: at least two sites are needed.");
+        if (terms.size() != coeffs.size())
+            throw runtime_error("GeneralMPO: number of terms and "
+                                "coefficients does not match.");
+        if (hamil->opf != nullptr &&
+            hamil->opf->get_type() == SparseMatrixTypes::CSR) {
+            if (hamil->get_n_orbs_left() > 0)
+                MPO<S, FL>::sparse_form[0] = 'S';
+            if (hamil->get_n_orbs_right() > 0)
+                MPO<S, FL>::sparse_form[n_sites - 1] = 'S';
+        }
+        // elementary site operators
+        vector<unordered_map<OpElement<S, FL>, int>> elem_mp(n_sites);
+        vector<vector<shared_ptr<OpElement<S, FL>>>> elems(n_sites);
+        // site operators (products of elementary site operators)
+        vector<map<vector<int>, int>> sop_mp(n_sites);
+        vector<vector<vector<int>>> sops(n_sites);
+        // terms as (site, site operator) lists sorted by site
+        vector<vector<pair<uint16_t, int>>> tops;
+        vector<FL> tcoeffs;
+        S qh(S::invalid);
+        for (size_t it = 0; it < terms.size(); it++) {
+            FL f = coeffs[it];
+            S q = vacuum;
+            vector<pair<uint16_t, shared_ptr<OpElement<S, FL>>>> xops;
+            xops.reserve(terms[it].size());
+            for (auto &op : terms[it]) {
+                if (op->site_index.size() == 0 ||
+                    op->site_index[0] >= n_sites)
+                    throw runtime_error("GeneralMPO: invalid site index.");
+                uint16_t m = op->site_index[0];
+                f *= op->factor;
+                xops.push_back(make_pair(
+                    m, dynamic_pointer_cast<OpElement<S, FL>>(
+                           abs_value((shared_ptr<OpExpr<S>>)op))));
+                q = (q + op->q_label)[0];
+            }
+            // stable sort by site, with fermionic sign
+            for (size_t i = 1; i < xops.size(); i++)
+                for (size_t j = i; j > 0 && xops[j - 1].first > xops[j].first;
+                     j--) {
+                    if (xops[j - 1].second->q_label.is_fermion() &&
+                        xops[j].second->q_label.is_fermion())
+                        f = -f;
+                    swap(xops[j - 1], xops[j]);
+                }
+            if (f == (FL)0.0)
+                continue;
+            if (qh == S(S::invalid))
+                qh = q;
+            else if (q != qh)
+                throw runtime_error("GeneralMPO: terms have different "
+                                    "quantum numbers.");
+            vector<pair<uint16_t, int>> top;
+            for (size_t i = 0, j; i < xops.size(); i = j) {
+                uint16_t m = xops[i].first;
+                vector<int> ids;
+                for (j = i; j < xops.size() && xops[j].first == m; j++) {
+                    auto p = elem_mp[m].find(*xops[j].second);
+                    if (p == elem_mp[m].end()) {
+                        p = elem_mp[m]
+                                .insert(make_pair(*xops[j].second,
+                                                  (int)elems[m].size()))
+                                .first;
+                        elems[m].push_back(xops[j].second);
+                    }
+                    ids.push_back(p->second);
+                }
+                auto p = sop_mp[m].find(ids);
+                if (p == sop_mp[m].end()) {
+                    p = sop_mp[m].insert(make_pair(ids, (int)sops[m].size()))
+                            .first;
+                    sops[m].push_back(ids);
+                }
+                top.push_back(make_pair(m, p->second));
+            }
+            tops.push_back(top);
+            tcoeffs.push_back(f);
+        }
+        if (tops.size() == 0)
+            throw runtime_error("GeneralMPO: no non-zero terms.");
+        MPO<S, FL>::op =
+            make_shared<OpElement<S, FL>>(OpNames::H, SiteIndex(), qh);
+        MPO<S, FL>::const_e = const_e;
+        if (hamil->delayed == DelayedOpNames::None)
+            MPO<S, FL>::tf = make_shared<TensorFunctions<S, FL>>(hamil->opf);
+        else
+            MPO<S, FL>::tf =
+                make_shared<DelayedTensorFunctions<S, FL>>(hamil->opf);
+        MPO<S, FL>::site_op_infos = hamil->site_op_infos;
+        MPO<S, FL>::basis = hamil->basis;
+        // site operator matrices
+        vector<vector<shared_ptr<OpElement<S, FL>>>> sop_exprs(n_sites);
+        vector<vector<shared_ptr<SparseMatrix<S, FL>>>> sop_mats(n_sites);
+        vector<shared_ptr<SparseMatrix<S, FL>>> i_mats(n_sites);
+        for (uint16_t m = 0; m < n_sites; m++) {
+            shared_ptr<SymbolicRowVector<S>> pelem =
+                make_shared<SymbolicRowVector<S>>((int)elems[m].size());
+            for (size_t i = 0; i < elems[m].size(); i++)
+                (*pelem)[i] = elems[m][i];
+            unordered_map<shared_ptr<OpExpr<S>>,
+                          shared_ptr<SparseMatrix<S, FL>>>
+                eops;
+            hamil->filter_site_ops(m, {pelem}, eops);
+            i_mats[m] = eops.at(i_op);
+            for (auto &ids : sops[m]) {
+                shared_ptr<OpExpr<S>> xop = elems[m][ids[0]];
+                shared_ptr<SparseMatrix<S, FL>> mat =
+                    eops.count(xop) ? eops.at(xop) : nullptr;
+                S q = elems[m][ids[0]]->q_label;
+                if (ids.size() == 1) {
+                    sop_exprs[m].push_back(elems[m][ids[0]]);
+                    sop_mats[m].push_back(mat);
+                    continue;
+                }
+                if (hamil->delayed != DelayedOpNames::None)
+                    throw runtime_error("GeneralMPO: same-site operator "
+                                        "products need non-delayed "
+                                        "site operators.");
+                for (size_t i = 1; i < ids.size(); i++) {
+                    q = (q + elems[m][ids[i]]->q_label)[0];
+                    xop = elems[m][ids[i]];
+                    shared_ptr<SparseMatrixInfo<S>> info =
+                        hamil->find_site_op_info(m, q);
+                    shared_ptr<SparseMatrix<S, FL>> c = nullptr;
+                    if (mat != nullptr && eops.count(xop) && info != nullptr) {
+                        c = make_shared<SparseMatrix<S, FL>>(d_alloc);
+                        c->allocate(info);
+                        hamil->opf->product(0, mat, eops.at(xop), c);
+                    }
+                    if (i != 1 && mat != nullptr)
+                        mat->deallocate();
+                    mat = c;
+                }
+                if (mat != nullptr && mat->norm() < TINY) {
+                    mat->deallocate();
+                    mat = nullptr;
+                }
+                int k = (int)sop_exprs[m].size();
+                sop_exprs[m].push_back(make_shared<OpElement<S, FL>>(
+                    OpNames::X,
+                    SiteIndex({m, (uint16_t)(k >> 12), (uint16_t)(k & 0xFFF)},
+                              {}),
+                    q));
+                sop_mats[m].push_back(mat);
+            }
+        }
+        // site operators proportional to an earlier one are merged
+        // (for example, same-site products in a different order)
+        vector<vector<pair<int, FL>>> sop_map(n_sites);
+        for (uint16_t m = 0; m < n_sites; m++)
+            for (int k = 0; k < (int)sops[m].size(); k++) {
+                sop_map[m].push_back(make_pair(k, (FL)1.0));
+                shared_ptr<SparseMatrix<S, FL>> b =
+                    hamil->delayed == DelayedOpNames::None ? sop_mats[m][k]
+                                                           : nullptr;
+                for (int j = 0; j < k && b != nullptr; j++) {
+                    shared_ptr<SparseMatrix<S, FL>> a = sop_mats[m][j];
+                    if (sop_map[m][j].first != j || a == nullptr ||
+                        a->info->delta_quantum != b->info->delta_quantum ||
+                        a->info->n != b->info->n ||
+                        a->total_memory != b->total_memory ||
+                        memcmp(a->info->quanta, b->info->quanta,
+                               sizeof(S) * a->info->n) != 0)
+                        continue;
+                    FL ab = 0.0;
+                    FP aa = 0.0, bb = 0.0;
+                    for (size_t i = 0; i < a->total_memory; i++) {
+                        ab += xconj<FL>(a->data[i]) * b->data[i];
+                        aa += abs(a->data[i]) * abs(a->data[i]);
+                        bb += abs(b->data[i]) * abs(b->data[i]);
+                    }
+                    FL x = ab / (FL)aa;
+                    FP rr = 0.0;
+                    for (size_t i = 0; i < a->total_memory; i++)
+                        rr += abs(b->data[i] - x * a->data[i]) *
+                              abs(b->data[i] - x * a->data[i]);
+                    if (rr <= (FP)1E-24 * bb) {
+                        sop_map[m][k] =
+                            make_pair(j, x * b->factor / a->factor);
+                        break;
+                    }
+                }
+            }
+        // active terms: left bond index, term index, position, coefficient
+        vector<int> tl, tt, tp;
+        vector<FL> tc;
+        for (int it = 0; it < (int)tops.size(); it++) {
+            bool zero = false;
+            for (auto &x : tops[it]) {
+                tcoeffs[it] *= sop_map[x.first][x.second].second;
+                x.second = sop_map[x.first][x.second].first;
+                zero = zero || sop_mats[x.first][x.second] == nullptr;
+            }
+            if (!zero) {
+                tl.push_back(0), tt.push_back(it), tp.push_back(0);
+                tc.push_back(tcoeffs[it]);
+            }
+        }
+        vector<S> qprev(1, vacuum);
+        for (uint16_t m = 0; m < n_sites; m++) {
+            // site tensor entries: (row, col) -> site operator -> coefficient
+            map<pair<int, int>, map<int, FL>> wmp;
+            vector<S> qcur;
+            if (m == n_sites - 1) {
+                for (size_t i = 0; i < tt.size(); i++) {
+                    int t = tt[i], p = tp[i], k = -1;
+                    if (p < (int)tops[t].size())
+                        k = tops[t][p].second;
+                    wmp[make_pair(tl[i], 0)][k] += tc[i];
+                }
+                qcur.push_back(qh);
+            } else {
+                // bipartite graph of distinct left and right parts
+                map<pair<int, int>, int> lmp;
+                vector<pair<int, int>> lvs;
+                map<vector<pair<uint16_t, int>>, int> rmp;
+                vector<pair<int, int>> rvs;
+                map<pair<int, int>, FL> emp;
+                for (size_t i = 0; i < tt.size(); i++) {
+                    int t = tt[i], p = tp[i], k = -1;
+                    if (p < (int)tops[t].size() && tops[t][p].first == m)
+                        k = tops[t][p++].second;
+                    auto lp = lmp.find(make_pair(tl[i], k));
+                    if (lp == lmp.end()) {
+                        lp = lmp.insert(make_pair(make_pair(tl[i], k),
+                                                  (int)lvs.size()))
+                                 .first;
+                        lvs.push_back(make_pair(tl[i], k));
+                    }
+                    vector<pair<uint16_t, int>> rkey(tops[t].begin() + p,
+                                                     tops[t].end());
+                    auto rp = rmp.find(rkey);
+                    if (rp == rmp.end()) {
+                        rp = rmp.insert(make_pair(rkey, (int)rvs.size()))
+                                 .first;
+                        rvs.push_back(make_pair(t, p));
+                    }
+                    emp[make_pair(lp->second, rp->second)] += tc[i];
+                }
+                vector<S> lqs(lvs.size());
+                for (size_t l = 0; l < lvs.size(); l++)
+                    lqs[l] = lvs[l].second == -1
+                                 ? qprev[lvs[l].first]
+                                 : (qprev[lvs[l].first] +
+                                    sop_exprs[m][lvs[l].second]->q_label)[0];
+                // new terms: (new left bond index, right part) -> coefficient
+                map<pair<int, int>, FL> nmp;
+                if (algo_type == MPOAlgorithmTypes::Bipartite) {
+                    HopcroftKarp hk((int)lvs.size(), (int)rvs.size());
+                    for (auto &e : emp)
+                        hk.add_edge(e.first.first, e.first.second);
+                    hk.solve();
+                    pair<vector<char>, vector<char>> cover =
+                        hk.min_vertex_cover();
+                    vector<int> lb(lvs.size(), -1), rb(rvs.size(), -1);
+                    for (size_t l = 0; l < lvs.size(); l++)
+                        if (cover.first[l]) {
+                            lb[l] = (int)qcur.size();
+                            qcur.push_back(lqs[l]);
+                            wmp[make_pair(lvs[l].first, lb[l])]
+                               [lvs[l].second] += (FL)1.0;
+                        }
+                    for (auto &e : emp) {
+                        int l = e.first.first, r = e.first.second;
+                        if (lb[l] != -1)
+                            nmp[make_pair(lb[l], r)] += e.second;
+                        else {
+                            assert(cover.second[r]);
+                            if (rb[r] == -1) {
+                                rb[r] = (int)qcur.size();
+                                qcur.push_back(lqs[l]);
+                                nmp[make_pair(rb[r], r)] = (FL)1.0;
+                            }
+                            wmp[make_pair(lvs[l].first, rb[r])]
+                               [lvs[l].second] += e.second;
+                        }
+                    }
+                } else {
+                    // left parts with the same quantum number form a block
+                    map<S, vector<int>> lgrp;
+                    for (size_t l = 0; l < lvs.size(); l++)
+                        lgrp[lqs[l]].push_back((int)l);
+                    vector<vector<pair<pair<int, int>, FL>>> gemp(lvs.size());
+                    for (auto &e : emp)
+                        gemp[e.first.first].push_back(e);
+                    vector<int> lloc(lvs.size(), -1), rloc(rvs.size(), -1);
+                    for (auto &g : lgrp) {
+                        vector<int> rs;
+                        for (size_t il = 0; il < g.second.size(); il++) {
+                            lloc[g.second[il]] = (int)il;
+                            for (auto &e : gemp[g.second[il]])
+                                if (rloc[e.first.second] == -1) {
+                                    rloc[e.first.second] = (int)rs.size();
+                                    rs.push_back(e.first.second);
+                                }
+                        }
+                        MKL_INT ml = (MKL_INT)g.second.size(),
+                                mr = (MKL_INT)rs.size(), mk = min(ml, mr);
+                        vector<FL> mat((size_t)ml * mr, 0), u((size_t)ml * mk),
+                            vt((size_t)mk * mr);
+                        vector<FP> s(mk);
+                        for (auto &l : g.second)
+                            for (auto &e : gemp[l])
+                                mat[(size_t)lloc[l] * mr +
+                                    rloc[e.first.second]] = e.second;
+                        GMatrixFunctions<FL>::svd(
+                            GMatrix<FL>(mat.data(), ml, mr),
+                            GMatrix<FL>(u.data(), ml, mk),
+                            GMatrix<FP>(s.data(), 1, mk),
+                            GMatrix<FL>(vt.data(), mk, mr));
+                        // singular values are in descending order
+                        for (MKL_INT ik = 0; ik < mk; ik++) {
+                            if (s[ik] <= cutoff * s[0])
+                                continue;
+                            FP umax = 0, vmax = 0;
+                            for (MKL_INT il = 0; il < ml; il++)
+                                umax = max(umax, abs(u[(size_t)il * mk + ik]));
+                            for (MKL_INT ir = 0; ir < mr; ir++)
+                                vmax =
+                                    max(vmax, abs(vt[(size_t)ik * mr + ir]));
+                            int b = (int)qcur.size();
+                            qcur.push_back(g.first);
+                            for (MKL_INT il = 0; il < ml; il++)
+                                if (abs(u[(size_t)il * mk + ik]) >
+                                    cutoff * umax) {
+                                    auto &lv = lvs[g.second[il]];
+                                    wmp[make_pair(lv.first, b)][lv.second] +=
+                                        u[(size_t)il * mk + ik];
+                                }
+                            for (MKL_INT ir = 0; ir < mr; ir++)
+                                if (abs(vt[(size_t)ik * mr + ir]) >
+                                    cutoff * vmax)
+                                    nmp[make_pair(b, rs[ir])] +=
+                                        s[ik] * vt[(size_t)ik * mr + ir];
+                        }
+                        for (auto &r : rs)
+                            rloc[r] = -1;
+                    }
+                }
+                tl.clear(), tt.clear(), tp.clear(), tc.clear();
+                for (auto &n : nmp)
+                    if (n.second != (FL)0.0) {
+                        tl.push_back(n.first.first);
+                        tt.push_back(rvs[n.first.second].first);
+                        tp.push_back(rvs[n.first.second].second);
+                        tc.push_back(n.second);
+                    }
+            }
+            // site tensor
+            shared_ptr<Symbolic<S>> pmat;
+            if (m == 0)
+                pmat = make_shared<SymbolicRowVector<S>>((int)qcur.size());
+            else if (m == n_sites - 1)
+                pmat = make_shared<SymbolicColumnVector<S>>((int)qprev.size());
+            else
+                pmat = make_shared<SymbolicMatrix<S>>((int)qprev.size(),
+                                                      (int)qcur.size());
+            unordered_map<shared_ptr<OpExpr<S>>,
+                          shared_ptr<SparseMatrix<S, FL>>>
+                xops;
+            for (auto &w : wmp) {
+                vector<shared_ptr<OpProduct<S, FL>>> strs;
+                for (auto &x : w.second) {
+                    if (x.second == (FL)0.0)
+                        continue;
+                    shared_ptr<OpElement<S, FL>> xop =
+                        x.first == -1 ? i_op : sop_exprs[m][x.first];
+                    xops[xop] =
+                        x.first == -1 ? i_mats[m] : sop_mats[m][x.first];
+                    strs.push_back(
+                        make_shared<OpProduct<S, FL>>(xop, x.second));
+                }
+                if (strs.size() == 1)
+                    (*pmat)[{w.first.first, w.first.second}] =
+                        (shared_ptr<OpExpr<S>>)strs[0]->a * strs[0]->factor;
+                else if (strs.size() != 0)
+                    (*pmat)[{w.first.first, w.first.second}] =
+                        make_shared<OpSum<S, FL>>(strs);
+            }
+            // operator names
+            shared_ptr<SymbolicRowVector<S>> plop =
+                make_shared<SymbolicRowVector<S>>((int)qcur.size());
+            for (int k = 0; k < (int)qcur.size(); k++)
+                (*plop)[k] =
+                    m == n_sites - 1
+                        ? MPO<S, FL>::op
+                        : make_shared<OpElement<S, FL>>(
+                              OpNames::XL,
+                              SiteIndex({m, (uint16_t)(k >> 12),
+                                         (uint16_t)(k & 0xFFF)},
+                                        {}),
+                              qcur[k]);
+            this->left_operator_names.push_back(plop);
+            shared_ptr<SymbolicColumnVector<S>> prop =
+                make_shared<SymbolicColumnVector<S>>((int)qprev.size());
+            for (int k = 0; k < (int)qprev.size(); k++)
+                (*prop)[k] = m == 0 ? MPO<S, FL>::op
+                                    : make_shared<OpElement<S, FL>>(
+                                          OpNames::XR,
+                                          SiteIndex({m, (uint16_t)(k >> 12),
+                                                     (uint16_t)(k & 0xFFF)},
+                                                    {}),
+                                          (qh - qprev[k])[0]);
+            this->right_operator_names.push_back(prop);
+            // at the first and last sites, block operators are copied from
+            // site operators, so every entry must be a named site operator
+            if (m == 0 || m == n_sites - 1) {
+                shared_ptr<Symbolic<S>> pnames =
+                    m == 0 ? (shared_ptr<Symbolic<S>>)plop
+                           : (shared_ptr<Symbolic<S>>)prop;
+                unordered_set<shared_ptr<OpExpr<S>>> used;
+                for (size_t i = 0; i < pmat->data.size(); i++) {
+                    shared_ptr<OpExpr<S>> &x = pmat->data[i];
+                    if (x->get_type() == OpTypes::Zero)
+                        continue;
+                    else if (x->get_type() == OpTypes::Elem &&
+                             dynamic_pointer_cast<OpElement<S, FL>>(x)
+                                     ->factor == (FL)1.0 &&
+                             !used.count(x)) {
+                        used.insert(x);
+                        pnames->data[i] = x;
+                        continue;
+                    }
+                    shared_ptr<OpElement<S, FL>> xname =
+                        dynamic_pointer_cast<OpElement<S, FL>>(
+                            pnames->data[i]);
+                    shared_ptr<SparseMatrixInfo<S>> info =
+                        hamil->find_site_op_info(m, xname->q_label);
+                    if (info == nullptr) {
+                        x = make_shared<OpExpr<S>>();
+                        continue;
+                    }
+                    shared_ptr<SparseMatrix<S, FL>> mat =
+                        make_shared<SparseMatrix<S, FL>>(d_alloc);
+                    mat->allocate(info);
+                    vector<shared_ptr<OpProduct<S, FL>>> strs;
+                    if (x->get_type() == OpTypes::Elem)
+                        strs.push_back(make_shared<OpProduct<S, FL>>(
+                            dynamic_pointer_cast<OpElement<S, FL>>(
+                                abs_value(x)),
+                            dynamic_pointer_cast<OpElement<S, FL>>(x)
+                                ->factor));
+                    else
+                        strs = dynamic_pointer_cast<OpSum<S, FL>>(x)->strings;
+                    for (auto &r : strs) {
+                        hamil->opf->iadd(mat, xops.at(r->a), r->factor);
+                        if (hamil->opf->seq->mode != SeqTypes::None)
+                            hamil->opf->seq->simple_perform();
+                    }
+                    x = xname;
+                    xops[xname] = mat;
+                }
+            }
+            // site operators
+            shared_ptr<OperatorTensor<S, FL>> opt =
+                make_shared<OperatorTensor<S, FL>>();
+            for (auto &x : pmat->data)
+                if (x->get_type() == OpTypes::Elem)
+                    opt->ops[abs_value(x)] = xops.at(abs_value(x));
+                else if (x->get_type() == OpTypes::Sum)
+                    for (auto &r :
+                         dynamic_pointer_cast<OpSum<S, FL>>(x)->strings)
+                        opt->ops[r->a] = xops.at(r->a);
+            opt->lmat = opt->rmat = pmat;
+            this->tensors.push_back(opt);
+            qprev = qcur;
+        }
+    }
+};
+
+} // namespace block2
@@ -33,6 +33,9 @@
 #include "state_averaged.hpp"
 #include <algorithm>
 #include <cassert>
+#include <fstream>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <memory>
 #include <utility>
@@ -45,7 +48,8 @@ namespace block2 {
 enum struct DecompositionTypes : uint8_t {
     SVD = 0,
     PureSVD = 1,
-    DensityMatrix = 2
+    DensityMatrix = 2,
+    RandomizedSVD = 3
 };
 
 enum struct TruncationTypes : ubond_t {
@@ -76,6 +80,183 @@ inline ubond_t operator&(TruncationTypes a, TruncationTypes b) {
     return (ubond_t)a & (ubond_t)b;
 }
 
+// Trace of the steps of moving the environment by one site (prefetch +
+// tracing). The steps (rotation, contraction) still run one after another
+// in the calling thread as sync tasks; only disk reads of the next
+// environment (prefetch) and saves of the old one run in background, and
+// are attached as async tasks for waiting. Start/end times and dependencies
+// of all tasks are recorded for the trace output and the critical path.
+struct SweepTrace {
+    struct Task {
+        string name;
+        vector<int> deps;
+        bool async;
+        // for sync tasks started inside another sync task, the outer task
+        int parent = -1;
+        double tstart = 0, tend = 0;
+        shared_ptr<promise<void>> done;
+        // waits for the task and rethrows its exception
+        function<void()> wait;
+        // for attached tasks, start and end time set by the producer thread
+        shared_ptr<pair<double, double>> times;
+    };
+    vector<shared_ptr<Task>> tasks;
+    // if not empty, the trace of each sweep is written into
+    // trace_filename.<sweep index>.json (Chrome trace event format)
+    string trace_filename = "";
+    double tref;
+    // sync tasks between begin and end
+    vector<int> open_tasks;
+    SweepTrace() { clear(); }
+    SweepTrace(const SweepTrace &) = delete;
+    SweepTrace &operator=(const SweepTrace &) = delete;
+    double now() const {
+        Timer t;
+        t.get_time();
+        return t.current - tref;
+    }
+    // negative dependencies are ignored
+    // returns the index of the task
+    int submit(const string &name, const vector<int> &deps,
+               const function<void()> &f) {
+        int i = begin(name, deps);
+        f();
+        end(i);
+        return i;
+    }
+    // start a sync task for the code between begin and end
+    int begin(const string &name, const vector<int> &deps) {
+        shared_ptr<Task> task = make_shared<Task>();
+        task->name = name, task->async = false;
+        for (int d : deps)
+            if (d >= 0) {
+                task->deps.push_back(d);
+                wait(d);
+            }
+        task->parent = open_tasks.size() == 0 ? -1 : open_tasks.back();
+        task->done = make_shared<promise<void>>();
+        shared_future<void> ft = task->done->get_future().share();
+        task->wait = [ft]() { ft.get(); };
+        task->tstart = now();
+        tasks.push_back(task);
+        open_tasks.push_back((int)tasks.size() - 1);
+        return (int)tasks.size() - 1;
+    }
+    void end(int i) {
+        assert(open_tasks.size() != 0 && open_tasks.back() == i);
+        open_tasks.pop_back();
+        tasks[i]->tend = now();
+        tasks[i]->done->set_value();
+    }
+    // an async task for work already started in background (as ft)
+    // times is filled by the background work when it starts and ends
+    template <typename T>
+    int attach(const string &name, const vector<int> &deps,
+               const shared_future<T> &ft,
+               const shared_ptr<pair<double, double>> &times) {
+        if (!ft.valid())
+            return -1;
+        shared_ptr<Task> task = make_shared<Task>();
+        task->name = name, task->async = true;
+        for (int d : deps)
+            if (d >= 0)
+                task->deps.push_back(d);
+        task->wait = [ft]() { ft.get(); };
+        task->times = times;
+        tasks.push_back(task);
+        return (int)tasks.size() - 1;
+    }
+    void wait(int i) const {
+        if (i < 0)
+            return;
+        tasks[i]->wait();
+        if (tasks[i]->times != nullptr) {
+            tasks[i]->tstart = tasks[i]->times->first - tref;
+            tasks[i]->tend = tasks[i]->times->second - tref;
+            tasks[i]->times = nullptr;
+        }
+    }
+    // sync tasks are always finished outside begin/end
+    void wait_all() const {
+        for (int i = 0; i < (int)tasks.size(); i++)
+            if (tasks[i]->async)
+                wait(i);
+    }
+    void clear() {
+        wait_all();
+        tasks.clear();
+        open_tasks.clear();
+        Timer t;
+        t.get_time();
+        tref = t.current;
+    }
+    // top-level sync tasks implicitly depend on the previous one
+    // a nested sync task is part of its outer task, so its chain runs from
+    // the start of the outer task to its own end
+    // returns the length of the longest dependency chain
+    double critical_path() const {
+        vector<double> tcp(tasks.size(), 0);
+        double r = 0;
+        for (int i = 0, ip = -1; i < (int)tasks.size(); i++) {
+            const shared_ptr<Task> &t = tasks[i];
+            double tx = 0;
+            for (int d : t->deps)
+                tx = max(tx, tcp[d]);
+            tcp[i] = tx + t->tend - t->tstart;
+            if (t->parent != -1) {
+                const shared_ptr<Task> &p = tasks[t->parent];
+                tcp[i] = max(tcp[i], tcp[t->parent] - p->tend + t->tend);
+            } else if (!t->async) {
+                if (ip != -1)
+                    tcp[i] = max(tcp[i], tcp[ip] + t->tend - t->tstart);
+                ip = i;
+            }
+            r = max(r, tcp[i]);
+        }
+        return r;
+    }
+    // total time of sync and async tasks
+    // nested sync tasks are counted in their outer tasks
+    pair<double, double> total_time() const {
+        pair<double, double> r = make_pair(0.0, 0.0);
+        for (auto &t : tasks)
+            if (t->parent == -1)
+                (t->async ? r.second : r.first) += t->tend - t->tstart;
+        return r;
+    }
+    void save_trace(const string &filename) const {
+        wait_all();
+        ofstream ofs(filename.c_str());
+        if (!ofs.good())
+            throw runtime_error("SweepTrace::save_trace on '" + filename +
+                                "' failed.");
+        ofs << "{\"traceEvents\": [" << endl;
+        for (int i = 0; i < (int)tasks.size(); i++) {
+            ofs << "{\"name\": \"" << tasks[i]->name
+                << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": "
+                << (int)tasks[i]->async << fixed << setprecision(0)
+                << ", \"ts\": " << tasks[i]->tstart * 1E6
+                << ", \"dur\": " << (tasks[i]->tend - tasks[i]->tstart) * 1E6
+                << ", \"args\": {\"id\": " << i << ", \"deps\": [";
+            for (size_t j = 0; j < tasks[i]->deps.size(); j++)
+                ofs << (j == 0 ? "" : ", ") << tasks[i]->deps[j];
+            ofs << "]}}" << (i == (int)tasks.size() - 1 ? "" : ",") << endl;
+        }
+        ofs << "]}" << endl;
+        if (!ofs.good())
+            throw runtime_error("SweepTrace::save_trace on '" + filename +
+                                "' failed.");
+        ofs.close();
+    }
+    friend ostream &operator<<(ostream &os, const SweepTrace &p) {
+        pair<double, double> tt = p.total_time();
+        os << "SweepTrace: " << p.tasks.size() << " tasks | Tsync = " << fixed
+           << setprecision(3) << tt.first << " | Tasync = " << tt.second
+           << " | Tcrit = " << p.critical_path();
+        return os;
+    }
+};
+
 template <typename, typename, typename> struct ComplexMixture;
 
 template <typename S, typename FL> struct ComplexMixture<S, FL, FL> {
@@ -162,6 +343,17 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
     Timer _t, _t2;
     bool iprint = false;
     bool save_partition_info = false;
+    // if true, a content hash of the MPS/MPO tensors each partition depends
+    // on is stored alongside the partition, and init_environments only
+    // recomputes partitions whose dependencies have changed
+    bool incremental_init = false;
+    // cached hashes of MPO sites (left and right operators), zero if unknown
+    vector<uint64_t> mpo_site_hashes;
+    // number of partitions reused / computed in the last init_environments
+    int n_reused_partitions = 0, n_computed_partitions = 0;
+    // if not nullptr, the steps in move_to are traced and the environment for
+    // the next site is read in background
+    shared_ptr<SweepTrace> sweep_trace = nullptr;
     OpNamesSet delayed_contraction = OpNamesSet();
     int fuse_center;
     MovingEnvironment(const shared_ptr<MPO<S, FL>> &mpo,
@@ -297,12 +489,15 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
         if (frame->use_main_stack)
             new_left->deallocate();
         Partition<S, FL>::deallocate_op_infos_notrunc(left_op_infos_notrunc);
+        remove_partition_hash(true, i);
         frame->save_data(1, get_left_partition_filename(i));
-        if (save_partition_info) {
+        if (save_partition_info || incremental_init) {
             frame->activate(1);
             envs[i]->save_data(true, get_left_partition_filename(i, true));
             frame->activate(0);
         }
+        if (incremental_init)
+            save_partition_hash(true, i);
     }
     // Contract and renormalize right block by one site
     // new site = i + dot
@@ -417,12 +612,15 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
         if (frame->use_main_stack)
             new_right->deallocate();
         Partition<S, FL>::deallocate_op_infos_notrunc(right_op_infos_notrunc);
+        remove_partition_hash(false, i);
         frame->save_data(1, get_right_partition_filename(i));
-        if (save_partition_info) {
+        if (save_partition_info || incremental_init) {
             frame->activate(1);
             envs[i]->save_data(false, get_right_partition_filename(i, true));
             frame->activate(0);
         }
+        if (incremental_init)
+            save_partition_hash(false, i);
     }
     void left_contract_rotate_unordered(
         int i, const shared_ptr<ParallelRule<S>> &rule = nullptr) {
@@ -595,19 +793,172 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
            << ".RIGHT." << Parsing::to_string(i);
         return ss.str();
     }
-    string get_left_partition_filename(int i, bool info = false) const {
+    string get_left_partition_filename(int i, bool info = false,
+                                       const string &dir = "") const {
+        stringstream ss;
+        ss << (dir == "" ? frame->save_dir : dir) << "/"
+           << frame->prefix_distri << ".PART." << (info ? "INFO." : "") << tag
+           << ".LEFT." << Parsing::to_string(i);
+        return ss.str();
+    }
+    string get_right_partition_filename(int i, bool info = false,
+                                        const string &dir = "") const {
+        stringstream ss;
+        ss << (dir == "" ? frame->save_dir : dir) << "/"
+           << frame->prefix_distri << ".PART." << (info ? "INFO." : "") << tag
+           << ".RIGHT." << Parsing::to_string(i);
+        return ss.str();
+    }
+    string get_environment_filename(const string &dir = "") const {
         stringstream ss;
-        ss << frame->save_dir << "/" << frame->prefix_distri << ".PART."
-           << (info ? "INFO." : "") << tag << ".LEFT." << Parsing::to_string(i);
+        ss << (dir == "" ? frame->save_dir : dir) << "/"
+           << frame->prefix_distri << ".ENV." << tag;
         return ss.str();
     }
-    string get_right_partition_filename(int i, bool info = false) const {
+    string get_partition_hash_filename(bool left, int i) const {
         stringstream ss;
-        ss << frame->save_dir << "/" << frame->prefix_distri << ".PART."
-           << (info ? "INFO." : "") << tag << ".RIGHT."
-           << Parsing::to_string(i);
+        ss << frame->save_dir << "/" << frame->prefix_distri << ".PART.HASH."
+           << tag << (left ? ".LEFT." : ".RIGHT.") << Parsing::to_string(i);
         return ss.str();
     }
+    static uint64_t combine_hash(uint64_t h, uint64_t x) {
+        if (h == 0 || x == 0)
+            return 0;
+        return Parsing::hash_string(string((char *)&x, sizeof(x)), h);
+    }
+    // Hash of MPS tensor file, zero if the tensor is not saved
+    static uint64_t get_mps_tensor_hash(const shared_ptr<MPS<S, FLS>> &mps,
+                                        int i) {
+        return mps->get_tensor_hash(i);
+    }
+    // Hash of the MPO tensor and operator names at site i,
+    // for the left (contracted from left) or right block
+    // The order of the operators in the tensor does not matter
+    uint64_t get_mpo_site_hash(int i, bool left) {
+        mpo_site_hashes.resize(n_sites * 2, 0);
+        uint64_t &h = mpo_site_hashes[i * 2 + !left];
+        if (h != 0)
+            return h;
+        if (left)
+            mpo->load_left_operators(i);
+        else
+            mpo->load_right_operators(i);
+        mpo->load_tensor(i);
+        stringstream ss;
+        shared_ptr<Symbolic<S>> names = left ? mpo->left_operator_names[i]
+                                             : mpo->right_operator_names[i];
+        shared_ptr<Symbolic<S>> mat =
+            left ? mpo->tensors[i]->lmat : mpo->tensors[i]->rmat;
+        if (names != nullptr)
+            save_symbolic<S>(names, ss);
+        if (mat != nullptr)
+            save_symbolic<S>(mat, ss);
+        uint64_t hops = 0;
+        for (auto &op : mpo->tensors[i]->ops) {
+            stringstream sop;
+            save_expr<S>(op.first, sop);
+            if (op.second->info != nullptr)
+                op.second->info->save_data(sop);
+            op.second->save_data(sop);
+            hops += Parsing::hash_string(sop.str());
+        }
+        h = combine_hash(Parsing::hash_string(ss.str()), hops + 1);
+        mpo->unload_tensor(i);
+        if (left)
+            mpo->unload_left_operators(i);
+        else
+            mpo->unload_right_operators(i);
+        return h;
+    }
+    // Stored dependency hash of partition i, zero if not available
+    uint64_t load_partition_hash(bool left, int i) const {
+        string filename = get_partition_hash_filename(left, i);
+        if (!Parsing::file_exists(filename))
+            return 0;
+        string r = Parsing::read_file(filename);
+        uint64_t h = 0;
+        if (r.size() == sizeof(h))
+            memcpy(&h, r.data(), sizeof(h));
+        return h;
+    }
+    // Dependency hash of left partition i (sites 0 .. i - 1) or right
+    // partition i (sites i + dot .. n_sites - 1), from the stored hash of
+    // the previous partition and the hashes of the new site
+    // Zero if any of them is unknown
+    uint64_t get_partition_hash(bool left, int i) {
+        const int j = left ? i - 1 : i + dot;
+        uint64_t h;
+        if (left ? j == 0 : j == n_sites - 1) {
+            stringstream ss;
+            ss << (left ? "LEFT" : "RIGHT") << n_sites << "/" << dot << "/"
+               << (bra == ket) << "/" << mpo->left_operator_exprs.size()
+               << "/" << mpo->right_operator_exprs.size();
+            if (mpo->schemer != nullptr)
+                ss << "/" << mpo->schemer->left_trans_site << "/"
+                   << mpo->schemer->right_trans_site;
+            h = Parsing::hash_string(ss.str());
+        } else
+            h = load_partition_hash(left, left ? i - 1 : i + 1);
+        h = combine_hash(h, get_mps_tensor_hash(bra, j));
+        if (bra != ket)
+            h = combine_hash(h, get_mps_tensor_hash(ket, j));
+        h = combine_hash(h, get_mpo_site_hash(j, left));
+        // intermediates are built from the operators of the next site
+        const int k = left ? i : i + dot - 1;
+        if (k >= 0 && k < (int)(left ? mpo->left_operator_exprs.size()
+                                     : mpo->right_operator_exprs.size()))
+            h = combine_hash(h, get_mpo_site_hash(k, left));
+        return h;
+    }
+    void remove_partition_hash(bool left, int i) const {
+        string filename = get_partition_hash_filename(left, i);
+        if (Parsing::file_exists(filename))
+            Parsing::remove_file(filename);
+    }
+    // Store the dependency hash after the partition is written
+    void save_partition_hash(bool left, int i) {
+        if (!frame->partition_can_write)
+            return;
+        uint64_t h = get_partition_hash(left, i);
+        if (h == 0)
+            return;
+        if (frame->save_buffering && frame->save_futures[1].valid())
+            frame->save_futures[1].wait();
+        Parsing::write_file(get_partition_hash_filename(left, i),
+                            string((char *)&h, sizeof(h)));
+    }
+    // Restore partition i from scratch if it is saved with the same
+    // dependency hash (collective over procs)
+    // If a manifest (see load_partition_manifest) is given, the partition
+    // must also be listed in it for this proc, with the same number of procs
+    bool reuse_partition(bool left, int i,
+                         const vector<vector<uint8_t>> &manifest =
+                             vector<vector<uint8_t>>()) {
+        string filename = left ? get_left_partition_filename(i)
+                               : get_right_partition_filename(i);
+        string info_filename = left ? get_left_partition_filename(i, true)
+                                    : get_right_partition_filename(i, true);
+        uint64_t h = load_partition_hash(left, i);
+        bool failed = h == 0 || !Parsing::file_exists(filename) ||
+                      !Parsing::file_exists(info_filename);
+        if (!failed && manifest.size() != 0) {
+            int nproc = para_rule == nullptr ? 1 : para_rule->comm->size;
+            int iproc = para_rule == nullptr ? 0 : para_rule->comm->rank;
+            const uint8_t mask = left ? (1 | 4) : (2 | 8);
+            failed = (int)manifest.size() != nproc ||
+                     (int)manifest[iproc].size() != n_sites ||
+                     (manifest[iproc][i] & mask) != mask;
+        }
+        failed = failed || get_partition_hash(left, i) != h;
+        if (para_rule != nullptr)
+            para_rule->comm->allreduce_logical_or(failed);
+        if (failed)
+            return false;
+        frame->activate(1);
+        envs[i]->load_data(left, info_filename);
+        frame->activate(0);
+        return true;
+    }
     void shallow_copy_to(const shared_ptr<MovingEnvironment> &me) const {
         for (int i = 0; i < n_sites; i++) {
             me->envs[i] = make_shared<Partition<S, FL>>(*envs[i]);
@@ -629,6 +980,144 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
         shallow_copy_to(me);
         return me;
     }
+    // Which procs hold renormalized operators of which sites in scratch
+    // manifest[rank][i] & 1/2/4/8: LEFT / RIGHT / LEFT INFO / RIGHT INFO
+    vector<vector<uint8_t>> get_partition_manifest() const {
+        int nproc = para_rule == nullptr ? 1 : para_rule->comm->size;
+        int iproc = para_rule == nullptr ? 0 : para_rule->comm->rank;
+        vector<char> flags((size_t)nproc * n_sites * 4, 0);
+        char *pf = flags.data() + (size_t)iproc * n_sites * 4;
+        if (frame->save_buffering && frame->save_futures[1].valid())
+            frame->save_futures[1].wait();
+        for (int i = 0; i < n_sites; i++) {
+            pf[i * 4 + 0] =
+                Parsing::file_exists(get_left_partition_filename(i));
+            pf[i * 4 + 1] =
+                Parsing::file_exists(get_right_partition_filename(i));
+            pf[i * 4 + 2] =
+                Parsing::file_exists(get_left_partition_filename(i, true));
+            pf[i * 4 + 3] =
+                Parsing::file_exists(get_right_partition_filename(i, true));
+        }
+        if (para_rule != nullptr)
+            para_rule->comm->allreduce_logical_or(flags.data(), flags.size());
+        vector<vector<uint8_t>> manifest(nproc, vector<uint8_t>(n_sites, 0));
+        for (int ip = 0; ip < nproc; ip++)
+            for (int i = 0; i < n_sites; i++)
+                for (int k = 0; k < 4; k++)
+                    if (flags[((size_t)ip * n_sites + i) * 4 + k])
+                        manifest[ip][i] |= (uint8_t)(1 << k);
+        return manifest;
+    }
+    string get_partition_manifest_filename() const {
+        stringstream ss;
+        ss << frame->save_dir << "/" << frame->prefix << ".PART." << tag
+           << ".MANIFEST";
+        return ss.str();
+    }
+    // Write the manifest as text in the common scratch dir
+    // First line: number of procs and sites
+    // Other lines: rank site LEFT RIGHT LEFT-INFO RIGHT-INFO
+    vector<vector<uint8_t>> save_partition_manifest() const {
+        vector<vector<uint8_t>> manifest = get_partition_manifest();
+        if (frame->prefix_can_write) {
+            string filename = get_partition_manifest_filename();
+            ofstream ofs(filename.c_str());
+            if (!ofs.good())
+                throw runtime_error("MovingEnvironment::save_partition_"
+                                    "manifest on '" +
+                                    filename + "' failed.");
+            ofs << "# NPROC NSITES" << endl;
+            ofs << setw(5) << manifest.size() << setw(6) << n_sites << endl;
+            ofs << "# RANK SITE LEFT RIGHT LEFT-INFO RIGHT-INFO" << endl;
+            for (int ip = 0; ip < (int)manifest.size(); ip++)
+                for (int i = 0; i < n_sites; i++)
+                    if (manifest[ip][i] != 0) {
+                        ofs << setw(5) << ip << setw(6) << i;
+                        for (int k = 0; k < 4; k++)
+                            ofs << setw(2) << ((manifest[ip][i] >> k) & 1);
+                        ofs << endl;
+                    }
+            if (!ofs.good())
+                throw runtime_error("MovingEnvironment::save_partition_"
+                                    "manifest on '" +
+                                    filename + "' failed.");
+            ofs.close();
+        }
+        return manifest;
+    }
+    // Read the manifest written by save_partition_manifest
+    // Empty if there is no manifest in scratch
+    vector<vector<uint8_t>> load_partition_manifest() const {
+        string filename = get_partition_manifest_filename();
+        if (!Parsing::file_exists(filename))
+            return vector<vector<uint8_t>>();
+        ifstream ifs(filename.c_str());
+        if (!ifs.good())
+            throw runtime_error("MovingEnvironment::load_partition_manifest "
+                                "on '" +
+                                filename + "' failed.");
+        vector<string> lines = Parsing::readlines(&ifs);
+        ifs.close();
+        vector<vector<uint8_t>> manifest;
+        int nproc = -1, xn_sites = -1;
+        for (auto &l : lines) {
+            vector<string> ls = Parsing::split(l, " ", true);
+            if (ls.size() == 0 || ls[0][0] == '#')
+                continue;
+            bool ok;
+            if (nproc == -1) {
+                ok = ls.size() == 2;
+                if (ok) {
+                    nproc = Parsing::to_int(ls[0]);
+                    xn_sites = Parsing::to_int(ls[1]);
+                    ok = nproc > 0 && xn_sites > 0;
+                }
+                if (ok)
+                    manifest.assign(nproc, vector<uint8_t>(xn_sites, 0));
+            } else {
+                ok = ls.size() == 6;
+                int ip = ok ? Parsing::to_int(ls[0]) : -1;
+                int i = ok ? Parsing::to_int(ls[1]) : -1;
+                ok = ok && ip >= 0 && ip < nproc && i >= 0 && i < xn_sites;
+                for (int k = 0; ok && k < 4; k++)
+                    manifest[ip][i] |= (uint8_t)((ls[k + 2] == "1") << k);
+            }
+            if (!ok)
+                throw runtime_error("MovingEnvironment::load_partition_"
+                                    "manifest on '" +
+                                    filename + "': bad line '" + l + "'.");
+        }
+        return manifest;
+    }
+    // Send all renormalized operators held by proc "from" to proc "to"
+    // After this, proc "to" holds the same partitions as proc "from"
+    // Used when the ownership of operators changes between procs
+    // Collective over all procs
+    void migrate_partitions(int from, int to) {
+        if (from == to)
+            return;
+        assert(para_rule != nullptr);
+        // pending async writes must be finished before sending
+        for (int i = 0; i < frame->n_frames; i++)
+            frame->reset_buffer(i);
+        vector<vector<uint8_t>> manifest = get_partition_manifest();
+        const shared_ptr<ParallelCommunicator<S>> &comm = para_rule->comm;
+        if (comm->rank == from || comm->rank == to)
+            for (int i = 0; i < n_sites; i++)
+                for (int k = 0; k < 4; k++)
+                    if ((manifest[from][i] >> k) & 1) {
+                        string fn =
+                            (k & 1) ? get_right_partition_filename(i, k >> 1)
+                                    : get_left_partition_filename(i, k >> 1);
+                        comm->send_file(fn, fn, from, to);
+                    }
+        // contents in memory may be outdated
+        if (comm->rank == to)
+            for (auto &fn : frame->present_filenames)
+                fn = "";
+        comm->barrier();
+    }
     virtual void finalize_environments(bool renormalize_ops = true) {
         if (!(ket->get_type() & MPSTypes::MultiCenter))
             return;
@@ -937,9 +1426,8 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
             para_mps->canonical_form[j] = 'S';
         }
     }
-    // Generate contracted environment blocks for all center sites
-    virtual void init_environments(bool iprint = false) {
-        this->iprint = iprint;
+    // Empty partitions (and the left block for singlet embedding)
+    void init_partitions() {
         envs.clear();
         envs.resize(n_sites);
         for (int i = 0; i < n_sites; i++) {
@@ -970,6 +1458,11 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
             envs[0]->left->ops[make_shared<OpExpr<S>>()] = xmat;
             envs[0]->left_op_infos.push_back(make_pair(dq, xinfo));
         }
+    }
+    // Generate contracted environment blocks for all center sites
+    virtual void init_environments(bool iprint = false) {
+        this->iprint = iprint;
+        init_partitions();
         if (ket->get_type() & MPSTypes::MultiCenter) {
             shared_ptr<ParallelMPS<S, FLS>> para_mps =
                 dynamic_pointer_cast<ParallelMPS<S, FLS>>(ket);
@@ -1021,20 +1514,177 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
             para_mps->disable_parallel_writing();
         } else if (bra->info->get_warm_up_type() == WarmUpTypes::None &&
                    ket->info->get_warm_up_type() == WarmUpTypes::None) {
+            // the previous partition must be in memory for rotation
+            bool reused = false;
+            n_reused_partitions = n_computed_partitions = 0;
+            vector<vector<uint8_t>> manifest;
+            if (incremental_init)
+                manifest = load_partition_manifest();
             for (int i = 1; i <= center; i++) {
                 check_signal_()();
+                if (incremental_init && reuse_partition(true, i, manifest)) {
+                    if (iprint)
+                        cout << "init .. L = " << i << " (reused)" << endl;
+                    reused = true;
+                    n_reused_partitions++;
+                    continue;
+                }
                 if (iprint)
                     cout << "init .. L = " << i << endl;
+                if (reused && envs[i - 1]->left != nullptr)
+                    frame->load_data(1, get_left_partition_filename(i - 1));
+                reused = false;
+                n_computed_partitions++;
                 left_contract_rotate(i);
             }
+            reused = false;
             for (int i = n_sites - dot - 1; i >= center; i--) {
                 check_signal_()();
+                if (incremental_init && reuse_partition(false, i, manifest)) {
+                    if (iprint)
+                        cout << "init .. R = " << i << " (reused)" << endl;
+                    reused = true;
+                    n_reused_partitions++;
+                    continue;
+                }
                 if (iprint)
                     cout << "init .. R = " << i << endl;
+                if (reused && envs[i + 1]->right != nullptr)
+                    frame->load_data(1, get_right_partition_filename(i + 1));
+                reused = false;
+                n_computed_partitions++;
                 right_contract_rotate(i);
             }
         }
         frame->reset(1);
+        if (incremental_init)
+            save_partition_manifest();
+    }
+    // Copy the environment blocks that are valid for the current center
+    // (left blocks up to and right blocks from the center) into a restart
+    // dir, as part of the checkpoint being prepared (see DataFrame).
+    // Distributed environments (MPI) are not saved.
+    void save_environments(const string &dir) const {
+        if (para_rule != nullptr || !frame->partition_can_write)
+            return;
+        if (frame->save_buffering && frame->save_futures[1].valid())
+            frame->save_futures[1].wait();
+        vector<uint8_t> saved(n_sites, 0);
+        frame->activate(1);
+        for (int i = 1; i <= center; i++)
+            if (envs[i]->left != nullptr &&
+                Parsing::file_exists(get_left_partition_filename(i))) {
+                envs[i]->save_data(true, get_left_partition_filename(i, true));
+                saved[i] |= 1;
+            }
+        for (int i = center; i < n_sites - dot; i++)
+            if (envs[i]->right != nullptr &&
+                Parsing::file_exists(get_right_partition_filename(i))) {
+                envs[i]->save_data(false,
+                                   get_right_partition_filename(i, true));
+                saved[i] |= 2;
+            }
+        frame->activate(0);
+        for (int i = 0; i < n_sites; i++) {
+            if (saved[i] & 1) {
+                frame->copy_checkpoint_file(
+                    get_left_partition_filename(i, true),
+                    get_left_partition_filename(i, true, dir));
+                frame->copy_checkpoint_file(
+                    get_left_partition_filename(i),
+                    get_left_partition_filename(i, false, dir));
+            }
+            if (saved[i] & 2) {
+                frame->copy_checkpoint_file(
+                    get_right_partition_filename(i, true),
+                    get_right_partition_filename(i, true, dir));
+                frame->copy_checkpoint_file(
+                    get_right_partition_filename(i),
+                    get_right_partition_filename(i, false, dir));
+            }
+        }
+        ofstream ofs(get_environment_filename().c_str(), ios::binary);
+        if (!ofs.good())
+            throw runtime_error("MovingEnvironment::save_environments on '" +
+                                get_environment_filename() + "' failed.");
+        ofs.write((char *)&n_sites, sizeof(n_sites));
+        ofs.write((char *)&dot, sizeof(dot));
+        ofs.write((char *)&center, sizeof(center));
+        ofs.write((char *)&saved[0], sizeof(uint8_t) * n_sites);
+        if (!ofs.good())
+            throw runtime_error("MovingEnvironment::save_environments on '" +
+                                get_environment_filename() + "' failed.");
+        ofs.close();
+        frame->copy_checkpoint_file(get_environment_filename(),
+                                    get_environment_filename(dir));
+    }
+    // Restore environment blocks written by save_environments, instead of
+    // init_environments. Returns false (and nothing is changed) if dir
+    // does not contain complete environments for the current center of
+    // this MPS, in which case init_environments should be used
+    virtual bool load_environments(const string &dir) {
+        if (para_rule != nullptr ||
+            !Parsing::file_exists(get_environment_filename(dir)))
+            return false;
+        ifstream ifs(get_environment_filename(dir).c_str(), ios::binary);
+        if (!ifs.good())
+            throw runtime_error("MovingEnvironment::load_environments on '" +
+                                get_environment_filename(dir) + "' failed.");
+        int xn_sites, xdot, xcenter;
+        ifs.read((char *)&xn_sites, sizeof(xn_sites));
+        ifs.read((char *)&xdot, sizeof(xdot));
+        ifs.read((char *)&xcenter, sizeof(xcenter));
+        if (xn_sites != n_sites || xdot != dot || xcenter != center)
+            return false;
+        vector<uint8_t> saved(n_sites, 0);
+        ifs.read((char *)&saved[0], sizeof(uint8_t) * n_sites);
+        if (ifs.fail() || ifs.bad())
+            throw runtime_error("MovingEnvironment::load_environments on '" +
+                                get_environment_filename(dir) + "' failed.");
+        ifs.close();
+        for (int i = 0; i < n_sites; i++)
+            if (((saved[i] & 1) &&
+                 (!Parsing::file_exists(
+                      get_left_partition_filename(i, true, dir)) ||
+                  !Parsing::file_exists(
+                      get_left_partition_filename(i, false, dir)))) ||
+                ((saved[i] & 2) &&
+                 (!Parsing::file_exists(
+                      get_right_partition_filename(i, true, dir)) ||
+                  !Parsing::file_exists(
+                      get_right_partition_filename(i, false, dir)))))
+                return false;
+        init_partitions();
+        frame->reset_buffer(1);
+        // the hashes in scratch are not for the restored partitions
+        for (int i = 0; i < n_sites; i++) {
+            remove_partition_hash(true, i);
+            remove_partition_hash(false, i);
+        }
+        frame->activate(1);
+        for (int i = 0; i < n_sites; i++) {
+            if (saved[i] & 1) {
+                envs[i]->load_data(true,
+                                   get_left_partition_filename(i, true, dir));
+                if (dir != frame->save_dir)
+                    Parsing::copy_file(
+                        get_left_partition_filename(i, false, dir),
+                        get_left_partition_filename(i));
+            }
+            if (saved[i] & 2) {
+                envs[i]->load_data(false,
+                                   get_right_partition_filename(i, true, dir));
+                if (dir != frame->save_dir)
+                    Parsing::copy_file(
+                        get_right_partition_filename(i, false, dir),
+                        get_right_partition_filename(i));
+            }
+        }
+        frame->activate(0);
+        frame->reset(1);
+        if (incremental_init)
+            save_partition_manifest();
+        return true;
     }
     void partial_prepare(int a, int b) {
         assert(a >= 0 && b <= n_sites);
@@ -1085,6 +1735,9 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
                                      get_left_partition_filename(center - 1));
                 left_contract_rotate(center);
             }
+            // hashes are for two-site right partitions
+            for (int i = n_sites - 1; i >= 0; i--)
+                remove_partition_hash(false, i);
             for (int i = n_sites - 1; i >= center; i--)
                 if (envs[i]->right != nullptr)
                     frame->rename_data(get_right_partition_filename(i),
@@ -1124,6 +1777,14 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
             envs[i]->right = nullptr;
         }
     }
+    // Run one step of move_to as a traced task (if sweep_trace is present)
+    int run_task(const string &name, const vector<int> &deps,
+                 const function<void()> &f) {
+        if (sweep_trace != nullptr)
+            return sweep_trace->submit(name, deps, f);
+        f();
+        return -1;
+    }
     // Move the center site by one
     virtual void move_to(int i, bool preserve_data = false) {
         string new_data_name = "";
@@ -1137,12 +1798,35 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
         //    but since no contraction will be performed,
         //    incorrect cinfo does not have effects
         if (i > center) {
+            int tload = -1, trot = -1;
+            // right block for the next site is read during the rotation
+            if (sweep_trace != nullptr &&
+                envs[center + 1]->right != nullptr) {
+                shared_future<shared_ptr<stringstream>> ft =
+                    frame->prefetch_data(
+                        1, get_right_partition_filename(center + 1));
+                sweep_trace->attach(
+                    "read R" + Parsing::to_string(center + 1), {}, ft,
+                    frame->prefetch_times[1]);
+            }
             if (envs[center]->left != nullptr &&
                 !(cached_info.first == OpCachingTypes::Left &&
                   cached_info.second == center))
-                frame->load_data(1, get_left_partition_filename(center));
+                tload = run_task("load L" + Parsing::to_string(center), {},
+                                 [this]() {
+                                     frame->load_data(
+                                         1, get_left_partition_filename(
+                                                center));
+                                 });
             // this will create left partition ++center (new_data_name)
-            left_contract_rotate(++center, preserve_data);
+            trot = run_task("rotate L" + Parsing::to_string(center + 1),
+                            {tload}, [this, preserve_data]() {
+                                left_contract_rotate(++center, preserve_data);
+                            });
+            if (sweep_trace != nullptr && frame->save_buffering)
+                sweep_trace->attach("save L" + Parsing::to_string(center),
+                                    {trot}, frame->save_futures[1],
+                                    frame->save_times[1]);
             if (envs[center]->left != nullptr)
                 new_data_name = get_left_partition_filename(center);
             if (frame->minimal_disk_usage && !preserve_data &&
@@ -1152,12 +1836,35 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
                     Parsing::remove_file(old_data_name);
             }
         } else if (i < center) {
+            int tload = -1, trot = -1;
+            // left block for the next site is read during the rotation
+            if (sweep_trace != nullptr &&
+                envs[center - 1]->left != nullptr) {
+                shared_future<shared_ptr<stringstream>> ft =
+                    frame->prefetch_data(
+                        1, get_left_partition_filename(center - 1));
+                sweep_trace->attach(
+                    "read L" + Parsing::to_string(center - 1), {}, ft,
+                    frame->prefetch_times[1]);
+            }
             if (envs[center]->right != nullptr &&
                 !(cached_info.first == OpCachingTypes::Right &&
                   cached_info.second == center + dot - 1))
-                frame->load_data(1, get_right_partition_filename(center));
+                tload = run_task("load R" + Parsing::to_string(center), {},
+                                 [this]() {
+                                     frame->load_data(
+                                         1, get_right_partition_filename(
+                                                center));
+                                 });
             // this will create right partition --center (new_data_name)
-            right_contract_rotate(--center, preserve_data);
+            trot = run_task("rotate R" + Parsing::to_string(center - 1),
+                            {tload}, [this, preserve_data]() {
+                                right_contract_rotate(--center, preserve_data);
+                            });
+            if (sweep_trace != nullptr && frame->save_buffering)
+                sweep_trace->attach("save R" + Parsing::to_string(center),
+                                    {trot}, frame->save_futures[1],
+                                    frame->save_times[1]);
             if (envs[center]->right != nullptr)
                 new_data_name = get_right_partition_filename(center);
             if (frame->minimal_disk_usage && !preserve_data &&
@@ -2142,19 +2849,23 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
             mats->iscale(sqrt(noise) / norm);
     }
     // Diagonalize density matrix and truncate to k eigenvalues
+    // dw_target: if nonzero, keep the minimal number of states (at most k)
+    //   such that the discarded weight is not larger than dw_target
     static FPS
     truncate_density_matrix(const shared_ptr<SparseMatrix<S, FLS>> &dm,
                             vector<pair<int, int>> &ss, int k, FPS cutoff,
                             bool store_wfn_spectra, vector<FPS> &wfn_spectra,
-                            TruncationTypes trunc_type) {
+                            TruncationTypes trunc_type, FPS dw_target = 0) {
         vector<shared_ptr<VectorAllocator<FPS>>> d_allocs(dm->info->n);
         vector<GDiagonalMatrix<FPS>> eigen_values(
             dm->info->n, GDiagonalMatrix<FPS>(nullptr, 0));
         vector<GMatrix<FPS>> eigen_values_reduced(dm->info->n,
                                                   GMatrix<FPS>(nullptr, 0, 0));
-        int ntg = threading->activate_global();
-#pragma omp parallel for schedule(dynamic) num_threads(ntg)
-        for (int i = 0; i < dm->info->n; i++) {
+        vector<size_t> sizes(dm->info->n);
+        for (int i = 0; i < dm->info->n; i++)
+            sizes[i] = (size_t)dm->info->n_states_bra[i] *
+                       dm->info->n_states_bra[i];
+        threading->parallel_for_blocks(sizes, [&](int i) {
             d_allocs[i] = make_shared<VectorAllocator<FPS>>();
             GDiagonalMatrix<FPS> w(nullptr, dm->info->n_states_bra[i]);
             w.allocate(d_allocs[i]);
@@ -2172,8 +2883,7 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
                     wr, dm->info->quanta[i].multiplicity());
             eigen_values[i] = w;
             eigen_values_reduced[i] = wr;
-        }
-        threading->activate_normal();
+        });
         int k_total = 0;
         for (int i = 0; i < dm->info->n; i++)
             k_total += eigen_values[i].n;
@@ -2198,6 +2908,18 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
                      return eigen_values_reduced[a.first].data[a.second] >
                             eigen_values_reduced[b.first].data[b.second];
                  });
+            if (dw_target > 0) {
+                FPS dw = 0;
+                int kd = k_total;
+                for (; kd > 1; kd--) {
+                    FPS x = max((FPS)0, eigen_values[ss[kd - 1].first]
+                                            .data[ss[kd - 1].second]);
+                    if (dw + x > dw_target)
+                        break;
+                    dw += x;
+                }
+                k = min(k, kd);
+            }
             if (((ubond_t)trunc_type >> 2) == 0) {
                 for (int i = k; i < k_total; i++) {
                     FPS x = eigen_values[ss[i].first].data[ss[i].second];
@@ -2257,10 +2979,13 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
         return error;
     }
     // Truncate and keep k singular values
+    // dw_target: if nonzero, keep the minimal number of states (at most k)
+    //   such that the discarded weight is not larger than dw_target
     static FPS truncate_singular_values(
         const vector<S> &qs, const vector<shared_ptr<GTensor<FPS>>> &s,
         vector<pair<int, int>> &ss, int k, FPS cutoff, bool store_wfn_spectra,
-        vector<FPS> &wfn_spectra, TruncationTypes trunc_type) {
+        vector<FPS> &wfn_spectra, TruncationTypes trunc_type,
+        FPS dw_target = 0) {
         vector<shared_ptr<GTensor<FPS>>> s_reduced;
         cutoff = sqrt(cutoff);
         int k_total = 0;
@@ -2297,6 +3022,17 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
                     return s_reduced[a.first]->data[a.second] >
                            s_reduced[b.first]->data[b.second];
                 });
+            if (dw_target > 0) {
+                FPS dw = 0;
+                int kd = k_total;
+                for (; kd > 1; kd--) {
+                    FPS x = s[ss[kd - 1].first]->data[ss[kd - 1].second];
+                    if (dw + x * x > dw_target)
+                        break;
+                    dw += x * x;
+                }
+                k = min(k, kd);
+            }
             if (((ubond_t)trunc_type >> 2) == 0) {
                 for (int i = k; i < k_total; i++) {
                     FPS x = s[ss[i].first]->data[ss[i].second];
@@ -2491,6 +3227,9 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
         return winfo;
     }
     // Split wavefunction to two MPS tensors using svd
+    // for RandomizedSVD, k + rsvd_oversampling columns are sampled per block
+    // the weight missed by randomized blocks is included in the error and
+    // the number of randomized blocks is added to n_rsvd (if not null)
     static FPS split_wavefunction_svd(
         S opdq, const shared_ptr<SparseMatrix<S, FLS>> &wfn, int k,
         bool trace_right, bool normalize,
@@ -2502,10 +3241,12 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
         const shared_ptr<SparseMatrixGroup<S, FLS>> &mwfn = nullptr,
         const vector<shared_ptr<SparseMatrix<S, FLS>>> &xwfns =
             vector<shared_ptr<SparseMatrix<S, FLS>>>(),
-        const vector<FPS> &weights = vector<FPS>()) {
+        const vector<FPS> &weights = vector<FPS>(), int rsvd_oversampling = 10,
+        FPS rsvd_eps = 1E-12, FPS dw_target = 0, int *n_rsvd = nullptr) {
         vector<shared_ptr<GTensor<FLS>>> l, r;
         vector<shared_ptr<GTensor<FPS>>> s;
         vector<S> qs;
+        int nr = 0;
         // for perturbative SVD
         if (mwfn != nullptr) {
             vector<vector<shared_ptr<GTensor<FLS>>>> xlr;
@@ -2534,15 +3275,33 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
                 l = xlr.back();
             }
         } else {
+            // randomized svd per block, with exact svd as fallback
+            ubond_t rsvd_rank =
+                decomp_type == DecompositionTypes::RandomizedSVD && k != -1
+                    ? (ubond_t)k
+                    : 0;
             if (trace_right)
-                wfn->right_svd(qs, l, s, r);
+                nr = wfn->right_svd(qs, l, s, r, 0, 0, rsvd_rank,
+                                    rsvd_oversampling, rsvd_eps);
             else
-                wfn->left_svd(qs, l, s, r);
+                nr = wfn->left_svd(qs, l, s, r, 0, 0, rsvd_rank,
+                                   rsvd_oversampling, rsvd_eps);
         }
         // ss: pair<quantum index in dm, reduced matrix index in dm>
         vector<pair<int, int>> ss;
-        FPS error = truncate_singular_values(
-            qs, s, ss, k, cutoff, store_wfn_spectra, wfn_spectra, trunc_type);
+        FPS error =
+            truncate_singular_values(qs, s, ss, k, cutoff, store_wfn_spectra,
+                                     wfn_spectra, trunc_type, dw_target);
+        // randomized blocks only return the leading singular values
+        if (nr != 0) {
+            FPS norm = wfn->norm(), snorm = 0;
+            for (auto &x : s)
+                for (FPS v : x->data)
+                    snorm += v * v;
+            error += max(norm * norm - snorm, (FPS)0.0);
+        }
+        if (n_rsvd != nullptr)
+            *n_rsvd += nr;
         // ilr: row index in singular values list
         // im: number of states
         vector<int> ilr;
@@ -2666,11 +3425,13 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
         bool normalize, shared_ptr<SparseMatrix<S, FLS>> &left,
         shared_ptr<SparseMatrix<S, FLS>> &right, FPS cutoff,
         bool store_wfn_spectra, vector<FPS> &wfn_spectra,
-        TruncationTypes trunc_type = TruncationTypes::Physical) {
+        TruncationTypes trunc_type = TruncationTypes::Physical,
+        FPS dw_target = 0) {
         // ss: pair<quantum index in dm, reduced matrix index in dm>
         vector<pair<int, int>> ss;
-        FPS error = truncate_density_matrix(
-            dm, ss, k, cutoff, store_wfn_spectra, wfn_spectra, trunc_type);
+        FPS error =
+            truncate_density_matrix(dm, ss, k, cutoff, store_wfn_spectra,
+                                    wfn_spectra, trunc_type, dw_target);
         // ilr: row index in dm
         // im: number of states
         vector<int> ilr;
@@ -2764,11 +3525,13 @@ template <typename S, typename FL, typename FLS> struct MovingEnvironment {
         vector<shared_ptr<SparseMatrixGroup<S, FLS>>> &new_wfns,
         shared_ptr<SparseMatrix<S, FLS>> &rot_mat, FPS cutoff,
         bool store_wfn_spectra, vector<FPS> &wfn_spectra,
-        TruncationTypes trunc_type = TruncationTypes::Physical) {
+        TruncationTypes trunc_type = TruncationTypes::Physical,
+        FPS dw_target = 0) {
         // ss: pair<quantum index in dm, reduced matrix index in dm>
         vector<pair<int, int>> ss;
-        FPS error = truncate_density_matrix(
-            dm, ss, k, cutoff, store_wfn_spectra, wfn_spectra, trunc_type);
+        FPS error =
+            truncate_density_matrix(dm, ss, k, cutoff, store_wfn_spectra,
+                                    wfn_spectra, trunc_type, dw_target);
         // ilr: row index in dm
         // im: number of states
         vector<int> ilr;
@@ -26,6 +26,7 @@
 #include "../core/symbolic.hpp"
 #include "../core/tensor_functions.hpp"
 #include "mps.hpp"
+#include <cstring>
 #include <iomanip>
 #include <memory>
 #include <sstream>
@@ -144,6 +145,11 @@ template <typename S, typename FL> struct MPO {
     vector<vector<size_t>> archive_marks;
     size_t archive_schemer_mark;
     string archive_filename = "";
+    // If true, only site operators (ops) of tensors are stored in archive file
+    // and the symbolic parts of tensors are kept in memory
+    bool archive_ops_only = false;
+    // Set if archive_tensor failed (see check_tensor_archive)
+    bool archive_failed = false;
     MPO(int n_sites)
         : n_sites(n_sites), sparse_form(n_sites, 'N'), const_e(0.0),
           op(nullptr), schemer(nullptr), tf(nullptr) {}
@@ -266,14 +272,20 @@ template <typename S, typename FL> struct MPO {
         total = left_total.back() + right_total.back();
         return vector<size_t>{psz * 8, peak * 8, total * 8};
     }
+    // Number of left operators after each site
+    vector<int> get_bond_dims() const {
+        vector<int> r(left_operator_names.size(), 0);
+        for (size_t i = 0; i < left_operator_names.size(); i++)
+            if (left_operator_names[i] != nullptr)
+                r[i] = (int)left_operator_names[i]->data.size();
+        return r;
+    }
     virtual void deallocate() {
         for (int16_t m = n_sites - 1; m >= 0; m--)
             if (tensors[m] != nullptr)
                 tensors[m]->deallocate();
     }
-    void load_tensor(int i) {
-        if (archive_filename == "")
-            return;
+    shared_ptr<OperatorTensor<S, FL>> load_archived_tensor(int i) const {
         assert(i < n_sites);
         ifstream ifs(archive_filename.c_str(), ios::binary);
         if (!ifs.good())
@@ -281,20 +293,80 @@ template <typename S, typename FL> struct MPO {
                                 "' failed.");
         ifs.clear();
         ifs.seekg(archive_marks[i][0]);
-        tensors[i] = make_shared<OperatorTensor<S, FL>>();
-        tensors[i]->load_data(ifs);
+        shared_ptr<OperatorTensor<S, FL>> opt =
+            make_shared<OperatorTensor<S, FL>>();
+        opt->load_data(ifs);
         if (ifs.fail() || ifs.bad())
             throw runtime_error("MPO:load_tensor on '" + archive_filename +
                                 "' failed.");
         ifs.close();
+        return opt;
+    }
+    void load_tensor(int i) {
+        if (archive_filename == "")
+            return;
+        if (archive_ops_only)
+            tensors[i]->ops = load_archived_tensor(i)->ops;
+        else
+            tensors[i] = load_archived_tensor(i);
     }
     void unload_tensor(int i) {
         assert(i < n_sites);
-        if (archive_filename != "")
+        if (archive_filename != "" && archive_ops_only)
+            tensors[i]->ops.clear();
+        else if (archive_filename != "")
             tensors[i] = nullptr;
     }
+    // Create archive file for streaming site operators to disk
+    // during construction of MPO
+    void init_tensor_archive(const string &filename) {
+        archive_filename = filename;
+        archive_ops_only = true;
+        archive_failed = false;
+        archive_marks.assign(n_sites + 1, vector<size_t>(7, 0));
+        ofstream ofs(filename.c_str(), ios::binary);
+        if (!ofs.good())
+            throw runtime_error("MPO:init_tensor_archive on '" + filename +
+                                "' failed.");
+        // zero mark means no data
+        ofs.write((char *)&n_sites, sizeof(n_sites));
+        if (!ofs.good())
+            throw runtime_error("MPO:init_tensor_archive on '" + filename +
+                                "' failed.");
+        ofs.close();
+    }
+    // Append site operators of tensor i to archive file and unload them
+    // Can be invoked from multiple threads, so errors are not thrown here
+    // but reported later by check_tensor_archive
+    void archive_tensor(int i) {
+        assert(archive_ops_only && i < n_sites);
+        shared_ptr<OperatorTensor<S, FL>> opt =
+            make_shared<OperatorTensor<S, FL>>();
+        opt->ops = tensors[i]->ops;
+#pragma omp critical(mpo_tensor_archive)
+        {
+            fstream ofs(archive_filename.c_str(),
+                        ios::binary | ios::in | ios::out);
+            if (ofs.good()) {
+                ofs.seekp(0, ios::end);
+                archive_marks[i][0] = (size_t)ofs.tellp();
+                opt->save_data(ofs);
+            }
+            if (!ofs.good())
+                archive_failed = true;
+            ofs.close();
+        }
+        tensors[i]->ops.clear();
+    }
+    // Throw if any archive_tensor call failed
+    // (outside the parallel region that archives the tensors)
+    void check_tensor_archive() const {
+        if (archive_failed)
+            throw runtime_error("MPO:archive_tensor on '" + archive_filename +
+                                "' failed.");
+    }
     void load_schemer() {
-        if (archive_filename == "")
+        if (archive_filename == "" || archive_ops_only)
             return;
         ifstream ifs(archive_filename.c_str(), ios::binary);
         if (!ifs.good())
@@ -309,11 +381,11 @@ template <typename S, typename FL> struct MPO {
         ifs.close();
     }
     void unload_schemer() {
-        if (archive_filename != "")
+        if (archive_filename != "" && !archive_ops_only)
             schemer->unload_data();
     }
     void load_left_operators(int i) {
-        if (archive_filename == "")
+        if (archive_filename == "" || archive_ops_only)
             return;
         assert(i < n_sites);
         ifstream ifs(archive_filename.c_str(), ios::binary);
@@ -334,14 +406,14 @@ template <typename S, typename FL> struct MPO {
         ifs.close();
     }
     void unload_left_operators(int i) {
-        if (archive_filename != "") {
+        if (archive_filename != "" && !archive_ops_only) {
             assert(i < n_sites);
             left_operator_names[i] = nullptr;
             left_operator_exprs[i] = nullptr;
         }
     }
     void load_right_operators(int i) {
-        if (archive_filename == "")
+        if (archive_filename == "" || archive_ops_only)
             return;
         assert(i < n_sites);
         ifstream ifs(archive_filename.c_str(), ios::binary);
@@ -362,14 +434,14 @@ template <typename S, typename FL> struct MPO {
         ifs.close();
     }
     void unload_right_operators(int i) {
-        if (archive_filename != "") {
+        if (archive_filename != "" && !archive_ops_only) {
             assert(i < n_sites);
             right_operator_names[i] = nullptr;
             right_operator_exprs[i] = nullptr;
         }
     }
     void load_middle_operators(int i) {
-        if (archive_filename == "")
+        if (archive_filename == "" || archive_ops_only)
             return;
         assert(i < n_sites);
         ifstream ifs(archive_filename.c_str(), ios::binary);
@@ -390,13 +462,14 @@ template <typename S, typename FL> struct MPO {
         ifs.close();
     }
     void unload_middle_operators(int i) {
-        if (archive_filename != "") {
+        if (archive_filename != "" && !archive_ops_only) {
             assert(i < n_sites);
             middle_operator_names[i] = nullptr;
             middle_operator_exprs[i] = nullptr;
         }
     }
-    virtual void load_data(istream &ifs, bool minimal = false) {
+    // Load MPO data before the per-site arrays (shared by both formats)
+    void load_header(istream &ifs, bool minimal) {
         ifs.read((char *)&n_sites, sizeof(n_sites));
         ifs.read((char *)&const_e, sizeof(const_e));
         sparse_form = string(n_sites, 'N');
@@ -436,6 +509,19 @@ template <typename S, typename FL> struct MPO {
                 site_op_infos[i][j].second->load_data(ifs);
             }
         }
+    }
+    virtual void load_data(istream &ifs, bool minimal = false) {
+        streamoff base = ifs.tellg();
+        char magic[8];
+        ifs.read(magic, sizeof(magic));
+        if (ifs.good() && memcmp(magic, indexed_format_magic(), 8) == 0) {
+            load_data_indexed(ifs, (size_t)base, minimal);
+            return;
+        }
+        ifs.clear();
+        ifs.seekg(base);
+        load_header(ifs, minimal);
+        int sz;
         archive_marks.resize(n_sites + 1);
         for (int i = 0; i <= n_sites; i++)
             archive_marks[i].resize(7);
@@ -512,7 +598,7 @@ template <typename S, typename FL> struct MPO {
     }
     void load_data(const string &filename, bool minimal = false) {
         if (minimal)
-            archive_filename = filename;
+            archive_filename = filename, archive_ops_only = false;
         ifstream ifs(filename.c_str(), ios::binary);
         if (!ifs.good())
             throw runtime_error("MPO:load_data on '" + filename + "' failed.");
@@ -521,8 +607,8 @@ template <typename S, typename FL> struct MPO {
             throw runtime_error("MPO:load_data on '" + filename + "' failed.");
         ifs.close();
     }
-    virtual void save_data(ostream &ofs) const {
-        assert(archive_filename == "");
+    // Save MPO data before the per-site arrays (shared by both formats)
+    void save_header(ostream &ofs) const {
         ofs.write((char *)&n_sites, sizeof(n_sites));
         ofs.write((char *)&const_e, sizeof(const_e));
         ofs.write((char *)&sparse_form[0], sizeof(char) * n_sites);
@@ -545,10 +631,15 @@ template <typename S, typename FL> struct MPO {
                 site_op_infos[i][j].second->save_data(ofs);
             }
         }
+    }
+    virtual void save_data(ostream &ofs) const {
+        assert(archive_filename == "" || archive_ops_only);
+        save_header(ofs);
+        int sz;
         sz = (int)tensors.size();
         ofs.write((char *)&sz, sizeof(sz));
         for (int i = 0; i < sz; i++)
-            tensors[i]->save_data(ofs);
+            save_tensor(i, ofs);
         sz = (int)basis.size();
         ofs.write((char *)&sz, sizeof(sz));
         for (int i = 0; i < sz; i++)
@@ -587,6 +678,123 @@ template <typename S, typename FL> struct MPO {
             throw runtime_error("MPO:save_data on '" + filename + "' failed.");
         ofs.close();
     }
+    // Indexed binary format (version 1):
+    // magic, version, header (same as non-indexed format), basis,
+    // sizes of the seven per-site arrays (tensors, left/right/middle names,
+    // left/right/middle exprs), index table of section offsets
+    // (relative to the magic, 0 = absent, in the order of archive_marks),
+    // and per-site sections. With minimal = true, only the header and
+    // the index table are read and per-site data is loaded on demand
+    // (by seeking to the offsets; the file is not memory mapped)
+    static const char *indexed_format_magic() { return "B2MPOIDX"; }
+    static uint32_t indexed_format_version() { return 1; }
+    void save_tensor(int i, ostream &ofs) const {
+        if (archive_ops_only) {
+            shared_ptr<OperatorTensor<S, FL>> opt = tensors[i]->copy();
+            opt->ops = load_archived_tensor(i)->ops;
+            opt->save_data(ofs);
+        } else
+            tensors[i]->save_data(ofs);
+    }
+    void save_data_indexed(ostream &ofs) const {
+        assert(archive_filename == "" || archive_ops_only);
+        const streamoff base = ofs.tellp();
+        const uint32_t version = indexed_format_version();
+        ofs.write(indexed_format_magic(), 8);
+        ofs.write((char *)&version, sizeof(version));
+        save_header(ofs);
+        int sz = (int)basis.size();
+        ofs.write((char *)&sz, sizeof(sz));
+        for (int i = 0; i < sz; i++)
+            basis[i]->save_data(ofs);
+        const vector<shared_ptr<Symbolic<S>>> *syms[6] = {
+            &left_operator_names, &right_operator_names,
+            &middle_operator_names, &left_operator_exprs,
+            &right_operator_exprs, &middle_operator_exprs};
+        int szs[7], n_marks = (int)tensors.size();
+        szs[0] = (int)tensors.size();
+        for (int k = 0; k < 6; k++)
+            szs[k + 1] = (int)syms[k]->size(),
+                    n_marks = max(n_marks, szs[k + 1]);
+        ofs.write((char *)szs, sizeof(szs));
+        ofs.write((char *)&n_marks, sizeof(n_marks));
+        vector<uint64_t> table((size_t)n_marks * 7, 0);
+        const streamoff table_pos = ofs.tellp();
+        ofs.write((char *)table.data(), sizeof(uint64_t) * table.size());
+        for (int i = 0; i < n_marks; i++)
+            for (int k = 0; k < 7; k++) {
+                if (i >= szs[k])
+                    continue;
+                table[i * 7 + k] = (uint64_t)(ofs.tellp() - base);
+                if (k == 0)
+                    save_tensor(i, ofs);
+                else
+                    save_symbolic<S>((*syms[k - 1])[i], ofs);
+            }
+        const streamoff end_pos = ofs.tellp();
+        ofs.seekp(table_pos);
+        ofs.write((char *)table.data(), sizeof(uint64_t) * table.size());
+        ofs.seekp(end_pos);
+    }
+    void save_data_indexed(const string &filename) const {
+        ofstream ofs(filename.c_str(), ios::binary);
+        if (!ofs.good())
+            throw runtime_error("MPO:save_data_indexed on '" + filename +
+                                "' failed.");
+        save_data_indexed(ofs);
+        if (!ofs.good())
+            throw runtime_error("MPO:save_data_indexed on '" + filename +
+                                "' failed.");
+        ofs.close();
+    }
+    // base is the stream position of the magic
+    void load_data_indexed(istream &ifs, size_t base, bool minimal) {
+        uint32_t version = 0;
+        ifs.read((char *)&version, sizeof(version));
+        if (version == 0 || version > indexed_format_version())
+            throw runtime_error("MPO:load_data_indexed unsupported version " +
+                                Parsing::to_string(version) + ".");
+        load_header(ifs, minimal);
+        int sz;
+        ifs.read((char *)&sz, sizeof(sz));
+        basis.resize(sz);
+        for (int i = 0; i < sz; i++) {
+            basis[i] = make_shared<StateInfo<S>>();
+            basis[i]->load_data(ifs);
+        }
+        vector<shared_ptr<Symbolic<S>>> *syms[6] = {
+            &left_operator_names, &right_operator_names,
+            &middle_operator_names, &left_operator_exprs,
+            &right_operator_exprs, &middle_operator_exprs};
+        int szs[7], n_marks;
+        ifs.read((char *)szs, sizeof(szs));
+        ifs.read((char *)&n_marks, sizeof(n_marks));
+        vector<uint64_t> table((size_t)n_marks * 7);
+        ifs.read((char *)table.data(), sizeof(uint64_t) * table.size());
+        tensors.assign(szs[0], nullptr);
+        for (int k = 0; k < 6; k++)
+            syms[k]->assign(szs[k + 1], nullptr);
+        archive_marks.assign(max(n_sites + 1, n_marks), vector<size_t>(7, 0));
+        for (int i = 0; i < n_marks; i++)
+            for (int k = 0; k < 7; k++)
+                if (table[i * 7 + k] != 0)
+                    archive_marks[i][k] = (size_t)(base + table[i * 7 + k]);
+        if (minimal)
+            return;
+        for (int i = 0; i < n_marks; i++)
+            for (int k = 0; k < 7; k++) {
+                if (archive_marks[i][k] == 0)
+                    continue;
+                ifs.seekg(archive_marks[i][k]);
+                if (k == 0) {
+                    tensors[i] = make_shared<OperatorTensor<S, FL>>();
+                    tensors[i]->load_data(ifs);
+                } else
+                    (*syms[k - 1])[i] = load_symbolic<S, FL>(ifs);
+            }
+        for (auto &mk : archive_marks)
+            memset(mk.data(), 0, sizeof(size_t) * mk.size());
+    }
     // For simplified MPO, the tensor symbols can be deleted
     // to save memory and storage
     void reduce_data() const {
@@ -37,6 +37,91 @@ using namespace std;
 
 namespace block2 {
 
+// Interned table of normalized OpElement
+// each unique element gets a 32-bit id, so that terms can be stored as flat
+// arrays of (id, id, factor, conj) and compared / hashed as integers
+// the symmetry rule is evaluated once for each element added to the table
+// (SimplifiedMPO uses one table for all expressions of one site, which is
+// read-only while the expressions are simplified)
+template <typename S, typename FL> struct OpElementTable {
+    static const uint32_t npos = (uint32_t)-1;
+    unordered_map<OpElement<S, FL>, uint32_t> mp;
+    vector<shared_ptr<OpElement<S, FL>>> ops;
+    // id, transpose flag and factor after applying the rule (see add)
+    vector<uint32_t> rid;
+    vector<uint8_t> rtrans;
+    vector<FL> rfactor;
+    OpElementTable() {}
+    size_t size() const { return ops.size(); }
+    // returns id of the normalized element; factor of x is not included
+    uint32_t intern(const shared_ptr<OpElement<S, FL>> &x) {
+        if (x == nullptr)
+            return npos;
+        OpElement<S, FL> ax = x->abs();
+        auto it = mp.find(ax);
+        if (it != mp.end())
+            return it->second;
+        uint32_t id = (uint32_t)ops.size();
+        mp[ax] = id;
+        ops.push_back(x->is_normalized() ? x
+                                         : make_shared<OpElement<S, FL>>(ax));
+        rid.push_back(npos);
+        rtrans.push_back(0);
+        rfactor.push_back(1.0);
+        return id;
+    }
+    // interns x and the element that x refers to via the rule
+    uint32_t add(const shared_ptr<OpElement<S, FL>> &x,
+                 const shared_ptr<Rule<S, FL>> &rule) {
+        uint32_t ix = intern(x);
+        if (rid[ix] == npos) {
+            shared_ptr<OpElementRef<S, FL>> opx = rule->operator()(ops[ix]);
+            if (opx == nullptr)
+                rid[ix] = ix;
+            else {
+                uint32_t iy = intern(opx->op);
+                rid[ix] = iy, rtrans[ix] = opx->trans;
+                rfactor[ix] = (FL)opx->factor * opx->op->factor;
+            }
+        }
+        return ix;
+    }
+    // interns all elements in the terms of a sum expression
+    void add_expr(const shared_ptr<OpExpr<S>> &expr,
+                  const shared_ptr<Rule<S, FL>> &rule) {
+        if (expr->get_type() != OpTypes::Sum)
+            return;
+        for (auto &x : dynamic_pointer_cast<OpSum<S, FL>>(expr)->strings) {
+            add(x->a, rule);
+            if (x->b != nullptr)
+                add(x->b, rule);
+        }
+    }
+    // id of the (added) element x after applying the rule;
+    // factor is multiplied by the factor of x and the factor of the rule
+    uint32_t resolve(const shared_ptr<OpElement<S, FL>> &x, FL &factor,
+                     uint8_t &trans) const {
+        uint32_t ix = mp.at(x->abs());
+        factor *= x->factor * rfactor[ix];
+        trans = rtrans[ix];
+        return rid[ix];
+    }
+    const shared_ptr<OpElement<S, FL>> &operator[](uint32_t id) const {
+        return ops[id];
+    }
+};
+
+template <typename S, typename FL> const uint32_t OpElementTable<S, FL>::npos;
+
+// Product term in interned representation (b == npos for single operator)
+template <typename FL> struct OpTermIds {
+    uint32_t a, b;
+    FL factor;
+    uint8_t conj;
+    OpTermIds(uint32_t a, uint32_t b, FL factor, uint8_t conj)
+        : a(a), b(b), factor(factor), conj(conj) {}
+};
+
 // Simplify MPO expression according to symmetry rules
 template <typename S, typename FL> struct SimplifiedMPO : MPO<S, FL> {
     // Original MPO
@@ -76,6 +161,11 @@ template <typename S, typename FL> struct SimplifiedMPO : MPO<S, FL> {
         MPO<S, FL>::site_op_infos = mpo->site_op_infos;
         MPO<S, FL>::left_operator_names = mpo->left_operator_names;
         MPO<S, FL>::sparse_form = mpo->sparse_form;
+        if (mpo->archive_ops_only) {
+            MPO<S, FL>::archive_filename = mpo->archive_filename;
+            MPO<S, FL>::archive_marks = mpo->archive_marks;
+            MPO<S, FL>::archive_ops_only = true;
+        }
         for (auto &x : MPO<S, FL>::left_operator_names)
             x = x->copy();
         MPO<S, FL>::right_operator_names = mpo->right_operator_names;
@@ -321,29 +411,10 @@ template <typename S, typename FL> struct SimplifiedMPO : MPO<S, FL> {
                                            ->data[j]
                                            ->get_type() != OpTypes::Zero)
                                 px[i & 1][j] = 1;
-                        if (xmp.size() != 0) {
-                            for (size_t j = 0;
-                                 j < MPO<S, FL>::left_operator_names[i]
-                                         ->data.size();
-                                 j++)
-                                if (px[i & 1][j] &&
-                                    MPO<S, FL>::left_operator_names[i]
-                                            ->data[j]
-                                            ->get_type() != OpTypes::Zero) {
-                                    auto xref = rule->operator()(
-                                        dynamic_pointer_cast<OpElement<S, FL>>(
-                                            MPO<S, FL>::left_operator_names[i]
-                                                ->data[j]));
-                                    if (xref != nullptr &&
-                                        xmp.count(xref->op) != 0)
-                                        xmp.at(xref->op) = -1;
-                                }
-                            for (auto &j : xmp)
-                                if (j.second != -1)
-                                    MPO<S, FL>::left_operator_names[i]
-                                        ->data[j.second] = zero;
-                            xmp.clear();
-                        }
+                        if (xmp.size() != 0)
+                            remove_unreferenced_ops(
+                                MPO<S, FL>::left_operator_names[i],
+                                px[i & 1], xmp);
                     } else if (MPO<S, FL>::schemer->right_trans_site -
                                    MPO<S, FL>::schemer->left_trans_site >
                                1) {
@@ -375,30 +446,10 @@ template <typename S, typename FL> struct SimplifiedMPO : MPO<S, FL> {
                                            ->left_new_operator_names->data[j]
                                            ->get_type() != OpTypes::Zero)
                                 px[i & 1][j] = 1;
-                        if (xmp.size() != 0) {
-                            for (size_t j = 0;
-                                 j < MPO<S, FL>::schemer
-                                         ->left_new_operator_names->data.size();
-                                 j++)
-                                if (px[i & 1][j] &&
-                                    MPO<S, FL>::schemer->left_new_operator_names
-                                            ->data[j]
-                                            ->get_type() != OpTypes::Zero) {
-                                    auto xref = rule->operator()(
-                                        dynamic_pointer_cast<OpElement<S, FL>>(
-                                            MPO<S, FL>::schemer
-                                                ->left_new_operator_names
-                                                ->data[j]));
-                                    if (xref != nullptr &&
-                                        xmp.count(xref->op) != 0)
-                                        xmp.at(xref->op) = -1;
-                                }
-                            for (auto &j : xmp)
-                                if (j.second != -1)
-                                    MPO<S, FL>::schemer->left_new_operator_names
-                                        ->data[j.second] = zero;
-                            xmp.clear();
-                        }
+                        if (xmp.size() != 0)
+                            remove_unreferenced_ops(
+                                MPO<S, FL>::schemer->left_new_operator_names,
+                                px[i & 1], xmp);
                     }
                     if (MPO<S, FL>::schemer != nullptr &&
                         i == MPO<S, FL>::schemer->left_trans_site) {
@@ -524,29 +575,10 @@ template <typename S, typename FL> struct SimplifiedMPO : MPO<S, FL> {
                                            ->data[j]
                                            ->get_type() != OpTypes::Zero)
                                 px[i & 1][j] = 1;
-                        if (xmp.size() != 0) {
-                            for (size_t j = 0;
-                                 j < MPO<S, FL>::right_operator_names[i]
-                                         ->data.size();
-                                 j++)
-                                if (px[i & 1][j] &&
-                                    MPO<S, FL>::right_operator_names[i]
-                                            ->data[j]
-                                            ->get_type() != OpTypes::Zero) {
-                                    auto xref = rule->operator()(
-                                        dynamic_pointer_cast<OpElement<S, FL>>(
-                                            MPO<S, FL>::right_operator_names[i]
-                                                ->data[j]));
-                                    if (xref != nullptr &&
-                                        xmp.count(xref->op) != 0)
-                                        xmp.at(xref->op) = -1;
-                                }
-                            for (auto &j : xmp)
-                                if (j.second != -1)
-                                    MPO<S, FL>::right_operator_names[i]
-                                        ->data[j.second] = zero;
-                            xmp.clear();
-                        }
+                        if (xmp.size() != 0)
+                            remove_unreferenced_ops(
+                                MPO<S, FL>::right_operator_names[i],
+                                px[i & 1], xmp);
                     } else if (MPO<S, FL>::schemer->right_trans_site -
                                    MPO<S, FL>::schemer->left_trans_site >
                                1) {
@@ -579,32 +611,10 @@ template <typename S, typename FL> struct SimplifiedMPO : MPO<S, FL> {
                                            ->right_new_operator_names->data[j]
                                            ->get_type() != OpTypes::Zero)
                                 px[i & 1][j] = 1;
-                        if (xmp.size() != 0) {
-                            for (size_t j = 0;
-                                 j <
-                                 MPO<S, FL>::schemer->right_new_operator_names
-                                     ->data.size();
-                                 j++)
-                                if (px[i & 1][j] &&
-                                    MPO<S, FL>::schemer
-                                            ->right_new_operator_names->data[j]
-                                            ->get_type() != OpTypes::Zero) {
-                                    auto xref = rule->operator()(
-                                        dynamic_pointer_cast<OpElement<S, FL>>(
-                                            MPO<S, FL>::schemer
-                                                ->right_new_operator_names
-                                                ->data[j]));
-                                    if (xref != nullptr &&
-                                        xmp.count(xref->op) != 0)
-                                        xmp.at(xref->op) = -1;
-                                }
-                            for (auto &j : xmp)
-                                if (j.second != -1)
-                                    MPO<S, FL>::schemer
-                                        ->right_new_operator_names
-                                        ->data[j.second] = zero;
-                            xmp.clear();
-                        }
+                        if (xmp.size() != 0)
+                            remove_unreferenced_ops(
+                                MPO<S, FL>::schemer->right_new_operator_names,
+                                px[i & 1], xmp);
                     }
                     if (MPO<S, FL>::schemer != nullptr &&
                         i == MPO<S, FL>::schemer->right_trans_site) {
@@ -728,6 +738,193 @@ template <typename S, typename FL> struct SimplifiedMPO : MPO<S, FL> {
         simplify();
         threading->activate_normal();
     }
+    // operators in xmp (op -> index in names) are not useful by themselves
+    // they are kept only if indirectly referenced (via the rule) by
+    // any useful operator in names; xmp is cleared
+    void
+    remove_unreferenced_ops(const shared_ptr<Symbolic<S>> &names,
+                            const vector<uint8_t> &pxi,
+                            unordered_map<shared_ptr<OpExpr<S>>, int> &xmp) {
+        static shared_ptr<OpExpr<S>> zero = make_shared<OpExpr<S>>();
+        const int n = (int)names->data.size();
+        vector<int> xref_idx(n, -1);
+        int ntg = threading->activate_global();
+#pragma omp parallel for schedule(static, 50) num_threads(ntg)
+        for (int j = 0; j < n; j++)
+            if (pxi[j] && names->data[j]->get_type() != OpTypes::Zero) {
+                auto xref = rule->operator()(
+                    dynamic_pointer_cast<OpElement<S, FL>>(names->data[j]));
+                if (xref != nullptr) {
+                    auto it = xmp.find(xref->op);
+                    if (it != xmp.end())
+                        xref_idx[j] = it->second;
+                }
+            }
+        vector<uint8_t> referenced(n, 0);
+        for (int j = 0; j < n; j++)
+            if (xref_idx[j] != -1)
+                referenced[xref_idx[j]] = 1;
+        for (auto &j : xmp)
+            if (!referenced[j.second])
+                names->data[j.second] = zero;
+        xmp.clear();
+    }
+    // simplify a sum expression whose elements are all in table
+    // (scale multiplies all terms)
+    shared_ptr<OpExpr<S>> simplify_sum(const shared_ptr<OpSum<S, FL>> &ops,
+                                       S op, const OpElementTable<S, FL> &table,
+                                       FL scale = 1.0) {
+        static shared_ptr<OpExpr<S>> zero = make_shared<OpExpr<S>>();
+        const uint32_t npos = OpElementTable<S, FL>::npos;
+        // ids in terms are local to this sum (in order of appearance),
+        // so that the grouping below does not scale with the table size
+        vector<uint32_t> lids;
+        unordered_map<uint32_t, uint32_t> lmp;
+        lmp.reserve(ops->strings.size() * 2);
+        auto local = [&lids, &lmp](uint32_t ix) -> uint32_t {
+            auto it = lmp.find(ix);
+            if (it != lmp.end())
+                return it->second;
+            lmp[ix] = (uint32_t)lids.size();
+            lids.push_back(ix);
+            return (uint32_t)lids.size() - 1;
+        };
+        // merge terms that differ only by coefficients
+        vector<OpTermIds<FL>> fterms;
+        unordered_map<uint64_t, size_t> mp[4];
+        fterms.reserve(ops->strings.size());
+        for (int i = 0; i < 4; i++)
+            mp[i].reserve(ops->strings.size());
+        for (auto &x : ops->strings) {
+            if (x->factor == 0.0)
+                continue;
+            FL factor = x->factor * scale;
+            uint8_t ta = 0, tb = 0;
+            uint32_t a = local(table.resolve(x->a, factor, ta));
+            uint32_t b =
+                x->b == nullptr ? npos : local(table.resolve(x->b, factor, tb));
+            uint8_t conj = ta | (tb << 1);
+            uint64_t key = ((uint64_t)a << 32) | b;
+            auto it = mp[conj].find(key);
+            if (it == mp[conj].end()) {
+                mp[conj][key] = fterms.size();
+                fterms.push_back(OpTermIds<FL>(a, b, factor, conj));
+            } else
+                fterms[it->second].factor += factor;
+        }
+        size_t nt = 0;
+        for (size_t k = 0; k < fterms.size(); k++)
+            if (abs(fterms[k].factor) >= TINY)
+                fterms[nt++] = fterms[k];
+        fterms.erase(fterms.begin() + nt, fterms.end());
+        if (fterms.size() == 0)
+            return zero;
+        vector<shared_ptr<OpProduct<S, FL>>> terms;
+        terms.reserve(fterms.size());
+        auto elem = [&table, &lids](uint32_t id)
+            -> const shared_ptr<OpElement<S, FL>> & { return table[lids[id]]; };
+        // terms point to the interned (normalized) elements,
+        // so that the elements are not copied for each term
+        auto make_term = [&elem, npos](const OpTermIds<FL> &t) {
+            shared_ptr<OpProduct<S, FL>> r = make_shared<OpProduct<S, FL>>(
+                nullptr, nullptr, t.factor, t.conj);
+            r->a = elem(t.a);
+            r->b = t.b == npos ? nullptr : elem(t.b);
+            return r;
+        };
+        if (fterms[0].b == npos || fterms.size() <= 2 || !collect_terms ||
+            op == S(S::invalid)) {
+            for (auto &t : fterms)
+                terms.push_back(make_term(t));
+            return make_shared<OpSum<S, FL>>(terms);
+        }
+        const uint32_t nl = (uint32_t)lids.size();
+        // extract common factors from terms
+        // groups are indexed by [conj][id][multiplicity of the other op]
+        vector<map<int, vector<uint32_t>>> mpa[2], mpb[2];
+        size_t nga = 0, ngb = 0;
+        for (int i = 0; i < 2; i++) {
+            mpa[i].resize(nl);
+            mpb[i].resize(nl);
+        }
+        for (uint32_t k = 0; k < (uint32_t)fterms.size(); k++) {
+            const OpTermIds<FL> &x = fterms[k];
+            assert(x.b != npos);
+            map<int, vector<uint32_t>> &ma = mpa[x.conj & 1][x.a];
+            map<int, vector<uint32_t>> &mb = mpb[(x.conj & 2) >> 1][x.b];
+            nga += ma.empty(), ngb += mb.empty();
+            ma[elem(x.b)->q_label.multiplicity()].push_back(k);
+            mb[elem(x.a)->q_label.multiplicity()].push_back(k);
+        }
+        // merge right part if left = true else merge left part
+        const bool left = nga <= ngb;
+        vector<map<int, vector<uint32_t>>>(&mpx)[2] = left ? mpa : mpb;
+        // position of the collected id inside the current group
+        vector<int> pos[2];
+        pos[0].resize(nl, -1);
+        pos[1].resize(nl, -1);
+        for (int i = 0; i < 2; i++)
+            for (uint32_t ir = 0; ir < nl; ir++) {
+                if (mpx[i][ir].empty())
+                    continue;
+                // pgb = op.pg - pga or pga = op.pg - pgb
+                int pgr = elem(ir)->q_label.pg();
+                int pg = S::pg_mul(i ? pgr : S::pg_inv(pgr), op.pg());
+                for (auto &rr : mpx[i][ir]) {
+                    if (rr.second.size() == 1) {
+                        terms.push_back(make_term(fterms[rr.second[0]]));
+                        continue;
+                    }
+                    vector<bool> conjs;
+                    vector<uint32_t> gids;
+                    vector<FL> gfactors;
+                    conjs.reserve(rr.second.size());
+                    gids.reserve(rr.second.size());
+                    gfactors.reserve(rr.second.size());
+                    for (auto &k : rr.second) {
+                        const OpTermIds<FL> &s = fterms[k];
+                        const uint32_t ig = left ? s.b : s.a;
+                        const bool cj = (s.conj & (left ? 2 : 1)) != 0;
+                        if (!S::pg_equal(elem(ig)->q_label.pg(),
+                                         cj ? S::pg_inv(pg) : pg))
+                            continue;
+                        if (pos[cj][ig] != -1)
+                            gfactors[pos[cj][ig]] += s.factor;
+                        else {
+                            pos[cj][ig] = (int)gids.size();
+                            conjs.push_back(cj);
+                            gids.push_back(ig);
+                            gfactors.push_back(s.factor);
+                        }
+                    }
+                    for (size_t j = 0; j < gids.size(); j++)
+                        pos[conjs[j]][gids[j]] = -1;
+                    if (gids.size() == 0)
+                        continue;
+                    uint8_t cjx = left ? i : i << 1;
+                    if (conjs[0])
+                        conjs.flip(), cjx |= left ? 1 << 1 : 1;
+                    if (gids.size() == 1) {
+                        terms.push_back(make_term(
+                            left ? OpTermIds<FL>(ir, gids[0], gfactors[0], cjx)
+                                 : OpTermIds<FL>(gids[0], ir, gfactors[0],
+                                                 cjx)));
+                        continue;
+                    }
+                    vector<shared_ptr<OpElement<S, FL>>> gops;
+                    gops.reserve(gids.size());
+                    for (size_t j = 0; j < gids.size(); j++)
+                        gops.push_back(make_shared<OpElement<S, FL>>(
+                            *elem(gids[j]) * gfactors[j]));
+                    terms.push_back(
+                        left ? make_shared<OpSumProd<S, FL>>(
+                                   elem(ir), gops, conjs, 1.0, cjx)
+                             : make_shared<OpSumProd<S, FL>>(
+                                   gops, elem(ir), conjs, 1.0, cjx));
+                }
+            }
+        return make_shared<OpSum<S, FL>>(terms);
+    }
     shared_ptr<OpExpr<S>> simplify_expr(const shared_ptr<OpExpr<S>> &expr,
                                         S op = S(S::invalid)) {
         static shared_ptr<OpExpr<S>> zero = make_shared<OpExpr<S>>();
@@ -747,203 +944,10 @@ template <typename S, typename FL> struct SimplifiedMPO : MPO<S, FL> {
             return make_shared<OpProduct<S, FL>>(a, b, factor, conj);
         } break;
         case OpTypes::Sum: {
-            shared_ptr<OpSum<S, FL>> ops =
-                dynamic_pointer_cast<OpSum<S, FL>>(expr);
-            // merge terms that differ only by coefficients
-            unordered_map<shared_ptr<OpExpr<S>>,
-                          vector<shared_ptr<OpProduct<S, FL>>>>
-                mp;
-            mp.reserve(ops->strings.size());
-            for (auto &x : ops->strings) {
-                if (x->factor == 0.0)
-                    continue;
-                shared_ptr<OpElementRef<S, FL>> opl = rule->operator()(x->a);
-                shared_ptr<OpElementRef<S, FL>> opr =
-                    x->b == nullptr ? nullptr : rule->operator()(x->b);
-                shared_ptr<OpElement<S, FL>> a =
-                    opl == nullptr ? x->a : opl->op;
-                shared_ptr<OpElement<S, FL>> b =
-                    opr == nullptr ? x->b : opr->op;
-                uint8_t conj = (opl != nullptr && opl->trans) |
-                               ((opr != nullptr && opr->trans) << 1);
-                FL factor = (opl != nullptr ? opl->factor : 1.0) *
-                            (opr != nullptr ? opr->factor : 1.0) * x->factor;
-                if (!mp.count(a))
-                    mp[a] = vector<shared_ptr<OpProduct<S, FL>>>();
-                vector<shared_ptr<OpProduct<S, FL>>> &px = mp.at(a);
-                int g = -1;
-                for (size_t k = 0; k < px.size(); k++)
-                    if (px[k]->b == b && px[k]->conj == conj) {
-                        g = (int)k;
-                        break;
-                    }
-                if (g == -1)
-                    px.push_back(
-                        make_shared<OpProduct<S, FL>>(a, b, factor, conj));
-                else {
-                    px[g]->factor += factor;
-                    if (abs(px[g]->factor) < TINY)
-                        px.erase(px.begin() + g);
-                }
-            }
-            vector<shared_ptr<OpProduct<S, FL>>> terms;
-            terms.reserve(mp.size());
-            for (auto &r : mp)
-                terms.insert(terms.end(), r.second.begin(), r.second.end());
-            if (terms.size() == 0)
-                return zero;
-            else if (terms[0]->b == nullptr || terms.size() <= 2)
-                return make_shared<OpSum<S, FL>>(terms);
-            else if (collect_terms && op != S(S::invalid)) {
-                // extract common factors from terms
-                unordered_map<shared_ptr<OpExpr<S>>,
-                              map<int, vector<shared_ptr<OpProduct<S, FL>>>>>
-                    mpa[2], mpb[2];
-                for (int i = 0; i < 2; i++) {
-                    mpa[i].reserve(terms.size());
-                    mpb[i].reserve(terms.size());
-                }
-                for (auto &x : terms) {
-                    assert(x->a != nullptr && x->b != nullptr);
-                    if (x->conj & 1)
-                        mpa[1][x->a][x->b->q_label.multiplicity()].push_back(x);
-                    else
-                        mpa[0][x->a][x->b->q_label.multiplicity()].push_back(x);
-                    if (x->conj & 2)
-                        mpb[1][x->b][x->a->q_label.multiplicity()].push_back(x);
-                    else
-                        mpb[0][x->b][x->a->q_label.multiplicity()].push_back(x);
-                }
-                terms.clear();
-                if (mpa[0].size() + mpa[1].size() <=
-                    mpb[0].size() + mpb[1].size()) {
-                    // merge right part
-                    for (int i = 0; i < 2; i++)
-                        for (auto &r : mpa[i]) {
-                            // pgb = op.pg - pga
-                            int pga =
-                                dynamic_pointer_cast<OpElement<S, FL>>(r.first)
-                                    ->q_label.pg();
-                            int pg =
-                                S::pg_mul(i ? pga : S::pg_inv(pga), op.pg());
-                            for (auto &rr : r.second) {
-                                if (rr.second.size() == 1)
-                                    terms.push_back(rr.second[0]);
-                                else {
-                                    vector<bool> conjs;
-                                    vector<shared_ptr<OpElement<S, FL>>> ops;
-                                    conjs.reserve(rr.second.size());
-                                    ops.reserve(rr.second.size());
-                                    for (auto &s : rr.second) {
-                                        if (!S::pg_equal(s->b->q_label.pg(),
-                                                         (s->conj & 2)
-                                                             ? S::pg_inv(pg)
-                                                             : pg))
-                                            continue;
-                                        bool cj = (s->conj & 2) != 0,
-                                             found = false;
-                                        OpElement<S, FL> op = s->b->abs();
-                                        for (size_t j = 0; j < ops.size(); j++)
-                                            if (conjs[j] == cj &&
-                                                op == ops[j]->abs()) {
-                                                found = true;
-                                                ops[j]->factor +=
-                                                    s->b->factor * s->factor;
-                                                break;
-                                            }
-                                        if (!found) {
-                                            conjs.push_back((s->conj & 2) != 0);
-                                            ops.push_back(dynamic_pointer_cast<
-                                                          OpElement<S, FL>>(
-                                                (shared_ptr<OpExpr<S>>)s->b *
-                                                s->factor));
-                                        }
-                                    }
-                                    uint8_t cjx = i;
-                                    if (conjs[0])
-                                        conjs.flip(), cjx |= 1 << 1;
-                                    if (ops.size() == 1)
-                                        terms.push_back(
-                                            make_shared<OpProduct<S, FL>>(
-                                                dynamic_pointer_cast<
-                                                    OpElement<S, FL>>(r.first),
-                                                ops[0], 1.0, cjx));
-                                    else if (ops.size() != 0)
-                                        terms.push_back(
-                                            make_shared<OpSumProd<S, FL>>(
-                                                dynamic_pointer_cast<
-                                                    OpElement<S, FL>>(r.first),
-                                                ops, conjs, 1.0, cjx));
-                                }
-                            }
-                        }
-                } else {
-                    // merge left part
-                    for (int i = 0; i < 2; i++)
-                        for (auto &r : mpb[i]) {
-                            // pga = op.pg - pgb
-                            int pgb =
-                                dynamic_pointer_cast<OpElement<S, FL>>(r.first)
-                                    ->q_label.pg();
-                            int pg =
-                                S::pg_mul(i ? pgb : S::pg_inv(pgb), op.pg());
-                            for (auto &rr : r.second) {
-                                if (rr.second.size() == 1)
-                                    terms.push_back(rr.second[0]);
-                                else {
-                                    vector<bool> conjs;
-                                    vector<shared_ptr<OpElement<S, FL>>> ops;
-                                    conjs.reserve(rr.second.size());
-                                    ops.reserve(rr.second.size());
-                                    for (auto &s : rr.second) {
-                                        if (!S::pg_equal(s->a->q_label.pg(),
-                                                         (s->conj & 1)
-                                                             ? S::pg_inv(pg)
-                                                             : pg))
-                                            continue;
-                                        bool cj = (s->conj & 1) != 0,
-                                             found = false;
-                                        OpElement<S, FL> op = s->a->abs();
-                                        for (size_t j = 0; j < ops.size(); j++)
-                                            if (conjs[j] == cj &&
-                                                op == ops[j]->abs()) {
-                                                found = true;
-                                                ops[j]->factor +=
-                                                    s->a->factor * s->factor;
-                                                break;
-                                            }
-                                        if (!found) {
-                                            conjs.push_back((s->conj & 1) != 0);
-                                            ops.push_back(dynamic_pointer_cast<
-                                                          OpElement<S, FL>>(
-                                                (shared_ptr<OpExpr<S>>)s->a *
-                                                s->factor));
-                                        }
-                                    }
-                                    uint8_t cjx = i << 1;
-                                    if (conjs[0])
-                                        conjs.flip(), cjx |= 1;
-                                    if (ops.size() == 1)
-                                        terms.push_back(
-                                            make_shared<OpProduct<S, FL>>(
-                                                ops[0],
-                                                dynamic_pointer_cast<
-                                                    OpElement<S, FL>>(r.first),
-                                                1.0, cjx));
-                                    else if (ops.size() != 0)
-                                        terms.push_back(
-                                            make_shared<OpSumProd<S, FL>>(
-                                                ops,
-                                                dynamic_pointer_cast<
-                                                    OpElement<S, FL>>(r.first),
-                                                conjs, 1.0, cjx));
-                                }
-                            }
-                        }
-                }
-                return make_shared<OpSum<S, FL>>(terms);
-            } else
-                return make_shared<OpSum<S, FL>>(terms);
+            OpElementTable<S, FL> table;
+            table.add_expr(expr, rule);
+            return simplify_sum(dynamic_pointer_cast<OpSum<S, FL>>(expr), op,
+                                table);
         } break;
         case OpTypes::Zero:
         case OpTypes::Elem:
@@ -954,9 +958,10 @@ template <typename S, typename FL> struct SimplifiedMPO : MPO<S, FL> {
         }
         return expr;
     }
-    void simplify_symbolic(const shared_ptr<Symbolic<S>> &name,
-                           const shared_ptr<Symbolic<S>> &expr,
-                           const shared_ptr<Symbolic<S>> &ref = nullptr) {
+    // remove zero and redundant (rule-referenced) operators
+    void prune_symbolic(const shared_ptr<Symbolic<S>> &name,
+                        const shared_ptr<Symbolic<S>> &expr,
+                        const shared_ptr<Symbolic<S>> &ref = nullptr) {
         assert(name->data.size() == expr->data.size());
         size_t k = 0;
         for (size_t j = 0; j < name->data.size(); j++) {
@@ -976,15 +981,31 @@ template <typename S, typename FL> struct SimplifiedMPO : MPO<S, FL> {
         }
         name->data.resize(k);
         expr->data.resize(k);
-        int ntg = ref != nullptr ? threading->activate_global() : 1;
-#pragma omp parallel for schedule(static, 20) num_threads(ntg)
-        for (int j = 0; j < (int)name->data.size(); j++) {
-            shared_ptr<OpElement<S, FL>> op =
-                dynamic_pointer_cast<OpElement<S, FL>>(name->data[j]);
-            name->data[j] = abs_value(name->data[j]);
-            expr->data[j] =
-                simplify_expr(expr->data[j], op->q_label) * (1.0 / op->factor);
-        }
+    }
+    // simplify one expression and multiply it by scale, using the
+    // interned elements of its site for sum expressions if table is given
+    shared_ptr<OpExpr<S>>
+    simplify_site_expr(const shared_ptr<OpExpr<S>> &expr, S op,
+                       const OpElementTable<S, FL> *table, FL scale = 1.0) {
+        if (table != nullptr && expr->get_type() == OpTypes::Sum)
+            return simplify_sum(dynamic_pointer_cast<OpSum<S, FL>>(expr), op,
+                                *table, scale);
+        return simplify_expr(expr, op) * scale;
+    }
+    // simplify one pruned expression and normalize its name
+    void
+    simplify_symbolic_term(const shared_ptr<Symbolic<S>> &name,
+                           const shared_ptr<Symbolic<S>> &expr, int j,
+                           const OpElementTable<S, FL> *table = nullptr) {
+        shared_ptr<OpElement<S, FL>> op =
+            dynamic_pointer_cast<OpElement<S, FL>>(name->data[j]);
+        name->data[j] = abs_value(name->data[j]);
+        expr->data[j] = simplify_site_expr(expr->data[j], op->q_label, table,
+                                           (FL)(1.0 / op->factor));
+    }
+    // assign intermediate operators and update symbolic shape
+    void finalize_symbolic(const shared_ptr<Symbolic<S>> &name,
+                           const shared_ptr<Symbolic<S>> &expr) {
         if (use_intermediate) {
             uint16_t idxi = 0, idxj = 0;
             for (size_t j = 0; j < expr->data.size(); j++) {
@@ -1015,6 +1036,16 @@ template <typename S, typename FL> struct SimplifiedMPO : MPO<S, FL> {
         else
             name->m = expr->m = (int)name->data.size();
     }
+    void simplify_symbolic(const shared_ptr<Symbolic<S>> &name,
+                           const shared_ptr<Symbolic<S>> &expr,
+                           const shared_ptr<Symbolic<S>> &ref = nullptr) {
+        prune_symbolic(name, expr, ref);
+        int ntg = ref != nullptr ? threading->activate_global() : 1;
+#pragma omp parallel for schedule(static, 20) num_threads(ntg)
+        for (int j = 0; j < (int)name->data.size(); j++)
+            simplify_symbolic_term(name, expr, j);
+        finalize_symbolic(name, expr);
+    }
     void simplify() {
         if (MPO<S, FL>::schemer != nullptr) {
             simplify_symbolic(
@@ -1028,28 +1059,70 @@ template <typename S, typename FL> struct SimplifiedMPO : MPO<S, FL> {
                 MPO<S, FL>::right_operator_names[MPO<S, FL>::schemer
                                                      ->right_trans_site]);
         }
+        const int n_sites = MPO<S, FL>::n_sites;
         int ntg = threading->activate_global();
-        vector<int> gidx(MPO<S, FL>::n_sites);
-        for (int i = 0; i < MPO<S, FL>::n_sites; i++)
-            gidx[i] = i;
-        if (ntg != 1)
-            sort(gidx.begin(), gidx.end(), [this](int i, int j) {
-                return this->left_operator_names[i]->data.size() >
-                       this->left_operator_names[j]->data.size();
-            });
+        // one interned element table per site, shared by the left, right
+        // and middle expressions of the site
+        vector<OpElementTable<S, FL>> tables(n_sites);
+        // sites are independent, the rule is applied in parallel over sites
 #pragma omp parallel for schedule(dynamic) num_threads(ntg)
-        for (int ii = 0; ii < MPO<S, FL>::n_sites; ii++) {
-            int i = gidx[ii];
-            simplify_symbolic(MPO<S, FL>::left_operator_names[i],
+        for (int i = 0; i < n_sites; i++) {
+            prune_symbolic(MPO<S, FL>::left_operator_names[i],
+                           MPO<S, FL>::left_operator_exprs[i]);
+            prune_symbolic(MPO<S, FL>::right_operator_names[i],
+                           MPO<S, FL>::right_operator_exprs[i]);
+            for (auto &x : MPO<S, FL>::left_operator_exprs[i]->data)
+                tables[i].add_expr(x, rule);
+            for (auto &x : MPO<S, FL>::right_operator_exprs[i]->data)
+                tables[i].add_expr(x, rule);
+            if (i < n_sites - 1)
+                for (auto &x : MPO<S, FL>::middle_operator_exprs[i]->data)
+                    tables[i].add_expr(x, rule);
+        }
+        // expressions of all sites are flattened into one task list,
+        // so that the load is balanced when sites differ in size
+        // task k is (symbolic index, expr index); symbolic index
+        // 3i, 3i + 1, 3i + 2 is left, right, middle expr of site i
+        vector<size_t> offsets(n_sites * 3 + 1, 0);
+        for (int i = 0; i < n_sites; i++) {
+            offsets[i * 3 + 1] =
+                MPO<S, FL>::left_operator_exprs[i]->data.size();
+            offsets[i * 3 + 2] =
+                MPO<S, FL>::right_operator_exprs[i]->data.size();
+            offsets[i * 3 + 3] =
+                i < n_sites - 1
+                    ? MPO<S, FL>::middle_operator_exprs[i]->data.size()
+                    : 0;
+        }
+        for (int i = 0; i < n_sites * 3; i++)
+            offsets[i + 1] += offsets[i];
+#pragma omp parallel for schedule(dynamic, 4) num_threads(ntg)
+        for (int64_t k = 0; k < (int64_t)offsets.back(); k++) {
+            int ix = (int)(upper_bound(offsets.begin(), offsets.end(),
+                                      (size_t)k) -
+                           offsets.begin()) -
+                     1;
+            int i = ix / 3, j = (int)(k - offsets[ix]);
+            if (ix % 3 == 0)
+                simplify_symbolic_term(MPO<S, FL>::left_operator_names[i],
+                                       MPO<S, FL>::left_operator_exprs[i], j,
+                                       &tables[i]);
+            else if (ix % 3 == 1)
+                simplify_symbolic_term(MPO<S, FL>::right_operator_names[i],
+                                       MPO<S, FL>::right_operator_exprs[i],
+                                       j, &tables[i]);
+            else {
+                shared_ptr<OpExpr<S>> &x =
+                    MPO<S, FL>::middle_operator_exprs[i]->data[j];
+                x = simplify_site_expr(x, S(S::invalid), &tables[i]);
+            }
+        }
+#pragma omp parallel for schedule(static) num_threads(ntg)
+        for (int i = 0; i < n_sites; i++) {
+            finalize_symbolic(MPO<S, FL>::left_operator_names[i],
                               MPO<S, FL>::left_operator_exprs[i]);
-            simplify_symbolic(MPO<S, FL>::right_operator_names[i],
+            finalize_symbolic(MPO<S, FL>::right_operator_names[i],
                               MPO<S, FL>::right_operator_exprs[i]);
-            if (i < MPO<S, FL>::n_sites - 1) {
-                shared_ptr<Symbolic<S>> mexpr =
-                    MPO<S, FL>::middle_operator_exprs[i];
-                for (size_t j = 0; j < mexpr->data.size(); j++)
-                    mexpr->data[j] = simplify_expr(mexpr->data[j]);
-            }
         }
     }
     AncillaTypes get_ancilla_type() const override {
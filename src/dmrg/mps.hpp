@@ -830,10 +830,10 @@ template <typename S> struct MPSInfo {
     void copy_mutable(const string &dir) const {
         if (frame->prefix_can_write) {
             for (int i = 0; i < n_sites + 1; i++) {
-                Parsing::copy_file(get_filename(true, i),
-                                   get_filename(true, i, dir));
-                Parsing::copy_file(get_filename(false, i),
-                                   get_filename(false, i, dir));
+                frame->copy_checkpoint_file(get_filename(true, i),
+                                            get_filename(true, i, dir));
+                frame->copy_checkpoint_file(get_filename(false, i),
+                                            get_filename(false, i, dir));
             }
             save_data(dir + "/mps_info.bin");
         }
@@ -1404,6 +1404,8 @@ template <typename S, typename FL> struct MPS {
     shared_ptr<MPSInfo<S>> info;
     vector<shared_ptr<SparseMatrix<S, FL>>> tensors;
     string canonical_form;
+    // hashes of the saved tensor files, zero if not computed
+    mutable vector<uint64_t> tensor_hashes;
     MPS(const shared_ptr<MPSInfo<S>> &info)
         : n_sites(0), center(0), dot(0), info(info) {}
     MPS(int n_sites, int center, int dot)
@@ -2128,6 +2130,7 @@ template <typename S, typename FL> struct MPS {
             if (mps->tensors[i] != nullptr)
                 mps->tensors[i] = make_shared<SparseMatrix<S, FL>>(d_alloc);
         mps->info = new_info;
+        mps->invalidate_tensor_hash();
         shallow_copy_to(mps);
         return mps;
     }
@@ -2149,8 +2152,20 @@ template <typename S, typename FL> struct MPS {
         if (frame->prefix_can_write) {
             for (int i = 0; i < n_sites; i++)
                 if (tensors[i] != nullptr)
-                    Parsing::copy_file(get_filename(i), get_filename(i, dir));
-            Parsing::copy_file(get_filename(-1), get_filename(-1, dir));
+                    frame->copy_checkpoint_file(get_filename(i),
+                                                get_filename(i, dir));
+            frame->copy_checkpoint_file(get_filename(-1),
+                                        get_filename(-1, dir));
+        }
+    }
+    // Save MPS and MPSInfo into a restart dir (see DataFrame::end_checkpoint)
+    // the MPSInfo file is updated last
+    void save_checkpoint(const string &dir) const {
+        if (frame->prefix_can_write) {
+            string staging = frame->begin_checkpoint(dir);
+            info->copy_mutable(staging);
+            copy_data(staging);
+            frame->end_checkpoint(dir, vector<string>{"mps_info.bin"});
         }
     }
     void load_data_from(istream &ifs) {
@@ -2163,6 +2178,7 @@ template <typename S, typename FL> struct MPS {
         ifs.read((char *)&canonical_form[0], sizeof(char) * n_sites);
         vector<uint8_t> bs(n_sites);
         ifs.read((char *)&bs[0], sizeof(uint8_t) * n_sites);
+        invalidate_tensor_hash();
         tensors.resize(n_sites, nullptr);
         for (int i = 0; i < n_sites; i++)
             if (bs[i])
@@ -2227,11 +2243,30 @@ template <typename S, typename FL> struct MPS {
                 tensors[i]->load_data(get_filename(i), true, i_alloc);
             }
     }
+    // Hash of the saved file of tensor i, zero if the tensor is not saved
+    // Cached until the tensor is saved or the MPS is reloaded
+    uint64_t get_tensor_hash(int i) const {
+        tensor_hashes.resize(n_sites, 0);
+        if (tensors[i] == nullptr)
+            return 0;
+        if (tensor_hashes[i] == 0 && Parsing::file_exists(get_filename(i)))
+            tensor_hashes[i] =
+                Parsing::hash_string(Parsing::read_file(get_filename(i)));
+        return tensor_hashes[i];
+    }
+    // Forget the hash of tensor i (all tensors if i == -1)
+    void invalidate_tensor_hash(int i = -1) const {
+        if (i == -1)
+            tensor_hashes.clear();
+        else if (i < (int)tensor_hashes.size())
+            tensor_hashes[i] = 0;
+    }
     virtual void load_mutable() const {
         shared_ptr<VectorAllocator<uint32_t>> i_alloc =
             make_shared<VectorAllocator<uint32_t>>();
         shared_ptr<VectorAllocator<FP>> d_alloc =
             make_shared<VectorAllocator<FP>>();
+        invalidate_tensor_hash();
         for (int i = 0; i < n_sites; i++)
             if (tensors[i] != nullptr) {
                 tensors[i]->alloc = d_alloc;
@@ -2239,12 +2274,14 @@ template <typename S, typename FL> struct MPS {
             }
     }
     virtual void save_mutable() const {
+        invalidate_tensor_hash();
         if (frame->prefix_can_write)
             for (int i = 0; i < n_sites; i++)
                 if (tensors[i] != nullptr)
                     tensors[i]->save_data(get_filename(i), true);
     }
     virtual void save_tensor(int i) const {
+        invalidate_tensor_hash(i);
         if (frame->prefix_can_write) {
             assert(tensors[i] != nullptr);
             tensors[i]->save_data(get_filename(i), true);
@@ -23,6 +23,8 @@
 #include "../core/integral.hpp"
 #include "../core/parallel_rule.hpp"
 #include "../core/rule.hpp"
+#include <algorithm>
+#include <fstream>
 #include <memory>
 
 using namespace std;
@@ -46,9 +48,13 @@ struct ParallelRuleSumMPO : ParallelRule<S, FL> {
         return ParallelProperty(comm->rank, ParallelOpTypes::None);
     }
     bool index_available() const noexcept { return comm->rank == comm->root; }
+    // Proc that owns the terms starting with site index i
+    int index_owner(uint16_t i) const noexcept {
+        // return i * comm->size / n_sites;
+        return i % comm->size;
+    }
     bool index_available(uint16_t i) const noexcept {
-        // return comm->rank == i * comm->size / n_sites;
-        return comm->rank == i % comm->size;
+        return comm->rank == index_owner(i);
     }
     bool index_available(uint16_t i, uint16_t j) const noexcept {
         return index_available(i);
@@ -80,42 +86,526 @@ template <typename S, typename FL> struct SumMPORule : Rule<S, FL> {
 
 // One- and two-electron integrals
 // distriubed over mpi procs
+// After read_distributed, each proc only stores the integral elements
+// involving at least one site index owned by this proc
 template <typename S, typename FL> struct ParallelFCIDUMP : FCIDUMP<FL> {
+    typedef typename FCIDUMP<FL>::FP FP;
     using FCIDUMP<FL>::const_e;
     using FCIDUMP<FL>::e;
     using FCIDUMP<FL>::n_sites;
     using FCIDUMP<FL>::t;
     using FCIDUMP<FL>::v;
+    using FCIDUMP<FL>::params;
+    using FCIDUMP<FL>::ts;
+    using FCIDUMP<FL>::vs;
+    using FCIDUMP<FL>::vabs;
+    using FCIDUMP<FL>::vgs;
+    using FCIDUMP<FL>::uhf;
+    using FCIDUMP<FL>::general;
+    using FCIDUMP<FL>::total_memory;
+    // One integral element in distributed storage
+    // key: array id (ts0, ts1, vs0, vs1, vabs0, vgs0, vgs1, vgs2) << 56
+    //      + index in the (symmetry-packed) array
+    // idx: canonical site indices (counting from 0)
+    struct Element {
+        uint64_t key;
+        array<uint16_t, 4> idx;
+        FL val;
+        bool operator<(const Element &other) const { return key < other.key; }
+    };
     shared_ptr<ParallelRuleSumMPO<S, FL>> rule;
+    bool distributed = false;
+    vector<Element> elements;
     ParallelFCIDUMP(const shared_ptr<ParallelRuleSumMPO<S, FL>> &rule)
         : rule(rule), FCIDUMP<FL>() {}
+    // Canonical indices and key of an integral element in array aid
+    Element make_element(uint8_t aid, uint16_t i, uint16_t j, uint16_t k,
+                         uint16_t l, FL val) const {
+        Element x;
+        if (aid < 2) {
+            if (!ts[aid].general && j > i)
+                swap(i, j);
+            x.key = ts[aid].find_index(i, j);
+        } else if (aid < 4) {
+            if (j > i)
+                swap(i, j);
+            if (l > k)
+                swap(k, l);
+            if (vs[aid - 2].find_index(k, l) > vs[aid - 2].find_index(i, j))
+                swap(i, k), swap(j, l);
+            x.key = vs[aid - 2].find_index(i, j, k, l);
+        } else if (aid < 5) {
+            if (j > i)
+                swap(i, j);
+            if (l > k)
+                swap(k, l);
+            x.key = vabs[0].find_index(i, j, k, l);
+        } else {
+            const size_t n = vgs[aid - 5].n;
+            x.key = ((i * n + j) * n + k) * n + l;
+        }
+        assert(x.key < (1ULL << 56));
+        x.key |= (uint64_t)aid << 56;
+        x.idx = array<uint16_t, 4>{i, j, k, l};
+        x.val = val;
+        return x;
+    }
+    // Array id and canonical indices of an element read from FCIDUMP
+    // (indices counting from 1); ip: same as in FCIDUMP::set_integral
+    // Returns false for the constant energy term
+    bool classify(const array<uint16_t, 4> &idx, FL val, int ip,
+                  Element &x) const {
+        if (idx[0] + idx[1] + idx[2] + idx[3] == 0)
+            return false;
+        uint8_t aid;
+        if (idx[2] + idx[3] == 0) {
+            aid = uhf ? ip - 3 : 0;
+            x = make_element(aid, idx[0] - 1, idx[1] - 1, 0, 0, val);
+            x.idx[2] = x.idx[3] = x.idx[1];
+            return true;
+        } else if (!uhf)
+            aid = general ? 5 : 2;
+        else {
+            assert(ip <= 2);
+            aid = general ? 5 + ip : (ip < 2 ? 2 + ip : 4);
+        }
+        x = make_element(aid, idx[0] - 1, idx[1] - 1, idx[2] - 1, idx[3] - 1,
+                         val);
+        return true;
+    }
+    // Find an integral element in distributed storage
+    FL find_element(uint8_t aid, uint16_t i, uint16_t j, uint16_t k,
+                    uint16_t l) const {
+        Element x = make_element(aid, i, j, k, l, 0.0);
+        auto it = lower_bound(elements.begin(), elements.end(), x);
+        return it != elements.end() && it->key == x.key ? it->val : (FL)0.0;
+    }
+    // Append an element to the send buffers of all procs owning any of its
+    // site indices (once for each proc)
+    void send_to_owners(const Element &x, vector<vector<char>> &sdata) const {
+        int owners[4];
+        for (int k = 0; k < 4; k++) {
+            owners[k] = rule->index_owner(x.idx[k]);
+            bool dup = false;
+            for (int kk = 0; kk < k; kk++)
+                dup = dup || owners[kk] == owners[k];
+            if (!dup)
+                sdata[owners[k]].insert(sdata[owners[k]].end(), (char *)&x,
+                                        (char *)&x + sizeof(x));
+        }
+    }
+    // Exchange the elements in send buffers, and replace the distributed
+    // storage by the received elements (collective)
+    // Elements are received in proc order, so that the last duplicate wins
+    void receive_elements(vector<vector<char>> &sdata) {
+        vector<vector<char>> rdata;
+        rule->comm->alltoallv(sdata, rdata);
+        sdata.clear();
+        elements.clear();
+        for (auto &r : rdata)
+            elements.insert(elements.end(), (Element *)r.data(),
+                            (Element *)(r.data() + r.size()));
+        rdata.clear();
+        stable_sort(elements.begin(), elements.end());
+        size_t ie = 0;
+        for (size_t i = 0; i < elements.size(); i++) {
+            if (ie != 0 && elements[ie - 1].key == elements[i].key)
+                ie--;
+            elements[ie++] = elements[i];
+        }
+        elements.resize(ie);
+        elements.shrink_to_fit();
+    }
+    // Call f for each nonzero element of full integrals (canonical indices)
+    template <typename F>
+    void for_each_element(const FCIDUMP<FL> &fd, F f) const {
+        const uint16_t n = fd.n_sites();
+        auto add = [this, &f](uint8_t aid, uint16_t i, uint16_t j, uint16_t k,
+                              uint16_t l, FL val) {
+            if (val == (FL)0.0)
+                return;
+            Element x = make_element(aid, i, j, k, l, val);
+            if (aid < 2)
+                x.idx[2] = x.idx[3] = x.idx[1];
+            f(x);
+        };
+        for (uint8_t s = 0; s < (uint8_t)fd.ts.size(); s++)
+            for (uint16_t i = 0; i < n; i++)
+                for (uint16_t j = 0; j < (fd.ts[s].general ? n : i + 1); j++)
+                    add(s, i, j, 0, 0, fd.ts[s](i, j));
+        for (uint8_t s = 0; s < (uint8_t)fd.vs.size(); s++)
+            for (uint16_t i = 0; i < n; i++)
+                for (uint16_t j = 0; j <= i; j++)
+                    for (uint16_t k = 0; k <= i; k++)
+                        for (uint16_t l = 0; l <= (k == i ? j : k); l++)
+                            add(2 + s, i, j, k, l, fd.vs[s](i, j, k, l));
+        for (auto &v : fd.vabs)
+            for (uint16_t i = 0; i < n; i++)
+                for (uint16_t j = 0; j <= i; j++)
+                    for (uint16_t k = 0; k < n; k++)
+                        for (uint16_t l = 0; l <= k; l++)
+                            add(4, i, j, k, l, v(i, j, k, l));
+        for (uint8_t s = 0; s < (uint8_t)fd.vgs.size(); s++)
+            for (uint16_t i = 0; i < n; i++)
+                for (uint16_t j = 0; j < n; j++)
+                    for (uint16_t k = 0; k < n; k++)
+                        for (uint16_t l = 0; l < n; l++)
+                            add(5 + s, i, j, k, l, fd.vgs[s](i, j, k, l));
+    }
+    // Parse a FCIDUMP file where each proc reads and parses one byte range
+    // of the file in parallel, then each element is sent to procs owning
+    // any of its site indices
+    // Binary integral files are mapped as a whole in each proc instead
+    void read_distributed(const string &filename) {
+        if (FCIDUMP<FL>::is_binary(filename)) {
+            FCIDUMP<FL>::read_binary(filename);
+            distributed = false;
+            return;
+        }
+        shared_ptr<ParallelCommunicator<S>> comm = rule->comm;
+        params.clear();
+        const_e = 0.0;
+        ifstream ifs(filename.c_str(), ios::binary);
+        if (!ifs.good())
+            throw runtime_error("ParallelFCIDUMP::read_distributed on '" +
+                                filename + "' failed.");
+        FCIDUMP<FL>::read_params(ifs);
+        FCIDUMP<FL>::init_integrals(false);
+        total_memory = 0;
+        rule->n_sites = n_sites();
+        int64_t body_start = ifs.good() ? (int64_t)ifs.tellg() : 0;
+        ifs.clear();
+        ifs.seekg(0, ios::end);
+        int64_t file_end = (int64_t)ifs.tellg();
+        if (body_start == 0 || body_start > file_end)
+            body_start = file_end;
+        int64_t body = file_end - body_start;
+        int64_t a = body_start + body * comm->rank / comm->size;
+        int64_t b = body_start + body * (comm->rank + 1) / comm->size;
+        // every line belongs to the proc whose byte range holds its start
+        // buf holds bytes [a - 1, b) and the rest of the last line
+        vector<char> buf;
+        size_t start = 0;
+        if (a < b) {
+            buf.resize(b - a + 1);
+            ifs.seekg(a - 1);
+            ifs.read(buf.data(), buf.size());
+            if (buf.back() != '\n') {
+                string line;
+                getline(ifs, line);
+                buf.insert(buf.end(), line.begin(), line.end());
+                buf.push_back('\n');
+            }
+            while (start < (size_t)(b - a) && buf[start] != '\n')
+                start++;
+            start++;
+        }
+        if (ifs.bad())
+            throw runtime_error("ParallelFCIDUMP::read_distributed on '" +
+                                filename + "' failed.");
+        ifs.close();
+        if (start > (size_t)(b - a))
+            buf.clear(), start = 0;
+        const char *pbuf = buf.data() + start, *pend = buf.data() + buf.size();
+        int ntg = threading->activate_global();
+        // for UHF, the array of one element depends on the number of
+        // separator lines before it (possibly in other byte ranges)
+        int ip = 0;
+        if (uhf) {
+            vector<double> nsep(comm->size, 0);
+            int nloc = 0;
+            fd_parse_lines<FL>(
+                pbuf, pend, nloc, true, ntg,
+                [](int, const array<uint16_t, 4> &, FL, int) {});
+            nsep[comm->rank] = nloc;
+            comm->allreduce_sum(nsep.data(), nsep.size());
+            for (int i = 0; i < comm->rank; i++)
+                ip += (int)nsep[i];
+        }
+        // elements parsed by each thread, to be sent to each proc
+        vector<vector<vector<char>>> tdata(ntg,
+                                           vector<vector<char>>(comm->size));
+        vector<pair<bool, FL>> ecs(ntg, make_pair(false, (FL)0.0));
+        fd_parse_lines<FL>(
+            pbuf, pend, ip, uhf, ntg,
+            [this, &tdata, &ecs](int ir, const array<uint16_t, 4> &idx, FL val,
+                                 int jp) {
+                Element x;
+                if (!classify(idx, val, jp, x)) {
+                    if (!uhf || jp == 6)
+                        ecs[ir] = make_pair(true, val);
+                    return;
+                }
+                send_to_owners(x, tdata[ir]);
+            });
+        threading->activate_normal();
+        buf.clear();
+        buf.shrink_to_fit();
+        FL local_e = 0.0;
+        bool has_local_e = false;
+        for (auto &ec : ecs)
+            if (ec.first)
+                local_e = ec.second, has_local_e = true;
+        vector<vector<char>> sdata(comm->size);
+        for (int k = 0; k < comm->size; k++)
+            for (int ir = 0; ir < ntg; ir++) {
+                sdata[k].insert(sdata[k].end(), tdata[ir][k].begin(),
+                                tdata[ir][k].end());
+                vector<char>().swap(tdata[ir][k]);
+            }
+        // received in file order, so that the last duplicate wins
+        receive_elements(sdata);
+        // the last constant energy line in file order wins
+        vector<double> has_e(comm->size, 0);
+        vector<FL> proc_e(comm->size, 0.0);
+        has_e[comm->rank] = has_local_e;
+        proc_e[comm->rank] = local_e;
+        comm->allreduce_sum(has_e.data(), has_e.size());
+        comm->allreduce_sum(proc_e.data(), proc_e.size());
+        for (int i = 0; i < comm->size; i++)
+            if (has_e[i] != 0)
+                const_e = proc_e[i];
+        distributed = true;
+    }
+    // Remove integral elements that violate a symmetry
+    // (distributed storage); f(x, is_t) should return whether x is allowed
+    // Returns the error of the removed elements (summed over all procs)
+    template <typename F> FP symmetrize_distributed(F f) {
+        double error = 0.0;
+        size_t ie = 0;
+        for (size_t i = 0; i < elements.size(); i++)
+            if (f(elements[i].idx, (elements[i].key >> 56) < 2))
+                elements[ie++] = elements[i];
+            // each element is counted only in the owner of its first index
+            else if (rule->index_available(elements[i].idx[0]))
+                error += abs(elements[i].val);
+        elements.resize(ie);
+        rule->comm->allreduce_sum(&error, 1);
+        return (FP)error;
+    }
+    FP symmetrize(const vector<uint8_t> &orbsym) override {
+        if (!distributed)
+            return FCIDUMP<FL>::symmetrize(orbsym);
+        return symmetrize_distributed(
+            [&orbsym](const array<uint16_t, 4> &x, bool is_t) {
+                return is_t ? !(orbsym[x[0]] ^ orbsym[x[1]])
+                            : !(orbsym[x[0]] ^ orbsym[x[1]] ^ orbsym[x[2]] ^
+                                orbsym[x[3]]);
+            });
+    }
+    FP symmetrize(const vector<int16_t> &orbsym) override {
+        if (!distributed)
+            return FCIDUMP<FL>::symmetrize(orbsym);
+        return symmetrize_distributed(
+            [&orbsym](const array<uint16_t, 4> &x, bool is_t) {
+                return is_t ? !(orbsym[x[0]] - orbsym[x[1]])
+                            : !(orbsym[x[0]] - orbsym[x[1]] + orbsym[x[2]] -
+                                orbsym[x[3]]);
+            });
+    }
+    FP symmetrize(const vector<int> &ksym, int kmod) override {
+        if (!distributed)
+            return FCIDUMP<FL>::symmetrize(ksym, kmod);
+        return symmetrize_distributed(
+            [&ksym, kmod](const array<uint16_t, 4> &x, bool is_t) {
+                int dk = is_t ? ksym[x[0]] - ksym[x[1]]
+                              : ksym[x[0]] - ksym[x[1]] + ksym[x[2]] -
+                                    ksym[x[3]];
+                return kmod == 0 ? dk == 0 : (dk % kmod + kmod) % kmod == 0;
+            });
+    }
+    // Full integrals collected from the distributed storage of all procs
+    // Collective; if root is -1, every proc gets a copy of all integrals,
+    // otherwise only the root proc does and other procs get nullptr
+    shared_ptr<FCIDUMP<FL>> to_fcidump(int root = -1) const {
+        shared_ptr<ParallelCommunicator<S>> comm = rule->comm;
+        const bool has_data =
+            !distributed || root == -1 || comm->rank == root;
+        shared_ptr<FCIDUMP<FL>> r =
+            has_data ? make_shared<FCIDUMP<FL>>() : nullptr;
+        if (has_data) {
+            r->params = params;
+            r->const_e = const_e;
+            r->init_integrals();
+        }
+        if (!distributed) {
+            memcpy(r->data, FCIDUMP<FL>::data, sizeof(FL) * total_memory);
+            return r;
+        }
+        // each element is sent only by the owner of its first index
+        vector<char> xdata;
+        for (auto &x : elements)
+            if (rule->index_available(x.idx[0]))
+                xdata.insert(xdata.end(), (const char *)&x,
+                             (const char *)&x + sizeof(x));
+        vector<vector<char>> sdata(comm->size), rdata;
+        for (int k = 0; k < comm->size; k++)
+            if (root == -1 || k == root)
+                sdata[k] = xdata;
+        xdata.clear();
+        comm->alltoallv(sdata, rdata);
+        sdata.clear();
+        if (!has_data)
+            return r;
+        for (auto &rd : rdata)
+            for (const Element *x = (const Element *)rd.data(),
+                               *xend = (const Element *)(rd.data() + rd.size());
+                 x < xend; x++) {
+                const uint8_t aid = (uint8_t)(x->key >> 56);
+                const array<uint16_t, 4> &ix = x->idx;
+                if (aid < 2)
+                    r->ts[aid](ix[0], ix[1]) = x->val;
+                else if (aid < 4)
+                    r->vs[aid - 2](ix[0], ix[1], ix[2], ix[3]) = x->val;
+                else if (aid < 5)
+                    r->vabs[0](ix[0], ix[1], ix[2], ix[3]) = x->val;
+                else
+                    r->vgs[aid - 5](ix[0], ix[1], ix[2], ix[3]) = x->val;
+            }
+        return r;
+    }
+    // Distributed storage of the (nonzero) elements of full integrals
+    // that are needed by this proc
+    void distribute(const FCIDUMP<FL> &fd) {
+        const uint16_t n = fd.n_sites();
+        rule->n_sites = n;
+        params = fd.params;
+        const_e = fd.const_e;
+        FCIDUMP<FL>::init_integrals(false);
+        total_memory = 0;
+        elements.clear();
+        for_each_element(fd, [this](const Element &x) {
+            for (int p = 0; p < 4; p++)
+                if (rule->index_available(x.idx[p])) {
+                    elements.push_back(x);
+                    break;
+                }
+        });
+        sort(elements.begin(), elements.end());
+        elements.shrink_to_fit();
+        distributed = true;
+    }
+    // In distributed storage, the site indices of local elements are
+    // renumbered, and the elements are sent to the procs owning the new
+    // indices (collective)
+    void reorder(const vector<uint16_t> &ord) override {
+        if (!distributed)
+            return FCIDUMP<FL>::reorder(ord);
+        const uint16_t n = n_sites();
+        assert(ord.size() == n);
+        vector<uint16_t> rord(n);
+        for (uint16_t i = 0; i < n; i++)
+            rord[ord[i]] = i;
+        vector<vector<char>> sdata(rule->comm->size);
+        // each element is sent only by the owner of its first index
+        for (auto &x : elements)
+            if (rule->index_available(x.idx[0])) {
+                const uint8_t aid = (uint8_t)(x.key >> 56);
+                const array<uint16_t, 4> &ix = x.idx;
+                Element y =
+                    aid < 2 ? make_element(aid, rord[ix[0]], rord[ix[1]], 0, 0,
+                                           x.val)
+                            : make_element(aid, rord[ix[0]], rord[ix[1]],
+                                           rord[ix[2]], rord[ix[3]], x.val);
+                if (aid < 2)
+                    y.idx[2] = y.idx[3] = y.idx[1];
+                send_to_owners(y, sdata);
+            }
+        receive_elements(sdata);
+        rule->n_sites = n;
+        if (params.count("orbsym"))
+            this->set_orb_sym(
+                FCIDUMP<FL>::reorder(this->template orb_sym<int>(), ord));
+        if (params.count("ksym"))
+            this->set_k_sym(
+                FCIDUMP<FL>::reorder(this->template k_sym<int>(), ord));
+    }
+    // In distributed storage, the full integrals are collected and rotated
+    // in the root proc only, then sent back to the owner procs (collective)
+    void rotate(const vector<FL> &rot_mat) override {
+        if (!distributed)
+            return FCIDUMP<FL>::rotate(rot_mat);
+        shared_ptr<FCIDUMP<FL>> fd = to_fcidump(rule->comm->root);
+        vector<vector<char>> sdata(rule->comm->size);
+        if (fd != nullptr) {
+            fd->rotate(rot_mat);
+            for_each_element(*fd, [this, &sdata](const Element &x) {
+                send_to_owners(x, sdata);
+            });
+            fd->deallocate();
+        }
+        receive_elements(sdata);
+    }
+    // In distributed storage, this is collective and the full integrals
+    // are collected and written in the root proc only
+    void write(const string &filename) const override {
+        if (!distributed)
+            return FCIDUMP<FL>::write(filename);
+        shared_ptr<FCIDUMP<FL>> fd = to_fcidump(rule->comm->root);
+        if (fd != nullptr) {
+            fd->write(filename);
+            fd->deallocate();
+        }
+    }
+    shared_ptr<FCIDUMP<FL>> deep_copy() const override {
+        if (!distributed)
+            return FCIDUMP<FL>::deep_copy();
+        return make_shared<ParallelFCIDUMP>(*this);
+    }
+    void deallocate() override {
+        if (!distributed)
+            return FCIDUMP<FL>::deallocate();
+        elements.clear();
+        elements.shrink_to_fit();
+        distributed = false;
+    }
     // One-electron integral element (SU(2))
     FL t(uint16_t i, uint16_t j) const override {
         if (rule->n_sites == 0)
             rule->n_sites = n_sites();
-        return rule->index_available(i, j) ? FCIDUMP<FL>::t(i, j) : 0;
+        if (!rule->index_available(i, j))
+            return 0;
+        return distributed ? find_element(0, i, j, 0, 0) : FCIDUMP<FL>::t(i, j);
     }
     // One-electron integral element (SZ)
     FL t(uint8_t s, uint16_t i, uint16_t j) const override {
         if (rule->n_sites == 0)
             rule->n_sites = n_sites();
-        return rule->index_available(i, j) ? FCIDUMP<FL>::t(s, i, j) : 0;
+        if (!rule->index_available(i, j))
+            return 0;
+        return distributed ? find_element(uhf ? s : 0, i, j, 0, 0)
+                           : FCIDUMP<FL>::t(s, i, j);
     }
     // Two-electron integral element (SU(2))
     FL v(uint16_t i, uint16_t j, uint16_t k, uint16_t l) const override {
         if (rule->n_sites == 0)
             rule->n_sites = n_sites();
-        return rule->index_available(i, j, k, l) ? FCIDUMP<FL>::v(i, j, k, l)
-                                                 : 0;
+        if (!rule->index_available(i, j, k, l))
+            return 0;
+        else if (!distributed)
+            return FCIDUMP<FL>::v(i, j, k, l);
+        return find_element(general ? 5 : 2, i, j, k, l);
     }
     // Two-electron integral element (SZ)
     FL v(uint8_t sl, uint8_t sr, uint16_t i, uint16_t j, uint16_t k,
          uint16_t l) const override {
         if (rule->n_sites == 0)
             rule->n_sites = n_sites();
-        return rule->index_available(i, j, k, l)
-                   ? FCIDUMP<FL>::v(sl, sr, i, j, k, l)
-                   : 0;
+        if (!rule->index_available(i, j, k, l))
+            return 0;
+        else if (!distributed)
+            return FCIDUMP<FL>::v(sl, sr, i, j, k, l);
+        else if (!uhf)
+            return v(i, j, k, l);
+        uint8_t aid;
+        if (sl == sr)
+            aid = general ? 5 + sl : 2 + sl;
+        else {
+            aid = general ? 7 : 4;
+            if (sl != 0)
+                swap(i, k), swap(j, l);
+        }
+        return find_element(aid, i, j, k, l);
     }
 };
 
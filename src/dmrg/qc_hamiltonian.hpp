@@ -60,6 +60,9 @@ struct HamiltonianQC<S, FL, typename S::is_sz_t> : Hamiltonian<S, FL> {
     shared_ptr<FCIDUMP<FL>> fcidump;
     // Chemical potenital parameter in Hamiltonian
     FL mu = 0;
+    // Integrals with magnitude below this threshold are treated as zero
+    // in site operators and MPO construction (0 = no screening)
+    FP screening_cutoff = 0;
     HamiltonianQC()
         : Hamiltonian<S, FL>(S(), 0, vector<typename S::pg_t>()),
           fcidump(nullptr) {}
@@ -603,6 +606,9 @@ struct HamiltonianQC<S, FL, typename S::is_sz_t> : Hamiltonian<S, FL> {
                         ph, m, p.first, info);
         }
     }
+    void node_share(const shared_ptr<ParallelCommunicator<S>> &comm) override {
+        this->node_share_op_prims(comm, op_prims, site_norm_ops, fcidump);
+    }
     void deallocate() override {
         for (auto &op_prims : this->op_prims)
             for (auto &ops_map : op_prims.second)
@@ -616,12 +622,19 @@ struct HamiltonianQC<S, FL, typename S::is_sz_t> : Hamiltonian<S, FL> {
         opf->cg->deallocate();
         Hamiltonian<S, FL>::deallocate();
     }
+    // Error bound of screening (see Hamiltonian::screening_error_bound)
+    FP screening_error_bound() const {
+        return Hamiltonian<S, FL>::screening_error_bound(
+            fcidump, mu, screening_cutoff, 2, (FP)1.0, (FP)0.5);
+    }
     FL v(uint8_t sl, uint8_t sr, uint16_t i, uint16_t j, uint16_t k,
          uint16_t l) const {
-        return fcidump->v(sl, sr, i, j, k, l);
+        FL r = fcidump->v(sl, sr, i, j, k, l);
+        return abs(r) < screening_cutoff ? (FL)0.0 : r;
     }
     FL t(uint8_t s, uint16_t i, uint16_t j) const {
-        return i == j ? fcidump->t(s, i, i) - mu : fcidump->t(s, i, j);
+        FL r = i == j ? fcidump->t(s, i, i) - mu : fcidump->t(s, i, j);
+        return abs(r) < screening_cutoff ? (FL)0.0 : r;
     }
     FL e() const { return fcidump->e(); }
 };
@@ -651,6 +664,9 @@ struct HamiltonianQC<S, FL, typename S::is_su2_t> : Hamiltonian<S, FL> {
     shared_ptr<FCIDUMP<FL>> fcidump;
     // Chemical potenital parameter in Hamiltonian
     FL mu = 0;
+    // Integrals with magnitude below this threshold are treated as zero
+    // in site operators and MPO construction (0 = no screening)
+    FP screening_cutoff = 0;
     HamiltonianQC()
         : Hamiltonian<S, FL>(S(), 0, vector<typename S::pg_t>()),
           fcidump(nullptr) {}
@@ -1035,6 +1051,9 @@ struct HamiltonianQC<S, FL, typename S::is_su2_t> : Hamiltonian<S, FL> {
                         ph, m, p.first, info);
         }
     }
+    void node_share(const shared_ptr<ParallelCommunicator<S>> &comm) override {
+        this->node_share_op_prims(comm, op_prims, site_norm_ops, fcidump);
+    }
     void deallocate() override {
         for (auto &op_prims : this->op_prims)
             for (auto &ops_map : op_prims.second)
@@ -1048,11 +1067,19 @@ struct HamiltonianQC<S, FL, typename S::is_su2_t> : Hamiltonian<S, FL> {
         opf->cg->deallocate();
         Hamiltonian<S, FL>::deallocate();
     }
+    // Error bound of screening (see Hamiltonian::screening_error_bound)
+    // spatial integrals are summed over two (t) or four (v) spin cases
+    FP screening_error_bound() const {
+        return Hamiltonian<S, FL>::screening_error_bound(
+            fcidump, mu, screening_cutoff, 1, (FP)2.0, (FP)2.0);
+    }
     FL v(uint16_t i, uint16_t j, uint16_t k, uint16_t l) const {
-        return fcidump->v(i, j, k, l);
+        FL r = fcidump->v(i, j, k, l);
+        return abs(r) < screening_cutoff ? (FL)0.0 : r;
     }
     FL t(uint16_t i, uint16_t j) const {
-        return i == j ? fcidump->t(i, i) - mu : fcidump->t(i, j);
+        FL r = i == j ? fcidump->t(i, i) - mu : fcidump->t(i, j);
+        return abs(r) < screening_cutoff ? (FL)0.0 : r;
     }
     FL e() const { return fcidump->e(); }
 };
@@ -1082,6 +1109,9 @@ struct HamiltonianQC<S, FL, typename S::is_sg_t> : Hamiltonian<S, FL> {
     shared_ptr<FCIDUMP<FL>> fcidump;
     // Chemical potenital parameter in Hamiltonian
     FL mu = 0;
+    // Integrals with magnitude below this threshold are treated as zero
+    // in site operators and MPO construction (0 = no screening)
+    FP screening_cutoff = 0;
     HamiltonianQC()
         : Hamiltonian<S, FL>(S(), 0, vector<typename S::pg_t>()),
           fcidump(nullptr) {}
@@ -1407,6 +1437,9 @@ struct HamiltonianQC<S, FL, typename S::is_sg_t> : Hamiltonian<S, FL> {
                         ph, m, p.first, info);
         }
     }
+    void node_share(const shared_ptr<ParallelCommunicator<S>> &comm) override {
+        this->node_share_op_prims(comm, op_prims, site_norm_ops, fcidump);
+    }
     void deallocate() override {
         for (auto &op_prims : this->op_prims)
             for (auto &ops_map : op_prims.second)
@@ -1420,11 +1453,18 @@ struct HamiltonianQC<S, FL, typename S::is_sg_t> : Hamiltonian<S, FL> {
         opf->cg->deallocate();
         Hamiltonian<S, FL>::deallocate();
     }
+    // Error bound of screening (see Hamiltonian::screening_error_bound)
+    FP screening_error_bound() const {
+        return Hamiltonian<S, FL>::screening_error_bound(
+            fcidump, mu, screening_cutoff, 1, (FP)1.0, (FP)0.5);
+    }
     FL v(uint16_t i, uint16_t j, uint16_t k, uint16_t l) const {
-        return fcidump->v(i, j, k, l);
+        FL r = fcidump->v(i, j, k, l);
+        return abs(r) < screening_cutoff ? (FL)0.0 : r;
     }
     FL t(uint16_t i, uint16_t j) const {
-        return i == j ? fcidump->t(i, i) - mu : fcidump->t(i, j);
+        FL r = i == j ? fcidump->t(i, i) - mu : fcidump->t(i, j);
+        return abs(r) < screening_cutoff ? (FL)0.0 : r;
     }
     FL e() const { return fcidump->e(); }
 };
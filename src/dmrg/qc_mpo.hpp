@@ -600,9 +600,11 @@ template <typename S, typename FL>
 struct MPOQC<S, FL, typename S::is_sz_t> : MPO<S, FL> {
     QCTypes mode;
     const bool symmetrized_p = true;
+    // tensor_archive: if not empty, site operators are streamed to this file
+    // once each site is built (see MPO::init_tensor_archive)
     MPOQC(const shared_ptr<HamiltonianQC<S, FL>> &hamil,
           QCTypes mode = QCTypes::NC, int trans_center = -1,
-          bool symmetrized_p = true)
+          bool symmetrized_p = true, const string &tensor_archive = "")
         : MPO<S, FL>(hamil->n_sites), mode(mode), symmetrized_p(symmetrized_p) {
         shared_ptr<OpExpr<S>> h_op = make_shared<OpElement<S, FL>>(
             OpNames::H, SiteIndex(), hamil->vacuum);
@@ -1572,6 +1574,8 @@ struct MPOQC<S, FL, typename S::is_sz_t> : MPO<S, FL> {
         }
         SeqTypes seqt = hamil->opf->seq->mode;
         hamil->opf->seq->mode = SeqTypes::None;
+        if (tensor_archive != "")
+            this->init_tensor_archive(tensor_archive);
         const uint16_t m_start = hamil->get_n_orbs_left() > 0 ? 1 : 0;
         const uint16_t m_end =
             hamil->get_n_orbs_right() > 0 ? n_sites - 1 : n_sites;
@@ -1584,16 +1588,24 @@ struct MPOQC<S, FL, typename S::is_sz_t> : MPO<S, FL> {
             shared_ptr<OperatorTensor<S, FL>> opt = this->tensors[m];
             hamil->filter_site_ops((uint16_t)m, {opt->lmat, opt->rmat},
                                    opt->ops);
+            if (tensor_archive != "")
+                this->archive_tensor(m);
         }
         if (hamil->get_n_orbs_left() > 0 && n_sites > 0) {
             shared_ptr<OperatorTensor<S, FL>> opt = this->tensors[0];
             hamil->filter_site_ops(0, {opt->lmat, opt->rmat}, opt->ops);
+            if (tensor_archive != "")
+                this->archive_tensor(0);
         }
         if (hamil->get_n_orbs_right() > 0 && n_sites > 0) {
             shared_ptr<OperatorTensor<S, FL>> opt = this->tensors[n_sites - 1];
             hamil->filter_site_ops(n_sites - 1, {opt->lmat, opt->rmat},
                                    opt->ops);
+            if (tensor_archive != "")
+                this->archive_tensor(n_sites - 1);
         }
+        if (tensor_archive != "")
+            this->check_tensor_archive();
         hamil->opf->seq->mode = seqt;
         if (mode == QCTypes(QCTypes::NC | QCTypes::CN) ||
             mode == QCTypes::Conventional) {
@@ -1750,8 +1762,11 @@ struct MPOQC<S, FL, typename S::is_sz_t> : MPO<S, FL> {
 template <typename S, typename FL>
 struct MPOQC<S, FL, typename S::is_su2_t> : MPO<S, FL> {
     QCTypes mode;
+    // tensor_archive: if not empty, site operators are streamed to this file
+    // once each site is built (see MPO::init_tensor_archive)
     MPOQC(const shared_ptr<HamiltonianQC<S, FL>> &hamil,
-          QCTypes mode = QCTypes::NC, int trans_center = -1)
+          QCTypes mode = QCTypes::NC, int trans_center = -1,
+          const string &tensor_archive = "")
         : MPO<S, FL>(hamil->n_sites), mode(mode) {
         shared_ptr<OpExpr<S>> h_op = make_shared<OpElement<S, FL>>(
             OpNames::H, SiteIndex(), hamil->vacuum);
@@ -2551,6 +2566,8 @@ struct MPOQC<S, FL, typename S::is_su2_t> : MPO<S, FL> {
         }
         SeqTypes seqt = hamil->opf->seq->mode;
         hamil->opf->seq->mode = SeqTypes::None;
+        if (tensor_archive != "")
+            this->init_tensor_archive(tensor_archive);
         const uint16_t m_start = hamil->get_n_orbs_left() > 0 ? 1 : 0;
         const uint16_t m_end =
             hamil->get_n_orbs_right() > 0 ? n_sites - 1 : n_sites;
@@ -2563,16 +2580,24 @@ struct MPOQC<S, FL, typename S::is_su2_t> : MPO<S, FL> {
             shared_ptr<OperatorTensor<S, FL>> opt = this->tensors[m];
             hamil->filter_site_ops((uint16_t)m, {opt->lmat, opt->rmat},
                                    opt->ops);
+            if (tensor_archive != "")
+                this->archive_tensor(m);
         }
         if (hamil->get_n_orbs_left() > 0 && n_sites > 0) {
             shared_ptr<OperatorTensor<S, FL>> opt = this->tensors[0];
             hamil->filter_site_ops(0, {opt->lmat, opt->rmat}, opt->ops);
+            if (tensor_archive != "")
+                this->archive_tensor(0);
         }
         if (hamil->get_n_orbs_right() > 0 && n_sites > 0) {
             shared_ptr<OperatorTensor<S, FL>> opt = this->tensors[n_sites - 1];
             hamil->filter_site_ops(n_sites - 1, {opt->lmat, opt->rmat},
                                    opt->ops);
+            if (tensor_archive != "")
+                this->archive_tensor(n_sites - 1);
         }
+        if (tensor_archive != "")
+            this->check_tensor_archive();
         hamil->opf->seq->mode = seqt;
         if (mode == QCTypes(QCTypes::NC | QCTypes::CN) ||
             mode == QCTypes::Conventional) {
@@ -2744,9 +2769,11 @@ template <typename S, typename FL>
 struct MPOQC<S, FL, typename S::is_sg_t> : MPO<S, FL> {
     QCTypes mode;
     const bool symmetrized_p = true;
+    // tensor_archive: if not empty, site operators are streamed to this file
+    // once each site is built (see MPO::init_tensor_archive)
     MPOQC(const shared_ptr<HamiltonianQC<S, FL>> &hamil,
           QCTypes mode = QCTypes::NC, int trans_center = -1,
-          bool symmetrized_p = true)
+          bool symmetrized_p = true, const string &tensor_archive = "")
         : MPO<S, FL>(hamil->n_sites), mode(mode), symmetrized_p(symmetrized_p) {
         // fermionic exchange factor
         const FL exf = S::GIF ? -1.0 : 1.0;
@@ -3423,6 +3450,8 @@ struct MPOQC<S, FL, typename S::is_sg_t> : MPO<S, FL> {
         }
         SeqTypes seqt = hamil->opf->seq->mode;
         hamil->opf->seq->mode = SeqTypes::None;
+        if (tensor_archive != "")
+            this->init_tensor_archive(tensor_archive);
         const uint16_t m_start = hamil->get_n_orbs_left() > 0 ? 1 : 0;
         const uint16_t m_end =
             hamil->get_n_orbs_right() > 0 ? n_sites - 1 : n_sites;
@@ -3435,16 +3464,24 @@ struct MPOQC<S, FL, typename S::is_sg_t> : MPO<S, FL> {
             shared_ptr<OperatorTensor<S, FL>> opt = this->tensors[m];
             hamil->filter_site_ops((uint16_t)m, {opt->lmat, opt->rmat},
                                    opt->ops);
+            if (tensor_archive != "")
+                this->archive_tensor(m);
         }
         if (hamil->get_n_orbs_left() > 0 && n_sites > 0) {
             shared_ptr<OperatorTensor<S, FL>> opt = this->tensors[0];
             hamil->filter_site_ops(0, {opt->lmat, opt->rmat}, opt->ops);
+            if (tensor_archive != "")
+                this->archive_tensor(0);
         }
         if (hamil->get_n_orbs_right() > 0 && n_sites > 0) {
             shared_ptr<OperatorTensor<S, FL>> opt = this->tensors[n_sites - 1];
             hamil->filter_site_ops(n_sites - 1, {opt->lmat, opt->rmat},
                                    opt->ops);
+            if (tensor_archive != "")
+                this->archive_tensor(n_sites - 1);
         }
+        if (tensor_archive != "")
+            this->check_tensor_archive();
         hamil->opf->seq->mode = seqt;
         if (mode == QCTypes(QCTypes::NC | QCTypes::CN) ||
             mode == QCTypes::Conventional) {
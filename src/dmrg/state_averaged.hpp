@@ -437,12 +437,14 @@ template <typename S, typename FL> struct MultiMPS : MPS<S, FL> {
         if (frame->prefix_can_write) {
             for (int i = 0; i < n_sites; i++)
                 if (tensors[i] != nullptr)
-                    Parsing::copy_file(get_filename(i), get_filename(i, dir));
+                    frame->copy_checkpoint_file(get_filename(i),
+                                                get_filename(i, dir));
                 else if (i == center)
                     for (int j = 0; j < nroots; j++)
-                        Parsing::copy_file(get_wfn_filename(j),
-                                           get_wfn_filename(j, dir));
-            Parsing::copy_file(get_filename(-1), get_filename(-1, dir));
+                        frame->copy_checkpoint_file(get_wfn_filename(j),
+                                                    get_wfn_filename(j, dir));
+            frame->copy_checkpoint_file(get_filename(-1),
+                                        get_filename(-1, dir));
         }
     }
     void load_data() override {
@@ -486,6 +488,7 @@ template <typename S, typename FL> struct MultiMPS : MPS<S, FL> {
     void load_mutable() const override {
         shared_ptr<VectorAllocator<uint32_t>> i_alloc =
             make_shared<VectorAllocator<uint32_t>>();
+        MPS<S, FL>::invalidate_tensor_hash();
         for (int i = 0; i < n_sites; i++)
             if (tensors[i] != nullptr)
                 tensors[i]->load_data(get_filename(i), true, i_alloc);
@@ -495,6 +498,7 @@ template <typename S, typename FL> struct MultiMPS : MPS<S, FL> {
         }
     }
     void save_mutable() const override {
+        MPS<S, FL>::invalidate_tensor_hash();
         if (frame->prefix_can_write) {
             for (int i = 0; i < n_sites; i++)
                 if (tensors[i] != nullptr)
@@ -527,6 +531,7 @@ template <typename S, typename FL> struct MultiMPS : MPS<S, FL> {
             wfns[0]->deallocate_infos();
     }
     void save_tensor(int i) const override {
+        MPS<S, FL>::invalidate_tensor_hash(i);
         if (frame->prefix_can_write) {
             assert(tensors[i] != nullptr || i == center);
             if (tensors[i] != nullptr)
@@ -65,6 +65,175 @@ inline bool has_abort_file() {
     return stop;
 }
 
+// Automatic bond dimension, noise and davidson threshold schedule for DMRG
+// the bond dimension is increased when the energy is converged at the current
+// bond dimension while the discarded weight is still large, the noise is
+// switched off when the quantum number distribution of the wavefunction does
+// not change, and the calculation stops when the energy error estimated from
+// the extrapolation in discarded weight is below target_error
+template <typename S, typename FL> struct DMRGScheduler {
+    typedef typename GMatrix<FL>::FP FP;
+    ubond_t start_bond_dim, max_bond_dim;
+    FP target_error, start_noise;
+    FP bond_dim_factor = 1.5;
+    // energy change per sweep for convergence at fixed bond dimension
+    FP energy_tol = 1E-6;
+    // bond dimension is not increased below this discarded weight
+    FP discarded_weight_tol = 1E-12;
+    // change of quanta distribution (1-norm) for switching off noise
+    FP quanta_tol = 1E-2;
+    // number of sweeps at each bond dimension
+    int min_sweeps = 2, max_sweeps = 6;
+    // number of points used in extrapolation
+    int n_extrap = 3;
+    uint8_t iprint = 1;
+    // current schedule
+    ubond_t bond_dim = 0;
+    FP noise = 0, davidson_conv_thrd = 0;
+    int n_stage_sweeps = 0;
+    // energy change and discarded weight of last sweep
+    FP energy_change = 0, discarded_weight = 0;
+    // discarded weight and energy at the end of each noiseless bond dimension
+    vector<pair<FP, FP>> stage_points;
+    vector<pair<S, FP>> last_quanta;
+    vector<FP> energies;
+    FP extrap_energy = 0, extrap_error = numeric_limits<FP>::max();
+    DMRGScheduler(ubond_t start_bond_dim, ubond_t max_bond_dim,
+                  FP target_error = 1E-5, FP start_noise = 1E-4)
+        : start_bond_dim(start_bond_dim), max_bond_dim(max_bond_dim),
+          target_error(target_error), start_noise(start_noise) {}
+    virtual ~DMRGScheduler() = default;
+    void initialize() {
+        bond_dim = start_bond_dim;
+        noise = start_noise;
+        davidson_conv_thrd = (noise == 0 ? energy_tol : noise) * 0.1;
+        n_stage_sweeps = 0;
+        stage_points.clear();
+        last_quanta.clear();
+        energies.clear();
+        extrap_energy = 0;
+        extrap_error = numeric_limits<FP>::max();
+    }
+    // 1-norm difference between two quanta distributions
+    static FP quanta_change(const vector<pair<S, FP>> &a,
+                            const vector<pair<S, FP>> &b) {
+        FP r = 0, na = 0, nb = 0;
+        for (auto &x : a)
+            na += x.second;
+        for (auto &x : b)
+            nb += x.second;
+        if (na == 0 || nb == 0)
+            return a.size() == b.size() ? 0 : 1;
+        for (auto &x : a) {
+            FP y = 0;
+            for (auto &z : b)
+                if (z.first == x.first)
+                    y += z.second;
+            r += abs(x.second / na - y / nb);
+        }
+        for (auto &z : b) {
+            bool found = false;
+            for (auto &x : a)
+                found = found || x.first == z.first;
+            if (!found)
+                r += abs(z.second / nb);
+        }
+        return r;
+    }
+    // linear extrapolation of energy to zero discarded weight
+    void extrapolate() {
+        int n = min((int)stage_points.size(), n_extrap);
+        extrap_error = numeric_limits<FP>::max();
+        if (n < 2)
+            return;
+        FP sx = 0, sy = 0, sxx = 0, sxy = 0;
+        for (int i = (int)stage_points.size() - n;
+             i < (int)stage_points.size(); i++) {
+            FP x = stage_points[i].first, y = stage_points[i].second;
+            sx += x, sy += y, sxx += x * x, sxy += x * y;
+        }
+        FP det = n * sxx - sx * sx;
+        if (abs(det) < 1E-30)
+            return;
+        extrap_energy = (sxx * sy - sx * sxy) / det;
+        extrap_error = abs(stage_points.back().second - extrap_energy);
+    }
+    // called after each sweep with the energies and discarded weights at all
+    // sites in the sweep and the quanta distribution of the wavefunction
+    // sets the schedule for the next sweep and returns true when converged
+    virtual bool update(const vector<vector<FP>> &sweep_energies,
+                        const vector<FP> &sweep_discarded_weights,
+                        const vector<pair<S, FP>> &quanta) {
+        FP energy = min_element(sweep_energies.begin(), sweep_energies.end(),
+                                [](const vector<FP> &x, const vector<FP> &y) {
+                                    return x.back() < y.back();
+                                })
+                        ->back();
+        discarded_weight = *max_element(sweep_discarded_weights.begin(),
+                                        sweep_discarded_weights.end());
+        energy_change = energies.size() == 0
+                            ? numeric_limits<FP>::max()
+                            : abs(energy - energies.back());
+        energies.push_back(energy);
+        n_stage_sweeps++;
+        bool converged = false;
+        if (noise != 0 && last_quanta.size() != 0) {
+            FP dq = quanta_change(quanta, last_quanta);
+            if (dq < quanta_tol) {
+                if (iprint >= 1)
+                    cout << "Scheduler: noise off (quanta change = "
+                         << scientific << setprecision(2) << dq << ")"
+                         << endl;
+                noise = 0, n_stage_sweeps = 0;
+            }
+        }
+        last_quanta = quanta;
+        if ((n_stage_sweeps >= min_sweeps && energy_change < energy_tol) ||
+            n_stage_sweeps >= max_sweeps) {
+            if (noise == 0) {
+                stage_points.push_back(make_pair(discarded_weight, energy));
+                extrapolate();
+                if (iprint >= 1 && extrap_error != numeric_limits<FP>::max())
+                    cout << "Scheduler: M = " << (uint32_t)bond_dim
+                         << " E(extrap) = " << fixed << setprecision(10)
+                         << extrap_energy << " error = " << scientific
+                         << setprecision(2) << extrap_error << endl;
+            }
+            if (noise == 0 && (discarded_weight < discarded_weight_tol ||
+                               extrap_error < target_error)) {
+                if (iprint >= 1)
+                    cout << "Scheduler: converged (DW = " << scientific
+                         << setprecision(2) << discarded_weight << ")"
+                         << endl;
+                converged = true;
+            } else if (bond_dim < max_bond_dim &&
+                       discarded_weight >= discarded_weight_tol) {
+                ubond_t new_bond_dim = (ubond_t)min(
+                    (FP)max_bond_dim,
+                    max((FP)bond_dim + 1, ceil(bond_dim * bond_dim_factor)));
+                if (iprint >= 1)
+                    cout << "Scheduler: M = " << (uint32_t)bond_dim << " -> "
+                         << (uint32_t)new_bond_dim << " (DE = " << scientific
+                         << setprecision(2) << energy_change
+                         << " DW = " << discarded_weight << ")" << endl;
+                bond_dim = new_bond_dim, n_stage_sweeps = 0;
+            } else if (noise != 0) {
+                if (iprint >= 1)
+                    cout << "Scheduler: noise off (M = " << (uint32_t)bond_dim
+                         << ")" << endl;
+                noise = 0, n_stage_sweeps = 0;
+            } else {
+                if (iprint >= 1)
+                    cout << "Scheduler: stopped at max M = "
+                         << (uint32_t)bond_dim << endl;
+                converged = true;
+            }
+        }
+        davidson_conv_thrd = (noise == 0 ? energy_tol : noise) * 0.1;
+        return converged;
+    }
+};
+
 // Density Matrix Renormalization Group
 template <typename S, typename FL, typename FLS> struct DMRG {
     typedef typename MovingEnvironment<S, FL, FLS>::FP FP;
@@ -83,17 +252,68 @@ template <typename S, typename FL, typename FLS> struct DMRG {
     vector<FPS> sweep_discarded_weights;
     vector<vector<vector<pair<S, FPS>>>> sweep_quanta;
     vector<FPS> davidson_conv_thrds;
+    // automatic schedule (if not null, bond_dims, noises and
+    // davidson_conv_thrds are set by the scheduler after each sweep)
+    shared_ptr<DMRGScheduler<S, FLS>> scheduler = nullptr;
     int isweep = 0;
     int davidson_max_iter = 5000;
     int davidson_soft_max_iter = -1;
     FPS davidson_shift = 0.0;
     DavidsonTypes davidson_type = DavidsonTypes::Normal;
+    // adaptive davidson threshold at each site, from the previous sweep:
+    // max(davidson_conv_thrds[isweep], min(davidson_adaptive_max_thrd,
+    //     dw_factor * site discarded weight + de_factor * |energy change|))
+    bool davidson_adaptive = false;
+    FPS davidson_adaptive_dw_factor = 0.1;
+    FPS davidson_adaptive_de_factor = 0.1;
+    FPS davidson_adaptive_max_thrd = 1E-5;
+    // adaptive davidson iteration budget at each site, from the previous
+    // sweep (used as soft max iterations, bounded by davidson_soft_max_iter):
+    // max(davidson_adaptive_min_iter,
+    //     davidson_adaptive_iter_factor * iterations at this site)
+    FPS davidson_adaptive_iter_factor = 2.0;
+    int davidson_adaptive_min_iter = 4;
+    // per sweep davidson iterations and matvecs (measured), and saved
+    // iterations relative to the fixed threshold (estimated from the
+    // convergence rate of each solve; one matvec is saved per iteration)
+    vector<size_t> davidson_iters, davidson_matvecs, davidson_est_saved_iters;
+    vector<FPS> site_discarded_weights;
+    vector<int> site_davidson_iters;
+    // residual of the davidson initial guess and number of matvecs
+    // at the current site (set by the update methods)
+    FP davidson_init_qq = -1;
+    int davidson_nmult = 0;
+    // number of randomized svd blocks in the current sweep
+    int rsvd_nblocks = 0;
+    // one-site single-state algorithm only: after each decomposition,
+    // optimize the bond matrix with the zero-site effective hamiltonian
+    // before absorbing it into the next site
+    bool zero_dot_update = false;
+    // mid-sweep checkpoints (MPS, valid environments and sweep state) are
+    // written into checkpoint_dir every checkpoint_site_interval sites
+    // and/or every checkpoint_time_interval seconds (zero means never)
+    // solve resumes the interrupted sweep if checkpoint_dir has a
+    // checkpoint of the current MPS (the caller should restore the MPS and
+    // then use MovingEnvironment::load_environments)
+    string checkpoint_dir = "";
+    int checkpoint_site_interval = 0;
+    double checkpoint_time_interval = 0;
+    // whether the next sweep continues the sweep loaded from checkpoint
+    bool resume_sweep = false;
     int conn_adjust_step = 2;
     bool forward;
     uint8_t iprint = 2;
     NoiseTypes noise_type = NoiseTypes::DensityMatrix;
     TruncationTypes trunc_type = TruncationTypes::Physical;
     DecompositionTypes decomp_type = DecompositionTypes::DensityMatrix;
+    // oversampling and accuracy threshold for RandomizedSVD
+    int rsvd_oversampling = 10;
+    FPS rsvd_eps = 1E-12;
+    // per sweep number of blocks decomposed by randomized svd
+    vector<size_t> rsvd_blocks;
+    // if nonzero, each bond keeps the smallest number of states whose
+    // discarded weight is below this target; bond_dims is then the upper bound
+    FPS trunc_dw_target = 0;
     FPS cutoff = 1E-14;
     FPS quanta_cutoff = 1E-3;
     bool decomp_last_site = true;
@@ -221,6 +441,9 @@ template <typename S, typename FL, typename FLS> struct DMRG {
                            ((forward && i == me->n_sites - 1 && !fuse_left) ||
                             (!forward && i == 0 && fuse_left));
         bool build_pdm = noise != 0 && (noise_type & NoiseTypes::Collected);
+        const bool bond_step = zero_dot_update && !skip_decomp &&
+                               (forward ? i != me->n_sites - 1 : i != 0);
+        shared_ptr<SparseMatrix<S, FLS>> bond = nullptr;
         // effective hamiltonian
         if (davidson_soft_max_iter != 0 || noise != 0)
             pdi = one_dot_eigs_and_perturb(forward, fuse_left, i,
@@ -333,10 +556,11 @@ template <typename S, typename FL, typename FLS> struct DMRG {
                     error = MovingEnvironment<S, FL, FLS>::split_density_matrix(
                         dm, me->ket->tensors[i], (int)bond_dim, forward, true,
                         left, right, cutoff, store_wfn_spectra, wfn_spectra,
-                        trunc_type);
+                        trunc_type, trunc_dw_target);
                     tsplt += _t.get_time();
                 } else if (decomp_type == DecompositionTypes::SVD ||
-                           decomp_type == DecompositionTypes::PureSVD) {
+                           decomp_type == DecompositionTypes::PureSVD ||
+                           decomp_type == DecompositionTypes::RandomizedSVD) {
                     assert(noise_type == NoiseTypes::None ||
                            (noise_type & NoiseTypes::Perturbative) ||
                            (noise_type & NoiseTypes::Wavefunction));
@@ -356,7 +580,10 @@ template <typename S, typename FL, typename FLS> struct DMRG {
                             me->ket->info->vacuum, me->ket->tensors[i],
                             (int)bond_dim, forward, true, left, right, cutoff,
                             store_wfn_spectra, wfn_spectra, trunc_type,
-                            decomp_type, pket);
+                            decomp_type, pket,
+                            vector<shared_ptr<SparseMatrix<S, FLS>>>(),
+                            vector<FPS>(), rsvd_oversampling, rsvd_eps,
+                            trunc_dw_target, &rsvd_nblocks);
                     tsvd += _t.get_time();
                 } else
                     assert(false);
@@ -373,10 +600,14 @@ template <typename S, typename FL, typename FLS> struct DMRG {
                     me->ket->info->save_left_dims(i + 1);
                     info->deallocate();
                     if (i != me->n_sites - 1) {
-                        MovingEnvironment<S, FL, FLS>::contract_one_dot(
-                            i + 1, right, me->ket, forward);
-                        me->ket->save_tensor(i + 1);
-                        me->ket->unload_tensor(i + 1);
+                        if (bond_step)
+                            bond = copy_bond_matrix(right);
+                        else {
+                            MovingEnvironment<S, FL, FLS>::contract_one_dot(
+                                i + 1, right, me->ket, forward);
+                            me->ket->save_tensor(i + 1);
+                            me->ket->unload_tensor(i + 1);
+                        }
                         me->ket->canonical_form[i] = 'L';
                         me->ket->canonical_form[i + 1] = 'S';
                     } else {
@@ -399,10 +630,14 @@ template <typename S, typename FL, typename FLS> struct DMRG {
                     me->ket->info->save_right_dims(i);
                     info->deallocate();
                     if (i > 0) {
-                        MovingEnvironment<S, FL, FLS>::contract_one_dot(
-                            i - 1, left, me->ket, forward);
-                        me->ket->save_tensor(i - 1);
-                        me->ket->unload_tensor(i - 1);
+                        if (bond_step)
+                            bond = copy_bond_matrix(left);
+                        else {
+                            MovingEnvironment<S, FL, FLS>::contract_one_dot(
+                                i - 1, left, me->ket, forward);
+                            me->ket->save_tensor(i - 1);
+                            me->ket->unload_tensor(i - 1);
+                        }
                         me->ket->canonical_form[i - 1] = 'K';
                         me->ket->canonical_form[i] = 'R';
                     } else {
@@ -459,12 +694,89 @@ template <typename S, typename FL, typename FLS> struct DMRG {
             pket->deallocate();
             pket->deallocate_infos();
         }
+        // the energy after truncation replaces the one-site energy
+        if (bond_step) {
+            tuple<FPS, int, size_t, double> pdk =
+                zero_dot_eigs_and_absorb(i, forward, bond, davidson_conv_thrd);
+            get<0>(pdi) = get<0>(pdk);
+            get<1>(pdi) += get<1>(pdk), get<2>(pdi) += get<2>(pdk);
+            get<3>(pdi) += get<3>(pdk);
+        }
         if (me->para_rule != nullptr)
             me->para_rule->comm->barrier();
         return Iteration(
             vector<FPS>{get<0>(pdi) + xreal<FLS>(me->mpo->const_e)}, error,
             mmps, get<1>(pdi), get<2>(pdi), get<3>(pdi));
     }
+    // copy of the bond matrix from the decomposition in dynamic memory
+    // so that it can outlive the stack memory of the one-site update
+    static shared_ptr<SparseMatrix<S, FLS>>
+    copy_bond_matrix(const shared_ptr<SparseMatrix<S, FLS>> &mat) {
+        shared_ptr<VectorAllocator<uint32_t>> i_alloc =
+            make_shared<VectorAllocator<uint32_t>>();
+        shared_ptr<VectorAllocator<FPS>> d_alloc =
+            make_shared<VectorAllocator<FPS>>();
+        shared_ptr<SparseMatrix<S, FLS>> r =
+            make_shared<SparseMatrix<S, FLS>>(d_alloc);
+        r->allocate(
+            make_shared<SparseMatrixInfo<S>>(mat->info->deep_copy(i_alloc)));
+        r->copy_data_from(mat);
+        r->factor = mat->factor;
+        return r;
+    }
+    // zero-site update of the bond matrix between site i and the next site
+    // (in the sweep direction), using the environments of the bond
+    // the bond basis is the one after the one-site decomposition, so that
+    // the states added by noise (subspace expansion) are also optimized
+    virtual tuple<FPS, int, size_t, double>
+    zero_dot_eigs_and_absorb(int i, bool forward,
+                             shared_ptr<SparseMatrix<S, FLS>> bond,
+                             FPS davidson_conv_thrd) {
+        tuple<FPS, int, size_t, double> pdi;
+        if (me->para_rule != nullptr) {
+            if (me->para_rule->is_root())
+                bond->save_data(me->ket->get_filename(-2), true);
+            me->para_rule->comm->barrier();
+            if (!me->para_rule->is_root()) {
+                bond = make_shared<SparseMatrix<S, FLS>>(
+                    make_shared<VectorAllocator<FPS>>());
+                bond->load_data(me->ket->get_filename(-2), true,
+                                make_shared<VectorAllocator<uint32_t>>());
+            }
+        }
+        const int j = forward ? i + 1 : i - 1;
+        _t.get_time();
+        me->move_to(j, true);
+        shared_ptr<EffectiveHamiltonian<S, FL>> h_eff =
+            me->eff_ham(forward ? FuseTypes::NoFuseL : FuseTypes::NoFuseR,
+                        forward, true, bond, bond);
+        teff += _t.get_time();
+        pdi = h_eff->eigs(iprint >= 3, davidson_conv_thrd, davidson_max_iter,
+                          davidson_soft_max_iter, davidson_type,
+                          davidson_shift - xreal<FL>(me->mpo->const_e),
+                          me->para_rule,
+                          vector<shared_ptr<SparseMatrix<S, FLS>>>(), nullptr,
+                          &davidson_nmult);
+        teig += _t.get_time();
+        h_eff->deallocate();
+        // partition of site i is not removed by move_to with preserve_data
+        if (frame->minimal_disk_usage) {
+            string old_data_name =
+                forward ? me->get_right_partition_filename(i)
+                        : me->get_left_partition_filename(i);
+            if (Parsing::file_exists(old_data_name))
+                Parsing::remove_file(old_data_name);
+        }
+        if (me->para_rule == nullptr || me->para_rule->is_root()) {
+            MovingEnvironment<S, FL, FLS>::contract_one_dot(j, bond, me->ket,
+                                                            forward);
+            me->ket->save_tensor(j);
+            me->ket->unload_tensor(j);
+        }
+        bond->deallocate();
+        bond->info->deallocate();
+        return pdi;
+    }
     virtual tuple<FPS, int, size_t, double>
     one_dot_eigs_and_perturb(const bool forward, const bool fuse_left,
                              const int i, const FPS davidson_conv_thrd,
@@ -501,7 +813,8 @@ template <typename S, typename FL, typename FLS> struct DMRG {
         pdi = h_eff->eigs(iprint >= 3, davidson_conv_thrd, davidson_max_iter,
                           davidson_soft_max_iter, davidson_type,
                           davidson_shift - xreal<FL>(me->mpo->const_e),
-                          me->para_rule, ortho_bra);
+                          me->para_rule, ortho_bra, &davidson_init_qq,
+                          &davidson_nmult);
         teig += _t.get_time();
         if (state_specific)
             for (auto &wfn : ortho_bra)
@@ -601,10 +914,12 @@ template <typename S, typename FL, typename FLS> struct DMRG {
                 error = MovingEnvironment<S, FL, FLS>::split_density_matrix(
                     dm, old_wfn, (int)bond_dim, forward, true,
                     me->ket->tensors[i], me->ket->tensors[i + 1], cutoff,
-                    store_wfn_spectra, wfn_spectra, trunc_type);
+                    store_wfn_spectra, wfn_spectra, trunc_type,
+                    trunc_dw_target);
                 tsplt += _t.get_time();
             } else if (decomp_type == DecompositionTypes::SVD ||
-                       decomp_type == DecompositionTypes::PureSVD) {
+                       decomp_type == DecompositionTypes::PureSVD ||
+                       decomp_type == DecompositionTypes::RandomizedSVD) {
                 assert(noise_type == NoiseTypes::None ||
                        (noise_type & NoiseTypes::Perturbative) ||
                        (noise_type & NoiseTypes::Wavefunction));
@@ -621,7 +936,9 @@ template <typename S, typename FL, typename FLS> struct DMRG {
                     me->ket->info->vacuum, old_wfn, (int)bond_dim, forward,
                     true, me->ket->tensors[i], me->ket->tensors[i + 1], cutoff,
                     store_wfn_spectra, wfn_spectra, trunc_type, decomp_type,
-                    pket);
+                    pket, vector<shared_ptr<SparseMatrix<S, FLS>>>(),
+                    vector<FPS>(), rsvd_oversampling, rsvd_eps,
+                    trunc_dw_target, &rsvd_nblocks);
                 tsvd += _t.get_time();
             } else
                 assert(false);
@@ -724,7 +1041,8 @@ template <typename S, typename FL, typename FLS> struct DMRG {
         pdi = h_eff->eigs(iprint >= 3, davidson_conv_thrd, davidson_max_iter,
                           davidson_soft_max_iter, davidson_type,
                           davidson_shift - xreal<FL>(me->mpo->const_e),
-                          me->para_rule, ortho_bra);
+                          me->para_rule, ortho_bra, &davidson_init_qq,
+                          &davidson_nmult);
         teig += _t.get_time();
         if (state_specific)
             for (auto &wfn : ortho_bra)
@@ -858,7 +1176,8 @@ template <typename S, typename FL, typename FLS> struct DMRG {
             tdm += _t.get_time();
             error = MovingEnvironment<S, FL, FLS>::multi_split_density_matrix(
                 dm, mket->wfns, (int)bond_dim, forward, true, new_wfns, rot,
-                cutoff, store_wfn_spectra, wfn_spectra, trunc_type);
+                cutoff, store_wfn_spectra, wfn_spectra, trunc_type,
+                trunc_dw_target);
             tsplt += _t.get_time();
             shared_ptr<StateInfo<S>> info = nullptr;
             // propagation
@@ -993,7 +1312,7 @@ template <typename S, typename FL, typename FLS> struct DMRG {
         pdi = h_eff->eigs(iprint >= 3, davidson_conv_thrd, davidson_max_iter,
                           davidson_soft_max_iter, davidson_type,
                           davidson_shift - xreal<FL>(me->mpo->const_e),
-                          me->para_rule);
+                          me->para_rule, &davidson_nmult);
         for (int i = 0; i < mket->nroots; i++) {
             mps_quanta[i] = h_eff->ket[i]->delta_quanta();
             mps_quanta[i].erase(
@@ -1070,7 +1389,7 @@ template <typename S, typename FL, typename FLS> struct DMRG {
             error = MovingEnvironment<S, FL, FLS>::multi_split_density_matrix(
                 dm, old_wfns, (int)bond_dim, forward, true, mket->wfns,
                 forward ? mket->tensors[i] : mket->tensors[i + 1], cutoff,
-                store_wfn_spectra, wfn_spectra, trunc_type);
+                store_wfn_spectra, wfn_spectra, trunc_type, trunc_dw_target);
             tsplt += _t.get_time();
             shared_ptr<StateInfo<S>> info = nullptr;
             if (forward) {
@@ -1168,7 +1487,7 @@ template <typename S, typename FL, typename FLS> struct DMRG {
         pdi = h_eff->eigs(iprint >= 3, davidson_conv_thrd, davidson_max_iter,
                           davidson_soft_max_iter, davidson_type,
                           davidson_shift - xreal<FL>(me->mpo->const_e),
-                          me->para_rule);
+                          me->para_rule, &davidson_nmult);
         for (int i = 0; i < mket->nroots; i++) {
             mps_quanta[i] = h_eff->ket[i]->delta_quanta();
             mps_quanta[i].erase(
@@ -1195,6 +1514,10 @@ template <typename S, typename FL, typename FLS> struct DMRG {
             xme->move_to(i);
         tmve += _t2.get_time();
         assert(me->dot == 1 || me->dot == 2);
+        const int tupd = me->sweep_trace == nullptr
+                             ? -1
+                             : me->sweep_trace->begin(
+                                   "update " + Parsing::to_string(i), {});
         Iteration it(vector<FPS>(), 0, 0, 0);
         // use site dependent bond dims
         if (site_dependent_bond_dims.size() > 0) {
@@ -1233,15 +1556,167 @@ template <typename S, typename FL, typename FLS> struct DMRG {
                 sweep_wfn_spectra.resize(bond_update_idx + 1);
             sweep_wfn_spectra[bond_update_idx] = wfn_spectra;
         }
+        if (tupd != -1)
+            me->sweep_trace->end(tupd);
         tblk += _t2.get_time();
         return it;
     }
+    string get_checkpoint_filename(const string &dir) const {
+        stringstream ss;
+        ss << dir << "/" << frame->prefix << ".DMRG." << me->tag << ".STATE";
+        return ss.str();
+    }
+    template <typename T>
+    static void save_checkpoint_vector(ostream &ofs, const vector<T> &v) {
+        size_t n = v.size();
+        ofs.write((char *)&n, sizeof(n));
+        if (n != 0)
+            ofs.write((char *)&v[0], sizeof(T) * n);
+    }
+    // quanta are written field by field (no padding bytes)
+    static void save_checkpoint_vector(ostream &ofs,
+                                       const vector<pair<S, FPS>> &v) {
+        size_t n = v.size();
+        ofs.write((char *)&n, sizeof(n));
+        for (size_t i = 0; i < n; i++) {
+            ofs.write((char *)&v[i].first, sizeof(S));
+            ofs.write((char *)&v[i].second, sizeof(FPS));
+        }
+    }
+    template <typename T>
+    static void save_checkpoint_vector(ostream &ofs,
+                                       const vector<vector<T>> &v) {
+        size_t n = v.size();
+        ofs.write((char *)&n, sizeof(n));
+        for (size_t i = 0; i < n; i++)
+            save_checkpoint_vector(ofs, v[i]);
+    }
+    static void load_checkpoint_vector(istream &ifs,
+                                       vector<pair<S, FPS>> &v) {
+        size_t n;
+        ifs.read((char *)&n, sizeof(n));
+        v.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            ifs.read((char *)&v[i].first, sizeof(S));
+            ifs.read((char *)&v[i].second, sizeof(FPS));
+        }
+    }
+    template <typename T>
+    static void load_checkpoint_vector(istream &ifs, vector<T> &v) {
+        size_t n;
+        ifs.read((char *)&n, sizeof(n));
+        v.resize(n);
+        if (n != 0)
+            ifs.read((char *)&v[0], sizeof(T) * n);
+    }
+    template <typename T>
+    static void load_checkpoint_vector(istream &ifs, vector<vector<T>> &v) {
+        size_t n;
+        ifs.read((char *)&n, sizeof(n));
+        v.resize(n);
+        for (size_t i = 0; i < n; i++)
+            load_checkpoint_vector(ifs, v[i]);
+    }
+    // Write MPS, environments and sweep state into checkpoint_dir
+    // The environments should already be at the next site of the sweep
+    virtual void save_sweep_checkpoint(bool forward) {
+        if (me->para_rule == nullptr || me->para_rule->is_root()) {
+            me->ket->save_data();
+            string staging = frame->begin_checkpoint(checkpoint_dir);
+            me->ket->info->copy_mutable(staging);
+            me->ket->copy_data(staging);
+            me->save_environments(staging);
+            string filename = get_checkpoint_filename(frame->save_dir);
+            ofstream ofs(filename.c_str(), ios::binary);
+            if (!ofs.good())
+                throw runtime_error("DMRG::save_sweep_checkpoint on '" +
+                                    filename + "' failed.");
+            uint8_t xforward = forward;
+            ofs.write((char *)&me->n_sites, sizeof(me->n_sites));
+            ofs.write((char *)&me->dot, sizeof(me->dot));
+            ofs.write((char *)&me->center, sizeof(me->center));
+            ofs.write((char *)&me->ket->canonical_form[0],
+                      sizeof(char) * me->n_sites);
+            ofs.write((char *)&xforward, sizeof(xforward));
+            save_checkpoint_vector(ofs, energies);
+            save_checkpoint_vector(ofs, discarded_weights);
+            save_checkpoint_vector(ofs, mps_quanta);
+            save_checkpoint_vector(ofs, sweep_energies);
+            save_checkpoint_vector(ofs, sweep_discarded_weights);
+            save_checkpoint_vector(ofs, sweep_quanta);
+            save_checkpoint_vector(ofs, site_discarded_weights);
+            save_checkpoint_vector(ofs, site_davidson_iters);
+            if (!ofs.good())
+                throw runtime_error("DMRG::save_sweep_checkpoint on '" +
+                                    filename + "' failed.");
+            ofs.close();
+            frame->copy_checkpoint_file(filename,
+                                        get_checkpoint_filename(staging));
+            // the sweep state refers to all other files, so it is updated last
+            frame->end_checkpoint(
+                checkpoint_dir,
+                vector<string>{"mps_info.bin",
+                               Parsing::get_filename(filename)});
+        }
+        if (me->para_rule != nullptr)
+            me->para_rule->comm->barrier();
+    }
+    // Remove the sweep state from checkpoint_dir when the sweep is finished,
+    // so that the MPS of a later checkpoint is not resumed with it
+    void remove_sweep_checkpoint() const {
+        if (checkpoint_dir == "" ||
+            (me->para_rule != nullptr && !me->para_rule->is_root()))
+            return;
+        frame->wait_checkpoint();
+        string filename = get_checkpoint_filename(checkpoint_dir);
+        if (Parsing::file_exists(filename))
+            Parsing::remove_file(filename);
+    }
+    // Load the state of an interrupted sweep from checkpoint_dir
+    // Returns false if there is no checkpoint for the current MPS
+    virtual bool load_sweep_checkpoint(bool &forward) {
+        string filename = get_checkpoint_filename(checkpoint_dir);
+        if (!Parsing::file_exists(filename))
+            return false;
+        ifstream ifs(filename.c_str(), ios::binary);
+        if (!ifs.good())
+            throw runtime_error("DMRG::load_sweep_checkpoint on '" + filename +
+                                "' failed.");
+        int xn_sites, xdot, xcenter;
+        ifs.read((char *)&xn_sites, sizeof(xn_sites));
+        ifs.read((char *)&xdot, sizeof(xdot));
+        ifs.read((char *)&xcenter, sizeof(xcenter));
+        if (xn_sites != me->n_sites || xdot != me->dot ||
+            xcenter != me->center)
+            return false;
+        string canonical_form(me->n_sites, ' ');
+        ifs.read((char *)&canonical_form[0], sizeof(char) * me->n_sites);
+        if (canonical_form != me->ket->canonical_form)
+            return false;
+        uint8_t xforward;
+        ifs.read((char *)&xforward, sizeof(xforward));
+        load_checkpoint_vector(ifs, energies);
+        load_checkpoint_vector(ifs, discarded_weights);
+        load_checkpoint_vector(ifs, mps_quanta);
+        load_checkpoint_vector(ifs, sweep_energies);
+        load_checkpoint_vector(ifs, sweep_discarded_weights);
+        load_checkpoint_vector(ifs, sweep_quanta);
+        load_checkpoint_vector(ifs, site_discarded_weights);
+        load_checkpoint_vector(ifs, site_davidson_iters);
+        if (ifs.fail() || ifs.bad())
+            throw runtime_error("DMRG::load_sweep_checkpoint on '" + filename +
+                                "' failed.");
+        ifs.close();
+        forward = xforward;
+        resume_sweep = true;
+        return true;
+    }
     // one standard DMRG sweep
     virtual tuple<vector<FPS>, FPS, vector<vector<pair<S, FPS>>>>
     sweep(bool forward, ubond_t bond_dim, FPS noise, FPS davidson_conv_thrd) {
         teff = teig = tprt = tblk = tmve = tdm = tsplt = tsvd = torth = 0;
         frame->twrite = frame->tread = frame->tasync = 0;
-        frame->fpwrite = frame->fpread = 0;
+        frame->fpwrite = frame->fpread = frame->tprefetch = 0;
         if (frame->fp_codec != nullptr)
             frame->fp_codec->ndata = frame->fp_codec->ncpsd = 0;
         if (me->para_rule != nullptr && iprint >= 2) {
@@ -1249,12 +1724,17 @@ template <typename S, typename FL, typename FLS> struct DMRG {
             me->para_rule->comm->tidle = 0;
             me->para_rule->comm->twait = 0;
         }
+        if (me->sweep_trace != nullptr)
+            me->sweep_trace->clear();
         me->prepare();
         for (auto &xme : ext_mes)
             xme->prepare();
-        sweep_energies.clear();
-        sweep_discarded_weights.clear();
-        sweep_quanta.clear();
+        if (!resume_sweep) {
+            sweep_energies.clear();
+            sweep_discarded_weights.clear();
+            sweep_quanta.clear();
+        }
+        resume_sweep = false;
         sweep_cumulative_nflop = 0;
         sweep_max_pket_size = 0;
         sweep_max_eff_ham_size = 0;
@@ -1266,8 +1746,25 @@ template <typename S, typename FL, typename FLS> struct DMRG {
         else
             for (int it = me->center; it >= 0; it--)
                 sweep_range.push_back(it);
+        // adaptive davidson threshold and iteration budget from the previous
+        // sweep
+        bool adaptive = davidson_adaptive && energies.size() != 0 &&
+                        (int)site_discarded_weights.size() == me->n_sites &&
+                        (int)site_davidson_iters.size() == me->n_sites;
+        FPS adaptive_de = 0;
+        if (adaptive && energies.size() >= 2)
+            adaptive_de = abs(energies[energies.size() - 1].back() -
+                              energies[energies.size() - 2].back());
+        site_discarded_weights.resize(me->n_sites, 0);
+        site_davidson_iters.resize(me->n_sites, 0);
+        const int soft_max_iter = davidson_soft_max_iter;
+        size_t sweep_ndav = 0, sweep_nmult = 0, sweep_nsaved = 0;
+        rsvd_nblocks = 0;
+        int ckpt_nsites = 0;
+        double ckpt_time = 0;
 
-        Timer t;
+        Timer t, tckpt;
+        tckpt.get_time();
         for (auto i : sweep_range) {
             check_signal_()();
             if (iprint >= 2) {
@@ -1281,8 +1778,25 @@ template <typename S, typename FL, typename FLS> struct DMRG {
                 cout.flush();
             }
             t.get_time();
-            Iteration r =
-                blocking(i, forward, bond_dim, noise, davidson_conv_thrd);
+            FPS site_thrd = davidson_conv_thrd;
+            if (adaptive)
+                site_thrd = max(
+                    davidson_conv_thrd,
+                    min(davidson_adaptive_max_thrd,
+                        davidson_adaptive_dw_factor *
+                                site_discarded_weights[i] +
+                            davidson_adaptive_de_factor * adaptive_de));
+            if (adaptive && site_davidson_iters[i] > 0) {
+                int budget = max(davidson_adaptive_min_iter,
+                                 (int)ceil(davidson_adaptive_iter_factor *
+                                           site_davidson_iters[i]));
+                davidson_soft_max_iter =
+                    soft_max_iter == -1 ? budget : min(soft_max_iter, budget);
+            }
+            davidson_init_qq = -1;
+            davidson_nmult = 0;
+            Iteration r = blocking(i, forward, bond_dim, noise, site_thrd);
+            davidson_soft_max_iter = soft_max_iter;
             sweep_cumulative_nflop += r.nflop;
             if (iprint >= 2)
                 cout << r << " T = " << setw(4) << fixed << setprecision(2)
@@ -1290,6 +1804,18 @@ template <typename S, typename FL, typename FLS> struct DMRG {
             sweep_energies.push_back(r.energies);
             sweep_discarded_weights.push_back(r.error);
             sweep_quanta.push_back(r.quanta);
+            site_discarded_weights[i] = r.error;
+            site_davidson_iters[i] = r.ndav;
+            sweep_ndav += r.ndav;
+            sweep_nmult += davidson_nmult;
+            // iterations needed to reach the fixed threshold, assuming
+            // the residual decreases at the same rate as in this solve
+            if (site_thrd > davidson_conv_thrd && r.ndav > 0 &&
+                davidson_init_qq > site_thrd) {
+                FP rate = log(davidson_init_qq / site_thrd) / r.ndav;
+                sweep_nsaved +=
+                    (size_t)ceil(log(site_thrd / davidson_conv_thrd) / rate);
+            }
             if (frame->restart_dir_optimal_mps != "" ||
                 frame->restart_dir_optimal_mps_per_sweep != "") {
                 size_t midx =
@@ -1302,26 +1828,36 @@ template <typename S, typename FL, typename FLS> struct DMRG {
                     if (me->para_rule == nullptr || me->para_rule->is_root()) {
                         if (frame->restart_dir_optimal_mps != "") {
                             string rdoe = frame->restart_dir_optimal_mps;
-                            if (!Parsing::path_exists(rdoe))
-                                Parsing::mkdir(rdoe);
-                            me->ket->info->copy_mutable(rdoe);
-                            me->ket->copy_data(rdoe);
+                            me->ket->save_checkpoint(rdoe);
                         }
                         if (frame->restart_dir_optimal_mps_per_sweep != "") {
                             string rdps =
                                 frame->restart_dir_optimal_mps_per_sweep + "." +
                                 Parsing::to_string((int)energies.size());
-                            if (!Parsing::path_exists(rdps))
-                                Parsing::mkdir(rdps);
-                            me->ket->info->copy_mutable(rdps);
-                            me->ket->copy_data(rdps);
+                            me->ket->save_checkpoint(rdps);
                         }
                     }
-                    if (me->para_rule != nullptr)
-                        me->para_rule->comm->barrier();
                 }
             }
+            ckpt_nsites++, ckpt_time += tckpt.get_time();
+            if (checkpoint_dir != "" && i != sweep_range.back() &&
+                ((checkpoint_site_interval > 0 &&
+                  ckpt_nsites >= checkpoint_site_interval) ||
+                 (checkpoint_time_interval > 0 &&
+                  ckpt_time >= checkpoint_time_interval))) {
+                // environments are moved to the next site in advance,
+                // so that the checkpoint can be resumed from there
+                _t2.get_time();
+                me->move_to(forward ? i + 1 : i - 1);
+                for (auto &xme : ext_mes)
+                    xme->move_to(forward ? i + 1 : i - 1);
+                tmve += _t2.get_time();
+                save_sweep_checkpoint(forward);
+                ckpt_nsites = 0, ckpt_time = 0;
+                tckpt.get_time();
+            }
         }
+        remove_sweep_checkpoint();
         size_t idx =
             min_element(sweep_energies.begin(), sweep_energies.end(),
                         [](const vector<FPS> &x, const vector<FPS> &y) {
@@ -1330,20 +1866,26 @@ template <typename S, typename FL, typename FLS> struct DMRG {
             sweep_energies.begin();
         if (frame->restart_dir != "" &&
             (me->para_rule == nullptr || me->para_rule->is_root())) {
-            if (!Parsing::path_exists(frame->restart_dir))
-                Parsing::mkdir(frame->restart_dir);
-            me->ket->info->copy_mutable(frame->restart_dir);
-            me->ket->copy_data(frame->restart_dir);
+            me->ket->save_checkpoint(frame->restart_dir);
         }
         if (frame->restart_dir_per_sweep != "" &&
             (me->para_rule == nullptr || me->para_rule->is_root())) {
             string rdps = frame->restart_dir_per_sweep + "." +
                           Parsing::to_string((int)energies.size());
-            if (!Parsing::path_exists(rdps))
-                Parsing::mkdir(rdps);
-            me->ket->info->copy_mutable(rdps);
-            me->ket->copy_data(rdps);
+            me->ket->save_checkpoint(rdps);
+        }
+        if (me->sweep_trace != nullptr) {
+            me->sweep_trace->wait_all();
+            if (me->sweep_trace->trace_filename != "" &&
+                (me->para_rule == nullptr || me->para_rule->is_root()))
+                me->sweep_trace->save_trace(
+                    me->sweep_trace->trace_filename + "." +
+                    Parsing::to_string((int)energies.size()) + ".json");
         }
+        davidson_iters.push_back(sweep_ndav);
+        davidson_matvecs.push_back(sweep_nmult);
+        davidson_est_saved_iters.push_back(sweep_nsaved);
+        rsvd_blocks.push_back(rsvd_nblocks);
         FPS max_dw = *max_element(sweep_discarded_weights.begin(),
                                   sweep_discarded_weights.end());
         return make_tuple(sweep_energies[idx], max_dw, sweep_quanta[idx]);
@@ -1656,10 +2198,7 @@ template <typename S, typename FL, typename FLS> struct DMRG {
             (para_mps->rule == nullptr || para_mps->rule->comm->group == 0) &&
             (me->para_rule == nullptr || me->para_rule->is_root())) {
             para_mps->save_data();
-            if (!Parsing::path_exists(frame->restart_dir))
-                Parsing::mkdir(frame->restart_dir);
-            para_mps->info->copy_mutable(frame->restart_dir);
-            para_mps->copy_data(frame->restart_dir);
+            para_mps->save_checkpoint(frame->restart_dir);
         }
         if (frame->restart_dir_per_sweep != "" &&
             (para_mps->rule == nullptr || para_mps->rule->comm->group == 0) &&
@@ -1667,17 +2206,37 @@ template <typename S, typename FL, typename FLS> struct DMRG {
             para_mps->save_data();
             string rdps = frame->restart_dir_per_sweep + "." +
                           Parsing::to_string((int)energies.size());
-            if (!Parsing::path_exists(rdps))
-                Parsing::mkdir(rdps);
-            para_mps->info->copy_mutable(rdps);
-            para_mps->copy_data(rdps);
+            para_mps->save_checkpoint(rdps);
         }
         FPS max_dw = *max_element(sweep_discarded_weights.begin(),
                                   sweep_discarded_weights.end());
         return make_tuple(sweep_energies[idx], max_dw, sweep_quanta[idx]);
     }
     // energy optimization using multiple DMRG sweeps
+    // quanta distribution of the wavefunction after a sweep, from the
+    // target quanta of all roots or the bond in the middle of the chain
+    vector<pair<S, FPS>>
+    get_quanta_distribution(bool forward,
+                            const vector<vector<pair<S, FPS>>> &quanta) const {
+        vector<pair<S, FPS>> r;
+        for (auto &x : quanta)
+            r.insert(r.end(), x.begin(), x.end());
+        if (r.size() != 0)
+            return r;
+        StateInfo<S> info;
+        info.load_data(me->ket->info->get_filename(forward, me->n_sites / 2));
+        for (int i = 0; i < info.n; i++)
+            r.push_back(make_pair(info.quanta[i], (FPS)info.n_states[i]));
+        info.deallocate();
+        return r;
+    }
     FPS solve(int n_sweeps, bool forward = true, FPS tol = 1E-6) {
+        if (scheduler != nullptr) {
+            scheduler->initialize();
+            bond_dims.assign(1, scheduler->bond_dim);
+            noises.assign(1, scheduler->noise);
+            davidson_conv_thrds.assign(1, scheduler->davidson_conv_thrd);
+        }
         if (bond_dims.size() < n_sweeps)
             bond_dims.resize(n_sweeps, bond_dims.back());
         if (noises.size() < n_sweeps)
@@ -1697,9 +2256,23 @@ template <typename S, typename FL, typename FLS> struct DMRG {
         energies.clear();
         discarded_weights.clear();
         mps_quanta.clear();
+        site_discarded_weights.clear();
+        site_davidson_iters.clear();
+        davidson_iters.clear();
+        davidson_matvecs.clear();
+        davidson_est_saved_iters.clear();
+        rsvd_blocks.clear();
         bool converged;
         FPS energy_difference;
-        for (int iw = 0; iw < n_sweeps; iw++) {
+        int iw_start = 0;
+        if (checkpoint_dir != "" && para_mps == nullptr &&
+            load_sweep_checkpoint(forward)) {
+            iw_start = (int)energies.size();
+            if (iprint >= 1)
+                cout << "Resume sweep " << iw_start << " from site "
+                     << me->center << endl;
+        }
+        for (int iw = iw_start; iw < n_sweeps; iw++) {
             isweep = iw;
             if (iprint >= 1)
                 cout << "Sweep = " << setw(4) << iw
@@ -1726,6 +2299,16 @@ template <typename S, typename FL, typename FLS> struct DMRG {
                         abs(energy_difference) < tol &&
                         noises[iw] == noises.back() &&
                         bond_dims[iw] == bond_dims.back();
+            if (scheduler != nullptr) {
+                converged = scheduler->update(
+                    sweep_energies, sweep_discarded_weights,
+                    get_quanta_distribution(forward, get<2>(sweep_results)));
+                if (iw + 1 < n_sweeps) {
+                    bond_dims[iw + 1] = scheduler->bond_dim;
+                    noises[iw + 1] = scheduler->noise;
+                    davidson_conv_thrds[iw + 1] = scheduler->davidson_conv_thrd;
+                }
+            }
             forward = !forward;
             double tswp = current.get_time();
             if (iprint >= 1) {
@@ -1745,6 +2328,12 @@ template <typename S, typename FL, typename FLS> struct DMRG {
                          << scientific << energy_difference;
                 cout << " | DW = " << setw(6) << setprecision(2) << scientific
                      << get<1>(sweep_results) << endl;
+                if (davidson_adaptive && davidson_iters.size() != 0)
+                    cout << "Davidson iters = " << setw(8)
+                         << davidson_iters.back() << " | matvecs = " << setw(8)
+                         << davidson_matvecs.back()
+                         << " | saved iters (estimated) = " << setw(8)
+                         << davidson_est_saved_iters.back() << endl;
                 if (iprint >= 2) {
                     cout << fixed << setprecision(3);
                     cout << "Time sweep = " << setw(12) << tswp;
@@ -1809,7 +2398,13 @@ template <typename S, typename FL, typename FLS> struct DMRG {
                              << " | cpsd = "
                              << Parsing::to_size_string(frame->fp_codec->ncpsd *
                                                         8);
-                    sout << " | Tasync = " << frame->tasync << endl;
+                    sout << " | Tasync = " << frame->tasync;
+                    if (frame->checkpoint_async)
+                        sout << " | Tckpt = " << frame->tcheckpoint;
+                    sout << endl;
+                    if (me->sweep_trace != nullptr)
+                        sout << " | Tprefetch = " << frame->tprefetch << " | "
+                             << *me->sweep_trace << endl;
                     sout << " | Trot = " << me->trot << " | Tctr = " << me->tctr
                          << " | Tint = " << me->tint << " | Tmid = " << me->tmid
                          << " | Tdctr = " << me->tdctr
@@ -1833,6 +2428,11 @@ template <typename S, typename FL, typename FLS> struct DMRG {
                 break;
         }
         this->forward = forward;
+        // the restart dir should be complete when solve returns
+        frame->wait_checkpoint();
+        // keep the manifest current for the next incremental init
+        if (me->incremental_init)
+            me->save_partition_manifest();
         if (!converged && iprint > 0 && tol != 0)
             cout << "ATTENTION: DMRG is not converged to desired tolerance of "
                  << scientific << tol << endl;
@@ -2574,7 +3174,9 @@ template <typename S, typename FL, typename FLS> struct Linear {
                                 trunc_type);
                         tsplt += _t.get_time();
                     } else if (decomp_type == DecompositionTypes::SVD ||
-                               decomp_type == DecompositionTypes::PureSVD) {
+                               decomp_type == DecompositionTypes::PureSVD ||
+                               decomp_type ==
+                                   DecompositionTypes::RandomizedSVD) {
                         if (mps != me->bra) {
                             error = MovingEnvironment<S, FL, FLS>::
                                 split_wavefunction_svd(
@@ -3185,7 +3787,8 @@ template <typename S, typename FL, typename FLS> struct Linear {
                         wfn_spectra, trunc_type);
                     tsplt += _t.get_time();
                 } else if (decomp_type == DecompositionTypes::SVD ||
-                           decomp_type == DecompositionTypes::PureSVD) {
+                           decomp_type == DecompositionTypes::PureSVD ||
+                           decomp_type == DecompositionTypes::RandomizedSVD) {
                     if (mps != me->bra) {
                         error = MovingEnvironment<S, FL, FLS>::
                             split_wavefunction_svd(
@@ -3451,23 +4054,15 @@ template <typename S, typename FL, typename FLS> struct Linear {
                         rme->para_rule->is_root()) {
                         if (frame->restart_dir_optimal_mps != "") {
                             string rdoe = frame->restart_dir_optimal_mps;
-                            if (!Parsing::path_exists(rdoe))
-                                Parsing::mkdir(rdoe);
-                            rme->bra->info->copy_mutable(rdoe);
-                            rme->bra->copy_data(rdoe);
+                            rme->bra->save_checkpoint(rdoe);
                         }
                         if (frame->restart_dir_optimal_mps_per_sweep != "") {
                             string rdps =
                                 frame->restart_dir_optimal_mps_per_sweep + "." +
                                 Parsing::to_string((int)targets.size());
-                            if (!Parsing::path_exists(rdps))
-                                Parsing::mkdir(rdps);
-                            rme->bra->info->copy_mutable(rdps);
-                            rme->bra->copy_data(rdps);
+                            rme->bra->save_checkpoint(rdps);
                         }
                     }
-                    if (rme->para_rule != nullptr)
-                        rme->para_rule->comm->barrier();
                 }
             }
         }
@@ -3525,19 +4120,13 @@ template <typename S, typename FL, typename FLS> struct Linear {
         }
         if (frame->restart_dir != "" &&
             (rme->para_rule == nullptr || rme->para_rule->is_root())) {
-            if (!Parsing::path_exists(frame->restart_dir))
-                Parsing::mkdir(frame->restart_dir);
-            rme->bra->info->copy_mutable(frame->restart_dir);
-            rme->bra->copy_data(frame->restart_dir);
+            rme->bra->save_checkpoint(frame->restart_dir);
         }
         if (frame->restart_dir_per_sweep != "" &&
             (rme->para_rule == nullptr || rme->para_rule->is_root())) {
             string rdps = frame->restart_dir_per_sweep + "." +
                           Parsing::to_string((int)targets.size());
-            if (!Parsing::path_exists(rdps))
-                Parsing::mkdir(rdps);
-            rme->bra->info->copy_mutable(rdps);
-            rme->bra->copy_data(rdps);
+            rme->bra->save_checkpoint(rdps);
         }
         FPS max_dw = *max_element(sweep_discarded_weights.begin(),
                                   sweep_discarded_weights.end());
@@ -279,7 +279,9 @@ template <typename S, typename FL, typename FLS> struct TDDMRG {
                                 store_wfn_spectra && mps == rme->bra,
                                 wfn_spectra, trunc_type);
                     } else if (decomp_type == DecompositionTypes::SVD ||
-                               decomp_type == DecompositionTypes::PureSVD) {
+                               decomp_type == DecompositionTypes::PureSVD ||
+                               decomp_type ==
+                                   DecompositionTypes::RandomizedSVD) {
                         if (mps != rme->bra) {
                             error = MovingEnvironment<S, FL, FLS>::
                                 split_wavefunction_svd(
@@ -508,7 +510,8 @@ template <typename S, typename FL, typename FLS> struct TDDMRG {
                         store_wfn_spectra && mps == rme->bra, wfn_spectra,
                         trunc_type);
                 } else if (decomp_type == DecompositionTypes::SVD ||
-                           decomp_type == DecompositionTypes::PureSVD) {
+                           decomp_type == DecompositionTypes::PureSVD ||
+                           decomp_type == DecompositionTypes::RandomizedSVD) {
                     if (mps != rme->bra) {
                         error = MovingEnvironment<S, FL, FLS>::
                             split_wavefunction_svd(
@@ -25,6 +25,7 @@
 #include "../dmrg/determinant.hpp"
 #include "../dmrg/effective_functions.hpp"
 #include "../dmrg/effective_hamiltonian.hpp"
+#include "../dmrg/general_mpo.hpp"
 #include "../dmrg/moving_environment.hpp"
 #include "../dmrg/mpo.hpp"
 #include "../dmrg/mpo_fusing.hpp"
@@ -78,6 +79,9 @@ extern template struct block2::LinearEffectiveHamiltonian<block2::SU2, double>;
 extern template struct block2::EffectiveHamiltonian<
     block2::SU2, double, block2::MultiMPS<block2::SU2, double>>;
 
+// general_mpo.hpp
+extern template struct block2::GeneralMPO<block2::SZ, double>;
+
 // moving_environment.hpp
 extern template struct block2::MovingEnvironment<block2::SZ, double, double>;
 extern template struct block2::MovingEnvironment<block2::SU2, double, double>;
@@ -265,6 +269,9 @@ extern template struct block2::LinearEffectiveHamiltonian<block2::SU2K, double>;
 extern template struct block2::EffectiveHamiltonian<
     block2::SU2K, double, block2::MultiMPS<block2::SU2K, double>>;
 
+// general_mpo.hpp
+extern template struct block2::GeneralMPO<block2::SZK, double>;
+
 // moving_environment.hpp
 extern template struct block2::MovingEnvironment<block2::SZK, double, double>;
 extern template struct block2::MovingEnvironment<block2::SU2K, double, double>;
@@ -449,6 +456,10 @@ extern template struct block2::LinearEffectiveHamiltonian<block2::SGB, double>;
 extern template struct block2::EffectiveHamiltonian<
     block2::SGB, double, block2::MultiMPS<block2::SGB, double>>;
 
+// general_mpo.hpp
+extern template struct block2::GeneralMPO<block2::SGF, double>;
+extern template struct block2::GeneralMPO<block2::SGB, double>;
+
 // moving_environment.hpp
 extern template struct block2::MovingEnvironment<block2::SGF, double, double>;
 extern template struct block2::MovingEnvironment<block2::SGB, double, double>;
@@ -635,6 +646,9 @@ extern template struct block2::EffectiveHamiltonian<
     block2::SU2, complex<double>,
     block2::MultiMPS<block2::SU2, complex<double>>>;
 
+// general_mpo.hpp
+extern template struct block2::GeneralMPO<block2::SZ, complex<double>>;
+
 // moving_environment.hpp
 extern template struct block2::MovingEnvironment<block2::SZ, complex<double>,
                                                  complex<double>>;
@@ -820,6 +834,9 @@ extern template struct block2::EffectiveHamiltonian<
     block2::SU2K, complex<double>,
     block2::MultiMPS<block2::SU2K, complex<double>>>;
 
+// general_mpo.hpp
+extern template struct block2::GeneralMPO<block2::SZK, complex<double>>;
+
 // moving_environment.hpp
 extern template struct block2::MovingEnvironment<block2::SZK, complex<double>,
                                                  complex<double>>;
@@ -1007,6 +1024,10 @@ extern template struct block2::EffectiveHamiltonian<
     block2::SGB, complex<double>,
     block2::MultiMPS<block2::SGB, complex<double>>>;
 
+// general_mpo.hpp
+extern template struct block2::GeneralMPO<block2::SGF, complex<double>>;
+extern template struct block2::GeneralMPO<block2::SGB, complex<double>>;
+
 // moving_environment.hpp
 extern template struct block2::MovingEnvironment<block2::SGF, complex<double>,
                                                  complex<double>>;
@@ -66,13 +66,24 @@ template <typename S, typename FL> void run(const map<string, string> &params) {
                                       (size_t)(0.9 * memory), scratch);
     frame_()->use_main_stack = false;
 
+#ifdef _HAS_MPI
+    // all procs read the same input; the MPO is distributed over procs
+    shared_ptr<ParallelCommunicator<S>> para_comm =
+        make_shared<MPICommunicator<S>>();
+#endif
+
     // random scratch file prefix to avoid conflicts
     if (params.count("prefix") != 0 && params.at("prefix") != "auto")
         frame_()->prefix = params.at("prefix");
     else {
         Random::rand_seed(0);
+        int prefix_id = Random::rand_int(0, 0xFFFFFF);
+#ifdef _HAS_MPI
+        // procs share the MPS files, so they must agree on the prefix
+        para_comm->broadcast(&prefix_id, 1, para_comm->root);
+#endif
         stringstream ss;
-        ss << hex << Random::rand_int(0, 0xFFFFFF);
+        ss << hex << prefix_id;
         frame_()->prefix = ss.str();
     }
 
@@ -81,6 +92,11 @@ template <typename S, typename FL> void run(const map<string, string> &params) {
     else
         Random::rand_seed(0);
 
+#ifdef _HAS_MPI
+    shared_ptr<ParallelRule<S, FL>> para_rule =
+        make_shared<ParallelRuleQC<S, FL>>(para_comm);
+#endif
+
     cout << "integer stack memory = " << fixed << setprecision(4)
          << ((frame_()->isize << 2) / 1E9) << " GB" << endl;
     cout << "double  stack memory = " << fixed << setprecision(4)
@@ -164,6 +180,26 @@ template <typename S, typename FL> void run(const map<string, string> &params) {
 
     hamil->opf->seq->mode = SeqTypes::Simple;
 
+    if (params.count("integral_cutoff") != 0) {
+        hamil->screening_cutoff =
+            Parsing::to_double(params.at("integral_cutoff"));
+        cout << "integral screening cutoff = " << scientific
+             << hamil->screening_cutoff
+             << " error bound = " << hamil->screening_error_bound() << endl;
+        cout << fixed;
+    }
+
+#ifdef _HAS_MPI
+    // one copy of integrals and site operators in each node
+    // (MPI-3 shared memory), before anything else is allocated
+    if (params.count("node_share") == 0 ||
+        !!Parsing::to_int(params.at("node_share"))) {
+        hamil->node_share(para_comm);
+        cout << "node shared integrals and site operators .. procs = "
+             << para_comm->node_size() << endl;
+    }
+#endif
+
     if (params.count("seq_type") != 0) {
         if (params.at("seq_type") == "none")
             hamil->opf->seq->mode = SeqTypes::None;
@@ -201,12 +237,15 @@ template <typename S, typename FL> void run(const map<string, string> &params) {
     t.get_time();
 
     shared_ptr<MPO<S, FL>> mpo;
+    // bond dims of the unscreened MPO, for the integral_cutoff report
+    vector<int> unscreened_bdims;
 
     if (params.count("load_mpo") != 0) {
         string fn = params.at("load_mpo");
         mpo = make_shared<MPO<S, FL>>(0);
         cout << "MPO loading start" << endl;
-        mpo->load_data(fn);
+        // for indexed mpo files, per-site data can be loaded on demand
+        mpo->load_data(fn, params.count("lazy_mpo") != 0);
         if (mpo->sparse_form.find('S') == string::npos)
             mpo->tf = make_shared<TensorFunctions<S, FL>>(hamil->opf);
         else
@@ -221,6 +260,22 @@ template <typename S, typename FL> void run(const map<string, string> &params) {
         norb = mpo->n_sites;
 
     } else {
+        // unscreened reference MPO (bond dims only)
+        if (params.count("integral_cutoff") != 0 &&
+            params.count("fused") == 0 && params.count("mrci-fused") == 0) {
+            cout << "MPO unscreened reference start" << endl;
+            auto cutoff = hamil->screening_cutoff;
+            hamil->screening_cutoff = 0;
+            shared_ptr<MPO<S, FL>> ref_mpo = make_shared<SimplifiedMPO<S, FL>>(
+                make_shared<MPOQC<S, FL>>(hamil, qc_type, trans_center),
+                make_shared<RuleQC<S, FL>>(), true);
+            unscreened_bdims = ref_mpo->get_bond_dims();
+            ref_mpo->deallocate();
+            hamil->screening_cutoff = cutoff;
+            cout << "MPO unscreened reference end .. T = " << t.get_time()
+                 << endl;
+        }
+
         // MPO construction
         cout << "MPO start" << endl;
         mpo = make_shared<MPOQC<S, FL>>(hamil, qc_type, trans_center);
@@ -328,7 +383,11 @@ template <typename S, typename FL> void run(const map<string, string> &params) {
     if (params.count("save_mpo") != 0) {
         string fn = params.at("save_mpo");
         cout << "MPO saving start" << endl;
-        mpo->save_data(fn);
+        // indexed_mpo: per-site data can be loaded on demand (see lazy_mpo)
+        if (params.count("indexed_mpo") != 0)
+            mpo->save_data_indexed(fn);
+        else
+            mpo->save_data(fn);
         cout << "MPO saving end .. T = " << t.get_time() << endl;
     }
 
@@ -342,6 +401,24 @@ template <typename S, typename FL> void run(const map<string, string> &params) {
         cout << endl;
     }
 
+    if (params.count("integral_cutoff") != 0 &&
+        params.count("load_mpo") == 0) {
+        vector<int> bdims = mpo->get_bond_dims();
+        if (unscreened_bdims.size() != 0)
+            cout << "MPO bond dim (unscreened -> screened) max = "
+                 << *max_element(unscreened_bdims.begin(),
+                                 unscreened_bdims.end())
+                 << " -> " << *max_element(bdims.begin(), bdims.end())
+                 << " total = "
+                 << accumulate(unscreened_bdims.begin(),
+                               unscreened_bdims.end(), 0)
+                 << " -> " << accumulate(bdims.begin(), bdims.end(), 0)
+                 << endl;
+        else
+            cout << "MPO max bond dim = "
+                 << *max_element(bdims.begin(), bdims.end()) << endl;
+    }
+
     if (params.count("print_mpo_dims") != 0) {
         cout << "left mpo dims = ";
         for (int i = 0; i < norb; i++)
@@ -353,6 +430,11 @@ template <typename S, typename FL> void run(const map<string, string> &params) {
         cout << endl;
     }
 
+#ifdef _HAS_MPI
+    // MPO parallelization
+    mpo = make_shared<ParallelMPO<S, FL>>(mpo, para_rule);
+#endif
+
     vector<ubond_t> bdims = {
         250, 250, 250,
         250, 250, (ubond_t)min(500U, (uint32_t)numeric_limits<ubond_t>::max())};
@@ -474,6 +556,10 @@ template <typename S, typename FL> void run(const map<string, string> &params) {
     mps->deallocate();
     mps_info->save_mutable();
     mps_info->deallocate_mutable();
+#ifdef _HAS_MPI
+    // only root writes the MPS; others read it back
+    para_comm->barrier();
+#endif
 
     int iprint = 2;
     if (params.count("iprint") != 0)
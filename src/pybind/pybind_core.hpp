@@ -979,6 +979,9 @@ template <typename S, typename FL> void bind_fl_hamiltonian(py::module &m) {
         .def("get_site_ops", &Hamiltonian<S, FL>::get_site_ops)
         .def("filter_site_ops", &Hamiltonian<S, FL>::filter_site_ops)
         .def("find_site_op_info", &Hamiltonian<S, FL>::find_site_op_info)
+        .def_static("node_share_integrals",
+                    &Hamiltonian<S, FL>::node_share_integrals)
+        .def("node_share", &Hamiltonian<S, FL>::node_share)
         .def("deallocate", &Hamiltonian<S, FL>::deallocate);
 }
 
@@ -999,13 +1002,21 @@ template <typename S> void bind_parallel(py::module &m) {
         .def_readwrite("para_type", &ParallelCommunicator<S>::para_type)
         .def("get_parallel_type", &ParallelCommunicator<S>::get_parallel_type)
         .def("barrier", &ParallelCommunicator<S>::barrier)
-        .def("split", &ParallelCommunicator<S>::split);
+        .def("split", &ParallelCommunicator<S>::split)
+        .def("send_file", &ParallelCommunicator<S>::send_file)
+        .def("node_size", &ParallelCommunicator<S>::node_size)
+        .def("node_rank", &ParallelCommunicator<S>::node_rank);
 
 #ifdef _HAS_MPI
     py::class_<MPICommunicator<S>, shared_ptr<MPICommunicator<S>>,
                ParallelCommunicator<S>>(m, "MPICommunicator")
         .def(py::init<>())
-        .def(py::init<int>());
+        .def(py::init<int>())
+        .def_readwrite("hierarchical", &MPICommunicator<S>::hierarchical)
+        .def_readwrite("hier_chunk_size",
+                       &MPICommunicator<S>::hier_chunk_size)
+        .def_readwrite("fixed_node_size",
+                       &MPICommunicator<S>::fixed_node_size);
 #endif
 
     py::class_<ParallelRule<S>, shared_ptr<ParallelRule<S>>>(m,
@@ -1542,6 +1553,16 @@ template <typename S = void> void bind_io(py::module &m) {
             return make_pair(r.first, idx);
         });
 
+    py::class_<HopcroftKarp, shared_ptr<HopcroftKarp>>(m, "HopcroftKarp")
+        .def(py::init<int, int>())
+        .def_readwrite("nl", &HopcroftKarp::nl)
+        .def_readwrite("nr", &HopcroftKarp::nr)
+        .def_readwrite("match_l", &HopcroftKarp::match_l)
+        .def_readwrite("match_r", &HopcroftKarp::match_r)
+        .def("add_edge", &HopcroftKarp::add_edge)
+        .def("solve", &HopcroftKarp::solve)
+        .def("min_vertex_cover", &HopcroftKarp::min_vertex_cover);
+
     py::class_<Prime, shared_ptr<Prime>>(m, "Prime")
         .def(py::init<>())
         .def_readwrite("primes", &Prime::primes)
@@ -1658,6 +1679,7 @@ template <typename S = void> void bind_io(py::module &m) {
         .def_readwrite("tread", &DataFrame::tread)
         .def_readwrite("twrite", &DataFrame::twrite)
         .def_readwrite("tasync", &DataFrame::tasync)
+        .def_readwrite("tprefetch", &DataFrame::tprefetch)
         .def_readwrite("fpread", &DataFrame::fpread)
         .def_readwrite("fpwrite", &DataFrame::fpwrite)
         .def_readwrite("n_frames", &DataFrame::n_frames)
@@ -1670,11 +1692,23 @@ template <typename S = void> void bind_io(py::module &m) {
         .def_readwrite("use_main_stack", &DataFrame::use_main_stack)
         .def_readwrite("minimal_disk_usage", &DataFrame::minimal_disk_usage)
         .def_readwrite("fp_codec", &DataFrame::fp_codec)
+        .def_readwrite("checkpoint_async", &DataFrame::checkpoint_async)
+        .def_readwrite("tcheckpoint", &DataFrame::tcheckpoint)
+        .def("begin_checkpoint", &DataFrame::begin_checkpoint)
+        .def("copy_checkpoint_file", &DataFrame::copy_checkpoint_file)
+        .def("end_checkpoint", &DataFrame::end_checkpoint, py::arg("dir"),
+             py::arg("commit_files") = vector<string>())
+        .def("wait_checkpoint", &DataFrame::wait_checkpoint)
         .def("update_peak_used_memory", &DataFrame::update_peak_used_memory)
         .def("reset_peak_used_memory", &DataFrame::reset_peak_used_memory)
         .def("activate", &DataFrame::activate)
         .def("load_data", &DataFrame::load_data)
         .def("save_data", &DataFrame::save_data)
+        .def("prefetch_data",
+             [](DataFrame *self, int i, const string &filename) {
+                 self->prefetch_data(i, filename);
+             })
+        .def("reset_prefetch", &DataFrame::reset_prefetch)
         .def("reset", &DataFrame::reset)
         .def("__repr__", [](DataFrame *self) {
             stringstream ss;
@@ -1711,6 +1745,7 @@ template <typename S = void> void bind_io(py::module &m) {
         .def_readwrite("n_threads_mkl", &Threading::n_threads_mkl)
         .def_readwrite("n_threads_global", &Threading::n_threads_global)
         .def_readwrite("n_levels", &Threading::n_levels)
+        .def_readwrite("mkl_block_size", &Threading::mkl_block_size)
         .def("openmp_available", &Threading::openmp_available)
         .def("mkl_available", &Threading::mkl_available)
         .def("tbb_available", &Threading::tbb_available)
@@ -2022,6 +2057,10 @@ template <typename FL> void bind_fl_matrix(py::module &m) {
         .def(py::init<>())
         .def("read", &FCIDUMP<FL>::read)
         .def("write", &FCIDUMP<FL>::write)
+        .def("read_binary", &FCIDUMP<FL>::read_binary, py::arg("filename"),
+             py::arg("use_mmap") = true)
+        .def("write_binary", &FCIDUMP<FL>::write_binary)
+        .def_static("is_binary", &FCIDUMP<FL>::is_binary)
         .def("initialize_h1e",
              [](FCIDUMP<FL> *self, uint16_t n_sites, uint16_t n_elec,
                 uint16_t twos, uint16_t isym, FL e, const py::array_t<FL> &t) {
@@ -2302,6 +2341,38 @@ template <typename FL> void bind_fl_matrix(py::module &m) {
             }
         });
 
+    py::class_<CholeskyFCIDUMP<FL>, shared_ptr<CholeskyFCIDUMP<FL>>,
+               FCIDUMP<FL>>(m, "CholeskyFCIDUMP")
+        .def(py::init<>())
+        .def(py::init<size_t>())
+        .def_readwrite("n_aux", &CholeskyFCIDUMP<FL>::n_aux)
+        .def_readwrite("cache_size", &CholeskyFCIDUMP<FL>::cache_size)
+        .def_readwrite("cd_thresh", &CholeskyFCIDUMP<FL>::cd_thresh)
+        .def("decompose", &CholeskyFCIDUMP<FL>::decompose)
+        .def("init_cache", &CholeskyFCIDUMP<FL>::init_cache)
+        .def("to_fcidump", &CholeskyFCIDUMP<FL>::to_fcidump)
+        .def("initialize_su2",
+             [](CholeskyFCIDUMP<FL> *self, uint16_t n_sites, uint16_t n_elec,
+                uint16_t twos, uint16_t isym, FL e, const py::array_t<FL> &t,
+                const py::array_t<FL> &cd) {
+                 self->initialize_su2(n_sites, n_elec, twos, isym, e, t.data(),
+                                      t.size(), cd.data(), cd.size());
+             })
+        .def("initialize_sz",
+             [](CholeskyFCIDUMP<FL> *self, uint16_t n_sites, uint16_t n_elec,
+                uint16_t twos, uint16_t isym, FL e, const py::tuple &t,
+                const py::tuple &cd) {
+                 assert(t.size() == 2 && cd.size() == 2);
+                 py::array_t<FL> ta = t[0].cast<py::array_t<FL>>();
+                 py::array_t<FL> tb = t[1].cast<py::array_t<FL>>();
+                 py::array_t<FL> cda = cd[0].cast<py::array_t<FL>>();
+                 py::array_t<FL> cdb = cd[1].cast<py::array_t<FL>>();
+                 self->initialize_sz(n_sites, n_elec, twos, isym, e, ta.data(),
+                                     ta.size(), tb.data(), tb.size(),
+                                     cda.data(), cda.size(), cdb.data(),
+                                     cdb.size());
+             });
+
     py::class_<SpinOrbitalFCIDUMP<FL>, shared_ptr<SpinOrbitalFCIDUMP<FL>>,
                FCIDUMP<FL>>(m, "SpinOrbitalFCIDUMP")
         .def(py::init<const shared_ptr<FCIDUMP<FL>> &>())
@@ -68,6 +68,28 @@ PYBIND11_MAKE_OPAQUE(
 PYBIND11_MAKE_OPAQUE(vector<shared_ptr<SparseTensor<SU2, complex<double>>>>);
 #endif
 
+template <typename S, typename FL> void bind_fl_general_mpo(py::module &m) {
+
+    py::class_<GeneralMPO<S, FL>, shared_ptr<GeneralMPO<S, FL>>, MPO<S, FL>>(
+        m, "GeneralMPO")
+        .def_readwrite("algo_type", &GeneralMPO<S, FL>::algo_type)
+        .def_readwrite("cutoff", &GeneralMPO<S, FL>::cutoff)
+        .def(py::init<const shared_ptr<Hamiltonian<S, FL>> &,
+                      const vector<vector<shared_ptr<OpElement<S, FL>>>> &,
+                      const vector<FL> &>())
+        .def(py::init<const shared_ptr<Hamiltonian<S, FL>> &,
+                      const vector<vector<shared_ptr<OpElement<S, FL>>>> &,
+                      const vector<FL> &, MPOAlgorithmTypes>())
+        .def(py::init<const shared_ptr<Hamiltonian<S, FL>> &,
+                      const vector<vector<shared_ptr<OpElement<S, FL>>>> &,
+                      const vector<FL> &, MPOAlgorithmTypes,
+                      typename GeneralMPO<S, FL>::FP>())
+        .def(py::init<const shared_ptr<Hamiltonian<S, FL>> &,
+                      const vector<vector<shared_ptr<OpElement<S, FL>>>> &,
+                      const vector<FL> &, MPOAlgorithmTypes,
+                      typename GeneralMPO<S, FL>::FP, FL>());
+}
+
 template <typename S, typename FL>
 auto bind_fl_spin_specific(py::module &m) -> decltype(typename S::is_su2_t()) {
 
@@ -102,6 +124,8 @@ auto bind_fl_spin_specific(py::module &m) -> decltype(typename S::is_sz_t()) {
         .def(py::init<const shared_ptr<HamiltonianQC<S, FL>> &,
                       const vector<uint16_t> &>(),
              py::arg("hamil"), py::arg("pts"));
+
+    bind_fl_general_mpo<S, FL>(m);
 }
 
 template <typename S, typename FL>
@@ -114,6 +138,8 @@ auto bind_fl_spin_specific(py::module &m) -> decltype(typename S::is_sg_t()) {
         .def_static("get_matrix", &PDM2MPOQC<S, FL>::get_matrix)
         .def_static("get_matrix_spatial",
                     &PDM2MPOQC<S, FL>::get_matrix_spatial);
+
+    bind_fl_general_mpo<S, FL>(m);
 }
 
 template <typename S> void bind_mps(py::module &m) {
@@ -316,9 +342,13 @@ template <typename S, typename FL> void bind_fl_mps(py::module &m) {
         .def("load_data", &MPS<S, FL>::load_data)
         .def("save_data", &MPS<S, FL>::save_data)
         .def("copy_data", &MPS<S, FL>::copy_data)
+        .def("save_checkpoint", &MPS<S, FL>::save_checkpoint)
         .def("load_mutable", &MPS<S, FL>::load_mutable)
         .def("save_mutable", &MPS<S, FL>::save_mutable)
         .def("save_tensor", &MPS<S, FL>::save_tensor)
+        .def("get_tensor_hash", &MPS<S, FL>::get_tensor_hash)
+        .def("invalidate_tensor_hash", &MPS<S, FL>::invalidate_tensor_hash,
+             py::arg("i") = -1)
         .def("load_tensor", &MPS<S, FL>::load_tensor)
         .def("unload_tensor", &MPS<S, FL>::unload_tensor)
         .def("deep_copy", &MPS<S, FL>::deep_copy)
@@ -620,6 +650,14 @@ void bind_fl_moving_environment(py::module &m) {
                        &MovingEnvironment<S, FL, FLS>::fuse_center)
         .def_readwrite("save_partition_info",
                        &MovingEnvironment<S, FL, FLS>::save_partition_info)
+        .def_readwrite("incremental_init",
+                       &MovingEnvironment<S, FL, FLS>::incremental_init)
+        .def_readwrite("n_reused_partitions",
+                       &MovingEnvironment<S, FL, FLS>::n_reused_partitions)
+        .def_readwrite("n_computed_partitions",
+                       &MovingEnvironment<S, FL, FLS>::n_computed_partitions)
+        .def_readwrite("sweep_trace",
+                       &MovingEnvironment<S, FL, FLS>::sweep_trace)
         .def_readwrite("cached_opt", &MovingEnvironment<S, FL, FLS>::cached_opt)
         .def_readwrite("cached_info",
                        &MovingEnvironment<S, FL, FLS>::cached_info)
@@ -684,9 +722,36 @@ void bind_fl_moving_environment(py::module &m) {
         .def("get_right_archive_filename",
              &MovingEnvironment<S, FL, FLS>::get_right_archive_filename)
         .def("get_left_partition_filename",
-             &MovingEnvironment<S, FL, FLS>::get_left_partition_filename)
+             &MovingEnvironment<S, FL, FLS>::get_left_partition_filename,
+             py::arg("i"), py::arg("info") = false, py::arg("dir") = "")
         .def("get_right_partition_filename",
-             &MovingEnvironment<S, FL, FLS>::get_right_partition_filename)
+             &MovingEnvironment<S, FL, FLS>::get_right_partition_filename,
+             py::arg("i"), py::arg("info") = false, py::arg("dir") = "")
+        .def("get_environment_filename",
+             &MovingEnvironment<S, FL, FLS>::get_environment_filename,
+             py::arg("dir") = "")
+        .def("init_partitions", &MovingEnvironment<S, FL, FLS>::init_partitions)
+        .def("save_environments",
+             &MovingEnvironment<S, FL, FLS>::save_environments)
+        .def("load_environments",
+             &MovingEnvironment<S, FL, FLS>::load_environments)
+        .def("get_partition_hash_filename",
+             &MovingEnvironment<S, FL, FLS>::get_partition_hash_filename)
+        .def("load_partition_hash",
+             &MovingEnvironment<S, FL, FLS>::load_partition_hash)
+        .def("get_partition_hash",
+             &MovingEnvironment<S, FL, FLS>::get_partition_hash)
+        .def("reuse_partition", &MovingEnvironment<S, FL, FLS>::reuse_partition)
+        .def("get_partition_manifest",
+             &MovingEnvironment<S, FL, FLS>::get_partition_manifest)
+        .def("get_partition_manifest_filename",
+             &MovingEnvironment<S, FL, FLS>::get_partition_manifest_filename)
+        .def("save_partition_manifest",
+             &MovingEnvironment<S, FL, FLS>::save_partition_manifest)
+        .def("load_partition_manifest",
+             &MovingEnvironment<S, FL, FLS>::load_partition_manifest)
+        .def("migrate_partitions",
+             &MovingEnvironment<S, FL, FLS>::migrate_partitions)
         .def("eff_ham", &MovingEnvironment<S, FL, FLS>::eff_ham,
              py::arg("fuse_type"), py::arg("forward"), py::arg("compute_diag"),
              py::arg("bra_wfn"), py::arg("ket_wfn"))
@@ -868,6 +933,10 @@ template <typename S, typename FL> void bind_fl_qc_hamiltonian(py::module &m) {
             "mu", [](HamiltonianQC<S, FL> *self) { return self->mu; },
             [](HamiltonianQC<S, FL> *self, FL mu) { self->set_mu(mu); })
         .def_readwrite("op_prims", &HamiltonianQC<S, FL>::op_prims)
+        .def_readwrite("screening_cutoff",
+                       &HamiltonianQC<S, FL>::screening_cutoff)
+        .def("screening_error_bound",
+             &HamiltonianQC<S, FL>::screening_error_bound)
         .def("v", &HamiltonianQC<S, FL>::v)
         .def("t", &HamiltonianQC<S, FL>::t)
         .def("e", &HamiltonianQC<S, FL>::e)
@@ -976,6 +1045,36 @@ void bind_fl_dmrg(py::module &m) {
             return ss.str();
         });
 
+    py::class_<DMRGScheduler<S, FLS>, shared_ptr<DMRGScheduler<S, FLS>>>(
+        m, "DMRGScheduler")
+        .def(py::init<ubond_t, ubond_t>())
+        .def(py::init<ubond_t, ubond_t, typename DMRG<S, FL, FLS>::FPS>())
+        .def(py::init<ubond_t, ubond_t, typename DMRG<S, FL, FLS>::FPS,
+                      typename DMRG<S, FL, FLS>::FPS>())
+        .def_readwrite("start_bond_dim", &DMRGScheduler<S, FLS>::start_bond_dim)
+        .def_readwrite("max_bond_dim", &DMRGScheduler<S, FLS>::max_bond_dim)
+        .def_readwrite("target_error", &DMRGScheduler<S, FLS>::target_error)
+        .def_readwrite("start_noise", &DMRGScheduler<S, FLS>::start_noise)
+        .def_readwrite("bond_dim_factor",
+                       &DMRGScheduler<S, FLS>::bond_dim_factor)
+        .def_readwrite("energy_tol", &DMRGScheduler<S, FLS>::energy_tol)
+        .def_readwrite("discarded_weight_tol",
+                       &DMRGScheduler<S, FLS>::discarded_weight_tol)
+        .def_readwrite("quanta_tol", &DMRGScheduler<S, FLS>::quanta_tol)
+        .def_readwrite("min_sweeps", &DMRGScheduler<S, FLS>::min_sweeps)
+        .def_readwrite("max_sweeps", &DMRGScheduler<S, FLS>::max_sweeps)
+        .def_readwrite("n_extrap", &DMRGScheduler<S, FLS>::n_extrap)
+        .def_readwrite("iprint", &DMRGScheduler<S, FLS>::iprint)
+        .def_readwrite("bond_dim", &DMRGScheduler<S, FLS>::bond_dim)
+        .def_readwrite("noise", &DMRGScheduler<S, FLS>::noise)
+        .def_readwrite("davidson_conv_thrd",
+                       &DMRGScheduler<S, FLS>::davidson_conv_thrd)
+        .def_readwrite("stage_points", &DMRGScheduler<S, FLS>::stage_points)
+        .def_readwrite("extrap_energy", &DMRGScheduler<S, FLS>::extrap_energy)
+        .def_readwrite("extrap_error", &DMRGScheduler<S, FLS>::extrap_error)
+        .def("initialize", &DMRGScheduler<S, FLS>::initialize)
+        .def("update", &DMRGScheduler<S, FLS>::update);
+
     py::class_<DMRG<S, FL, FLS>, shared_ptr<DMRG<S, FL, FLS>>>(m, "DMRG")
         .def(py::init<const shared_ptr<MovingEnvironment<S, FL, FLS>> &,
                       const vector<ubond_t> &,
@@ -997,6 +1096,23 @@ void bind_fl_dmrg(py::module &m) {
                        &DMRG<S, FL, FLS>::davidson_soft_max_iter)
         .def_readwrite("davidson_shift", &DMRG<S, FL, FLS>::davidson_shift)
         .def_readwrite("davidson_type", &DMRG<S, FL, FLS>::davidson_type)
+        .def_readwrite("davidson_adaptive",
+                       &DMRG<S, FL, FLS>::davidson_adaptive)
+        .def_readwrite("davidson_adaptive_dw_factor",
+                       &DMRG<S, FL, FLS>::davidson_adaptive_dw_factor)
+        .def_readwrite("davidson_adaptive_de_factor",
+                       &DMRG<S, FL, FLS>::davidson_adaptive_de_factor)
+        .def_readwrite("davidson_adaptive_max_thrd",
+                       &DMRG<S, FL, FLS>::davidson_adaptive_max_thrd)
+        .def_readwrite("davidson_iters", &DMRG<S, FL, FLS>::davidson_iters)
+        .def_readwrite("davidson_matvecs", &DMRG<S, FL, FLS>::davidson_matvecs)
+        .def_readwrite("davidson_adaptive_iter_factor",
+                       &DMRG<S, FL, FLS>::davidson_adaptive_iter_factor)
+        .def_readwrite("davidson_adaptive_min_iter",
+                       &DMRG<S, FL, FLS>::davidson_adaptive_min_iter)
+        .def_readwrite("davidson_est_saved_iters",
+                       &DMRG<S, FL, FLS>::davidson_est_saved_iters)
+        .def_readwrite("scheduler", &DMRG<S, FL, FLS>::scheduler)
         .def_readwrite("conn_adjust_step", &DMRG<S, FL, FLS>::conn_adjust_step)
         .def_readwrite("energies", &DMRG<S, FL, FLS>::energies)
         .def_readwrite("discarded_weights",
@@ -1010,6 +1126,18 @@ void bind_fl_dmrg(py::module &m) {
         .def_readwrite("noise_type", &DMRG<S, FL, FLS>::noise_type)
         .def_readwrite("trunc_type", &DMRG<S, FL, FLS>::trunc_type)
         .def_readwrite("decomp_type", &DMRG<S, FL, FLS>::decomp_type)
+        .def_readwrite("rsvd_oversampling",
+                       &DMRG<S, FL, FLS>::rsvd_oversampling)
+        .def_readwrite("rsvd_eps", &DMRG<S, FL, FLS>::rsvd_eps)
+        .def_readwrite("rsvd_blocks", &DMRG<S, FL, FLS>::rsvd_blocks)
+        .def_readwrite("trunc_dw_target", &DMRG<S, FL, FLS>::trunc_dw_target)
+        .def_readwrite("zero_dot_update", &DMRG<S, FL, FLS>::zero_dot_update)
+        .def_readwrite("checkpoint_dir", &DMRG<S, FL, FLS>::checkpoint_dir)
+        .def_readwrite("checkpoint_site_interval",
+                       &DMRG<S, FL, FLS>::checkpoint_site_interval)
+        .def_readwrite("checkpoint_time_interval",
+                       &DMRG<S, FL, FLS>::checkpoint_time_interval)
+        .def_readwrite("resume_sweep", &DMRG<S, FL, FLS>::resume_sweep)
         .def_readwrite("decomp_last_site", &DMRG<S, FL, FLS>::decomp_last_site)
         .def_readwrite("sweep_cumulative_nflop",
                        &DMRG<S, FL, FLS>::sweep_cumulative_nflop)
@@ -1034,6 +1162,15 @@ void bind_fl_dmrg(py::module &m) {
         .def("connection_sweep", &DMRG<S, FL, FLS>::connection_sweep)
         .def("unordered_sweep", &DMRG<S, FL, FLS>::unordered_sweep)
         .def("sweep", &DMRG<S, FL, FLS>::sweep)
+        .def("get_checkpoint_filename",
+             &DMRG<S, FL, FLS>::get_checkpoint_filename)
+        .def("save_sweep_checkpoint", &DMRG<S, FL, FLS>::save_sweep_checkpoint)
+        .def("load_sweep_checkpoint",
+             [](DMRG<S, FL, FLS> *self) {
+                 bool forward = true;
+                 bool r = self->load_sweep_checkpoint(forward);
+                 return make_pair(r, forward);
+             })
         .def("solve", &DMRG<S, FL, FLS>::solve, py::arg("n_sweeps"),
              py::arg("forward") = true, py::arg("tol") = 1E-6);
 }
@@ -1307,6 +1444,7 @@ template <typename S, typename FL> void bind_fl_parallel_dmrg(py::module &m) {
     py::class_<ParallelRuleSumMPO<S, FL>, shared_ptr<ParallelRuleSumMPO<S, FL>>,
                ParallelRule<S, FL>>(m, "ParallelRuleSumMPO")
         .def_readwrite("n_sites", &ParallelRuleSumMPO<S, FL>::n_sites)
+        .def("index_owner", &ParallelRuleSumMPO<S, FL>::index_owner)
         .def(py::init<const shared_ptr<ParallelCommunicator<S>> &>())
         .def(py::init<const shared_ptr<ParallelCommunicator<S>> &,
                       ParallelCommTypes>())
@@ -1341,7 +1479,14 @@ template <typename S, typename FL> void bind_fl_parallel_dmrg(py::module &m) {
     py::class_<ParallelFCIDUMP<S, FL>, shared_ptr<ParallelFCIDUMP<S, FL>>,
                FCIDUMP<FL>>(m, "ParallelFCIDUMP")
         .def_readwrite("rule", &ParallelFCIDUMP<S, FL>::rule)
-        .def(py::init<const shared_ptr<ParallelRuleSumMPO<S, FL>> &>());
+        .def_readwrite("distributed", &ParallelFCIDUMP<S, FL>::distributed)
+        .def(py::init<const shared_ptr<ParallelRuleSumMPO<S, FL>> &>())
+        .def("read_distributed", &ParallelFCIDUMP<S, FL>::read_distributed,
+             py::arg("filename"))
+        .def("to_fcidump", &ParallelFCIDUMP<S, FL>::to_fcidump,
+             py::arg("root") = -1)
+        .def("distribute", &ParallelFCIDUMP<S, FL>::distribute,
+             py::arg("fd"));
 
     py::class_<ParallelRuleQC<S, FL>, shared_ptr<ParallelRuleQC<S, FL>>,
                ParallelRule<S, FL>>(m, "ParallelRuleQC")
@@ -1421,6 +1566,30 @@ template <typename S> void bind_mpo(py::module &m) {
         .def("get_transform_formulas", &MPOSchemer<S>::get_transform_formulas);
 }
 
+template <typename S, typename FL>
+auto make_mpo_qc(const shared_ptr<HamiltonianQC<S, FL>> &hamil, QCTypes mode,
+                 int trans_center, const string &tensor_archive)
+    -> decltype(typename S::is_su2_t(), shared_ptr<MPOQC<S, FL>>()) {
+    return make_shared<MPOQC<S, FL>>(hamil, mode, trans_center,
+                                     tensor_archive);
+}
+
+template <typename S, typename FL>
+auto make_mpo_qc(const shared_ptr<HamiltonianQC<S, FL>> &hamil, QCTypes mode,
+                 int trans_center, const string &tensor_archive)
+    -> decltype(typename S::is_sz_t(), shared_ptr<MPOQC<S, FL>>()) {
+    return make_shared<MPOQC<S, FL>>(hamil, mode, trans_center, true,
+                                     tensor_archive);
+}
+
+template <typename S, typename FL>
+auto make_mpo_qc(const shared_ptr<HamiltonianQC<S, FL>> &hamil, QCTypes mode,
+                 int trans_center, const string &tensor_archive)
+    -> decltype(typename S::is_sg_t(), shared_ptr<MPOQC<S, FL>>()) {
+    return make_shared<MPOQC<S, FL>>(hamil, mode, trans_center, true,
+                                     tensor_archive);
+}
+
 template <typename S, typename FL> void bind_fl_mpo(py::module &m) {
 
     py::class_<MPO<S, FL>, shared_ptr<MPO<S, FL>>>(m, "MPO")
@@ -1449,6 +1618,12 @@ template <typename S, typename FL> void bind_fl_mpo(py::module &m) {
         .def_readwrite("archive_schemer_mark",
                        &MPO<S, FL>::archive_schemer_mark)
         .def_readwrite("archive_filename", &MPO<S, FL>::archive_filename)
+        .def_readwrite("archive_ops_only", &MPO<S, FL>::archive_ops_only)
+        .def("load_tensor", &MPO<S, FL>::load_tensor)
+        .def("unload_tensor", &MPO<S, FL>::unload_tensor)
+        .def("init_tensor_archive", &MPO<S, FL>::init_tensor_archive)
+        .def("archive_tensor", &MPO<S, FL>::archive_tensor)
+        .def("check_tensor_archive", &MPO<S, FL>::check_tensor_archive)
         .def("reduce_data", &MPO<S, FL>::reduce_data)
         .def("load_data",
              (void (MPO<S, FL>::*)(const string &, bool)) &
@@ -1456,6 +1631,10 @@ template <typename S, typename FL> void bind_fl_mpo(py::module &m) {
              py::arg("filename"), py::arg("minimal") = false)
         .def("save_data", (void (MPO<S, FL>::*)(const string &) const) &
                               MPO<S, FL>::save_data)
+        .def("save_data_indexed",
+             (void (MPO<S, FL>::*)(const string &) const) &
+                 MPO<S, FL>::save_data_indexed)
+        .def("get_bond_dims", &MPO<S, FL>::get_bond_dims)
         .def("get_blocking_formulas", &MPO<S, FL>::get_blocking_formulas)
         .def("get_ancilla_type", &MPO<S, FL>::get_ancilla_type)
         .def("get_parallel_type", &MPO<S, FL>::get_parallel_type)
@@ -1548,7 +1727,15 @@ template <typename S, typename FL> void bind_fl_mpo(py::module &m) {
         .def(py::init<const shared_ptr<HamiltonianQC<S, FL>> &>())
         .def(py::init<const shared_ptr<HamiltonianQC<S, FL>> &, QCTypes>())
         .def(
-            py::init<const shared_ptr<HamiltonianQC<S, FL>> &, QCTypes, int>());
+            py::init<const shared_ptr<HamiltonianQC<S, FL>> &, QCTypes, int>())
+        .def(py::init([](const shared_ptr<HamiltonianQC<S, FL>> &hamil,
+                         QCTypes mode, int trans_center,
+                         const string &tensor_archive) {
+                 return make_mpo_qc<S, FL>(hamil, mode, trans_center,
+                                           tensor_archive);
+             }),
+             py::arg("hamil"), py::arg("mode"), py::arg("trans_center"),
+             py::arg("tensor_archive"));
 
     py::class_<PDM1MPOQC<S, FL>, shared_ptr<PDM1MPOQC<S, FL>>, MPO<S, FL>>(
         m, "PDM1MPOQC")
@@ -1642,7 +1829,8 @@ template <typename S = void> void bind_dmrg_types(py::module &m) {
     py::enum_<DecompositionTypes>(m, "DecompositionTypes", py::arithmetic())
         .value("DensityMatrix", DecompositionTypes::DensityMatrix)
         .value("SVD", DecompositionTypes::SVD)
-        .value("PureSVD", DecompositionTypes::PureSVD);
+        .value("PureSVD", DecompositionTypes::PureSVD)
+        .value("RandomizedSVD", DecompositionTypes::RandomizedSVD);
 
     py::enum_<SymTypes>(m, "SymTypes", py::arithmetic())
         .value("RVec", SymTypes::RVec)
@@ -1703,6 +1891,10 @@ template <typename S = void> void bind_dmrg_types(py::module &m) {
         .value("NCCN", QCTypes(QCTypes::NC | QCTypes::CN))
         .value("Conventional", QCTypes::Conventional);
 
+    py::enum_<MPOAlgorithmTypes>(m, "MPOAlgorithmTypes", py::arithmetic())
+        .value("Bipartite", MPOAlgorithmTypes::Bipartite)
+        .value("SVD", MPOAlgorithmTypes::SVD);
+
     py::enum_<EquationTypes>(m, "EquationTypes", py::arithmetic())
         .value("Normal", EquationTypes::Normal)
         .value("PerturbativeCompression",
@@ -1732,6 +1924,22 @@ template <typename S = void> void bind_dmrg_types(py::module &m) {
         .value("Right", OpCachingTypes::Right)
         .value("LeftCopy", OpCachingTypes::LeftCopy)
         .value("RightCopy", OpCachingTypes::RightCopy);
+
+    py::class_<SweepTrace, shared_ptr<SweepTrace>>(m, "SweepTrace")
+        .def(py::init<>())
+        .def_readwrite("trace_filename", &SweepTrace::trace_filename)
+        .def_property_readonly(
+            "n_tasks", [](SweepTrace *self) { return self->tasks.size(); })
+        .def("wait_all", &SweepTrace::wait_all)
+        .def("clear", &SweepTrace::clear)
+        .def("critical_path", &SweepTrace::critical_path)
+        .def("total_time", &SweepTrace::total_time)
+        .def("save_trace", &SweepTrace::save_trace)
+        .def("__repr__", [](SweepTrace *self) {
+            stringstream ss;
+            ss << *self;
+            return ss.str();
+        });
 }
 
 template <typename S = void> void bind_dmrg_io(py::module &m) {
@@ -244,6 +244,25 @@ TYPED_TEST(TestDMRGN2STO3G, TestSU2) {
                                   DecompositionTypes::SVD,
                                   NoiseTypes::ReducedPerturbative);
 
+    // one copy of integrals and site operators in each node
+#ifdef _HAS_MPI
+    shared_ptr<ParallelCommunicator<SU2>> node_comm =
+        make_shared<MPICommunicator<SU2>>();
+#else
+    shared_ptr<ParallelCommunicator<SU2>> node_comm =
+        make_shared<ParallelCommunicator<SU2>>(1, 0, 0);
+#endif
+    hamil->node_share(node_comm);
+    EXPECT_EQ(hamil->site_ops_shm != nullptr, node_comm->node_size() > 1);
+    EXPECT_EQ(fcidump->vdata == nullptr, node_comm->node_size() > 1);
+
+    targets.resize(1);
+    energies.resize(1);
+
+    this->template test_dmrg<SU2>(targets, energies, hamil, "SU2 NODE SHARED",
+                                  DecompositionTypes::DensityMatrix,
+                                  NoiseTypes::DensityMatrix);
+
     hamil->deallocate();
     fcidump->deallocate();
 }
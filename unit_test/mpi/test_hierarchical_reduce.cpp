@@ -0,0 +1,91 @@
+
+#include "block2_core.hpp"
+#include <gtest/gtest.h>
+
+using namespace block2;
+
+// suppress googletest output for non-root mpi procs
+struct MPITest {
+    shared_ptr<testing::TestEventListener> tel;
+    testing::TestEventListener *def_tel;
+    MPITest() {
+        if (block2::MPI::rank() != 0) {
+            testing::TestEventListeners &tels =
+                testing::UnitTest::GetInstance()->listeners();
+            def_tel = tels.Release(tels.default_result_printer());
+            tel = make_shared<testing::EmptyTestEventListener>();
+            tels.Append(tel.get());
+        }
+    }
+    ~MPITest() {
+        if (block2::MPI::rank() != 0) {
+            testing::TestEventListeners &tels =
+                testing::UnitTest::GetInstance()->listeners();
+            assert(tel.get() == tels.Release(tel.get()));
+            tel = nullptr;
+            tels.Append(def_tel);
+        }
+    }
+    static bool okay() {
+        static MPITest _mpi_test;
+        return _mpi_test.tel != nullptr;
+    }
+};
+
+class TestHierarchicalReduce : public ::testing::Test {
+    static bool _mpi;
+
+  protected:
+    size_t isize = 1L << 20;
+    size_t dsize = 1L << 24;
+    void SetUp() override {
+        Random::rand_seed(0);
+        frame_() = make_shared<DataFrame>(isize, dsize, "nodex");
+    }
+    void TearDown() override {
+        frame_()->activate(0);
+        assert(ialloc_()->used == 0 && dalloc_()->used == 0);
+        frame_() = nullptr;
+    }
+};
+
+bool TestHierarchicalReduce::_mpi = MPITest::okay();
+
+// with 3 procs and 2 procs per node, the nodes have different sizes
+TEST_F(TestHierarchicalReduce, TestSum) {
+#ifdef _HAS_MPI
+    for (int node_size : {1, 2, 3}) {
+        shared_ptr<MPICommunicator<SZ>> comm =
+            make_shared<MPICommunicator<SZ>>();
+        comm->hierarchical = true;
+        comm->fixed_node_size = node_size;
+        // small chunks to test the intra-node steps
+        comm->hier_chunk_size = 7;
+        const int n = 23, nproc = comm->size;
+        vector<double> a(n), b(n), c(n), ref(n);
+        vector<complex<double>> z(n), zref(n);
+        for (int i = 0; i < n; i++) {
+            a[i] = b[i] = c[i] = i + 100.0 * comm->rank;
+            z[i] = complex<double>(i, comm->rank);
+            ref[i] = nproc * i + 100.0 * nproc * (nproc - 1) / 2;
+            zref[i] = complex<double>(nproc * i, nproc * (nproc - 1) / 2);
+        }
+        comm->allreduce_sum(a.data(), n);
+        comm->allreduce_sum(z.data(), n);
+        comm->reduce_sum(b.data(), n, nproc - 1);
+        comm->ireduce_sum(c.data(), n, 0);
+        comm->waitall();
+        EXPECT_EQ(comm->max_node_size, min(node_size, nproc));
+        EXPECT_LE(comm->node_size(), node_size);
+        for (int i = 0; i < n; i++) {
+            EXPECT_EQ(a[i], ref[i]);
+            EXPECT_EQ(z[i], zref[i]);
+            if (comm->rank == nproc - 1)
+                EXPECT_EQ(b[i], ref[i]);
+            if (comm->rank == 0)
+                EXPECT_EQ(c[i], ref[i]);
+        }
+        EXPECT_GE(comm->tcomm, 0.0);
+    }
+#endif
+}
@@ -253,3 +253,141 @@ TEST_F(TestSumMPON2STO3G, TestSZ) {
     hamil->deallocate();
     fcidump->deallocate();
 }
+
+// integrals in distributed storage are the same as from FCIDUMP::read
+TEST_F(TestSumMPON2STO3G, TestReadDistributed) {
+
+#ifdef _HAS_MPI
+    shared_ptr<ParallelCommunicator<SZ>> para_comm =
+        make_shared<MPICommunicator<SZ>>();
+#else
+    shared_ptr<ParallelCommunicator<SZ>> para_comm =
+        make_shared<ParallelCommunicator<SZ>>(1, 0, 0);
+#endif
+    shared_ptr<ParallelRuleSumMPO<SZ, double>> para_rule =
+        make_shared<ParallelRuleSumMPO<SZ, double>>(para_comm);
+
+    string filename = "data/N2.STO3G.FCIDUMP";
+    shared_ptr<FCIDUMP<double>> fcidump = make_shared<FCIDUMP<double>>();
+    fcidump->read(filename);
+    shared_ptr<ParallelFCIDUMP<SZ, double>> pfcidump =
+        make_shared<ParallelFCIDUMP<SZ, double>>(para_rule);
+    pfcidump->read_distributed(filename);
+    EXPECT_TRUE(pfcidump->distributed);
+    EXPECT_EQ(pfcidump->e(), fcidump->e());
+    EXPECT_EQ(pfcidump->n_elec(), fcidump->n_elec());
+
+    const int n = fcidump->n_sites();
+    // elements starting with sites owned by other procs are zero
+    auto check = [&para_rule, &pfcidump, n](const FCIDUMP<double> &ref) {
+        for (int i = 0; i < n; i++) {
+            const bool avail = para_rule->index_available(i);
+            for (int j = 0; j < n; j++) {
+                EXPECT_EQ(pfcidump->t(i, j), avail ? ref.t(i, j) : 0.0);
+                for (int k = 0; k < n; k++)
+                    for (int l = 0; l < n; l++)
+                        EXPECT_EQ(pfcidump->v(i, j, k, l),
+                                  avail ? ref.v(i, j, k, l) : 0.0);
+            }
+        }
+    };
+    check(*fcidump);
+    shared_ptr<FCIDUMP<double>> full = pfcidump->to_fcidump();
+    EXPECT_EQ(full->total_memory, fcidump->total_memory);
+    EXPECT_TRUE(
+        equal(full->data, full->data + full->total_memory, fcidump->data));
+    full->deallocate();
+    // collected in the root proc only
+    full = pfcidump->to_fcidump(para_comm->root);
+    EXPECT_EQ(full != nullptr, para_comm->rank == para_comm->root);
+    if (full != nullptr) {
+        EXPECT_TRUE(
+            equal(full->data, full->data + full->total_memory, fcidump->data));
+        full->deallocate();
+    }
+
+    // errors are summed over all procs
+    vector<uint8_t> orbsym = fcidump->orb_sym<uint8_t>();
+    orbsym[1] ^= 1;
+    double perr = pfcidump->symmetrize(orbsym);
+    double err = fcidump->symmetrize(orbsym);
+    EXPECT_GT(err, 0.0);
+    EXPECT_LT(abs(perr - err), 1E-12);
+    check(*fcidump);
+
+    vector<uint16_t> ord(n);
+    for (int i = 0; i < n; i++)
+        ord[i] = (uint16_t)((i * 3 + 1) % n);
+    pfcidump->reorder(ord);
+    fcidump->reorder(ord);
+    EXPECT_TRUE(pfcidump->params == fcidump->params);
+    check(*fcidump);
+
+    vector<double> rot_mat((size_t)n * n, 0.0);
+    for (int i = 0; i < n; i++)
+        rot_mat[i * n + i] = 1.0;
+    rot_mat[0] = rot_mat[n + 1] = cos(0.3);
+    rot_mat[1] = -(rot_mat[n] = sin(0.3));
+    pfcidump->rotate(rot_mat);
+    fcidump->rotate(rot_mat);
+    check(*fcidump);
+
+    shared_ptr<FCIDUMP<double>> copy = pfcidump->deep_copy();
+    pfcidump->deallocate();
+    EXPECT_FALSE(pfcidump->distributed);
+    EXPECT_EQ(copy->t(0, 1), para_rule->index_available(0) ? fcidump->t(0, 1)
+                                                           : 0.0);
+
+    // written by the root proc only
+    string out_filename = "nodex/N2.STO3G.PARA.FCIDUMP";
+    if (para_comm->rank == para_comm->root)
+        Parsing::mkdir("nodex");
+    copy->write(out_filename);
+    para_comm->barrier();
+    FCIDUMP<double> rfcidump;
+    rfcidump.read(out_filename);
+    EXPECT_EQ(rfcidump.total_memory, fcidump->total_memory);
+    for (size_t i = 0; i < rfcidump.total_memory; i++)
+        EXPECT_LT(abs(rfcidump.data[i] - fcidump->data[i]), 1E-12);
+    EXPECT_LT(abs(rfcidump.e() - fcidump->e()), 1E-12);
+    rfcidump.deallocate();
+    copy->deallocate();
+    fcidump->deallocate();
+}
+
+TEST_F(TestSumMPON2STO3G, TestSZDistributed) {
+
+#ifdef _HAS_MPI
+    shared_ptr<ParallelCommunicator<SZ>> para_comm =
+        make_shared<MPICommunicator<SZ>>();
+#else
+    shared_ptr<ParallelCommunicator<SZ>> para_comm =
+        make_shared<ParallelCommunicator<SZ>>(1, 0, 0);
+#endif
+    shared_ptr<ParallelRuleSumMPO<SZ, double>> para_rule =
+        make_shared<ParallelRuleSumMPO<SZ, double>>(para_comm);
+
+    shared_ptr<ParallelFCIDUMP<SZ, double>> fcidump =
+        make_shared<ParallelFCIDUMP<SZ, double>>(para_rule);
+    PGTypes pg = PGTypes::D2H;
+    string filename = "data/N2.STO3G.FCIDUMP";
+    fcidump->read_distributed(filename);
+    vector<uint8_t> orbsym = fcidump->orb_sym<uint8_t>();
+    transform(orbsym.begin(), orbsym.end(), orbsym.begin(),
+              PointGroup::swap_pg(pg));
+
+    vector<vector<SZ>> targets = {{SZ(fcidump->n_elec(), 0, 0),
+                                   SZ(fcidump->n_elec(), 2, 0)}};
+    vector<vector<double>> energies = {{-107.654122447525, -107.031449471627}};
+
+    int norb = fcidump->n_sites();
+    shared_ptr<HamiltonianQC<SZ, double>> hamil =
+        make_shared<HamiltonianQC<SZ, double>>(SZ(0), norb, orbsym, fcidump);
+
+    test_dmrg<SZ, double>(targets, energies, hamil, "SZ DISTRIBUTED",
+                          DecompositionTypes::DensityMatrix,
+                          NoiseTypes::DensityMatrix);
+
+    hamil->deallocate();
+    fcidump->deallocate();
+}
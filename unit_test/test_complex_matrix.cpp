@@ -1084,6 +1084,51 @@ TEST_F(TestComplexMatrix, TestSVD) {
     }
 }
 
+TEST_F(TestComplexMatrix, TestRandomizedSVD) {
+    for (int i = 0; i < n_tests; i++) {
+        MKL_INT m = Random::rand_int(60, 200);
+        MKL_INT n = Random::rand_int(60, 200);
+        MKL_INT p = Random::rand_int(1, 20);
+        MKL_INT k = p + Random::rand_int(0, 10);
+        // low rank matrix
+        shared_ptr<ComplexTensor> x =
+            make_shared<ComplexTensor>(vector<MKL_INT>{m, p});
+        shared_ptr<ComplexTensor> y =
+            make_shared<ComplexTensor>(vector<MKL_INT>{p, n});
+        shared_ptr<ComplexTensor> a =
+            make_shared<ComplexTensor>(vector<MKL_INT>{m, n});
+        shared_ptr<ComplexTensor> aa =
+            make_shared<ComplexTensor>(vector<MKL_INT>{m, n});
+        shared_ptr<ComplexTensor> l =
+            make_shared<ComplexTensor>(vector<MKL_INT>{m, k});
+        shared_ptr<Tensor> s = make_shared<Tensor>(vector<MKL_INT>{k});
+        shared_ptr<ComplexTensor> r =
+            make_shared<ComplexTensor>(vector<MKL_INT>{k, n});
+        shared_ptr<ComplexTensor> kk =
+            make_shared<ComplexTensor>(vector<MKL_INT>{k, k});
+        Random::complex_fill<double>(x->data.data(), x->size(), -1.0, 1.0);
+        Random::complex_fill<double>(y->data.data(), y->size(), -1.0, 1.0);
+        ComplexMatrixFunctions::multiply(x->ref(), false, y->ref(), false,
+                                         a->ref(), 1.0, 0.0);
+        ComplexMatrixFunctions::copy(aa->ref(), a->ref());
+        ASSERT_TRUE(ComplexMatrixFunctions::randomized_svd(
+            a->ref(), l->ref(), s->ref().flip_dims(), r->ref(), p, 1E-12));
+        ComplexMatrixFunctions::multiply(l->ref(), 3, l->ref(), false,
+                                         kk->ref(), 1.0, 0.0);
+        ASSERT_TRUE(MatrixFunctions::all_close(kk->ref(), IdentityMatrix(k),
+                                               1E-10, 0.0));
+        ComplexMatrixRef xr(r->data.data(), 1, n);
+        for (MKL_INT i = 0; i < k; i++) {
+            ASSERT_GE((*s)({i}), 0.0);
+            ComplexMatrixFunctions::iscale(xr.shift_ptr(i * n), (*s)({i}));
+        }
+        ComplexMatrixFunctions::multiply(l->ref(), false, r->ref(), false,
+                                         a->ref(), 1.0, 0.0);
+        ASSERT_TRUE(
+            MatrixFunctions::all_close(aa->ref(), a->ref(), 1E-10, 0.0));
+    }
+}
+
 TEST_F(TestComplexMatrix, TestQR) {
     for (int i = 0; i < n_tests; i++) {
         MKL_INT m = Random::rand_int(1, 200);
@@ -15,7 +15,8 @@ template <typename FL> class TestOneSiteDMRGN2STO3G : public ::testing::Test {
     void test_dmrg(const vector<vector<S>> &targets,
                    const vector<vector<FL>> &energies,
                    const shared_ptr<HamiltonianQC<S, FL>> &hamil,
-                   const string &name, DecompositionTypes dt, NoiseTypes nt);
+                   const string &name, DecompositionTypes dt, NoiseTypes nt,
+                   bool zero_dot = false);
     void SetUp() override {
         cout << "BOND INTEGER SIZE = " << sizeof(ubond_t) << endl;
         Random::rand_seed(0);
@@ -39,7 +40,7 @@ template <typename S>
 void TestOneSiteDMRGN2STO3G<FL>::test_dmrg(
     const vector<vector<S>> &targets, const vector<vector<FL>> &energies,
     const shared_ptr<HamiltonianQC<S, FL>> &hamil, const string &name,
-    DecompositionTypes dt, NoiseTypes nt) {
+    DecompositionTypes dt, NoiseTypes nt, bool zero_dot) {
     Timer t;
     t.get_time();
     // MPO construction
@@ -98,6 +99,7 @@ void TestOneSiteDMRGN2STO3G<FL>::test_dmrg(
             dmrg->iprint = 0;
             dmrg->decomp_type = dt;
             dmrg->noise_type = nt;
+            dmrg->zero_dot_update = zero_dot;
             dmrg->davidson_soft_max_iter = 4000;
             FL energy = dmrg->solve(10, mps->center == 0, 1E-8);
 
@@ -191,6 +193,12 @@ TYPED_TEST(TestOneSiteDMRGN2STO3G, TestSU2) {
     this->template test_dmrg<SU2>(targets, energies, hamil, "SU2 SVD RED PERT",
                                   DecompositionTypes::SVD,
                                   NoiseTypes::ReducedPerturbative);
+    this->template test_dmrg<SU2>(targets, energies, hamil, "SU2 PERT ZERO DOT",
+                                  DecompositionTypes::DensityMatrix,
+                                  NoiseTypes::ReducedPerturbative, true);
+    this->template test_dmrg<SU2>(targets, energies, hamil, "SU2 SVD ZERO DOT",
+                                  DecompositionTypes::SVD,
+                                  NoiseTypes::Wavefunction, true);
 
     hamil->deallocate();
     fcidump->deallocate();
@@ -263,6 +271,12 @@ TYPED_TEST(TestOneSiteDMRGN2STO3G, TestSZ) {
     this->template test_dmrg<SZ>(targets, energies, hamil, "SZ SVD RED PERT",
                                  DecompositionTypes::SVD,
                                  NoiseTypes::ReducedPerturbative);
+    this->template test_dmrg<SZ>(targets, energies, hamil, "SZ PERT ZERO DOT",
+                                 DecompositionTypes::DensityMatrix,
+                                 NoiseTypes::ReducedPerturbative, true);
+    this->template test_dmrg<SZ>(targets, energies, hamil, "SZ SVD ZERO DOT",
+                                 DecompositionTypes::SVD,
+                                 NoiseTypes::Wavefunction, true);
 
     hamil->deallocate();
     fcidump->deallocate();
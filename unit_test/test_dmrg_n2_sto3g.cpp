@@ -16,6 +16,8 @@ template <typename FL> class TestDMRGN2STO3G : public ::testing::Test {
                    const vector<vector<FL>> &energies,
                    const shared_ptr<HamiltonianQC<S, FL>> &hamil,
                    const string &name, DecompositionTypes dt, NoiseTypes nt);
+    template <typename S>
+    vector<int> mpo_bond_dims(const shared_ptr<HamiltonianQC<S, FL>> &hamil);
     void SetUp() override {
         cout << "BOND INTEGER SIZE = " << sizeof(ubond_t) << endl;
         Random::rand_seed(0);
@@ -125,6 +127,19 @@ void TestDMRGN2STO3G<FL>::test_dmrg(
     mpo->deallocate();
 }
 
+template <typename FL>
+template <typename S>
+vector<int> TestDMRGN2STO3G<FL>::mpo_bond_dims(
+    const shared_ptr<HamiltonianQC<S, FL>> &hamil) {
+    shared_ptr<MPO<S, FL>> mpo =
+        make_shared<MPOQC<S, FL>>(hamil, QCTypes::Conventional);
+    mpo = make_shared<SimplifiedMPO<S, FL>>(
+        mpo, make_shared<RuleQC<S, FL>>(), true);
+    vector<int> r = mpo->get_bond_dims();
+    mpo->deallocate();
+    return r;
+}
+
 #ifdef _USE_COMPLEX
 typedef ::testing::Types<complex<double>, double> TestFL;
 #else
@@ -180,6 +195,9 @@ TYPED_TEST(TestDMRGN2STO3G, TestSU2) {
     this->template test_dmrg<SU2>(targets, energies, hamil, "SU2 PURE SVD",
                                   DecompositionTypes::PureSVD,
                                   NoiseTypes::Wavefunction);
+    this->template test_dmrg<SU2>(targets, energies, hamil, "SU2 RAND SVD",
+                                  DecompositionTypes::RandomizedSVD,
+                                  NoiseTypes::Wavefunction);
     this->template test_dmrg<SU2>(targets, energies, hamil, "SU2 PERT",
                                   DecompositionTypes::DensityMatrix,
                                   NoiseTypes::Perturbative);
@@ -258,6 +276,9 @@ TYPED_TEST(TestDMRGN2STO3G, TestSZ) {
     this->template test_dmrg<SZ>(targets, energies, hamil, "SZ PURE SVD",
                                  DecompositionTypes::PureSVD,
                                  NoiseTypes::Wavefunction);
+    this->template test_dmrg<SZ>(targets, energies, hamil, "SZ RAND SVD",
+                                 DecompositionTypes::RandomizedSVD,
+                                 NoiseTypes::Wavefunction);
     this->template test_dmrg<SZ>(targets, energies, hamil, "SZ PERT",
                                  DecompositionTypes::DensityMatrix,
                                  NoiseTypes::Perturbative);
@@ -281,6 +302,139 @@ TYPED_TEST(TestDMRGN2STO3G, TestSZ) {
     fcidump->deallocate();
 }
 
+// two-electron integrals from the Cholesky decomposition of the FCIDUMP
+TYPED_TEST(TestDMRGN2STO3G, TestCholesky) {
+    using FL = TypeParam;
+
+    shared_ptr<CholeskyFCIDUMP<FL>> fcidump =
+        make_shared<CholeskyFCIDUMP<FL>>();
+    PGTypes pg = PGTypes::D2H;
+    string filename = "data/N2.STO3G.FCIDUMP";
+    fcidump->read(filename);
+    const int norb = fcidump->n_sites();
+    EXPECT_GT(fcidump->n_aux, 0);
+    EXPECT_LT(fcidump->n_aux, norb * norb);
+    vector<uint8_t> orbsym = fcidump->template orb_sym<uint8_t>();
+    transform(orbsym.begin(), orbsym.end(), orbsym.begin(),
+              PointGroup::swap_pg(pg));
+
+    // same energies as with the full two-electron integrals
+    vector<vector<FL>> energies = {{-107.654122447525, -106.939132859668}};
+    vector<vector<SU2>> su2_targets = {
+        {SU2(fcidump->n_elec(), 0, 0), SU2(fcidump->n_elec(), 2, 0)}};
+    shared_ptr<HamiltonianQC<SU2, FL>> su2_hamil =
+        make_shared<HamiltonianQC<SU2, FL>>(SU2(0), norb, orbsym, fcidump);
+    this->template test_dmrg<SU2>(su2_targets, energies, su2_hamil,
+                                  "SU2 CHOLESKY",
+                                  DecompositionTypes::DensityMatrix,
+                                  NoiseTypes::DensityMatrix);
+    su2_hamil->deallocate();
+
+    energies = {{-107.654122447525, -107.031449471627}};
+    vector<vector<SZ>> sz_targets = {
+        {SZ(fcidump->n_elec(), 0, 0), SZ(fcidump->n_elec(), 2, 0)}};
+    shared_ptr<HamiltonianQC<SZ, FL>> sz_hamil =
+        make_shared<HamiltonianQC<SZ, FL>>(SZ(0), norb, orbsym, fcidump);
+    this->template test_dmrg<SZ>(sz_targets, energies, sz_hamil,
+                                 "SZ CHOLESKY",
+                                 DecompositionTypes::DensityMatrix,
+                                 NoiseTypes::DensityMatrix);
+    sz_hamil->deallocate();
+    fcidump->deallocate();
+}
+
+// integrals below the cutoff are dropped from the MPO
+TYPED_TEST(TestDMRGN2STO3G, TestScreening) {
+    using FL = TypeParam;
+    typedef typename GMatrix<FL>::FP FP;
+
+    shared_ptr<FCIDUMP<FL>> fcidump = make_shared<FCIDUMP<FL>>();
+    PGTypes pg = PGTypes::D2H;
+    string filename = "data/N2.STO3G.FCIDUMP";
+    fcidump->read(filename);
+    const int norb = fcidump->n_sites();
+    vector<uint8_t> orbsym = fcidump->template orb_sym<uint8_t>();
+    transform(orbsym.begin(), orbsym.end(), orbsym.begin(),
+              PointGroup::swap_pg(pg));
+
+    // all integrals of N2/STO-3G are either zero by symmetry or above 1E-4,
+    // so a large cutoff is needed to remove any operator
+    shared_ptr<HamiltonianQC<SU2, FL>> hamil =
+        make_shared<HamiltonianQC<SU2, FL>>(SU2(0), norb, orbsym, fcidump);
+    vector<int> ref_bdims = this->template mpo_bond_dims<SU2>(hamil);
+    hamil->screening_cutoff = 1E-8;
+    EXPECT_LT(hamil->screening_error_bound(), (FP)1E-10);
+    EXPECT_TRUE(this->template mpo_bond_dims<SU2>(hamil) == ref_bdims);
+    hamil->screening_cutoff = 1E-2;
+    EXPECT_GT(hamil->screening_error_bound(), (FP)1E-2);
+    vector<int> bdims = this->template mpo_bond_dims<SU2>(hamil);
+    int ref_total = 0, total = 0;
+    for (size_t i = 0; i < bdims.size(); i++) {
+        EXPECT_LE(bdims[i], ref_bdims[i]);
+        ref_total += ref_bdims[i], total += bdims[i];
+    }
+    EXPECT_LT(total, ref_total);
+    hamil->deallocate();
+
+    // without point group symmetry, the integrals zero by symmetry are
+    // replaced by noise below 1E-10, which only screening can remove
+    for (int i = 0; i < norb; i++)
+        for (int j = 0; j <= i; j++)
+            for (int k = 0; k < norb; k++)
+                for (int l = 0; l <= k; l++) {
+                    if (fcidump->v(i, j, k, l) != (FL)0.0)
+                        continue;
+                    const int ij = i * norb + j, kl = k * norb + l;
+                    const int key = max(ij, kl) * norb * norb + min(ij, kl);
+                    FL x = (FL)((FP)(key % 7 - 3) + (FP)0.5) * (FL)1E-11;
+                    fcidump->set_integral(
+                        array<uint16_t, 4>{(uint16_t)(i + 1), (uint16_t)(j + 1),
+                                           (uint16_t)(k + 1),
+                                           (uint16_t)(l + 1)},
+                        x, 0);
+                }
+    orbsym.assign(norb, 0);
+    vector<vector<FL>> energies = {{-107.654122447525}};
+    vector<vector<SU2>> su2_targets = {{SU2(fcidump->n_elec(), 0, 0)}};
+    vector<vector<SZ>> sz_targets = {{SZ(fcidump->n_elec(), 0, 0)}};
+
+    hamil = make_shared<HamiltonianQC<SU2, FL>>(SU2(0), norb, orbsym, fcidump);
+    ref_bdims = this->template mpo_bond_dims<SU2>(hamil);
+    hamil->screening_cutoff = 1E-8;
+    bdims = this->template mpo_bond_dims<SU2>(hamil);
+    ref_total = 0, total = 0;
+    for (size_t i = 0; i < bdims.size(); i++) {
+        EXPECT_LE(bdims[i], ref_bdims[i]);
+        ref_total += ref_bdims[i], total += bdims[i];
+    }
+    EXPECT_LT(total, ref_total);
+    EXPECT_GT(hamil->screening_error_bound(), (FP)0.0);
+    EXPECT_LT(hamil->screening_error_bound(), (FP)1E-6);
+    this->template test_dmrg<SU2>(su2_targets, energies, hamil,
+                                  "SU2 SCREENING",
+                                  DecompositionTypes::DensityMatrix,
+                                  NoiseTypes::DensityMatrix);
+    hamil->deallocate();
+
+    shared_ptr<HamiltonianQC<SZ, FL>> sz_hamil =
+        make_shared<HamiltonianQC<SZ, FL>>(SZ(0), norb, orbsym, fcidump);
+    vector<int> sz_ref_bdims = this->template mpo_bond_dims<SZ>(sz_hamil);
+    sz_hamil->screening_cutoff = 1E-8;
+    vector<int> sz_bdims = this->template mpo_bond_dims<SZ>(sz_hamil);
+    ref_total = 0, total = 0;
+    for (size_t i = 0; i < sz_bdims.size(); i++) {
+        EXPECT_LE(sz_bdims[i], sz_ref_bdims[i]);
+        ref_total += sz_ref_bdims[i], total += sz_bdims[i];
+    }
+    EXPECT_LT(total, ref_total);
+    this->template test_dmrg<SZ>(sz_targets, energies, sz_hamil,
+                                 "SZ SCREENING",
+                                 DecompositionTypes::DensityMatrix,
+                                 NoiseTypes::DensityMatrix);
+    sz_hamil->deallocate();
+    fcidump->deallocate();
+}
+
 #ifdef _USE_SG
 
 TYPED_TEST(TestDMRGN2STO3G, TestSGF) {
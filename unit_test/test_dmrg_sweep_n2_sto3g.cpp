@@ -0,0 +1,634 @@
+
+#include "block2_core.hpp"
+#include "block2_dmrg.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace block2;
+
+class TestDMRGSweepN2STO3G : public ::testing::Test {
+  protected:
+    size_t isize = 1L << 24;
+    size_t dsize = 1L << 32;
+    const double energy = -107.654122447525;
+    shared_ptr<FCIDUMP<double>> fcidump;
+
+    template <typename S> shared_ptr<HamiltonianQC<S, double>> get_hamil();
+    template <typename S>
+    shared_ptr<MPO<S, double>>
+    get_mpo(const shared_ptr<HamiltonianQC<S, double>> &hamil);
+    template <typename S>
+    shared_ptr<MPS<S, double>>
+    get_mps(const shared_ptr<HamiltonianQC<S, double>> &hamil,
+            ubond_t bond_dim);
+    template <typename S>
+    shared_ptr<DMRG<S, double, double>>
+    get_dmrg(const shared_ptr<MPO<S, double>> &mpo,
+             const shared_ptr<MPS<S, double>> &mps,
+             const vector<ubond_t> &bdims, const vector<double> &noises);
+    template <typename S>
+    size_t test_davidson(const shared_ptr<HamiltonianQC<S, double>> &hamil,
+                         bool adaptive, const string &name);
+    void SetUp() override {
+        Random::rand_seed(0);
+        frame_() = make_shared<DataFrame>(isize, dsize, "nodex");
+        frame_()->use_main_stack = false;
+        frame_()->minimal_disk_usage = true;
+        threading_() = make_shared<Threading>(
+            ThreadingTypes::OperatorBatchedGEMM | ThreadingTypes::Global, 8, 8,
+            1);
+        threading_()->seq_type = SeqTypes::Tasked;
+        cout << *threading_() << endl;
+        fcidump = make_shared<FCIDUMP<double>>();
+        fcidump->read("data/N2.STO3G.FCIDUMP");
+    }
+    void TearDown() override {
+        fcidump->deallocate();
+        frame_()->activate(0);
+        assert(ialloc_()->used == 0 && dalloc_()->used == 0);
+        frame_() = nullptr;
+    }
+};
+
+template <typename S>
+shared_ptr<HamiltonianQC<S, double>> TestDMRGSweepN2STO3G::get_hamil() {
+    vector<uint8_t> orbsym = fcidump->orb_sym<uint8_t>();
+    transform(orbsym.begin(), orbsym.end(), orbsym.begin(),
+              PointGroup::swap_pg(PGTypes::D2H));
+    return make_shared<HamiltonianQC<S, double>>(
+        S(0, 0, 0), fcidump->n_sites(), orbsym, fcidump);
+}
+
+template <typename S>
+shared_ptr<MPO<S, double>> TestDMRGSweepN2STO3G::get_mpo(
+    const shared_ptr<HamiltonianQC<S, double>> &hamil) {
+    shared_ptr<MPO<S, double>> mpo =
+        make_shared<MPOQC<S, double>>(hamil, QCTypes::Conventional);
+    return make_shared<SimplifiedMPO<S, double>>(
+        mpo, make_shared<RuleQC<S, double>>(), true);
+}
+
+// random MPS saved to disk, with the center at the first site
+template <typename S>
+shared_ptr<MPS<S, double>> TestDMRGSweepN2STO3G::get_mps(
+    const shared_ptr<HamiltonianQC<S, double>> &hamil, ubond_t bond_dim) {
+    S target(fcidump->n_elec(), fcidump->twos(), 0);
+    Random::rand_seed(0);
+    shared_ptr<MPSInfo<S>> mps_info = make_shared<MPSInfo<S>>(
+        hamil->n_sites, hamil->vacuum, target, hamil->basis);
+    mps_info->set_bond_dimension(bond_dim);
+    shared_ptr<MPS<S, double>> mps =
+        make_shared<MPS<S, double>>(hamil->n_sites, 0, 2);
+    mps->initialize(mps_info);
+    mps->random_canonicalize();
+    mps->save_mutable();
+    mps->deallocate();
+    mps_info->save_mutable();
+    mps_info->deallocate_mutable();
+    return mps;
+}
+
+template <typename S>
+shared_ptr<DMRG<S, double, double>> TestDMRGSweepN2STO3G::get_dmrg(
+    const shared_ptr<MPO<S, double>> &mpo,
+    const shared_ptr<MPS<S, double>> &mps, const vector<ubond_t> &bdims,
+    const vector<double> &noises) {
+    shared_ptr<MovingEnvironment<S, double, double>> me =
+        make_shared<MovingEnvironment<S, double, double>>(mpo, mps, mps,
+                                                          "DMRG");
+    me->init_environments(false);
+    shared_ptr<DMRG<S, double, double>> dmrg =
+        make_shared<DMRG<S, double, double>>(me, bdims, noises);
+    dmrg->iprint = 1;
+    return dmrg;
+}
+
+// returns the total number of davidson matvecs
+template <typename S>
+size_t TestDMRGSweepN2STO3G::test_davidson(
+    const shared_ptr<HamiltonianQC<S, double>> &hamil, bool adaptive,
+    const string &name) {
+    vector<ubond_t> bdims = {20, 20, 50, 50, 100, 100, 200};
+    vector<double> noises = {1E-5, 1E-5, 1E-6, 1E-6, 1E-7, 1E-7, 0.0};
+    shared_ptr<MPO<S, double>> mpo = get_mpo(hamil);
+    shared_ptr<MPS<S, double>> mps = get_mps(hamil, bdims[0]);
+    shared_ptr<DMRG<S, double, double>> dmrg =
+        get_dmrg(mpo, mps, bdims, noises);
+    dmrg->davidson_adaptive = adaptive;
+    double ener = dmrg->solve(20, mps->center == 0, 1E-8);
+
+    // one davidson report per sweep
+    size_t ndav = 0, nmult = 0, nsaved = 0;
+    EXPECT_EQ(dmrg->davidson_iters.size(), dmrg->energies.size());
+    EXPECT_EQ(dmrg->davidson_est_saved_iters.size(), dmrg->energies.size());
+    for (size_t i = 0; i < dmrg->davidson_iters.size(); i++) {
+        EXPECT_GE(dmrg->davidson_matvecs[i], dmrg->davidson_iters[i]);
+        ndav += dmrg->davidson_iters[i];
+        nmult += dmrg->davidson_matvecs[i];
+        nsaved += dmrg->davidson_est_saved_iters[i];
+    }
+
+    cout << "== " << name << " == E = " << fixed << setw(22)
+         << setprecision(12) << ener << " error = " << scientific
+         << setprecision(3) << setw(10) << (ener - energy)
+         << " NDAV = " << ndav << " NMULT = " << nmult << endl;
+
+    EXPECT_LT(abs(ener - energy), 1E-7);
+
+    // first sweep has no previous sweep to adapt to
+    EXPECT_EQ(dmrg->davidson_est_saved_iters[0], 0);
+    if (adaptive)
+        EXPECT_GT(nsaved, 0);
+    else
+        EXPECT_EQ(nsaved, 0);
+
+    // one matvec per iteration
+    EXPECT_EQ(nmult, ndav);
+
+    // per-site iteration budget is only applied within the sweep
+    EXPECT_EQ(dmrg->davidson_soft_max_iter, -1);
+    EXPECT_EQ((int)dmrg->site_davidson_iters.size(), mps->n_sites);
+
+    mps->info->deallocate();
+    mpo->deallocate();
+    return nmult;
+}
+
+TEST_F(TestDMRGSweepN2STO3G, TestSU2Adaptive) {
+    shared_ptr<HamiltonianQC<SU2, double>> hamil = get_hamil<SU2>();
+    size_t nmult_fixed = test_davidson<SU2>(hamil, false, "SU2 FIXED");
+    size_t nmult_adaptive = test_davidson<SU2>(hamil, true, "SU2 ADAPTIVE");
+    EXPECT_LT(nmult_adaptive, nmult_fixed);
+    hamil->deallocate();
+}
+
+TEST_F(TestDMRGSweepN2STO3G, TestSU2Scheduler) {
+    shared_ptr<HamiltonianQC<SU2, double>> hamil = get_hamil<SU2>();
+    shared_ptr<MPO<SU2, double>> mpo = get_mpo(hamil);
+    shared_ptr<MPS<SU2, double>> mps = get_mps(hamil, 10);
+    shared_ptr<DMRG<SU2, double, double>> dmrg =
+        get_dmrg(mpo, mps, vector<ubond_t>{}, vector<double>{});
+    dmrg->scheduler =
+        make_shared<DMRGScheduler<SU2, double>>(10, 200, 1E-6, 1E-4);
+    double ener = dmrg->solve(40, mps->center == 0, 0);
+
+    cout << "== SU2 SCHEDULER == E = " << fixed << setw(22)
+         << setprecision(12) << ener << " error = " << scientific
+         << setprecision(3) << setw(10) << (ener - energy) << endl;
+
+    EXPECT_LT(abs(ener - energy), 1E-5);
+    // bond dimension increased and noise switched off by the scheduler
+    EXPECT_GT(dmrg->bond_dims[dmrg->energies.size() - 1], 10);
+    EXPECT_EQ(dmrg->noises[dmrg->energies.size() - 1], 0.0);
+    EXPECT_LT(dmrg->energies.size(), 40);
+
+    mps->info->deallocate();
+    mpo->deallocate();
+    hamil->deallocate();
+}
+
+TEST_F(TestDMRGSweepN2STO3G, TestSU2DiscardedWeightTarget) {
+    shared_ptr<HamiltonianQC<SU2, double>> hamil = get_hamil<SU2>();
+    shared_ptr<MPO<SU2, double>> mpo = get_mpo(hamil);
+    vector<ubond_t> bdims = {50, 100, 200};
+    vector<double> noises = {1E-6, 1E-7, 0.0};
+    map<int, size_t> mtots;
+    for (int it = 0; it < 2; it++) {
+        for (auto dt : vector<DecompositionTypes>{
+                 DecompositionTypes::DensityMatrix, DecompositionTypes::SVD}) {
+            shared_ptr<MPS<SU2, double>> mps = get_mps(hamil, bdims[0]);
+            shared_ptr<DMRG<SU2, double, double>> dmrg =
+                get_dmrg(mpo, mps, bdims, noises);
+            dmrg->decomp_type = dt;
+            if (dt == DecompositionTypes::SVD)
+                dmrg->noise_type = NoiseTypes::Wavefunction;
+            dmrg->trunc_dw_target = it == 0 ? 0 : 1E-10;
+            double ener = dmrg->solve(20, mps->center == 0, 1E-9);
+
+            // bond dimension actually used in the last sweep
+            mps->info->load_mutable();
+            ubond_t mmax = 0;
+            size_t mtot = 0;
+            for (int i = 0; i <= hamil->n_sites; i++) {
+                mmax = max(mmax,
+                           (ubond_t)mps->info->left_dims[i]->n_states_total);
+                mtot += mps->info->left_dims[i]->n_states_total;
+            }
+            mps->info->deallocate_mutable();
+
+            cout << "== SU2 DW TARGET " << dmrg->trunc_dw_target << " == E = "
+                 << fixed << setw(22) << setprecision(12) << ener
+                 << " error = " << scientific << setprecision(3) << setw(10)
+                 << (ener - energy) << " MMAX = " << mmax
+                 << " MTOT = " << mtot << endl;
+
+            EXPECT_LT(abs(ener - energy), 1E-6);
+            EXPECT_LE(mmax, bdims.back());
+            if (it == 0)
+                mtots[(int)dt] = mtot;
+            else {
+                // no noise in the last sweep: the target is met at every bond
+                EXPECT_LE(dmrg->discarded_weights.back(), 1E-10);
+                EXPECT_LT(mtot, mtots[(int)dt]);
+            }
+            mps->info->deallocate();
+        }
+    }
+    mpo->deallocate();
+    hamil->deallocate();
+}
+
+TEST_F(TestDMRGSweepN2STO3G, TestSU2SweepTrace) {
+    shared_ptr<HamiltonianQC<SU2, double>> hamil = get_hamil<SU2>();
+    shared_ptr<MPO<SU2, double>> mpo = get_mpo(hamil);
+    vector<ubond_t> bdims = {50, 100, 200};
+    vector<double> noises = {1E-6, 1E-7, 0.0};
+    double ener_ref = 0;
+    // serial, traced with prefetch, traced with prefetch and async saving
+    for (int ip = 0; ip < 3; ip++) {
+        frame_()->save_buffering = ip == 2;
+        shared_ptr<SweepTrace> sweep_trace =
+            ip == 0 ? nullptr : make_shared<SweepTrace>();
+        shared_ptr<MPS<SU2, double>> mps = get_mps(hamil, bdims[0]);
+        shared_ptr<DMRG<SU2, double, double>> dmrg =
+            get_dmrg(mpo, mps, bdims, noises);
+        dmrg->me->sweep_trace = sweep_trace;
+        if (sweep_trace != nullptr)
+            sweep_trace->trace_filename = frame_()->save_dir + "/trace";
+        double ener = dmrg->solve(6, mps->center == 0, 1E-8);
+        mps->info->deallocate();
+
+        cout << "== SU2 TRACE " << ip << " == E = " << fixed << setw(22)
+             << setprecision(12) << ener << " error = " << scientific
+             << setprecision(3) << setw(10) << (ener - energy) << endl;
+
+        if (ip == 0) {
+            EXPECT_LT(abs(ener - energy), 1E-7);
+            ener_ref = ener;
+            continue;
+        }
+        // prefetch only changes when the data is read from disk
+        // (threaded contractions are not bitwise reproducible between runs)
+        EXPECT_LT(abs(ener - ener_ref), 1E-8);
+        // tasks of the last sweep
+        EXPECT_GT(sweep_trace->tasks.size(), 0);
+        size_t nread = 0, nsave = 0;
+        for (int i = 0; i < (int)sweep_trace->tasks.size(); i++) {
+            const shared_ptr<SweepTrace::Task> &t = sweep_trace->tasks[i];
+            EXPECT_GE(t->tend, t->tstart);
+            for (int d : t->deps)
+                EXPECT_LT(d, i);
+            nread += t->name.substr(0, 4) == "read";
+            nsave += t->name.substr(0, 4) == "save";
+        }
+        EXPECT_GT(nread, 0);
+        EXPECT_EQ(nsave > 0, ip == 2);
+        pair<double, double> tt = sweep_trace->total_time();
+        EXPECT_LE(sweep_trace->critical_path(), tt.first + tt.second + 1E-6);
+        EXPECT_GT(frame_()->tprefetch, 0);
+        string trace =
+            Parsing::read_file(sweep_trace->trace_filename + ".0.json");
+        EXPECT_EQ(trace.substr(0, 15), "{\"traceEvents\":");
+    }
+    frame_()->save_buffering = false;
+
+    mpo->deallocate();
+    hamil->deallocate();
+}
+
+static void sleep_seconds(double t) {
+    this_thread::sleep_for(chrono::microseconds((long long)(t * 1E6)));
+}
+
+TEST_F(TestDMRGSweepN2STO3G, TestSweepTraceTasks) {
+    const double dt = 0.05;
+    SweepTrace p;
+    // work started in background before it is attached
+    shared_ptr<pair<double, double>> times =
+        make_shared<pair<double, double>>(0.0, 0.0);
+    shared_future<void> ft = async(launch::async, [times, dt]() {
+                                 Timer t;
+                                 sleep_seconds(dt);
+                                 t.get_time();
+                                 times->first = t.current;
+                                 sleep_seconds(dt);
+                                 t.get_time();
+                                 times->second = t.current;
+                             }).share();
+    int ta = p.attach("read", {}, ft, times);
+    // a sync task inside another sync task
+    int t0 = p.begin("update", {});
+    int t1 = p.submit("rotate", {}, [dt]() { sleep_seconds(dt); });
+    sleep_seconds(dt);
+    p.end(t0);
+    // background work started after the sync task it depends on
+    shared_ptr<pair<double, double>> stimes =
+        make_shared<pair<double, double>>(0.0, 0.0);
+    shared_future<void> sft = async(launch::async, [stimes, dt]() {
+                                  Timer t;
+                                  t.get_time();
+                                  stimes->first = t.current;
+                                  sleep_seconds(dt);
+                                  t.get_time();
+                                  stimes->second = t.current;
+                              }).share();
+    int t2 = p.attach("save", {t0}, sft, stimes);
+    p.wait_all();
+    const vector<shared_ptr<SweepTrace::Task>> &ts = p.tasks;
+
+    // the attached task has the times of the background work
+    EXPECT_GE(ts[ta]->tstart, 0.99 * dt);
+    EXPECT_GE(ts[ta]->tend - ts[ta]->tstart, 0.99 * dt);
+    EXPECT_EQ(ts[t0]->parent, -1);
+    EXPECT_EQ(ts[t1]->parent, t0);
+    EXPECT_GE(ts[t1]->tstart, ts[t0]->tstart);
+    EXPECT_LE(ts[t1]->tend, ts[t0]->tend);
+    EXPECT_GE(ts[t2]->tstart, ts[t0]->tend);
+
+    // the nested task is counted in its outer task only
+    pair<double, double> tt = p.total_time();
+    EXPECT_NEAR(tt.first, ts[t0]->tend - ts[t0]->tstart, 1E-12);
+    EXPECT_GE(tt.first, 1.99 * dt);
+    // longest chain: update -> save
+    EXPECT_NEAR(p.critical_path(),
+                ts[t0]->tend - ts[t0]->tstart + ts[t2]->tend - ts[t2]->tstart,
+                1E-12);
+
+    // exceptions of background work are thrown when waiting
+    shared_future<void> eft =
+        async(launch::async, []() {
+            throw runtime_error("traced task");
+        }).share();
+    int t3 = p.attach("throw", {t2}, eft,
+                      make_shared<pair<double, double>>(0.0, 0.0));
+    EXPECT_THROW(p.wait(t3), runtime_error);
+}
+
+TEST_F(TestDMRGSweepN2STO3G, TestSU2RestartDir) {
+    shared_ptr<HamiltonianQC<SU2, double>> hamil = get_hamil<SU2>();
+    shared_ptr<MPO<SU2, double>> mpo = get_mpo(hamil);
+    vector<ubond_t> bdims = {50, 100, 200};
+    vector<double> noises = {1E-6, 1E-7, 0.0};
+    const string rdir = frame_()->save_dir + "/restart";
+    for (bool ckpt_async : {false, true}) {
+        frame_()->checkpoint_async = ckpt_async;
+        // staging dir left by an interrupted writer
+        Parsing::mkdir(rdir + ".TMP");
+        Parsing::write_file(rdir + ".TMP/junk", "junk");
+        // file in the restart dir not written by the new checkpoints
+        // (such as another MPS kept by the user)
+        if (!Parsing::path_exists(rdir))
+            Parsing::mkdir(rdir);
+        Parsing::write_file(rdir + "/unrelated", "unrelated");
+        frame_()->tcheckpoint = 0;
+        frame_()->restart_dir = rdir;
+        shared_ptr<MPS<SU2, double>> mps = get_mps(hamil, bdims[0]);
+        shared_ptr<DMRG<SU2, double, double>> dmrg =
+            get_dmrg(mpo, mps, bdims, noises);
+        double ener = dmrg->solve(10, mps->center == 0, 1E-8);
+        frame_()->restart_dir = "";
+        EXPECT_LT(abs(ener - energy), 1E-7);
+        // the last checkpoint is complete when solve returns
+        EXPECT_TRUE(Parsing::path_exists(rdir));
+        EXPECT_FALSE(Parsing::path_exists(rdir + ".TMP"));
+        EXPECT_FALSE(Parsing::file_exists(rdir + "/junk"));
+        // restart dirs are only added to
+        EXPECT_TRUE(Parsing::file_exists(rdir + "/unrelated"));
+        EXPECT_EQ(Parsing::read_file(rdir + "/unrelated"), "unrelated");
+        EXPECT_GT(frame_()->tcheckpoint, 0.0);
+
+        // read the MPS from the restart dir only, and put it in scratch
+        frame_()->mps_dir = rdir;
+        shared_ptr<MPS<SU2, double>> rmps =
+            make_shared<MPS<SU2, double>>(mps->info);
+        rmps->load_data();
+        rmps->info->load_mutable();
+        rmps->load_mutable();
+        frame_()->mps_dir = frame_()->save_dir;
+        rmps->save_data();
+        rmps->save_mutable();
+        rmps->deallocate();
+        rmps->info->save_mutable();
+        rmps->info->deallocate_mutable();
+        EXPECT_EQ(rmps->n_sites, mps->n_sites);
+        EXPECT_EQ(rmps->center, mps->center);
+        EXPECT_EQ(rmps->canonical_form, mps->canonical_form);
+
+        // one more sweep from the reloaded MPS stays at the same energy
+        shared_ptr<DMRG<SU2, double, double>> rdmrg =
+            get_dmrg(mpo, rmps, vector<ubond_t>{bdims.back()},
+                     vector<double>{0.0});
+        double rener = rdmrg->solve(1, rmps->center == 0, 0);
+        EXPECT_LT(abs(rener - ener), 1E-8);
+        mps->info->deallocate();
+    }
+    frame_()->checkpoint_async = false;
+
+    mpo->deallocate();
+    hamil->deallocate();
+}
+
+// DMRG killed after a fixed number of sites
+template <typename S> struct InterruptedDMRG : DMRG<S, double, double> {
+    typedef typename DMRG<S, double, double>::Iteration Iteration;
+    int n_sites_left;
+    InterruptedDMRG(const shared_ptr<MovingEnvironment<S, double, double>> &me,
+                    const vector<ubond_t> &bond_dims,
+                    const vector<double> &noises, int n_sites_left)
+        : DMRG<S, double, double>(me, bond_dims, noises),
+          n_sites_left(n_sites_left) {}
+    Iteration blocking(int i, bool forward, ubond_t bond_dim, double noise,
+                       double davidson_conv_thrd) override {
+        Iteration it = DMRG<S, double, double>::blocking(
+            i, forward, bond_dim, noise, davidson_conv_thrd);
+        if (--n_sites_left == 0)
+            throw runtime_error("interrupted");
+        return it;
+    }
+};
+
+TEST_F(TestDMRGSweepN2STO3G, TestSU2Checkpoint) {
+    // environment partitions of both sides are kept in scratch
+    frame_()->minimal_disk_usage = false;
+    shared_ptr<HamiltonianQC<SU2, double>> hamil = get_hamil<SU2>();
+    shared_ptr<MPO<SU2, double>> mpo = get_mpo(hamil);
+    vector<ubond_t> bdims = {50, 100, 200};
+    vector<double> noises = {1E-6, 1E-7, 0.0};
+    string ckpt_dir = frame_()->save_dir + "/ckpt";
+    int n_sweep_sites = hamil->n_sites - 1;
+
+    // interrupted in the middle of the second sweep
+    shared_ptr<MPS<SU2, double>> mps = get_mps(hamil, bdims[0]);
+    shared_ptr<MovingEnvironment<SU2, double, double>> me =
+        make_shared<MovingEnvironment<SU2, double, double>>(mpo, mps, mps,
+                                                            "DMRG");
+    me->incremental_init = true;
+    me->init_environments(false);
+    shared_ptr<DMRG<SU2, double, double>> dmrg =
+        make_shared<InterruptedDMRG<SU2>>(me, bdims, noises,
+                                          n_sweep_sites + 5);
+    dmrg->iprint = 1;
+    dmrg->checkpoint_dir = ckpt_dir;
+    dmrg->checkpoint_site_interval = 2;
+    EXPECT_THROW(dmrg->solve(10, mps->center == 0, 1E-8), runtime_error);
+    frame_()->reset(1);
+    EXPECT_EQ(dmrg->energies.size(), 1);
+
+    // restart from the checkpoint dir, as a new job would do
+    for (auto &x : Parsing::list_dir(ckpt_dir))
+        Parsing::copy_file(ckpt_dir + "/" + x, frame_()->save_dir + "/" + x);
+    shared_ptr<MPSInfo<SU2>> rmps_info = make_shared<MPSInfo<SU2>>(0);
+    rmps_info->load_data(frame_()->save_dir + "/mps_info.bin");
+    shared_ptr<MPS<SU2, double>> rmps =
+        make_shared<MPS<SU2, double>>(rmps_info);
+    rmps->load_data();
+    // the last checkpoint is before the fifth site of the second sweep
+    EXPECT_EQ(rmps->center, n_sweep_sites - 5);
+
+    shared_ptr<MovingEnvironment<SU2, double, double>> rme =
+        make_shared<MovingEnvironment<SU2, double, double>>(mpo, rmps, rmps,
+                                                            "DMRG");
+    int n_hashes = 0;
+    for (int i = 0; i < hamil->n_sites; i++)
+        n_hashes += (rme->load_partition_hash(true, i) != 0) +
+                    (rme->load_partition_hash(false, i) != 0);
+    EXPECT_GT(n_hashes, 0);
+    EXPECT_TRUE(rme->load_environments(ckpt_dir));
+    // partition hashes in scratch are not for the restored environments
+    for (int i = 0; i < hamil->n_sites; i++) {
+        EXPECT_EQ(rme->load_partition_hash(true, i), 0);
+        EXPECT_EQ(rme->load_partition_hash(false, i), 0);
+    }
+    shared_ptr<DMRG<SU2, double, double>> rdmrg =
+        make_shared<DMRG<SU2, double, double>>(rme, bdims, noises);
+    rdmrg->iprint = 1;
+    rdmrg->checkpoint_dir = ckpt_dir;
+    double ener = rdmrg->solve(10, true, 1E-8);
+
+    cout << "== SU2 RESTART == E = " << fixed << setw(22) << setprecision(12)
+         << ener << " error = " << scientific << setprecision(3) << setw(10)
+         << (ener - energy) << endl;
+
+    // the sweep state is removed when the sweep is finished
+    EXPECT_FALSE(
+        Parsing::file_exists(rdmrg->get_checkpoint_filename(ckpt_dir)));
+    // the first sweep is not repeated
+    EXPECT_EQ(rdmrg->energies[0], dmrg->energies[0]);
+    EXPECT_LT(abs(ener - energy), 1E-7);
+
+    // quanta are stored field by field, without padding
+    SU2 target(fcidump->n_elec(), fcidump->twos(), 0);
+    vector<vector<pair<SU2, double>>> quanta = {
+        {make_pair(SU2(2, 0, 1), 0.25), make_pair(target, 0.75)}, {}};
+    stringstream ss;
+    DMRG<SU2, double, double>::save_checkpoint_vector(ss, quanta);
+    EXPECT_EQ(ss.str().size(),
+              3 * sizeof(size_t) + 2 * (sizeof(SU2) + sizeof(double)));
+    vector<vector<pair<SU2, double>>> rquanta;
+    DMRG<SU2, double, double>::load_checkpoint_vector(ss, rquanta);
+    EXPECT_TRUE(rquanta == quanta);
+
+    // environments of another center are not used
+    shared_ptr<MovingEnvironment<SU2, double, double>> xme =
+        make_shared<MovingEnvironment<SU2, double, double>>(mpo, rmps, rmps,
+                                                            "DMRG");
+    EXPECT_FALSE(xme->load_environments(ckpt_dir));
+
+    rmps_info->deallocate();
+    mps->info->deallocate();
+    mpo->deallocate();
+    hamil->deallocate();
+}
+
+TEST_F(TestDMRGSweepN2STO3G, TestSU2Incremental) {
+    // environment partitions of both sides are kept in scratch
+    frame_()->minimal_disk_usage = false;
+    shared_ptr<HamiltonianQC<SU2, double>> hamil = get_hamil<SU2>();
+    shared_ptr<MPO<SU2, double>> mpo = get_mpo(hamil);
+    vector<ubond_t> bdims = {50, 100, 200};
+    vector<double> noises = {1E-6, 1E-7, 0.0};
+    shared_ptr<MPS<SU2, double>> mps = get_mps(hamil, bdims[0]);
+
+    // center = 0, all environments are right partitions
+    const int n_parts = hamil->n_sites - 2;
+    shared_ptr<MovingEnvironment<SU2, double, double>> me =
+        make_shared<MovingEnvironment<SU2, double, double>>(mpo, mps, mps,
+                                                            "DMRG");
+    me->incremental_init = true;
+    me->init_environments(false);
+    frame_()->reset(1);
+    // the manifest of the partitions is saved after init
+    EXPECT_TRUE(me->load_partition_manifest() == me->get_partition_manifest());
+    vector<uint64_t> hashes(n_parts);
+    for (int i = 0; i < n_parts; i++) {
+        hashes[i] = me->load_partition_hash(false, i);
+        EXPECT_NE(hashes[i], 0);
+        EXPECT_EQ(me->get_partition_hash(false, i), hashes[i]);
+    }
+
+    // change the bytes (but not the state) of one tensor
+    // only the partition containing the changed site is invalid
+    const int k = hamil->n_sites / 2;
+    const uint64_t hk = mps->get_tensor_hash(k);
+    EXPECT_EQ(hk,
+              Parsing::hash_string(Parsing::read_file(mps->get_filename(k))));
+    mps->load_tensor(k);
+    mps->tensors[k]->iscale(-1.0);
+    mps->save_tensor(k);
+    mps->unload_tensor(k);
+    // the cached tensor hash is dropped when the tensor is saved
+    EXPECT_NE(mps->get_tensor_hash(k), hk);
+    EXPECT_EQ(mps->get_tensor_hash(k),
+              Parsing::hash_string(Parsing::read_file(mps->get_filename(k))));
+    for (int i = 0; i < n_parts; i++)
+        EXPECT_EQ(me->get_partition_hash(false, i) == hashes[i], i != k - 2);
+
+    // partitions downstream of the changed site are recomputed
+    shared_ptr<MovingEnvironment<SU2, double, double>> rme =
+        make_shared<MovingEnvironment<SU2, double, double>>(mpo, mps, mps,
+                                                            "DMRG");
+    rme->incremental_init = true;
+    rme->init_environments(true);
+    EXPECT_EQ(rme->n_reused_partitions, n_parts - (k - 1));
+    EXPECT_EQ(rme->n_computed_partitions, k - 1);
+    for (int i = 0; i < n_parts; i++) {
+        uint64_t h = rme->load_partition_hash(false, i);
+        EXPECT_EQ(rme->get_partition_hash(false, i), h);
+        EXPECT_EQ(h == hashes[i], i >= k - 1);
+    }
+
+    shared_ptr<DMRG<SU2, double, double>> dmrg =
+        make_shared<DMRG<SU2, double, double>>(rme, bdims, noises);
+    dmrg->iprint = 1;
+    double ener = dmrg->solve(10, mps->center == 0, 1E-8);
+
+    cout << "== SU2 INCREMENTAL == E = " << fixed << setw(22)
+         << setprecision(12) << ener << " error = " << scientific
+         << setprecision(3) << setw(10) << (ener - energy) << endl;
+
+    EXPECT_LT(abs(ener - energy), 1E-7);
+    EXPECT_TRUE(rme->load_partition_manifest() ==
+                rme->get_partition_manifest());
+
+    // partitions written with a different number of procs are not reused
+    string manifest_filename = rme->get_partition_manifest_filename();
+    stringstream ss;
+    ss << 2 << " " << hamil->n_sites << endl;
+    Parsing::write_file(manifest_filename, ss.str());
+    EXPECT_EQ(rme->load_partition_manifest().size(), 2);
+    shared_ptr<MovingEnvironment<SU2, double, double>> xme =
+        make_shared<MovingEnvironment<SU2, double, double>>(mpo, mps, mps,
+                                                            "DMRG");
+    xme->incremental_init = true;
+    xme->init_environments(false);
+    EXPECT_EQ(xme->n_reused_partitions, 0);
+    EXPECT_GT(xme->n_computed_partitions, 0);
+    EXPECT_EQ(xme->load_partition_manifest().size(), 1);
+
+    Parsing::write_file(manifest_filename, "    1\n");
+    EXPECT_THROW(xme->load_partition_manifest(), runtime_error);
+
+    mps->info->deallocate();
+    mpo->deallocate();
+    hamil->deallocate();
+}
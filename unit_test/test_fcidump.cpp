@@ -50,6 +50,196 @@ TEST_F(TestFCIDUMP, TestRead) {
     fcidump.deallocate();
 }
 
+// Small FCIDUMP with random integrals, comment and blank lines, and
+// duplicate (or symmetry-equivalent) elements with different values
+static void write_test_fcidump(const string &filename, int n, bool uhf) {
+    ofstream ofs(filename.c_str());
+    ofs << " &FCI NORB=" << n << ",NELEC=" << n << ",MS2=0," << endl;
+    ofs << "  ORBSYM=";
+    for (int i = 0; i < n; i++)
+        ofs << "1,";
+    ofs << endl << "  ISYM=1," << endl;
+    if (uhf)
+        ofs << "  IUHF=1," << endl;
+    ofs << " &END" << endl << setprecision(16);
+    for (int iv = 0; iv < (uhf ? 3 : 1); iv++) {
+        for (int i = 1; i <= n; i++)
+            for (int j = 1; j <= n; j++)
+                for (int k = 1; k <= n; k++)
+                    for (int l = 1; l <= n; l++) {
+                        ofs << Random::rand_double(-1, 1) << " " << i << " "
+                            << j << " " << k << " " << l;
+                        if ((i + j + k + l) % 7 == 0)
+                            ofs << " ! comment" << endl << endl << "! 0 0";
+                        ofs << endl;
+                    }
+        if (uhf)
+            ofs << "  0.0  0 0 0 0" << endl;
+    }
+    for (int it = 0; it < (uhf ? 2 : 1); it++) {
+        for (int i = 1; i <= n; i++)
+            for (int j = 1; j <= n; j++)
+                ofs << Random::rand_double(-1, 1) << " " << i << " " << j
+                    << " 0 0" << endl;
+        ofs << (uhf ? 0.0 : Random::rand_double(-1, 1)) << " 0 0 0 0" << endl;
+    }
+    ofs << Random::rand_double(-1, 1) << " 0 0 0 0" << endl;
+}
+
+// Reference serial parser: elements are stored one line at a time
+static void read_serial(FCIDUMP<double> &fcidump, const string &filename) {
+    ifstream ifs(filename.c_str());
+    fcidump.read_params(ifs);
+    fcidump.init_integrals();
+    fcidump.const_e = 0.0;
+    memset(fcidump.data, 0, sizeof(double) * fcidump.total_memory);
+    vector<string> lines = Parsing::readlines(&ifs);
+    array<uint16_t, 4> idx;
+    double val;
+    int ip = 0;
+    for (auto &l : lines) {
+        vector<string> x = Parsing::split(Parsing::trim(l), " ", true);
+        if (x.size() == 0)
+            continue;
+        fd_read_line(idx, val, x);
+        if (fcidump.uhf && idx[0] + idx[1] + idx[2] + idx[3] == 0)
+            ip++;
+        fcidump.set_integral(idx, val, ip);
+    }
+}
+
+TEST_F(TestFCIDUMP, TestParallelRead) {
+    Parsing::mkdir("nodex");
+    for (bool uhf : {false, true}) {
+        string filename = "nodex/TEST.FCIDUMP";
+        write_test_fcidump(filename, 5, uhf);
+        FCIDUMP<double> ref;
+        read_serial(ref, filename);
+        EXPECT_EQ(ref.uhf, uhf);
+        // small chunks: lines span chunk boundaries
+        for (size_t chunk_size : {(size_t)7, (size_t)97, (size_t)1 << 26}) {
+            FCIDUMP<double> fcidump;
+            fcidump.read_chunk_size = chunk_size;
+            fcidump.read(filename);
+            EXPECT_EQ(fcidump.uhf, uhf);
+            EXPECT_EQ(fcidump.const_e, ref.const_e);
+            EXPECT_EQ(fcidump.total_memory, ref.total_memory);
+            EXPECT_TRUE(equal(fcidump.data,
+                              fcidump.data + fcidump.total_memory, ref.data));
+            fcidump.deallocate();
+        }
+        ref.deallocate();
+    }
+}
+
+static void rand_elem(double &x) { x = Random::rand_double(-1, 1); }
+
+static void rand_elem(complex<double> &x) {
+    x = complex<double>(Random::rand_double(-1, 1),
+                        Random::rand_double(-1, 1));
+}
+
+// Random orthogonal (or unitary) matrix by Gram-Schmidt (row-major)
+template <typename FL> static vector<FL> random_unitary(int n) {
+    vector<FL> u((size_t)n * n);
+    for (auto &x : u)
+        rand_elem(x);
+    for (int j = 0; j < n; j++) {
+        for (int k = 0; k < j; k++) {
+            FL d = 0;
+            for (int i = 0; i < n; i++)
+                d += xconj(u[i * n + k]) * u[i * n + j];
+            for (int i = 0; i < n; i++)
+                u[i * n + j] -= d * u[i * n + k];
+        }
+        double d = 0;
+        for (int i = 0; i < n; i++)
+            d += abs(u[i * n + j]) * abs(u[i * n + j]);
+        for (int i = 0; i < n; i++)
+            u[i * n + j] /= sqrt(d);
+    }
+    return u;
+}
+
+// Compare rotated two-electron integrals with the naive transformation
+// r(ijkl) = sum_pqrs conj(U_pi) U_qj conj(U_rk) U_sl x(pqrs)
+// for the independent elements i >= j, k >= l (and ij >= kl if eight_fold)
+template <typename FL, typename VI>
+static void check_rotate(const VI &r, const VI &x, const vector<FL> &u,
+                         bool eight_fold) {
+    const int n = (int)x.n;
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j <= i; j++)
+            for (int k = 0; k < n; k++)
+                for (int l = 0; l <= k; l++) {
+                    if (eight_fold && i * (i + 1) / 2 + j < k * (k + 1) / 2 + l)
+                        continue;
+                    FL y = 0;
+                    for (int p = 0; p < n; p++)
+                        for (int q = 0; q < n; q++)
+                            for (int s = 0; s < n; s++)
+                                for (int t = 0; t < n; t++)
+                                    y += xconj(u[p * n + i]) * u[q * n + j] *
+                                         xconj(u[s * n + k]) * u[t * n + l] *
+                                         x(p, q, s, t);
+                    EXPECT_LT(abs(r(i, j, k, l) - y), 1E-12);
+                }
+}
+
+template <typename FL> static void test_rotate_reorder(bool uhf) {
+    const int n = 5;
+    string filename = "nodex/TEST.FCIDUMP";
+    write_test_fcidump(filename, n, uhf);
+    FCIDUMP<FL> fcidump, fref;
+    fcidump.read(filename);
+    fref.read(filename);
+    const vector<FL> u = random_unitary<FL>(n);
+    fcidump.rotate(u);
+    for (size_t it = 0; it < fref.ts.size(); it++)
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j <= i; j++) {
+                FL y = 0;
+                for (int p = 0; p < n; p++)
+                    for (int q = 0; q < n; q++)
+                        y += xconj(u[p * n + i]) * fref.ts[it](p, q) *
+                             u[q * n + j];
+                EXPECT_LT(abs(fcidump.ts[it](i, j) - y), 1E-12);
+            }
+    for (size_t iv = 0; iv < fref.vs.size(); iv++)
+        check_rotate(fcidump.vs[iv], fref.vs[iv], u, true);
+    for (size_t iv = 0; iv < fref.vabs.size(); iv++)
+        check_rotate(fcidump.vabs[iv], fref.vabs[iv], u, false);
+    fcidump.deallocate();
+    fcidump.read(filename);
+    vector<uint16_t> ord = {3, 0, 4, 2, 1};
+    fcidump.reorder(ord);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++) {
+            for (size_t it = 0; it < fref.ts.size(); it++)
+                EXPECT_EQ(fcidump.ts[it](i, j), fref.ts[it](ord[i], ord[j]));
+            for (int k = 0; k < n; k++)
+                for (int l = 0; l < n; l++) {
+                    for (size_t iv = 0; iv < fref.vs.size(); iv++)
+                        EXPECT_EQ(fcidump.vs[iv](i, j, k, l),
+                                  fref.vs[iv](ord[i], ord[j], ord[k], ord[l]));
+                    for (size_t iv = 0; iv < fref.vabs.size(); iv++)
+                        EXPECT_EQ(
+                            fcidump.vabs[iv](i, j, k, l),
+                            fref.vabs[iv](ord[i], ord[j], ord[k], ord[l]));
+                }
+        }
+    fcidump.deallocate();
+    fref.deallocate();
+}
+
+TEST_F(TestFCIDUMP, TestRotateReorder) {
+    Parsing::mkdir("nodex");
+    for (bool uhf : {false, true}) {
+        test_rotate_reorder<double>(uhf);
+        test_rotate_reorder<complex<double>>(uhf);
+    }
+}
+
 TEST_F(TestFCIDUMP, TestCompressedRead) {
     CompressedFCIDUMP<double> fcidump(5E-16);
     string filename = "data/CR2.SVP.FCIDUMP";
@@ -131,3 +321,108 @@ TEST_F(TestFCIDUMP, TestCompressedComplexRead) {
     EXPECT_EQ(fcidump.cps_vs[0](0, 2, 1, 1), fcidump.cps_vs[0](1, 1, 2, 0));
     fcidump.deallocate();
 }
+
+TEST_F(TestFCIDUMP, TestBinaryReadWrite) {
+    FCIDUMP<double> fcidump;
+    string filename = "data/CR2.SVP.FCIDUMP";
+    fcidump.read(filename);
+    string bin_filename = "nodex/CR2.SVP.FCIDUMP.BIN";
+    Parsing::mkdir("nodex");
+    fcidump.write_binary(bin_filename);
+    EXPECT_FALSE(FCIDUMP<double>::is_binary(filename));
+    EXPECT_TRUE(FCIDUMP<double>::is_binary(bin_filename));
+    for (bool use_mmap : {true, false}) {
+        FCIDUMP<double> fbin;
+        fbin.read_binary(bin_filename, use_mmap);
+        EXPECT_EQ(fbin.params.at("orbsym"), fcidump.params.at("orbsym"));
+        EXPECT_EQ(fbin.n_elec(), fcidump.n_elec());
+        EXPECT_EQ(fbin.uhf, false);
+        EXPECT_EQ(fbin.const_e, fcidump.const_e);
+        EXPECT_EQ(fbin.total_memory, fcidump.total_memory);
+        EXPECT_TRUE(equal(fbin.data, fbin.data + fbin.total_memory,
+                          fcidump.data));
+        EXPECT_EQ(fbin.vs[0](0, 2, 1, 1), fcidump.vs[0](0, 2, 1, 1));
+        fbin.deallocate();
+    }
+    FCIDUMP<double> fread;
+    fread.read(bin_filename);
+    EXPECT_EQ(fread.ts[0](0, 3), fcidump.ts[0](0, 3));
+    fread.deallocate();
+    fcidump.deallocate();
+}
+
+TEST_F(TestFCIDUMP, TestCholesky) {
+    FCIDUMP<double> fcidump;
+    string filename = "data/N2.STO3G.FCIDUMP";
+    fcidump.read(filename);
+    const int n = fcidump.n_sites(), nn = n * n;
+    // pivoted Cholesky decomposition of (ij|kl)
+    vector<double> diag(nn), ld, t(nn);
+    for (int ij = 0; ij < nn; ij++)
+        diag[ij] = fcidump.v(ij / n, ij % n, ij / n, ij % n);
+    int n_aux = 0;
+    for (; n_aux < nn; n_aux++) {
+        int p = (int)(max_element(diag.begin(), diag.end()) - diag.begin());
+        if (diag[p] < 1E-12)
+            break;
+        ld.resize((size_t)nn * (n_aux + 1));
+        const double dp = sqrt(diag[p]);
+        for (int ij = 0; ij < nn; ij++) {
+            double x = fcidump.v(ij / n, ij % n, p / n, p % n);
+            for (int q = 0; q < n_aux; q++)
+                x -= ld[(size_t)q * nn + ij] * ld[(size_t)q * nn + p];
+            ld[(size_t)n_aux * nn + ij] = x / dp;
+            diag[ij] -= (x / dp) * (x / dp);
+        }
+    }
+    EXPECT_LT(n_aux, nn);
+    vector<double> cd((size_t)nn * n_aux);
+    for (int ij = 0; ij < nn; ij++)
+        for (int q = 0; q < n_aux; q++)
+            cd[(size_t)ij * n_aux + q] = ld[(size_t)q * nn + ij];
+    for (int ij = 0; ij < nn; ij++)
+        t[ij] = fcidump.t(ij / n, ij % n);
+    CholeskyFCIDUMP<double> chd;
+    chd.initialize_su2(n, fcidump.n_elec(), fcidump.twos(), fcidump.isym(),
+                       fcidump.e(), t.data(), t.size(), cd.data(), cd.size());
+    EXPECT_EQ(chd.n_aux, n_aux);
+    EXPECT_EQ(chd.t(0, 3), fcidump.t(0, 3));
+    shared_ptr<FCIDUMP<double>> full = chd.to_fcidump();
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            for (int k = 0; k < n; k++)
+                for (int l = 0; l < n; l++) {
+                    EXPECT_LT(abs(chd.v(i, j, k, l) - fcidump.v(i, j, k, l)),
+                              1E-8);
+                    EXPECT_LT(abs(chd.v(1, 0, i, j, k, l) -
+                                  fcidump.v(1, 0, i, j, k, l)),
+                              1E-8);
+                    EXPECT_EQ(full->v(i, j, k, l), chd.v(i, j, k, l));
+                }
+    // symmetrization error includes the masked two-electron integrals
+    vector<uint8_t> orbsym(n);
+    for (int i = 0; i < n; i++)
+        orbsym[i] = (uint8_t)(i & 1);
+    double full_err = full->symmetrize(orbsym);
+    double chd_err = chd.deep_copy()->symmetrize(orbsym);
+    EXPECT_GT(full_err, 1.0);
+    EXPECT_LT(abs(chd_err - full_err), 1E-8);
+    full->deallocate();
+    // decomposition done by read
+    CholeskyFCIDUMP<double> rchd;
+    rchd.read(filename);
+    EXPECT_EQ(rchd.params.at("orbsym"), fcidump.params.at("orbsym"));
+    EXPECT_EQ(rchd.e(), fcidump.e());
+    EXPECT_LT(rchd.n_aux, nn);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++) {
+            EXPECT_EQ(rchd.t(i, j), fcidump.t(i, j));
+            for (int k = 0; k < n; k++)
+                for (int l = 0; l < n; l++)
+                    EXPECT_LT(abs(rchd.v(i, j, k, l) - fcidump.v(i, j, k, l)),
+                              1E-10);
+        }
+    rchd.deallocate();
+    chd.deallocate();
+    fcidump.deallocate();
+}
@@ -0,0 +1,80 @@
+
+#include "block2_core.hpp"
+#include <gtest/gtest.h>
+
+using namespace block2;
+
+class TestMatching : public ::testing::Test {
+  protected:
+    static const int n_tests = 200;
+    void SetUp() override { Random::rand_seed(0); }
+    void TearDown() override {}
+};
+
+// simple augmenting path algorithm for maximum bipartite matching
+static bool ref_augment(const vector<vector<int>> &adj, int u,
+                        vector<int> &match_r, vector<char> &vis) {
+    for (int v : adj[u])
+        if (!vis[v]) {
+            vis[v] = 1;
+            if (match_r[v] == -1 ||
+                ref_augment(adj, match_r[v], match_r, vis)) {
+                match_r[v] = u;
+                return true;
+            }
+        }
+    return false;
+}
+
+TEST_F(TestMatching, TestHopcroftKarp) {
+    for (int i = 0; i < n_tests; i++) {
+        int nl = Random::rand_int(1, 40), nr = Random::rand_int(1, 40);
+        int ne = Random::rand_int(0, nl * nr);
+        HopcroftKarp hk(nl, nr);
+        for (int k = 0; k < ne; k++)
+            hk.add_edge(Random::rand_int(0, nl), Random::rand_int(0, nr));
+        int r = hk.solve();
+        vector<int> match_r(nr, -1);
+        int ref = 0;
+        for (int u = 0; u < nl; u++) {
+            vector<char> vis(nr, 0);
+            ref += ref_augment(hk.adj, u, match_r, vis);
+        }
+        EXPECT_EQ(r, ref);
+        // the matching is consistent and uses existing edges
+        int nm = 0;
+        for (int u = 0; u < nl; u++)
+            if (hk.match_l[u] != -1) {
+                nm++;
+                EXPECT_EQ(hk.match_r[hk.match_l[u]], u);
+                EXPECT_TRUE(find(hk.adj[u].begin(), hk.adj[u].end(),
+                                 hk.match_l[u]) != hk.adj[u].end());
+            }
+        EXPECT_EQ(nm, r);
+        // the vertex cover has the size of the matching (Konig's theorem)
+        pair<vector<char>, vector<char>> cover = hk.min_vertex_cover();
+        int nc = 0;
+        for (int u = 0; u < nl; u++)
+            nc += cover.first[u];
+        for (int v = 0; v < nr; v++)
+            nc += cover.second[v];
+        EXPECT_EQ(nc, r);
+        for (int u = 0; u < nl; u++)
+            for (int v : hk.adj[u])
+                EXPECT_TRUE(cover.first[u] || cover.second[v]);
+    }
+}
+
+// the second phase needs one augmenting path through all vertices
+TEST_F(TestMatching, TestLongPath) {
+    const int n = 1 << 20;
+    HopcroftKarp hk(n, n);
+    for (int u = 0; u < n; u++) {
+        if (u + 1 < n)
+            hk.add_edge(u, u + 1);
+        hk.add_edge(u, u);
+    }
+    EXPECT_EQ(hk.solve(), n);
+    for (int u = 0; u < n; u++)
+        EXPECT_EQ(hk.match_l[u], u);
+}
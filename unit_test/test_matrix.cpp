@@ -1,5 +1,6 @@
 
 #include "block2_core.hpp"
+#include "block2_dmrg.hpp"
 #include "gtest/gtest.h"
 
 using namespace block2;
@@ -944,6 +945,57 @@ TEST_F(TestMatrix, TestSVD) {
     }
 }
 
+TEST_F(TestMatrix, TestRandomizedSVD) {
+    for (int i = 0; i < n_tests; i++) {
+        MKL_INT m = Random::rand_int(60, 200);
+        MKL_INT n = Random::rand_int(60, 200);
+        MKL_INT p = Random::rand_int(1, 20);
+        MKL_INT k = p + Random::rand_int(0, 10);
+        // low rank matrix
+        shared_ptr<Tensor> x = make_shared<Tensor>(vector<MKL_INT>{m, p});
+        shared_ptr<Tensor> y = make_shared<Tensor>(vector<MKL_INT>{p, n});
+        shared_ptr<Tensor> a = make_shared<Tensor>(vector<MKL_INT>{m, n});
+        shared_ptr<Tensor> aa = make_shared<Tensor>(vector<MKL_INT>{m, n});
+        shared_ptr<Tensor> l = make_shared<Tensor>(vector<MKL_INT>{m, k});
+        shared_ptr<Tensor> s = make_shared<Tensor>(vector<MKL_INT>{k});
+        shared_ptr<Tensor> r = make_shared<Tensor>(vector<MKL_INT>{k, n});
+        shared_ptr<Tensor> kk = make_shared<Tensor>(vector<MKL_INT>{k, k});
+        Random::fill<double>(x->data.data(), x->size(), -1.0, 1.0);
+        Random::fill<double>(y->data.data(), y->size(), -1.0, 1.0);
+        MatrixFunctions::multiply(x->ref(), false, y->ref(), false, a->ref(),
+                                  1.0, 0.0);
+        MatrixFunctions::copy(aa->ref(), a->ref());
+        ASSERT_TRUE(MatrixFunctions::randomized_svd(
+            a->ref(), l->ref(), s->ref().flip_dims(), r->ref(), p, 1E-12));
+        // original matrix is not changed
+        ASSERT_TRUE(
+            MatrixFunctions::all_close(aa->ref(), a->ref(), 1E-14, 0.0));
+        MatrixFunctions::multiply(l->ref(), true, l->ref(), false, kk->ref(),
+                                  1.0, 0.0);
+        ASSERT_TRUE(MatrixFunctions::all_close(kk->ref(), IdentityMatrix(k),
+                                               1E-10, 0.0));
+        MatrixFunctions::multiply(r->ref(), false, r->ref(), true, kk->ref(),
+                                  1.0, 0.0);
+        ASSERT_TRUE(MatrixFunctions::all_close(kk->ref(), IdentityMatrix(k),
+                                               1E-10, 0.0));
+        MatrixRef xr(r->data.data(), 1, n);
+        for (MKL_INT i = 0; i < k; i++) {
+            ASSERT_GE((*s)({i}), 0.0);
+            MatrixFunctions::iscale(xr.shift_ptr(i * n), (*s)({i}));
+        }
+        MatrixFunctions::multiply(l->ref(), false, r->ref(), false, a->ref(),
+                                  1.0, 0.0);
+        ASSERT_TRUE(
+            MatrixFunctions::all_close(aa->ref(), a->ref(), 1E-10, 0.0));
+        // full rank matrix cannot be captured by a small sampled rank
+        Random::fill<double>(a->data.data(), a->size(), -1.0, 1.0);
+        ASSERT_FALSE(MatrixFunctions::randomized_svd(
+            a->ref(), MatrixRef(l->data.data(), m, 2),
+            MatrixRef(s->data.data(), 1, 2), MatrixRef(r->data.data(), 2, n),
+            1, 1E-12));
+    }
+}
+
 TEST_F(TestMatrix, TestQR) {
     for (int i = 0; i < n_tests; i++) {
         MKL_INT m = Random::rand_int(1, 200);
@@ -1102,3 +1154,222 @@ TEST_F(TestMatrix, TestIDRS) {
         ax.deallocate();
     }
 }
+
+// blocks larger than mkl_block_size run first, in decreasing size
+TEST_F(TestMatrix, TestParallelForBlocks) {
+    shared_ptr<Threading> th = threading_();
+    for (int i = 0; i < n_tests; i++) {
+        int n = Random::rand_int(0, 50);
+        vector<size_t> sizes(n);
+        for (int j = 0; j < n; j++)
+            sizes[j] = (size_t)Random::rand_int(1, 1000);
+        for (int nt : {1, 4})
+            for (size_t mbs : {(size_t)0, (size_t)1, (size_t)500}) {
+                threading_() = make_shared<Threading>(
+                    ThreadingTypes::Operator | ThreadingTypes::Global, nt, nt);
+                threading_()->mkl_block_size = mbs;
+                vector<int> seq(n, -1), cnt(n, 0);
+                int ic = 0;
+                threading_()->parallel_for_blocks(sizes, [&](int j) {
+                    int x;
+#pragma omp atomic capture
+                    x = ic++;
+#pragma omp atomic
+                    cnt[j]++;
+                    seq[j] = x;
+                });
+                int nlarge = 0;
+                for (int j = 0; j < n; j++) {
+                    ASSERT_EQ(cnt[j], 1);
+                    nlarge += mbs != 0 && sizes[j] > mbs;
+                }
+                vector<int> idx(n);
+                for (int j = 0; j < n; j++)
+                    idx[seq[j]] = j;
+                for (int j = 0; j < n; j++) {
+                    EXPECT_EQ(j < nlarge, mbs != 0 && sizes[idx[j]] > mbs);
+                    if (j != 0 && (j < nlarge || nt == 1))
+                        EXPECT_GE(sizes[idx[j - 1]], sizes[idx[j]]);
+                }
+            }
+    }
+    threading_() = th;
+}
+
+// singular vectors are compared up to the sign
+static bool tensors_close(const vector<shared_ptr<GTensor<double>>> &a,
+                          const vector<shared_ptr<GTensor<double>>> &b,
+                          double tol) {
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i]->shape != b[i]->shape)
+            return false;
+        for (size_t j = 0; j < a[i]->data.size(); j++)
+            if (abs(abs(a[i]->data[j]) - abs(b[i]->data[j])) > tol)
+                return false;
+    }
+    return true;
+}
+
+// the svd and the density matrix truncation give the serial result
+// for any mkl_block_size
+TEST_F(TestMatrix, TestBlockedSVD) {
+    shared_ptr<Threading> th = threading_();
+    shared_ptr<Allocator<uint32_t>> i_alloc =
+        make_shared<VectorAllocator<uint32_t>>();
+    shared_ptr<Allocator<double>> d_alloc =
+        make_shared<VectorAllocator<double>>();
+    struct Result {
+        vector<SZ> rqs, lqs;
+        vector<shared_ptr<GTensor<double>>> ll, ls, lr, rl, rs, rr;
+        vector<pair<int, int>> ss;
+        vector<double> spectra;
+        double error;
+    };
+    for (int i = 0; i < n_tests / 10; i++) {
+        int nq = Random::rand_int(1, 12);
+        StateInfo<SZ> bra, ket;
+        bra.allocate(nq), ket.allocate(nq);
+        for (int j = 0; j < nq; j++) {
+            bra.quanta[j] = ket.quanta[j] = SZ(2 * j, 0, 0);
+            bra.n_states[j] = Random::rand_int(1, 60);
+            ket.n_states[j] = Random::rand_int(1, 60);
+        }
+        bra.sort_states(), ket.sort_states();
+        shared_ptr<SparseMatrixInfo<SZ>> winfo =
+            make_shared<SparseMatrixInfo<SZ>>(i_alloc);
+        winfo->initialize(bra, ket, SZ(0, 0, 0), false);
+        shared_ptr<SparseMatrix<SZ, double>> wfn =
+            make_shared<SparseMatrix<SZ, double>>(d_alloc);
+        wfn->allocate(winfo);
+        wfn->randomize(-1.0, 1.0);
+        shared_ptr<SparseMatrixInfo<SZ>> dinfo =
+            make_shared<SparseMatrixInfo<SZ>>(i_alloc);
+        dinfo->initialize(bra, bra, SZ(0, 0, 0), false);
+        shared_ptr<SparseMatrix<SZ, double>> dm =
+            make_shared<SparseMatrix<SZ, double>>(d_alloc);
+        dm->allocate(dinfo);
+        for (int j = 0; j < dinfo->n; j++)
+            MatrixFunctions::multiply((*wfn)[j], false, (*wfn)[j], true,
+                                      (*dm)[j], 1.0, 0.0);
+        int k = Random::rand_int(1, (int)bra.n_states_total + 1);
+        auto run = [&]() -> Result {
+            Result x;
+            wfn->left_svd(x.rqs, x.ll, x.ls, x.lr);
+            wfn->right_svd(x.lqs, x.rl, x.rs, x.rr);
+            shared_ptr<SparseMatrix<SZ, double>> dmc =
+                make_shared<SparseMatrix<SZ, double>>(d_alloc);
+            dmc->allocate(dinfo);
+            dmc->copy_data_from(dm);
+            x.error = MovingEnvironment<SZ, double, double>::
+                truncate_density_matrix(dmc, x.ss, k, 0.0, true, x.spectra,
+                                        TruncationTypes::Physical);
+            dmc->deallocate();
+            return x;
+        };
+        threading_() = make_shared<Threading>(
+            ThreadingTypes::Operator | ThreadingTypes::Global, 1, 1);
+        threading_()->mkl_block_size = 0;
+        Result ref = run();
+        for (size_t mbs : {(size_t)0, (size_t)1, (size_t)400}) {
+            threading_() = make_shared<Threading>(
+                ThreadingTypes::Operator | ThreadingTypes::Global, 4, 4);
+            threading_()->mkl_block_size = mbs;
+            Result x = run();
+            EXPECT_TRUE(x.rqs == ref.rqs && x.lqs == ref.lqs);
+            EXPECT_TRUE(tensors_close(x.ls, ref.ls, 1E-10));
+            EXPECT_TRUE(tensors_close(x.rs, ref.rs, 1E-10));
+            EXPECT_TRUE(tensors_close(x.ll, ref.ll, 1E-8));
+            EXPECT_TRUE(tensors_close(x.lr, ref.lr, 1E-8));
+            EXPECT_TRUE(tensors_close(x.rl, ref.rl, 1E-8));
+            EXPECT_TRUE(tensors_close(x.rr, ref.rr, 1E-8));
+            EXPECT_TRUE(x.ss == ref.ss);
+            EXPECT_EQ(x.spectra.size(), ref.spectra.size());
+            for (size_t j = 0; j < x.spectra.size(); j++)
+                EXPECT_NEAR(x.spectra[j], ref.spectra[j], 1E-10);
+            EXPECT_NEAR(x.error, ref.error, 1E-10);
+        }
+        dm->deallocate();
+        dinfo->deallocate();
+        wfn->deallocate();
+        winfo->deallocate();
+        ket.deallocate(), bra.deallocate();
+    }
+    threading_() = th;
+}
+
+// the error of randomized svd includes the weight outside the sampled range
+// so it agrees with the exact truncation error
+TEST_F(TestMatrix, TestRandomizedSVDError) {
+    shared_ptr<Allocator<uint32_t>> i_alloc =
+        make_shared<VectorAllocator<uint32_t>>();
+    shared_ptr<Allocator<double>> d_alloc =
+        make_shared<VectorAllocator<double>>();
+    // blocks have singular values c q^t (t < r)
+    const int nq = 3, k = 12, r = 40;
+    const double q = 0.85;
+    for (int i = 0; i < n_tests / 10; i++) {
+        StateInfo<SZ> bra, ket;
+        bra.allocate(nq), ket.allocate(nq);
+        for (int j = 0; j < nq; j++) {
+            bra.quanta[j] = SZ(2 * j, 0, 0);
+            ket.quanta[j] = SZ(2 * (nq - 1 - j), 0, 0);
+            bra.n_states[j] = Random::rand_int(60, 100);
+            ket.n_states[j] = Random::rand_int(60, 100);
+        }
+        bra.sort_states(), ket.sort_states();
+        shared_ptr<SparseMatrixInfo<SZ>> winfo =
+            make_shared<SparseMatrixInfo<SZ>>(i_alloc);
+        winfo->initialize(bra, ket, SZ(2 * (nq - 1), 0, 0), false, true);
+        shared_ptr<SparseMatrix<SZ, double>> wfn =
+            make_shared<SparseMatrix<SZ, double>>(d_alloc);
+        wfn->allocate(winfo);
+        for (int j = 0; j < winfo->n; j++) {
+            MatrixRef a = (*wfn)[j];
+            vector<double> x(a.m * r), xq(a.m * r), t(r * r);
+            vector<double> y(r * a.n), yq(r * a.n);
+            Random::fill<double>(x.data(), x.size(), -1.0, 1.0);
+            Random::fill<double>(y.data(), y.size(), -1.0, 1.0);
+            MatrixFunctions::qr(MatrixRef(x.data(), a.m, r),
+                                MatrixRef(xq.data(), a.m, r),
+                                MatrixRef(t.data(), r, r));
+            MatrixFunctions::lq(MatrixRef(y.data(), r, a.n),
+                                MatrixRef(t.data(), r, r),
+                                MatrixRef(yq.data(), r, a.n));
+            double c = Random::rand_double(0.5, 1.0);
+            for (int it = 0; it < r; it++, c *= q)
+                for (int ir = 0; ir < a.m; ir++)
+                    xq[ir * r + it] *= c;
+            MatrixFunctions::multiply(MatrixRef(xq.data(), a.m, r), false,
+                                      MatrixRef(yq.data(), r, a.n), false, a,
+                                      1.0, 0.0);
+        }
+        for (bool trace_right : {true, false}) {
+            double error[2];
+            int n_rsvd[2] = {0, 0};
+            for (int id = 0; id < 2; id++) {
+                shared_ptr<SparseMatrix<SZ, double>> left, right;
+                vector<double> spectra;
+                error[id] = MovingEnvironment<SZ, double, double>::
+                    split_wavefunction_svd(
+                        SZ(0, 0, 0), wfn, k, trace_right, false, left, right,
+                        0.0, false, spectra, TruncationTypes::Physical,
+                        id == 0 ? DecompositionTypes::SVD
+                                : DecompositionTypes::RandomizedSVD,
+                        nullptr, vector<shared_ptr<SparseMatrix<SZ, double>>>(),
+                        vector<double>(), 10, 1E-12, 0, &n_rsvd[id]);
+                right->deallocate();
+                left->deallocate();
+                right->info->deallocate();
+                left->info->deallocate();
+            }
+            EXPECT_EQ(n_rsvd[0], 0);
+            EXPECT_EQ(n_rsvd[1], nq);
+            EXPECT_NEAR(error[1], error[0], 1E-8);
+        }
+        wfn->deallocate();
+        winfo->deallocate();
+        ket.deallocate(), bra.deallocate();
+    }
+}
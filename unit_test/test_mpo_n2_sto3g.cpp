@@ -0,0 +1,458 @@
+
+#include "block2_core.hpp"
+#include "block2_dmrg.hpp"
+#include <gtest/gtest.h>
+
+using namespace block2;
+
+class TestMPON2STO3G : public ::testing::Test {
+  protected:
+    size_t isize = 1L << 24;
+    size_t dsize = 1L << 32;
+    shared_ptr<FCIDUMP<double>> fcidump;
+
+    template <typename S> shared_ptr<HamiltonianQC<S, double>> get_hamil();
+    template <typename S>
+    void test_dmrg(S target, double energy,
+                   const shared_ptr<HamiltonianQC<S, double>> &hamil,
+                   const shared_ptr<MPO<S, double>> &mpo, const string &name);
+    template <typename S>
+    void test_archived(S target, double energy,
+                       const shared_ptr<HamiltonianQC<S, double>> &hamil,
+                       const shared_ptr<MPO<S, double>> &mpo,
+                       const string &name);
+    template <typename S>
+    void test_indexed(S target, double energy,
+                      const shared_ptr<HamiltonianQC<S, double>> &hamil,
+                      const string &name);
+    int test_general(SZ target, double energy,
+                      const shared_ptr<HamiltonianQC<SZ, double>> &hamil,
+                      MPOAlgorithmTypes algo_type, const string &name);
+    void SetUp() override {
+        Random::rand_seed(0);
+        frame_() = make_shared<DataFrame>(isize, dsize, "nodex");
+        frame_()->use_main_stack = false;
+        frame_()->minimal_disk_usage = true;
+        threading_() = make_shared<Threading>(
+            ThreadingTypes::OperatorBatchedGEMM | ThreadingTypes::Global, 8, 8,
+            1);
+        threading_()->seq_type = SeqTypes::Tasked;
+        cout << *threading_() << endl;
+        fcidump = make_shared<FCIDUMP<double>>();
+        fcidump->read("data/N2.STO3G.FCIDUMP");
+    }
+    void TearDown() override {
+        fcidump->deallocate();
+        frame_()->activate(0);
+        assert(ialloc_()->used == 0 && dalloc_()->used == 0);
+        frame_() = nullptr;
+    }
+};
+
+template <typename S>
+shared_ptr<HamiltonianQC<S, double>> TestMPON2STO3G::get_hamil() {
+    vector<uint8_t> orbsym = fcidump->orb_sym<uint8_t>();
+    transform(orbsym.begin(), orbsym.end(), orbsym.begin(),
+              PointGroup::swap_pg(PGTypes::D2H));
+    return make_shared<HamiltonianQC<S, double>>(
+        S(0, 0, 0), fcidump->n_sites(), orbsym, fcidump);
+}
+
+template <typename S>
+void TestMPON2STO3G::test_dmrg(
+    S target, double energy, const shared_ptr<HamiltonianQC<S, double>> &hamil,
+    const shared_ptr<MPO<S, double>> &mpo, const string &name) {
+    ubond_t bond_dim = 200;
+    shared_ptr<MPSInfo<S>> mps_info = make_shared<MPSInfo<S>>(
+        hamil->n_sites, hamil->vacuum, target, hamil->basis);
+    mps_info->set_bond_dimension(bond_dim);
+    shared_ptr<MPS<S, double>> mps =
+        make_shared<MPS<S, double>>(hamil->n_sites, 0, 2);
+    mps->initialize(mps_info);
+    mps->random_canonicalize();
+    mps->save_mutable();
+    mps->deallocate();
+    mps_info->save_mutable();
+    mps_info->deallocate_mutable();
+
+    shared_ptr<MovingEnvironment<S, double, double>> me =
+        make_shared<MovingEnvironment<S, double, double>>(mpo, mps, mps,
+                                                          "DMRG");
+    me->init_environments(false);
+    shared_ptr<DMRG<S, double, double>> dmrg =
+        make_shared<DMRG<S, double, double>>(
+            me, vector<ubond_t>{bond_dim}, vector<double>{1E-8, 1E-9, 0.0});
+    dmrg->iprint = 0;
+    double ener = dmrg->solve(10, mps->center == 0, 1E-8);
+
+    cout << "== " << name << " ==" << setw(20) << target << " E = " << fixed
+         << setw(22) << setprecision(12) << ener << " error = " << scientific
+         << setprecision(3) << setw(10) << (ener - energy) << endl;
+
+    EXPECT_LT(abs(ener - energy), 1E-7);
+
+    mps_info->deallocate();
+}
+
+template <typename S>
+void TestMPON2STO3G::test_archived(
+    S target, double energy, const shared_ptr<HamiltonianQC<S, double>> &hamil,
+    const shared_ptr<MPO<S, double>> &mpo, const string &name) {
+    // all site operators are on disk after construction
+    for (int i = 0; i < mpo->n_sites; i++)
+        EXPECT_EQ(mpo->tensors[i]->ops.size(), 0);
+
+    shared_ptr<MPO<S, double>> smpo = make_shared<SimplifiedMPO<S, double>>(
+        mpo, make_shared<RuleQC<S, double>>(), true, true,
+        OpNamesSet({OpNames::R, OpNames::RD}));
+    EXPECT_TRUE(smpo->archive_ops_only);
+
+    // saved MPO contains all site operators
+    smpo->save_data("nodex/" + name + ".MPO");
+    shared_ptr<MPO<S, double>> lmpo = make_shared<MPO<S, double>>(0);
+    lmpo->load_data("nodex/" + name + ".MPO");
+    for (int i = 0; i < lmpo->n_sites; i++) {
+        smpo->load_tensor(i);
+        EXPECT_EQ(lmpo->tensors[i]->ops.size(), smpo->tensors[i]->ops.size());
+        smpo->unload_tensor(i);
+    }
+
+    test_dmrg<S>(target, energy, hamil, smpo, name + " ARCHIVED");
+    smpo->deallocate();
+}
+
+template <typename S>
+void TestMPON2STO3G::test_indexed(
+    S target, double energy, const shared_ptr<HamiltonianQC<S, double>> &hamil,
+    const string &name) {
+    shared_ptr<MPO<S, double>> mpo =
+        make_shared<MPOQC<S, double>>(hamil, QCTypes::Conventional);
+    mpo = make_shared<SimplifiedMPO<S, double>>(
+        mpo, make_shared<RuleQC<S, double>>(), true, true,
+        OpNamesSet({OpNames::R, OpNames::RD}));
+    string filename = "nodex/" + name + ".IDX.MPO";
+    mpo->save_data_indexed(filename);
+
+    // full loading
+    shared_ptr<MPO<S, double>> fmpo = make_shared<MPO<S, double>>(0);
+    fmpo->load_data(filename);
+    EXPECT_EQ(fmpo->n_sites, mpo->n_sites);
+    EXPECT_EQ(fmpo->archive_filename, "");
+    EXPECT_TRUE(fmpo->schemer != nullptr &&
+                fmpo->schemer->left_new_operator_names != nullptr);
+    for (int i = 0; i < mpo->n_sites; i++) {
+        EXPECT_EQ(fmpo->tensors[i]->ops.size(), mpo->tensors[i]->ops.size());
+        EXPECT_EQ(fmpo->left_operator_names[i]->data.size(),
+                  mpo->left_operator_names[i]->data.size());
+        EXPECT_EQ(fmpo->right_operator_exprs[i]->data.size(),
+                  mpo->right_operator_exprs[i]->data.size());
+    }
+
+    // lazy loading
+    shared_ptr<MPO<S, double>> lmpo = make_shared<MPO<S, double>>(0);
+    lmpo->load_data(filename, true);
+    EXPECT_EQ(lmpo->archive_filename, filename);
+    for (int i = 0; i < lmpo->n_sites; i++) {
+        EXPECT_TRUE(lmpo->tensors[i] == nullptr);
+        EXPECT_TRUE(lmpo->left_operator_names[i] == nullptr);
+    }
+    lmpo->load_left_operators(1);
+    EXPECT_EQ(lmpo->left_operator_names[1]->data.size(),
+              mpo->left_operator_names[1]->data.size());
+    lmpo->unload_left_operators(1);
+    EXPECT_TRUE(lmpo->tf != nullptr);
+
+    test_dmrg<S>(target, energy, hamil, lmpo, name + " INDEXED");
+
+    fmpo->deallocate();
+    mpo->deallocate();
+}
+
+int TestMPON2STO3G::test_general(
+    SZ target, double energy,
+    const shared_ptr<HamiltonianQC<SZ, double>> &hamil,
+    MPOAlgorithmTypes algo_type, const string &name) {
+    // spin-orbital operator strings of the ab initio Hamiltonian
+    uint16_t n = hamil->n_sites;
+    const int sz[2] = {1, -1};
+    vector<vector<shared_ptr<OpElement<SZ, double>>>> c_op(n), d_op(n);
+    for (uint16_t m = 0; m < n; m++)
+        for (uint8_t s = 0; s < 2; s++) {
+            c_op[m].push_back(make_shared<OpElement<SZ, double>>(
+                OpNames::C, SiteIndex({m}, {s}),
+                SZ(1, sz[s], hamil->orb_sym[m])));
+            d_op[m].push_back(make_shared<OpElement<SZ, double>>(
+                OpNames::D, SiteIndex({m}, {s}),
+                SZ(-1, -sz[s], SZ::pg_inv(hamil->orb_sym[m]))));
+        }
+    vector<vector<shared_ptr<OpElement<SZ, double>>>> terms;
+    vector<double> coeffs;
+    for (uint8_t s = 0; s < 2; s++)
+        for (uint16_t i = 0; i < n; i++)
+            for (uint16_t j = 0; j < n; j++)
+                if (abs(hamil->t(s, i, j)) > 1E-12) {
+                    terms.push_back({c_op[i][s], d_op[j][s]});
+                    coeffs.push_back(hamil->t(s, i, j));
+                }
+    for (uint8_t sl = 0; sl < 2; sl++)
+        for (uint8_t sr = 0; sr < 2; sr++)
+            for (uint16_t i = 0; i < n; i++)
+                for (uint16_t j = 0; j < n; j++)
+                    for (uint16_t k = 0; k < n; k++)
+                        for (uint16_t l = 0; l < n; l++) {
+                            if (sl == sr && (i == k || j == l))
+                                continue;
+                            double v = hamil->v(sl, sr, i, j, k, l);
+                            if (abs(v) > 1E-12) {
+                                terms.push_back({c_op[i][sl], c_op[k][sr],
+                                                 d_op[l][sr], d_op[j][sl]});
+                                coeffs.push_back(0.5 * v);
+                            }
+                        }
+
+    shared_ptr<MPO<SZ, double>> mpo = make_shared<GeneralMPO<SZ, double>>(
+        hamil, terms, coeffs, algo_type, 1E-12, hamil->e());
+    mpo = make_shared<SimplifiedMPO<SZ, double>>(
+        mpo, make_shared<Rule<SZ, double>>(), true);
+    vector<int> bdims = mpo->get_bond_dims();
+    int total = 0;
+    for (size_t i = 0; i < bdims.size(); i++)
+        total += bdims[i];
+
+    test_dmrg<SZ>(target, energy, hamil, mpo, name);
+    mpo->deallocate();
+    return total;
+}
+
+// Products in an expression (with sums of products expanded)
+// and their total factors, independent of the order of terms
+template <typename S>
+static map<string, double> expand_expr(const shared_ptr<OpExpr<S>> &expr) {
+    map<string, double> r;
+    auto add = [&r](const shared_ptr<OpElement<S, double>> &a,
+                    const shared_ptr<OpElement<S, double>> &b, bool ca,
+                    bool cb, double factor) {
+        string k = a->abs().to_str() + (ca ? "^T" : "");
+        if (b != nullptr)
+            k += " x " + b->abs().to_str() + (cb ? "^T" : "");
+        r[k] += factor * a->factor * (b == nullptr ? 1.0 : b->factor);
+    };
+    vector<shared_ptr<OpProduct<S, double>>> terms;
+    if (expr->get_type() == OpTypes::Elem)
+        add(dynamic_pointer_cast<OpElement<S, double>>(expr), nullptr, false,
+            false, 1.0);
+    else if (expr->get_type() == OpTypes::Prod)
+        terms.push_back(dynamic_pointer_cast<OpProduct<S, double>>(expr));
+    else if (expr->get_type() == OpTypes::Sum)
+        terms = dynamic_pointer_cast<OpSum<S, double>>(expr)->strings;
+    for (auto &t : terms)
+        if (t->get_type() == OpTypes::SumProd) {
+            shared_ptr<OpSumProd<S, double>> sp =
+                dynamic_pointer_cast<OpSumProd<S, double>>(t);
+            for (size_t k = 0; k < sp->ops.size(); k++)
+                if (sp->a != nullptr)
+                    add(sp->a, sp->ops[k], sp->conj & 1,
+                        ((sp->conj >> 1) & 1) ^ sp->conjs[k], sp->factor);
+                else
+                    add(sp->ops[k], sp->b, (sp->conj & 1) ^ sp->conjs[k],
+                        (sp->conj >> 1) & 1, sp->factor);
+        } else
+            add(t->a, t->b, t->conj & 1, (t->conj >> 1) & 1, t->factor);
+    return r;
+}
+
+template <typename S>
+static void check_same_exprs(const vector<shared_ptr<OpExpr<S>>> &a,
+                             const vector<shared_ptr<OpExpr<S>>> &b) {
+    ASSERT_EQ(a.size(), b.size());
+    for (size_t j = 0; j < a.size(); j++) {
+        map<string, double> ea = expand_expr(a[j]);
+        map<string, double> eb = expand_expr(b[j]);
+        EXPECT_EQ(ea.size(), eb.size());
+        for (auto &x : ea) {
+            EXPECT_EQ(eb.count(x.first), 1);
+            EXPECT_LT(abs(x.second - eb[x.first]), 1E-12);
+        }
+    }
+}
+
+template <typename S>
+static void check_same_mpo(const shared_ptr<MPO<S, double>> &a,
+                           const shared_ptr<MPO<S, double>> &b) {
+    for (int i = 0; i < a->n_sites; i++) {
+        EXPECT_EQ(a->left_operator_names[i]->data.size(),
+                  b->left_operator_names[i]->data.size());
+        EXPECT_EQ(a->right_operator_names[i]->data.size(),
+                  b->right_operator_names[i]->data.size());
+        check_same_exprs(a->left_operator_names[i]->data,
+                         b->left_operator_names[i]->data);
+        check_same_exprs(a->right_operator_names[i]->data,
+                         b->right_operator_names[i]->data);
+        check_same_exprs(a->left_operator_exprs[i]->data,
+                         b->left_operator_exprs[i]->data);
+        check_same_exprs(a->right_operator_exprs[i]->data,
+                         b->right_operator_exprs[i]->data);
+    }
+    ASSERT_TRUE(a->schemer != nullptr && b->schemer != nullptr);
+    check_same_exprs(a->schemer->left_new_operator_exprs->data,
+                     b->schemer->left_new_operator_exprs->data);
+    check_same_exprs(a->schemer->right_new_operator_exprs->data,
+                     b->schemer->right_new_operator_exprs->data);
+}
+
+// sum expressions simplified with interned ids give the same MPO as
+// the simplification comparing OpElement values (reference bond dimensions
+// and numbers of expanded terms in left and right expressions)
+template <typename S>
+static void test_interned(const shared_ptr<HamiltonianQC<S, double>> &hamil,
+                          const vector<int> &ref_bdims,
+                          const vector<size_t> &ref_nterms) {
+    shared_ptr<MPO<S, double>> mpo = make_shared<SimplifiedMPO<S, double>>(
+        make_shared<MPOQC<S, double>>(hamil, QCTypes::Conventional),
+        make_shared<RuleQC<S, double>>(), true, true,
+        OpNamesSet({OpNames::R, OpNames::RD}));
+    EXPECT_EQ(mpo->get_bond_dims(), ref_bdims);
+    ASSERT_EQ(mpo->n_sites, (int)ref_nterms.size());
+    for (int i = 0; i < mpo->n_sites; i++) {
+        size_t nterms = 0;
+        for (auto &expr : mpo->left_operator_exprs[i]->data)
+            nterms += expand_expr(expr).size();
+        for (auto &expr : mpo->right_operator_exprs[i]->data)
+            nterms += expand_expr(expr).size();
+        EXPECT_EQ(nterms, ref_nterms[i]);
+        // product terms of one site share one object per unique element
+        unordered_map<OpElement<S, double>, OpElement<S, double> *> elems;
+        for (auto &expr : mpo->left_operator_exprs[i]->data) {
+            if (expr->get_type() != OpTypes::Sum)
+                continue;
+            for (auto &x :
+                 dynamic_pointer_cast<OpSum<S, double>>(expr)->strings)
+                if (x->get_type() == OpTypes::Prod)
+                    for (auto &p : {x->a, x->b})
+                        if (p != nullptr) {
+                            auto it = elems.find(*p);
+                            if (it == elems.end())
+                                elems[*p] = p.get();
+                            else
+                                EXPECT_EQ(it->second, p.get());
+                        }
+        }
+    }
+    mpo->deallocate();
+}
+
+// the flattened expression task list and the parallel check of indirectly
+// referenced operators give the same MPO as one thread
+template <typename S>
+static void
+test_simplify_threads(const shared_ptr<HamiltonianQC<S, double>> &hamil) {
+    const int ntg = threading_()->n_threads_global;
+    vector<shared_ptr<MPO<S, double>>> mpos;
+    for (int nt : {1, 4}) {
+        threading_()->n_threads_global = nt;
+        mpos.push_back(make_shared<SimplifiedMPO<S, double>>(
+            make_shared<MPOQC<S, double>>(hamil, QCTypes::Conventional),
+            make_shared<RuleQC<S, double>>(), true, true,
+            OpNamesSet({OpNames::R, OpNames::RD})));
+    }
+    threading_()->n_threads_global = ntg;
+    check_same_mpo(mpos[0], mpos[1]);
+    ASSERT_EQ(mpos[0]->middle_operator_exprs.size(),
+              mpos[1]->middle_operator_exprs.size());
+    for (size_t i = 0; i < mpos[0]->middle_operator_exprs.size(); i++)
+        check_same_exprs(mpos[0]->middle_operator_exprs[i]->data,
+                         mpos[1]->middle_operator_exprs[i]->data);
+    mpos[1]->deallocate();
+    mpos[0]->deallocate();
+}
+
+TEST_F(TestMPON2STO3G, TestArchivedSU2) {
+    shared_ptr<HamiltonianQC<SU2, double>> hamil = get_hamil<SU2>();
+    shared_ptr<MPO<SU2, double>> mpo = make_shared<MPOQC<SU2, double>>(
+        hamil, QCTypes::Conventional, -1, "nodex/N2.STO3G.SU2.OPS");
+    test_archived<SU2>(SU2(fcidump->n_elec(), 0, 0), -107.654122447525,
+                       hamil, mpo, "SU2");
+    hamil->deallocate();
+}
+
+TEST_F(TestMPON2STO3G, TestArchivedSZ) {
+    shared_ptr<HamiltonianQC<SZ, double>> hamil = get_hamil<SZ>();
+    shared_ptr<MPO<SZ, double>> mpo = make_shared<MPOQC<SZ, double>>(
+        hamil, QCTypes::Conventional, -1, true, "nodex/N2.STO3G.SZ.OPS");
+    test_archived<SZ>(SZ(fcidump->n_elec(), 0, 0), -107.654122447525, hamil,
+                      mpo, "SZ");
+    hamil->deallocate();
+}
+
+TEST_F(TestMPON2STO3G, TestArchiveError) {
+    shared_ptr<MPO<SU2, double>> mpo = make_shared<MPO<SU2, double>>(4);
+    for (int i = 0; i < mpo->n_sites; i++)
+        mpo->tensors.push_back(make_shared<OperatorTensor<SU2, double>>());
+    EXPECT_THROW(mpo->init_tensor_archive("nodex/none/N2.STO3G.OPS"),
+                 runtime_error);
+    // errors in threads are reported after the parallel region
+    string filename = "nodex/N2.STO3G.OPS";
+    mpo->init_tensor_archive(filename);
+    mpo->check_tensor_archive();
+    Parsing::remove_file(filename);
+#pragma omp parallel for num_threads(2)
+    for (int i = 0; i < mpo->n_sites; i++)
+        mpo->archive_tensor(i);
+    EXPECT_THROW(mpo->check_tensor_archive(), runtime_error);
+}
+
+TEST_F(TestMPON2STO3G, TestIndexedSU2) {
+    shared_ptr<HamiltonianQC<SU2, double>> hamil = get_hamil<SU2>();
+    test_indexed<SU2>(SU2(fcidump->n_elec(), 0, 0), -107.654122447525, hamil,
+                      "SU2");
+    hamil->deallocate();
+}
+
+TEST_F(TestMPON2STO3G, TestInternedSimplification) {
+    shared_ptr<HamiltonianQC<SU2, double>> hamil = get_hamil<SU2>();
+    test_interned<SU2>(hamil, {8, 15, 26, 44, 63, 22, 17, 12, 6, 1},
+                       {20, 64, 88, 262, 268, 233, 75, 64, 36, 14});
+    hamil->deallocate();
+    shared_ptr<HamiltonianQC<SZ, double>> szhamil = get_hamil<SZ>();
+    test_interned<SZ>(szhamil, {14, 28, 50, 86, 124, 42, 32, 22, 10, 1},
+                      {36, 132, 170, 650, 606, 544, 144, 134, 66, 24});
+    szhamil->deallocate();
+}
+
+TEST_F(TestMPON2STO3G, TestSimplificationThreads) {
+    shared_ptr<HamiltonianQC<SU2, double>> hamil = get_hamil<SU2>();
+    test_simplify_threads<SU2>(hamil);
+    hamil->deallocate();
+    shared_ptr<HamiltonianQC<SZ, double>> szhamil = get_hamil<SZ>();
+    test_simplify_threads<SZ>(szhamil);
+    szhamil->deallocate();
+}
+
+TEST_F(TestMPON2STO3G, TestGeneral) {
+    shared_ptr<HamiltonianQC<SZ, double>> hamil = get_hamil<SZ>();
+    // reference: QC MPO simplified with the QC-specific rule
+    shared_ptr<MPO<SZ, double>> mpo =
+        make_shared<MPOQC<SZ, double>>(hamil, QCTypes::Conventional);
+    mpo = make_shared<SimplifiedMPO<SZ, double>>(
+        mpo, make_shared<RuleQC<SZ, double>>(), true);
+    vector<int> ref_bdims = mpo->get_bond_dims();
+    mpo->deallocate();
+    int ref_total = 0;
+    for (size_t i = 0; i < ref_bdims.size(); i++)
+        ref_total += ref_bdims[i];
+
+    int bip_total = test_general(SZ(fcidump->n_elec(), 0, 0),
+                                 -107.654122447525, hamil,
+                                 MPOAlgorithmTypes::Bipartite, "BIPARTITE");
+    int svd_total =
+        test_general(SZ(fcidump->n_elec(), 0, 0), -107.654122447525, hamil,
+                     MPOAlgorithmTypes::SVD, "SVD");
+    cout << "MPO bond dims total: QC = " << ref_total
+         << " BIPARTITE = " << bip_total << " SVD = " << svd_total << endl;
+    // the bipartite cover only removes repeated operator strings, while the
+    // QC MPO also sums integrals into complementary operators;
+    // SVD finds such linear combinations automatically
+    EXPECT_LT(svd_total, ref_total);
+    EXPECT_LT(svd_total, bip_total);
+    hamil->deallocate();
+}